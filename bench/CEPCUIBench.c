@@ -0,0 +1,1053 @@
+/*******************************************************************************
+ * CEPCUIBench.c : Benchmark of the stages of cepcui on synthetic records
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUICSVTokenizer.h"
+#include "CEPCUIInserter.h"
+#include "CEPCUIPublisher.h"
+#include "CEPCUIQuerySet.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Revision of the source tree, given by the Makefile
+ */
+#ifndef CEPCUIBench_REVISION
+#define CEPCUIBench_REVISION "unknown"
+#endif /* CEPCUIBench_REVISION */
+
+
+/**
+ * Table name of the benchmark, which is the same as the application
+ */
+#ifndef CEPCUIBench_TABLE_NAME
+#define CEPCUIBench_TABLE_NAME "cep_test"
+#endif /* CEPCUIBench_TABLE_NAME */
+
+
+/**
+ * CREATE TABLE statement of the "date,name,value" schema
+ */
+#ifndef CEPCUIBench_CREATE_TABLE
+#define CEPCUIBench_CREATE_TABLE "CREATE TABLE cep_test (date DATETIME, name TEXT, value DOUBLE)"
+#endif /* CEPCUIBench_CREATE_TABLE */
+
+
+/**
+ * PRAGMA statements applied to the memory database (same as the application)
+ */
+#ifndef CEPCUIBench_PRAGMA
+#define CEPCUIBench_PRAGMA "PRAGMA journal_mode=OFF;PRAGMA synchronous=OFF;PRAGMA temp_store=MEMORY;PRAGMA locking_mode=EXCLUSIVE;PRAGMA cache_size=-65536;"
+#endif /* CEPCUIBench_PRAGMA */
+
+
+/**
+ * Size of the input data inserted in one transaction (same as the application)[Byte]
+ */
+#ifndef CEPCUIBench_CHUNK_SIZE
+#define CEPCUIBench_CHUNK_SIZE 1048576
+#endif /* CEPCUIBench_CHUNK_SIZE */
+
+
+/**
+ * Size of the buffer for stepping query results[Byte]
+ */
+#ifndef CEPCUIBench_RESULT_BUFFER_LENGTH
+#define CEPCUIBench_RESULT_BUFFER_LENGTH 65536
+#endif /* CEPCUIBench_RESULT_BUFFER_LENGTH */
+
+
+/**
+ * Maximum number of values in a list option
+ */
+#ifndef CEPCUIBench_MAX_VALUE
+#define CEPCUIBench_MAX_VALUE 16
+#endif /* CEPCUIBench_MAX_VALUE */
+
+
+/**
+ * Default number of executions of each query
+ */
+#ifndef CEPCUIBench_DEFAULT_REPEAT
+#define CEPCUIBench_DEFAULT_REPEAT 20
+#endif /* CEPCUIBench_DEFAULT_REPEAT */
+
+
+/**
+ * Default seed of the synthetic records
+ */
+#ifndef CEPCUIBench_DEFAULT_SEED
+#define CEPCUIBench_DEFAULT_SEED 20140101
+#endif /* CEPCUIBench_DEFAULT_SEED */
+
+
+/**
+ * Query shape measured by the benchmark.<br>
+ */
+typedef struct
+	{
+	const char *name;
+	const char *sql;
+	} CEPCUIBenchQuery;
+
+
+/**
+ * Configuration of one benchmark run.<br>
+ */
+typedef struct
+	{
+	size_t rows;
+	size_t cardinality;
+	size_t repeat;
+	uint64_t seed;
+	const char *executable;
+	const char *directoryPath;
+	} CEPCUIBenchConfig;
+
+
+/**
+ * Result data which is copied out of the query.<br>
+ */
+typedef struct
+	{
+	M2MString *data;
+	size_t length;
+	size_t capacity;
+	} CEPCUIBenchResult;
+
+
+/**
+ * Names of the scanners of the tokenizer (in the order of CEPCUICSVScanner)
+ */
+static const char *SCANNER_NAME_LIST[] = {"convert-scalar", "convert-sse2", "convert-avx2"};
+
+
+/**
+ * Query shapes: aggregation per key, selective filter and top-N sort
+ */
+static const CEPCUIBenchQuery QUERY_LIST[] =
+	{
+	{"group", "SELECT name, AVG(value) AS avg, COUNT(*) AS count FROM cep_test GROUP BY name;"},
+	{"filter", "SELECT date, name, value FROM cep_test WHERE value>=990.0;"},
+	{"topn", "SELECT date, name, value FROM cep_test ORDER BY value DESC LIMIT 10;"}
+	};
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Run all the stages for the configuration and print their results.<br>
+ * Every stage is executed "repeat" times. This function is executed in a<br>
+ * child process, so that each configuration starts with a fresh heap.<br>
+ *
+ * @param[in] config	Configuration of the benchmark run
+ * @return				true : success, false : failure
+ */
+static bool this_benchmark (const CEPCUIBenchConfig *config);
+
+
+/**
+ * Compare the latencies for qsort().<br>
+ *
+ * @param[in] a	Latency
+ * @param[in] b	Latency
+ * @return		Negative, zero or positive value
+ */
+static int this_compare (const void *a, const void *b);
+
+
+/**
+ * Run the application in pipe mode on the input file as the end-to-end<br>
+ * stage, and print the result.<br>
+ *
+ * @param[in] config			Configuration of the benchmark run
+ * @param[in] query				Query shape
+ * @param[in] inputFilePath		Input file path string
+ * @param[out] latencyList		Array of "repeat" latencies for measuring the executions
+ */
+static void this_executeEndToEnd (const CEPCUIBenchConfig *config, const CEPCUIBenchQuery *query, const char *inputFilePath, double latencyList[]);
+
+
+/**
+ * Generate the synthetic "date,name,value" records.<br>
+ * The records only depend on the arguments, so that every run measures the<br>
+ * same data.<br>
+ *
+ * @param[in] rows			Number of records
+ * @param[in] cardinality	Number of distinct names
+ * @param[in] seed			Seed of the pseudo random numbers
+ * @param[out] length		Size of the records[Byte]
+ * @return					Records (allocated in this function) or NULL (in case of error)
+ */
+static M2MString *this_generate (const size_t rows, const size_t cardinality, const uint64_t seed, size_t *length);
+
+
+/**
+ * Get the elapsed time since the indicated time.<br>
+ *
+ * @param[in] start	Start time (CLOCK_MONOTONIC)
+ * @return			Elapsed time[sec]
+ */
+static double this_getElapsed (const struct timespec *start);
+
+
+/**
+ * Get the peak resident set size of this process since the last reset.<br>
+ *
+ * @param[in] reset	true : the peak was reset at the start of the stage, false : not reset
+ * @return			Peak resident set size[KiB] or -1 (in case of not reset or error)
+ */
+static long this_getPeakRSS (const bool reset);
+
+
+/**
+ * Open the memory database with the table, and create the inserter.<br>
+ *
+ * @param[out] inserter	Inserter (created in this function)
+ * @param[in] text		true : bind all the fields as text, false : bind with the column types
+ * @return				Memory database or NULL (in case of error)
+ */
+static sqlite3 *this_openDatabase (CEPCUIInserter **inserter, const bool text);
+
+
+/**
+ * Parse the comma separated list of numbers.<br>
+ *
+ * @param[in] string		Comma separated list string
+ * @param[out] valueList	Array for copying the numbers
+ * @return					Number of the numbers
+ */
+static size_t this_parseList (const char *string, size_t valueList[]);
+
+
+/**
+ * Print one line of the result in CSV format.<br>
+ *
+ * @param[in] config		Configuration of the benchmark run
+ * @param[in] query			Query shape name or "-"
+ * @param[in] stage			Stage name
+ * @param[in] records		Number of processed records
+ * @param[in] seconds		Total elapsed time[sec]
+ * @param[in,out] latencyList	Latencies[sec] (sorted in this function)
+ * @param[in] count			Number of the latencies
+ * @param[in] peakRSS		Peak resident set size of the stage[KiB] or -1
+ */
+static void this_print (const CEPCUIBenchConfig *config, const char *query, const char *stage, const size_t records, const double seconds, double latencyList[], const size_t count, const long peakRSS);
+
+
+/**
+ * Remove the directory and all the files in it.<br>
+ *
+ * @param[in] directoryPath	Directory path string
+ */
+static void this_removeDirectory (const char *directoryPath);
+
+
+/**
+ * Reset the peak resident set size of this process to the current one.<br>
+ *
+ * @return	true : success, false : not supported by the kernel
+ */
+static bool this_resetPeakRSS (void);
+
+
+/**
+ * Copy the chunk of the query result into the result data.<br>
+ *
+ * @param[in,out] argument	Result data
+ * @param[in] data			Chunk of CSV format result
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : failed to allocate heap memory
+ */
+static bool this_write (void *argument, const M2MString *data, const size_t dataLength);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Run all the stages for the configuration and print their results.<br>
+ * Every stage is executed "repeat" times. This function is executed in a<br>
+ * child process, so that each configuration starts with a fresh heap.<br>
+ *
+ * @param[in] config	Configuration of the benchmark run
+ * @return				true : success, false : failure
+ */
+static bool this_benchmark (const CEPCUIBenchConfig *config)
+	{
+	//========== Variable ==========
+	sqlite3 *database = NULL;
+	CEPCUIInserter *inserter = NULL;
+	CEPCUIQuerySet *querySet = NULL;
+	CEPCUIPublisher *publisher = NULL;
+	CEPCUICSVTokenizer tokenizer;
+	CEPCUICSVField FIELD[CEPCUIInserter_MAX_COLUMN];
+	CEPCUIBenchResult result;
+	M2MString *generated = NULL;
+	M2MString *data = NULL;
+	size_t length = 0;
+	size_t position = 0;
+	size_t records = 0;
+	size_t parsed = 0;
+	size_t i = 0;
+	size_t j = 0;
+	double value = 0;
+	ssize_t received = 0;
+	int64_t inserted = 0;
+	int64_t matched = 0;
+	int fd = -1;
+	FILE *file = NULL;
+	double *latencyList = NULL;
+	bool reset = false;
+	struct timespec start;
+	struct timespec total;
+	char INPUT_FILE_PATH[PATH_MAX];
+	char QUERY_DIRECTORY_PATH[PATH_MAX];
+	char FILE_PATH[PATH_MAX];
+	M2MString BUFFER[CEPCUIBench_RESULT_BUFFER_LENGTH];
+	const size_t QUERY_COUNT = sizeof(QUERY_LIST) / sizeof(QUERY_LIST[0]);
+
+	//===== Generate the input file (not measured) =====
+	snprintf(INPUT_FILE_PATH, sizeof(INPUT_FILE_PATH), "%s/input.csv", config->directoryPath);
+	if ((generated=this_generate(config->rows, config->cardinality, config->seed, &length))==NULL
+			|| (file=fopen(INPUT_FILE_PATH, "w"))==NULL
+			|| fwrite(generated, 1, length, file)!=length
+			|| fclose(file)!=0)
+		{
+		fprintf(stderr, "Failed to generate the input file(=\"%s\")\n", INPUT_FILE_PATH);
+		M2MHeap_free(generated);
+		return false;
+		}
+	M2MHeap_free(generated);
+	if ((data=(M2MString *)M2MHeap_malloc(length+1))==NULL
+			|| (latencyList=(double *)M2MHeap_malloc(sizeof(double)*config->repeat))==NULL)
+		{
+		fprintf(stderr, "Failed to allocate heap memory for the benchmark\n");
+		M2MHeap_free(data);
+		return false;
+		}
+	//===== Read =====
+	reset = this_resetPeakRSS();
+	clock_gettime(CLOCK_MONOTONIC, &total);
+	for (j=0; j<config->repeat; j++)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if ((fd=open(INPUT_FILE_PATH, O_RDONLY))<0)
+			{
+			fprintf(stderr, "Failed to read the input file(=\"%s\")\n", INPUT_FILE_PATH);
+			M2MHeap_free(data);
+			M2MHeap_free(latencyList);
+			return false;
+			}
+		for (position=0; position<length && (received=read(fd, &data[position], length-position))>0;)
+			{
+			position += (size_t)received;
+			}
+		close(fd);
+		latencyList[j] = this_getElapsed(&start);
+		}
+	data[length] = '\0';
+	this_print(config, "-", "read", config->rows * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+	//===== Convert =====
+	reset = this_resetPeakRSS();
+	clock_gettime(CLOCK_MONOTONIC, &total);
+	for (j=0; j<config->repeat; j++)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		CEPCUICSVTokenizer_init(&tokenizer, data, length);
+		for (records=0; CEPCUICSVTokenizer_next(&tokenizer, FIELD, CEPCUIInserter_MAX_COLUMN)>0; records++)
+			{
+			}
+		latencyList[j] = this_getElapsed(&start);
+		}
+	this_print(config, "-", "convert", records * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+	//===== Convert with each scanner supported by the CPU =====
+	for (i=CEPCUICSVScanner_SCALAR; i<=CEPCUICSVScanner_AVX2; i++)
+		{
+		CEPCUICSVTokenizer_init(&tokenizer, data, length);
+		if (CEPCUICSVTokenizer_setScanner(&tokenizer, (CEPCUICSVScanner)i)==(CEPCUICSVScanner)i)
+			{
+			reset = this_resetPeakRSS();
+			clock_gettime(CLOCK_MONOTONIC, &total);
+			for (j=0; j<config->repeat; j++)
+				{
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				CEPCUICSVTokenizer_init(&tokenizer, data, length);
+				CEPCUICSVTokenizer_setScanner(&tokenizer, (CEPCUICSVScanner)i);
+				for (records=0; CEPCUICSVTokenizer_next(&tokenizer, FIELD, CEPCUIInserter_MAX_COLUMN)>0; records++)
+					{
+					}
+				latencyList[j] = this_getElapsed(&start);
+				}
+			this_print(config, "-", SCANNER_NAME_LIST[i], records * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+			}
+		}
+	//===== Parse the "value" column (with the fast path and with strtod()) =====
+	reset = this_resetPeakRSS();
+	clock_gettime(CLOCK_MONOTONIC, &total);
+	for (j=0; j<config->repeat; j++)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		CEPCUICSVTokenizer_init(&tokenizer, data, length);
+		for (parsed=0; CEPCUICSVTokenizer_next(&tokenizer, FIELD, CEPCUIInserter_MAX_COLUMN)>2;)
+			{
+			parsed += (CEPCUICSVTokenizer_parseDouble(&tokenizer, &FIELD[2], &value)==true) ? 1 : 0;
+			}
+		latencyList[j] = this_getElapsed(&start);
+		}
+	this_print(config, "-", "parse", parsed * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+	reset = this_resetPeakRSS();
+	clock_gettime(CLOCK_MONOTONIC, &total);
+	for (j=0; j<config->repeat; j++)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		CEPCUICSVTokenizer_init(&tokenizer, data, length);
+		for (parsed=0; CEPCUICSVTokenizer_next(&tokenizer, FIELD, CEPCUIInserter_MAX_COLUMN)>2;)
+			{
+			// the buffer is NULL terminated, and strtod() stops at the delimiter
+			value = strtod((const char *)&data[FIELD[2].offset], NULL);
+			parsed++;
+			}
+		latencyList[j] = this_getElapsed(&start);
+		}
+	this_print(config, "-", "parse-strtod", parsed * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+	//===== Insert all the fields as text (converted by SQLite3), then insert =====
+	for (i=0; i<2; i++)
+		{
+		reset = this_resetPeakRSS();
+		clock_gettime(CLOCK_MONOTONIC, &total);
+		for (j=0; j<config->repeat; j++)
+			{
+			// every execution inserts into an empty memory database, and the last one of "insert" is queried
+			CEPCUIInserter_delete(&inserter);
+			sqlite3_close(database);
+			if ((database=this_openDatabase(&inserter, (i==0) ? true : false))==NULL)
+				{
+				fprintf(stderr, "Failed to create the memory database\n");
+				M2MHeap_free(data);
+				M2MHeap_free(latencyList);
+				return false;
+				}
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			CEPCUICSVTokenizer_init(&tokenizer, data, length);
+			for (records=0; tokenizer.position<length && (inserted=CEPCUIInserter_insertCSV(inserter, &tokenizer, CEPCUIBench_CHUNK_SIZE))>=0; records+=(size_t)inserted)
+				{
+				}
+			latencyList[j] = this_getElapsed(&start);
+			}
+		this_print(config, "-", (i==0) ? "insert-text" : "insert", records * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+		}
+	M2MHeap_free(data);
+	//===== Prepare the queries =====
+	snprintf(QUERY_DIRECTORY_PATH, sizeof(QUERY_DIRECTORY_PATH), "%s/queries", config->directoryPath);
+	mkdir(QUERY_DIRECTORY_PATH, 0755);
+	for (i=0; i<QUERY_COUNT; i++)
+		{
+		if (snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/%s.sql", QUERY_DIRECTORY_PATH, QUERY_LIST[i].name)<(int)sizeof(FILE_PATH)
+				&& (file=fopen(FILE_PATH, "w"))!=NULL)
+			{
+			fputs(QUERY_LIST[i].sql, file);
+			fclose(file);
+			}
+		}
+	if ((querySet=CEPCUIQuerySet_new((M2MString *)config->directoryPath))==NULL
+			|| CEPCUIQuerySet_prepare(querySet, database)==NULL)
+		{
+		fprintf(stderr, "Failed to prepare the queries\n");
+		M2MHeap_free(latencyList);
+		CEPCUIQuerySet_delete(&querySet);
+		CEPCUIInserter_delete(&inserter);
+		sqlite3_close(database);
+		return false;
+		}
+	memset(&result, 0, sizeof(result));
+	snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/results", config->directoryPath);
+	mkdir(FILE_PATH, 0755);
+	for (i=0; i<querySet->count; i++)
+		{
+		//===== Select =====
+		reset = this_resetPeakRSS();
+		clock_gettime(CLOCK_MONOTONIC, &total);
+		for (j=0; j<config->repeat; j++)
+			{
+			result.length = 0;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			matched = CEPCUIQuerySet_selectEach(querySet, i, BUFFER, sizeof(BUFFER), this_write, &result);
+			latencyList[j] = this_getElapsed(&start);
+			}
+		this_print(config, (char *)querySet->queryList[i].name, "select", (matched>0) ? (size_t)matched * config->repeat : 0, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+		//===== Write =====
+		snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/results/%s", config->directoryPath, querySet->queryList[i].name);
+		if (result.length>0 && (publisher=CEPCUIPublisher_new((M2MString *)FILE_PATH, 2))!=NULL)
+			{
+			CEPCUIPublisher_setRotation(publisher, true);
+			reset = this_resetPeakRSS();
+			clock_gettime(CLOCK_MONOTONIC, &total);
+			for (j=0; j<config->repeat; j++)
+				{
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				CEPCUIPublisher_publish(publisher, result.data, result.length);
+				latencyList[j] = this_getElapsed(&start);
+				}
+			this_print(config, (char *)querySet->queryList[i].name, "write", (size_t)matched * config->repeat, this_getElapsed(&total), latencyList, config->repeat, this_getPeakRSS(reset));
+			CEPCUIPublisher_delete(&publisher);
+			}
+		}
+	M2MHeap_free(result.data);
+	CEPCUIQuerySet_delete(&querySet);
+	CEPCUIInserter_delete(&inserter);
+	sqlite3_close(database);
+	//===== End to end =====
+	if (config->executable!=NULL)
+		{
+		for (i=0; i<QUERY_COUNT; i++)
+			{
+			this_executeEndToEnd(config, &QUERY_LIST[i], INPUT_FILE_PATH, latencyList);
+			}
+		}
+	M2MHeap_free(latencyList);
+	return true;
+	}
+
+
+/**
+ * Compare the latencies for qsort().<br>
+ *
+ * @param[in] a	Latency
+ * @param[in] b	Latency
+ * @return		Negative, zero or positive value
+ */
+static int this_compare (const void *a, const void *b)
+	{
+	return ((*(const double *)a) > (*(const double *)b)) - ((*(const double *)a) < (*(const double *)b));
+	}
+
+
+/**
+ * Run the application in pipe mode on the input file as the end-to-end<br>
+ * stage, and print the result.<br>
+ * The application gets a home directory of its own with the query, reads<br>
+ * all the records as one micro-batch and writes the result to /dev/null.<br>
+ * The peak RSS is the largest one of the application processes.<br>
+ *
+ * @param[in] config			Configuration of the benchmark run
+ * @param[in] query				Query shape
+ * @param[in] inputFilePath		Input file path string
+ * @param[out] latencyList		Array of "repeat" latencies for measuring the executions
+ */
+static void this_executeEndToEnd (const CEPCUIBenchConfig *config, const CEPCUIBenchQuery *query, const char *inputFilePath, double latencyList[])
+	{
+	//========== Variable ==========
+	pid_t pid = 0;
+	int status = 0;
+	int input = -1;
+	int output = -1;
+	size_t j = 0;
+	long peakRSS = 0;
+	FILE *file = NULL;
+	struct rusage usage;
+	struct timespec start;
+	struct timespec total;
+	char HOME_PATH[PATH_MAX];
+	char FILE_PATH[PATH_MAX];
+	char RECORD[64];
+
+	//===== Prepare the home directory =====
+	if (snprintf(HOME_PATH, sizeof(HOME_PATH), "%s/home", config->directoryPath)>=(int)sizeof(HOME_PATH))
+		{
+		fprintf(stderr, "Path of the home directory is too long\n");
+		return;
+		}
+	this_removeDirectory(HOME_PATH);
+	if (mkdir(HOME_PATH, 0755)!=0
+			|| snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/.m2m", HOME_PATH)>=(int)sizeof(FILE_PATH)
+			|| mkdir(FILE_PATH, 0755)!=0
+			|| snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/.m2m/cep", HOME_PATH)>=(int)sizeof(FILE_PATH)
+			|| mkdir(FILE_PATH, 0755)!=0
+			|| snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/.m2m/cep/select.sql", HOME_PATH)>=(int)sizeof(FILE_PATH)
+			|| (file=fopen(FILE_PATH, "w"))==NULL)
+		{
+		fprintf(stderr, "Failed to prepare the home directory(=\"%s\")\n", HOME_PATH);
+		this_removeDirectory(HOME_PATH);
+		return;
+		}
+	fputs(query->sql, file);
+	fclose(file);
+	snprintf(RECORD, sizeof(RECORD), "%zu", config->rows);
+	//===== Run the application =====
+	clock_gettime(CLOCK_MONOTONIC, &total);
+	for (j=0; j<config->repeat; j++)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if ((pid=fork())==0)
+			{
+			if ((input=open(inputFilePath, O_RDONLY))<0 || (output=open("/dev/null", O_WRONLY))<0)
+				{
+				_exit(127);
+				}
+			dup2(input, STDIN_FILENO);
+			dup2(output, STDOUT_FILENO);
+			dup2(output, STDERR_FILENO);
+			setenv("HOME", HOME_PATH, 1);
+			snprintf(FILE_PATH, sizeof(FILE_PATH), "--pipe-rows=%zu", config->rows);
+			execl(config->executable, config->executable, "--pipe", FILE_PATH, "0", RECORD, (char *)NULL);
+			_exit(127);
+			}
+		else if (pid>0 && wait4(pid, &status, 0, &usage)==pid && WIFEXITED(status) && WEXITSTATUS(status)==0)
+			{
+			latencyList[j] = this_getElapsed(&start);
+			peakRSS = (usage.ru_maxrss>peakRSS) ? usage.ru_maxrss : peakRSS;
+			}
+		else
+			{
+			fprintf(stderr, "Failed to run the application(=\"%s\")\n", config->executable);
+			this_removeDirectory(HOME_PATH);
+			return;
+			}
+		}
+	this_print(config, query->name, "e2e", config->rows * config->repeat, this_getElapsed(&total), latencyList, config->repeat, peakRSS);
+	this_removeDirectory(HOME_PATH);
+	return;
+	}
+
+
+/**
+ * Generate the synthetic "date,name,value" records.<br>
+ * The records only depend on the arguments, so that every run measures the<br>
+ * same data. The dates advance by one second from 2014-01-01, the names are<br>
+ * "n0" to "n<cardinality-1>" and the values are uniform in [0, 1000).<br>
+ *
+ * @param[in] rows			Number of records
+ * @param[in] cardinality	Number of distinct names
+ * @param[in] seed			Seed of the pseudo random numbers
+ * @param[out] length		Size of the records[Byte]
+ * @return					Records (allocated in this function) or NULL (in case of error)
+ */
+static M2MString *this_generate (const size_t rows, const size_t cardinality, const uint64_t seed, size_t *length)
+	{
+	//========== Variable ==========
+	M2MString *data = NULL;
+	size_t i = 0;
+	uint64_t state = (seed!=0) ? seed : 1;
+	time_t date = 1388534400;
+	struct tm calendar;
+	char DATE[32];
+	const size_t RECORD_LENGTH = 64;
+
+	//===== Allocate the buffer =====
+	if ((data=(M2MString *)M2MHeap_malloc(rows*RECORD_LENGTH+1))==NULL)
+		{
+		return NULL;
+		}
+	(*length) = 0;
+	for (i=0; i<rows; i++, date++)
+		{
+		//===== xorshift64* =====
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		gmtime_r(&date, &calendar);
+		strftime(DATE, sizeof(DATE), "%Y-%m-%d %H:%M:%S", &calendar);
+		(*length) += (size_t)snprintf((char *)&data[(*length)], RECORD_LENGTH, "%s,n%zu,%.2f\n", DATE, (size_t)((state * 2685821657736338717ULL) >> 32) % cardinality, (double)((state * 2685821657736338717ULL) % 100000) / 100.0);
+		}
+	return data;
+	}
+
+
+/**
+ * Get the elapsed time since the indicated time.<br>
+ *
+ * @param[in] start	Start time (CLOCK_MONOTONIC)
+ * @return			Elapsed time[sec]
+ */
+static double this_getElapsed (const struct timespec *start)
+	{
+	//========== Variable ==========
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+	}
+
+
+/**
+ * Get the peak resident set size of this process since the last reset.<br>
+ * It is "VmHWM" of /proc/self/status, so that it is the peak of the stage<br>
+ * only if this_resetPeakRSS() succeeded at the start of the stage.<br>
+ *
+ * @param[in] reset	true : the peak was reset at the start of the stage, false : not reset
+ * @return			Peak resident set size[KiB] or -1 (in case of not reset or error)
+ */
+static long this_getPeakRSS (const bool reset)
+	{
+	//========== Variable ==========
+	FILE *file = NULL;
+	long peakRSS = -1;
+	char LINE[256];
+
+	//===== Check argument =====
+	if (reset==true && (file=fopen("/proc/self/status", "r"))!=NULL)
+		{
+		while (fgets(LINE, sizeof(LINE), file)!=NULL)
+			{
+			if (sscanf(LINE, "VmHWM: %ld kB", &peakRSS)==1)
+				{
+				break;
+				}
+			}
+		fclose(file);
+		}
+	return peakRSS;
+	}
+
+
+/**
+ * Open the memory database with the table, and create the inserter.<br>
+ * The PRAGMA statements are the same as the application.<br>
+ *
+ * @param[out] inserter	Inserter (created in this function)
+ * @param[in] text		true : bind all the fields as text, false : bind with the column types
+ * @return				Memory database or NULL (in case of error)
+ */
+static sqlite3 *this_openDatabase (CEPCUIInserter **inserter, const bool text)
+	{
+	//========== Variable ==========
+	sqlite3 *database = NULL;
+	size_t i = 0;
+
+	//===== Create the table and the inserter =====
+	if (sqlite3_open(":memory:", &database)!=SQLITE_OK
+			|| sqlite3_exec(database, CEPCUIBench_PRAGMA, NULL, NULL, NULL)!=SQLITE_OK
+			|| sqlite3_exec(database, CEPCUIBench_CREATE_TABLE, NULL, NULL, NULL)!=SQLITE_OK
+			|| ((*inserter)=CEPCUIInserter_new(database, (M2MString *)CEPCUIBench_TABLE_NAME, 0))==NULL)
+		{
+		sqlite3_close(database);
+		return NULL;
+		}
+	for (i=0; text==true && i<(*inserter)->columnCount; i++)
+		{
+		(*inserter)->fieldTypeList[i] = CEPCUIFieldType_TEXT;
+		}
+	return database;
+	}
+
+
+/**
+ * Parse the comma separated list of numbers.<br>
+ *
+ * @param[in] string		Comma separated list string
+ * @param[out] valueList	Array for copying the numbers
+ * @return					Number of the numbers
+ */
+static size_t this_parseList (const char *string, size_t valueList[])
+	{
+	//========== Variable ==========
+	char *end = NULL;
+	size_t count = 0;
+
+	//===== Parse the numbers =====
+	while (count<CEPCUIBench_MAX_VALUE && string!=NULL && (*string)!='\0')
+		{
+		if ((valueList[count]=(size_t)strtoull(string, &end, 10))>0)
+			{
+			count++;
+			}
+		string = ((*end)==',') ? end + 1 : NULL;
+		}
+	return count;
+	}
+
+
+/**
+ * Print one line of the result in CSV format.<br>
+ * The percentiles are of the nearest rank.<br>
+ *
+ * @param[in] config		Configuration of the benchmark run
+ * @param[in] query			Query shape name or "-"
+ * @param[in] stage			Stage name
+ * @param[in] records		Number of processed records
+ * @param[in] seconds		Total elapsed time[sec]
+ * @param[in,out] latencyList	Latencies[sec] (sorted in this function)
+ * @param[in] count			Number of the latencies
+ * @param[in] peakRSS		Peak resident set size of the stage[KiB] or -1
+ */
+static void this_print (const CEPCUIBenchConfig *config, const char *query, const char *stage, const size_t records, const double seconds, double latencyList[], const size_t count, const long peakRSS)
+	{
+	//===== Sort the latencies =====
+	qsort(latencyList, count, sizeof(double), this_compare);
+	//===== Print the percentiles =====
+	printf("%s,%s,%zu,%zu,%s,%s,%zu,%.6f,%.0f,%.3f,%.3f,%.3f,%.3f,%ld\n", CEPCUIBench_REVISION, sqlite3_libversion(), config->rows, config->cardinality, query, stage, records, seconds, (seconds>0) ? (double)records / seconds : 0.0, latencyList[(count-1)/2] * 1e3, latencyList[(count*9-1)/10] * 1e3, latencyList[(count*99-1)/100] * 1e3, latencyList[count-1] * 1e3, peakRSS);
+	fflush(stdout);
+	return;
+	}
+
+
+/**
+ * Remove the directory and all the files in it.<br>
+ *
+ * @param[in] directoryPath	Directory path string
+ */
+static void this_removeDirectory (const char *directoryPath)
+	{
+	//========== Variable ==========
+	DIR *directory = NULL;
+	struct dirent *entry = NULL;
+	struct stat status;
+	char FILE_PATH[PATH_MAX];
+
+	//===== Remove the entries =====
+	if ((directory=opendir(directoryPath))!=NULL)
+		{
+		while ((entry=readdir(directory))!=NULL)
+			{
+			if (strcmp(entry->d_name, ".")==0 || strcmp(entry->d_name, "..")==0)
+				{
+				continue;
+				}
+			snprintf(FILE_PATH, sizeof(FILE_PATH), "%s/%s", directoryPath, entry->d_name);
+			if (lstat(FILE_PATH, &status)==0 && S_ISDIR(status.st_mode))
+				{
+				this_removeDirectory(FILE_PATH);
+				}
+			else
+				{
+				unlink(FILE_PATH);
+				}
+			}
+		closedir(directory);
+		rmdir(directoryPath);
+		}
+	return;
+	}
+
+
+/**
+ * Reset the peak resident set size of this process to the current one.<br>
+ * Writing "5" to /proc/self/clear_refs resets "VmHWM" (since Linux 4.0).<br>
+ *
+ * @return	true : success, false : not supported by the kernel
+ */
+static bool this_resetPeakRSS (void)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	bool reset = false;
+
+	//===== Reset the high water mark =====
+	if ((fd=open("/proc/self/clear_refs", O_WRONLY))>=0)
+		{
+		reset = (write(fd, "5", 1)==1) ? true : false;
+		close(fd);
+		}
+	return reset;
+	}
+
+
+/**
+ * Copy the chunk of the query result into the result data.<br>
+ *
+ * @param[in,out] argument	Result data
+ * @param[in] data			Chunk of CSV format result
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : failed to allocate heap memory
+ */
+static bool this_write (void *argument, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	CEPCUIBenchResult *result = (CEPCUIBenchResult *)argument;
+	M2MString *enlarged = NULL;
+
+	//===== Enlarge the buffer =====
+	if (result->capacity-result->length<dataLength)
+		{
+		if ((enlarged=(M2MString *)M2MHeap_malloc(result->capacity*2+dataLength))==NULL)
+			{
+			return false;
+			}
+		if (result->data!=NULL)
+			{
+			memcpy(enlarged, result->data, result->length);
+			M2MHeap_free(result->data);
+			}
+		result->data = enlarged;
+		result->capacity = result->capacity * 2 + dataLength;
+		}
+	memcpy(&result->data[result->length], data, dataLength);
+	result->length += dataLength;
+	return true;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Benchmark of the stages of the application on synthetic records.<br>
+ * For every combination of the numbers of records and names, the records<br>
+ * of the "date,name,value" schema are generated with a fixed seed, and<br>
+ * the following stages are measured in a child process:<br>
+ *<br>
+ * read : Read the input file into memory (from the page cache)<br>
+ * convert : Tokenize the CSV format records<br>
+ * convert-scalar, convert-sse2, convert-avx2 : Tokenize with each scanner supported by the CPU<br>
+ * parse, parse-strtod : Tokenize and convert the "value" column with the fast path, or with strtod()<br>
+ * insert-text : Insert the records with all the fields bound as text (converted by SQLite3)<br>
+ * insert : Insert the records into the memory database<br>
+ * select : Execute each query shape ("group", "filter" and "topn")<br>
+ * write : Publish the result of each query shape as a file<br>
+ * e2e : Run the application in pipe mode on the input file (with "--executable")<br>
+ *<br>
+ * The results are printed in CSV format with a header line, one line per<br>
+ * stage (and query shape). Every stage is executed "repeat" times.<br>
+ * "records" is the number of input records, or of result records for<br>
+ * "select" and "write", summed over the executions. "latency" columns are<br>
+ * the percentiles of the executions in milliseconds. "stage_peak_rss_kb"<br>
+ * is the peak RSS of the process during the stage, which includes the<br>
+ * memory held from the earlier stages (-1 if the kernel can't reset the<br>
+ * peak), and the largest peak RSS of the application processes for "e2e".<br>
+ *<br>
+ * [Usage]<br>
+ * cepcui_bench.exe [--rows=N,...] [--cardinality=N,...] [--repeat=N] [--seed=N] [--executable=PATH]<br>
+ *
+ * @param[in] argc	Number of arguments
+ * @param[in] argv	Options
+ * @return			0 : success, 1 : failure
+ */
+int main (int argc, char **argv)
+	{
+	//========== Variable ==========
+	CEPCUIBenchConfig config = {0, 0, CEPCUIBench_DEFAULT_REPEAT, CEPCUIBench_DEFAULT_SEED, NULL, NULL};	// Configuration of a run
+	size_t ROW_LIST[CEPCUIBench_MAX_VALUE] = {10000, 100000};		// Numbers of records
+	size_t CARDINALITY_LIST[CEPCUIBench_MAX_VALUE] = {10, 1000};	// Numbers of names
+	size_t rowCount = 2;											// Number of the numbers of records
+	size_t cardinalityCount = 2;									// Number of the numbers of names
+	size_t i = 0;
+	size_t j = 0;
+	int character = 0;
+	int status = 0;
+	int failure = 0;
+	pid_t pid = 0;
+	char DIRECTORY_PATH[] = "/tmp/cepcui_bench.XXXXXX";
+	const struct option OPTIONS[] =
+		{
+		{"rows", required_argument, NULL, 'n'},
+		{"cardinality", required_argument, NULL, 'c'},
+		{"repeat", required_argument, NULL, 'r'},
+		{"seed", required_argument, NULL, 's'},
+		{"executable", required_argument, NULL, 'e'},
+		{NULL, 0, NULL, 0}
+		};
+
+	//===== Get options =====
+	while ((character=getopt_long(argc, argv, "n:c:r:s:e:", OPTIONS, NULL))!=-1)
+		{
+		if (character=='n')
+			{
+			rowCount = this_parseList(optarg, ROW_LIST);
+			}
+		else if (character=='c')
+			{
+			cardinalityCount = this_parseList(optarg, CARDINALITY_LIST);
+			}
+		else if (character=='r')
+			{
+			config.repeat = ((config.repeat=(size_t)strtoull(optarg, NULL, 10))>0) ? config.repeat : CEPCUIBench_DEFAULT_REPEAT;
+			}
+		else if (character=='s')
+			{
+			config.seed = (uint64_t)strtoull(optarg, NULL, 10);
+			}
+		else if (character=='e')
+			{
+			config.executable = (access(optarg, X_OK)==0) ? optarg : NULL;
+			}
+		else
+			{
+			fprintf(stderr, "Usage: %s [--rows=N,...] [--cardinality=N,...] [--repeat=N] [--seed=N] [--executable=PATH]\n", argv[0]);
+			return 1;
+			}
+		}
+	if (mkdtemp(DIRECTORY_PATH)==NULL)
+		{
+		fprintf(stderr, "Failed to create the working directory\n");
+		return 1;
+		}
+	config.directoryPath = DIRECTORY_PATH;
+	printf("revision,sqlite,rows,cardinality,query,stage,records,seconds,rows_per_second,latency_p50_ms,latency_p90_ms,latency_p99_ms,latency_max_ms,stage_peak_rss_kb\n");
+	fflush(stdout);
+	//===== Run each configuration in a child process =====
+	for (i=0; i<rowCount; i++)
+		{
+		for (j=0; j<cardinalityCount; j++)
+			{
+			config.rows = ROW_LIST[i];
+			config.cardinality = CARDINALITY_LIST[j];
+			if ((pid=fork())==0)
+				{
+				_exit((this_benchmark(&config)==true) ? 0 : 1);
+				}
+			else if (pid<0 || waitpid(pid, &status, 0)!=pid || WIFEXITED(status)==0 || WEXITSTATUS(status)!=0)
+				{
+				failure = 1;
+				}
+			}
+		}
+	this_removeDirectory(DIRECTORY_PATH);
+	return failure;
+	}
+
+
+
+/* End Of File */
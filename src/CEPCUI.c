@@ -27,6 +27,21 @@
  * POSSIBILITY OF SUCH DAMAGE.
  ******************************************************************************/
 
+#include "CEPCUIArena.h"
+#include "CEPCUIBinaryReader.h"
+#include "CEPCUIInserter.h"
+#include "CEPCUILog.h"
+#include "CEPCUIMetrics.h"
+#include "CEPCUIPublisher.h"
+#include "CEPCUIQuerySet.h"
+#include "CEPCUIQueue.h"
+#include "CEPCUIRing.h"
+#include "CEPCUIScheduler.h"
+#include "CEPCUISchema.h"
+#include "CEPCUIServer.h"
+#include "CEPCUIShardSet.h"
+#include "CEPCUISnapshot.h"
+#include "CEPCUISpool.h"
 #include "m2m/cep/M2MCEP.h"
 #include "m2m/lib/db/M2MColumnList.h"
 #include "m2m/lib/db/M2MSQLiteDataType.h"
@@ -34,24 +49,567 @@
 #include "m2m/lib/io/M2MHeap.h"
 #include "m2m/lib/lang/M2MString.h"
 #include "m2m/lib/log/M2MFileAppender.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Name of the input file in the regulation directory
+ */
+#ifndef CEPCUI_INPUT_FILE_NAME
+#define CEPCUI_INPUT_FILE_NAME (M2MString *)"input.csv"
+#endif /* CEPCUI_INPUT_FILE_NAME */
+
+
+/**
+ * Name of the binary input file in the regulation directory
+ */
+#ifndef CEPCUI_BINARY_INPUT_FILE_NAME
+#define CEPCUI_BINARY_INPUT_FILE_NAME (M2MString *)"input.bin"
+#endif /* CEPCUI_BINARY_INPUT_FILE_NAME */
+
+
+/**
+ * Extension of the binary input files (other input files are read as CSV)
+ */
+#ifndef CEPCUI_BINARY_FILE_EXTENSION
+#define CEPCUI_BINARY_FILE_EXTENSION (M2MString *)".bin"
+#endif /* CEPCUI_BINARY_FILE_EXTENSION */
+
+
+/**
+ * Name of the output file in the regulation directory
+ */
+#ifndef CEPCUI_OUTPUT_FILE_NAME
+#define CEPCUI_OUTPUT_FILE_NAME (M2MString *)"output.csv"
+#endif /* CEPCUI_OUTPUT_FILE_NAME */
+
+
+/**
+ * Prefix of the output file names of named queries ("output.<name>.csv")
+ */
+#ifndef CEPCUI_OUTPUT_FILE_PREFIX
+#define CEPCUI_OUTPUT_FILE_PREFIX (M2MString *)"output."
+#endif /* CEPCUI_OUTPUT_FILE_PREFIX */
+
+
+/**
+ * Name of the directory of rotated result files in the regulation directory
+ */
+#ifndef CEPCUI_RESULT_DIRECTORY_NAME
+#define CEPCUI_RESULT_DIRECTORY_NAME (M2MString *)"results"
+#endif /* CEPCUI_RESULT_DIRECTORY_NAME */
+
+
+/**
+ * Name of the stop file in the regulation directory
+ */
+#ifndef CEPCUI_STOP_FILE_NAME
+#define CEPCUI_STOP_FILE_NAME (M2MString *)"cepcui.stop"
+#endif /* CEPCUI_STOP_FILE_NAME */
+
+
+/**
+ * Default sleep time[usec] of the loop processing
+ */
+#ifndef CEPCUI_DEFAULT_SLEEP_TIME
+#define CEPCUI_DEFAULT_SLEEP_TIME 15000000UL
+#endif /* CEPCUI_DEFAULT_SLEEP_TIME */
+
+
+
+/**
+ * Default size of the input data inserted in one transaction[Byte]
+ */
+#ifndef CEPCUI_DEFAULT_CHUNK_SIZE
+#define CEPCUI_DEFAULT_CHUNK_SIZE 1048576
+#endif /* CEPCUI_DEFAULT_CHUNK_SIZE */
+
+
+/**
+ * Size of the buffer through which a query result is streamed to its output[Byte]
+ */
+#ifndef CEPCUI_RESULT_BUFFER_LENGTH
+#define CEPCUI_RESULT_BUFFER_LENGTH 65536
+#endif /* CEPCUI_RESULT_BUFFER_LENGTH */
+
+
+/**
+ * Default number of records which closes a micro-batch in pipe mode
+ */
+#ifndef CEPCUI_DEFAULT_PIPE_RECORD
+#define CEPCUI_DEFAULT_PIPE_RECORD 1000
+#endif /* CEPCUI_DEFAULT_PIPE_RECORD */
+
+
+/**
+ * Default time[msec] after which a micro-batch is closed in pipe mode
+ */
+#ifndef CEPCUI_DEFAULT_PIPE_INTERVAL
+#define CEPCUI_DEFAULT_PIPE_INTERVAL 100
+#endif /* CEPCUI_DEFAULT_PIPE_INTERVAL */
+
+
+/**
+ * Size of the data read from stdin at once in pipe mode[Byte]
+ */
+#ifndef CEPCUI_PIPE_READ_LENGTH
+#define CEPCUI_PIPE_READ_LENGTH 65536
+#endif /* CEPCUI_PIPE_READ_LENGTH */
+
+
+/**
+ * Default file name of the Unix domain socket in server mode
+ */
+#ifndef CEPCUI_SOCKET_FILE_NAME
+#define CEPCUI_SOCKET_FILE_NAME "cepcui.sock"
+#endif /* CEPCUI_SOCKET_FILE_NAME */
+
+
+/**
+ * File name of the stats file rewritten periodically
+ */
+#ifndef CEPCUI_STATS_FILE_NAME
+#define CEPCUI_STATS_FILE_NAME "stats.txt"
+#endif /* CEPCUI_STATS_FILE_NAME */
+
+
+/**
+ * Number of input files (and results) buffered between the pipeline stages
+ */
+#ifndef CEPCUI_PIPELINE_DEPTH
+#define CEPCUI_PIPELINE_DEPTH 4
+#endif /* CEPCUI_PIPELINE_DEPTH */
+
+
+/**
+ * Maximum waiting time[usec] of the pipeline stages before checking whether<br>
+ * they should stop
+ */
+#ifndef CEPCUI_PIPELINE_POLL_TIME
+#define CEPCUI_PIPELINE_POLL_TIME 100000UL
+#endif /* CEPCUI_PIPELINE_POLL_TIME */
+
+
+/**
+ * PRAGMA statements applied to the memory database of CEP at startup.<br>
+ * The memory database is lost with the process anyway, so journaling and<br>
+ * syncing are disabled and the page cache is enlarged for bulk insertion.<br>
+ */
+#ifndef CEPCUI_MEMORY_DATABASE_PRAGMA
+#define CEPCUI_MEMORY_DATABASE_PRAGMA "PRAGMA journal_mode=OFF;PRAGMA synchronous=OFF;PRAGMA temp_store=MEMORY;PRAGMA locking_mode=EXCLUSIVE;PRAGMA cache_size=-65536;"
+#endif /* CEPCUI_MEMORY_DATABASE_PRAGMA */
+
+
+/**
+ * Default maximum number of accumulated records (same as CEP library)
+ */
+#ifndef CEPCUI_DEFAULT_MAX_RECORD
+#define CEPCUI_DEFAULT_MAX_RECORD 50
+#endif /* CEPCUI_DEFAULT_MAX_RECORD */
+
+
+/**
+ * Default name of the column by which the records are partitioned among shards
+ */
+#ifndef CEPCUI_DEFAULT_SHARD_KEY
+#define CEPCUI_DEFAULT_SHARD_KEY (M2MString *)"name"
+#endif /* CEPCUI_DEFAULT_SHARD_KEY */
+
+
+/**
+ * Default name of the time column of the time window
+ */
+#ifndef CEPCUI_DEFAULT_WINDOW_COLUMN
+#define CEPCUI_DEFAULT_WINDOW_COLUMN (M2MString *)"date"
+#endif /* CEPCUI_DEFAULT_WINDOW_COLUMN */
+
+
+/**
+ * Command line options of the application
+ */
+typedef struct
+	{
+	unsigned long sleepTime;
+	bool eventDriven;
+	bool spool;
+	bool coalesce;
+	unsigned int spoolDepth;
+	size_t chunkSize;
+	unsigned int maxRecord;
+	unsigned int batchRecord;
+	bool pipeline;
+	unsigned int shardCount;
+	const M2MString *shardKey;
+	unsigned int rotation;
+	bool pipe;
+	unsigned int pipeRecord;
+	unsigned long pipeInterval;
+	bool server;
+	const M2MString *socketPath;
+	bool ring;
+	const M2MString *ringName;
+	size_t ringCapacity;
+	unsigned int statsInterval;
+	unsigned short metricsPort;
+	bool incremental;
+	unsigned int windowTime;
+	const M2MString *windowColumn;
+	size_t windowMemory;
+	bool delta;
+	bool retract;
+	unsigned long minInterval;
+	unsigned long maxInterval;
+	unsigned int snapshotInterval;
+	} CEPCUIOption;
+
+
+/**
+ * Runtime context which lives as long as the CEP loop.<br>
+ * The file paths are resolved once before the loop, and the per-cycle<br>
+ * buffers (such as the merged results of the shards) are allocated in the<br>
+ * arena, which is reset at the beginning of every cycle.<br>
+ */
+typedef struct
+	{
+	M2MString directoryPath[PATH_MAX];
+	M2MString inputFilePath[PATH_MAX];
+	M2MString binaryInputFilePath[PATH_MAX];
+	M2MString stopFilePath[PATH_MAX];
+	CEPCUIArena *arena;
+	} CEPCUIContext;
+
+
+/**
+ * inotify watcher of the regulation directory (and spool and query directories)
+ */
+typedef struct
+	{
+	int fd;
+	int directory;
+	int incoming;
+	int queries;
+	} CEPCUIWatcher;
+
+
+/**
+ * Output destination of a query result.<br>
+ * In spool mode (or with rotation) the result is published by the publisher,<br>
+ * otherwise it is written to the output file in the regulation directory.<br>
+ */
+typedef struct
+	{
+	M2MString filePath[PATH_MAX];
+	CEPCUIPublisher *publisher;
+	} CEPCUIOutput;
+
+
+/**
+ * Input file mapped into memory (already removed from the directory).<br>
+ */
+typedef struct
+	{
+	M2MString filePath[PATH_MAX];
+	M2MString *data;
+	size_t length;
+	} CEPCUIBatch;
+
+
+/**
+ * Query result waiting to be written to its output destination.<br>
+ */
+typedef struct
+	{
+	CEPCUIOutput *output;
+	M2MString *result;
+	} CEPCUIResult;
+
+
+/**
+ * Output file to which a query result is being streamed.<br>
+ * The file is opened on the first chunk of the result, so nothing is<br>
+ * created for a query which matches no record.<br>
+ */
+typedef struct
+	{
+	const M2MCEP *cep;
+	CEPCUIOutput *output;
+	int fd;
+	M2MString temporaryFilePath[PATH_MAX];
+	} CEPCUIStream;
+
+
+/**
+ * Destination of the records received from the producers in server mode<br>
+ * or ring mode.<br>
+ */
+typedef struct
+	{
+	const M2MCEP *cep;
+	CEPCUIInserter *inserter;
+	CEPCUIShardSet *shardSet;
+	const CEPCUISchema *schema;
+	size_t chunkSize;
+	int64_t records;
+	} CEPCUIReceiver;
+
+
+/**
+ * Stages of the pipelined execution which run on their own threads.<br>
+ * The reading thread maps input files and passes them through batchQueue,<br>
+ * the main thread inserts them and executes the queries, and the writing<br>
+ * thread takes the results from resultQueue and publishes them.<br>
+ * The writing thread posts resultDrained when the last pending result is<br>
+ * written, so that the main thread can wait for it before a reload.<br>
+ */
+typedef struct
+	{
+	const M2MCEP *cep;
+	const CEPCUISchema *schema;
+	const CEPCUISpool *spool;
+	CEPCUIQueue *batchQueue;
+	CEPCUIQueue *resultQueue;
+	atomic_bool reading;
+	atomic_bool readerStopped;
+	atomic_bool writing;
+	atomic_size_t pendingResult;
+	sem_t resultDrained;
+	} CEPCUIPipeline;
+
 
 
 /*******************************************************************************
  * Declaration of private function
  ******************************************************************************/
 /**
- * 規程のディレクトリ配下に入力ファイルが存在するかどうか確認し、ファイルが存在<br>
- * する場合は当該ファイルのデータを読み取り、引数で指定されたポインタにコピー<br>
- * する。<br>
- * なお、入力ファイル名は同一であるため、データのコピーが済み次第、入力ファイル<br>
- * 自体は当該関数が削除する。<br>
+ * Close the temporary output file, and rename it into place if committed<br>
+ * (otherwise it is removed).<br>
+ *
+ * @param[in] cep					CEP object
+ * @param[in] fd					File descriptor of the temporary output file
+ * @param[in] temporaryFilePath		Temporary output file path string
+ * @param[in] filePath				Output file path string
+ * @param[in] commit				true : rename into place, false : discard
+ * @return							true : renamed, false : discarded or failure
+ */
+static bool this_closeResult (const M2MCEP *cep, const int fd, const M2MString *temporaryFilePath, const M2MString *filePath, const bool commit);
+
+
+/**
+ * Apply the PRAGMA statements for bulk insertion to the memory database.<br>
+ *
+ * @param[in] cep	CEP object
+ * @return			true : success, false : failure
+ */
+static bool this_configureMemoryDatabase (const M2MCEP *cep);
+
+
+/**
+ * Count the records of the result string (one per line after the header<br>
+ * line).<br>
+ *
+ * @param[in] result	Result string in CSV format
+ * @return				Number of records
+ */
+static uint64_t this_countRecords (const M2MString *result);
+
+
+/**
+ * Release the output destinations of the queries.<br>
+ *
+ * @param[in] querySet			Set of SELECT queries
+ * @param[in,out] outputList	Output destinations of the queries
+ */
+static void this_deleteOutputList (const CEPCUIQuerySet *querySet, CEPCUIOutput **outputList);
+
+
+/**
+ * Drain the input files in the spool directory in arrival order.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table (for binary input files)
+ * @param[in,out] querySet		Set of prepared SELECT queries
+ * @param[in,out] outputList	Output destinations of the queries
+ * @param[in] spool				Spool queue object
+ * @param[in] coalesce			true : insert all the pending files as one batch, false : one batch per file
+ * @param[in] chunkSize			Size of the buffer for records passed to CEP at once[Byte]
+ * @param[in,out] arena			Per-cycle arena
+ * @param[out] received			Set to true if any input file was inserted (kept otherwise)
+ * @return						true : more input files may be pending, false : incoming directory was drained (or outgoing directory is full)
+ */
+static bool this_drainSpool (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet *querySet, CEPCUIOutput outputList[], const CEPCUISpool *spool, const bool coalesce, const size_t chunkSize, CEPCUIArena *arena, bool *received);
+
+
+/**
+ * Execute all the queries on the CEP table and pass each result to the<br>
+ * writing thread of the pipeline.<br>
+ * Nothing is passed for a query which matches no record.<br>
+ *
+ * @param[in,out] pipeline		Pipeline object
+ * @param[in,out] querySet		Set of prepared SELECT queries
+ * @param[in,out] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in,out] outputList	Output destinations of the queries
+ * @return						Number of queries which matched records
+ */
+static size_t this_enqueueResult (CEPCUIPipeline *pipeline, CEPCUIQuerySet *querySet, CEPCUIShardSet *shardSet, CEPCUIOutput outputList[]);
+
+
+/**
+ * Repeat the CEP in pipe mode: CSV format records are read from stdin<br>
+ * continuously, and each micro-batch is inserted and queried as soon as it<br>
+ * has the indicated number of records or its first record has waited for<br>
+ * the indicated time. The results of all the queries are streamed to<br>
+ * stdout.<br>
+ * A record must not contain a line feed in pipe mode, since micro-batches<br>
+ * are split at line feeds. The records of one read are split into as many<br>
+ * micro-batches as needed, and stdin isn't read while a full micro-batch<br>
+ * is pending, so the buffer holds at most about one micro-batch and one<br>
+ * read. When stdin is closed, the rest of the records are processed before<br>
+ * returning; when stdout is closed, it returns at once.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executePipe (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher);
+
+
+/**
+ * Repeat the CEP in spool mode with the stages pipelined on three threads.<br>
+ * While the main thread inserts a batch and executes the queries, the next<br>
+ * input files are mapped and read ahead by the reading thread, and the<br>
+ * previous results are written by the writing thread.<br>
+ * When the stop file appears, the files already taken from the incoming<br>
+ * directory are still processed and written before returning.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] spool				Spool queue object
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executePipeline (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUISpool *spool, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher);
+
+
+/**
+ * Repeat the CEP in ring mode: producers on the same host write entries of<br>
+ * CSV format or binary records into the shared memory ring buffer, which<br>
+ * are inserted in place as soon as they are published. The queries are<br>
+ * executed after the published entries have been inserted, and their<br>
+ * results are written to the output files as usual; while the previous<br>
+ * results are not consumed yet, the records keep being inserted and the<br>
+ * queries wait.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table (used for binary records)
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executeRing (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher);
+
+
+/**
+ * Repeat the CEP in server mode: many producers connect to the Unix domain<br>
+ * socket and send length-framed batches of CSV format or binary records,<br>
+ * which are inserted as soon as they arrive. After every round of received<br>
+ * batches, the queries are executed and their results are sent to the<br>
+ * connections which subscribed to them (the queries are skipped while<br>
+ * there is no subscriber).<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table (used for binary records)
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executeServer (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher);
+
+
+/**
+ * Check whether any output file of the queries still exists in the<br>
+ * regulation directory (i.e. the consumer hasn't read it yet).<br>
+ * Rotated result files never block the CEP cycle.<br>
+ *
+ * @param[in] querySet		Set of SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @return					true : an output file exists, false : no output file exists
+ */
+static bool this_existsResult (const CEPCUIQuerySet *querySet, const CEPCUIOutput outputList[]);
+
+
+/**
+ * Insert the micro-batch of pipe mode into the CEP table and stream the<br>
+ * results of all the queries to stdout.<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[in] inserter		Inserter object of the CEP table
+ * @param[in] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in,out] querySet	Set of prepared SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @param[in] data			CSV format records of the micro-batch
+ * @param[in] length		Size of the records[Byte]
+ * @param[in] chunkSize		Size of the input data inserted in one transaction[Byte]
+ * @param[in,out] arena		Per-cycle arena (reset in this function)
+ * @return					true : success, false : stdout was closed
+ */
+static bool this_flushPipe (const M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, CEPCUIQuerySet *querySet, CEPCUIOutput outputList[], const M2MString *data, const size_t length, const size_t chunkSize, CEPCUIArena *arena);
+
+
+/**
+ * Get the regulation directory path.<br>
+ *
+ * @param[out] directoryPath		Buffer for copying the directory path string
+ * @param[in] directoryPathLength	Size of buffer[Byte]
+ * @return							Pointer of the buffer which the directory path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getDirectoryPath (M2MString directoryPath[], const size_t directoryPathLength);
+
+
+/**
+ * Get the binary input file path in the regulation directory.<br>
  *
- * @param[out] csv	CSV形式の入力データをコピーするためのポインタ(関数内部でヒープメモリを獲得する)
- * @return			コピーした入力データのポインタ or NULL(エラーの場合)
+ * @param[out] filePath			Buffer for copying the binary input file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @return						Pointer of the buffer which the binary input file path string was copied or NULL (in case of error)
  */
-static M2MString *this_getCSV (const M2MCEP *cep, M2MString **csv);
+static M2MString *this_getBinaryInputFilePath (M2MString filePath[], const size_t filePathLength);
 
 
 /**
@@ -69,479 +627,2630 @@ static M2MString *this_getInputFilePath (M2MString filePath[], const size_t file
  *
  * @param[out] filePath			出力ファイルパス文字列をコピーするためのバッファ
  * @param[in] filePathLength	バッファサイズ[Byte]
+ * @param[in] queryName			クエリ名を示す文字列(空文字列の場合は"output.csv")
  * @return						出力ファイルパス文字列をコピーしたバッファのポインタ or NULL(エラーの場合)
  */
-static unsigned char *this_getOutputFilePath (M2MString filePath[], const size_t filePathLength);
+static unsigned char *this_getOutputFilePath (M2MString filePath[], const size_t filePathLength, const M2MString *queryName);
+
+
+/**
+ * Get the stop file path in the regulation directory.<br>
+ *
+ * @param[out] filePath			Buffer for copying the stop file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @return						Pointer of the buffer which the stop file path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getStopFilePath (M2MString filePath[], const size_t filePathLength);
+
+
+/**
+ * Get the SQLite3 memory database of the CEP object.<br>
+ *
+ * @param[in] cep	CEP object
+ * @return			SQLite3 memory database or NULL (in case of error)
+ */
+static sqlite3 *this_getMemoryDatabase (const M2MCEP *cep);
+
+
+/**
+ * Get the number of result files which can still be published to every<br>
+ * outgoing directory of the queries.<br>
+ *
+ * @param[in] querySet		Set of SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @return					Minimum number of free slots in the outgoing directories
+ */
+static size_t this_getVacancy (const CEPCUIQuerySet *querySet, const CEPCUIOutput outputList[]);
+
+
+/**
+ * Insert the records of the mapped input file into the CEP table and unmap<br>
+ * it.<br>
+ * A file whose name ends with ".bin" is read as typed binary records, and<br>
+ * any other file is read as CSV format records.<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[in] inserter		Inserter object of the CEP table
+ * @param[in] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in] schema		Schema of the CEP table
+ * @param[in,out] batch		Mapped input file (unmapped in this function)
+ * @param[in] chunkSize		Size of the input data inserted in one transaction[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+static int64_t this_insertBatch (const M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIBatch *batch, const size_t chunkSize);
+
+
+/**
+ * Insert the records in the indicated file into the CEP table.<br>
+ * A file whose name ends with ".bin" is read as typed binary records, and<br>
+ * any other file is read as CSV format records.<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] inserter	Inserter object of the CEP table
+ * @param[in] shardSet	Shard set object or NULL (in case of not sharded)
+ * @param[in] schema	Schema of the CEP table
+ * @param[in] filePath	Input file path string
+ * @param[in] chunkSize	Size of the input data inserted in one transaction[Byte]
+ * @return				Number of inserted records or -1 (in case of error)
+ */
+static int64_t this_insertFile (const M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, const M2MString *filePath, const size_t chunkSize);
+
+
+/**
+ * Check whether the file path is a binary input file (ends with ".bin").<br>
+ *
+ * @param[in] filePath	File path string
+ * @return				true : binary input file, false : CSV input file
+ */
+static bool this_isBinaryFilePath (const M2MString *filePath);
+
+
+/**
+ * Check whether the file name is an output file name of the queries<br>
+ * ("output.csv" or "output.<name>.csv").<br>
+ *
+ * @param[in] fileName	File name string
+ * @return				true : output file, false : other file
+ */
+static bool this_isOutputFileName (const M2MString *fileName);
+
+
+/**
+ * Check whether the inotify event should trigger a CEP cycle.<br>
+ *
+ * @param[in] watcher	inotify watcher object
+ * @param[in] event		inotify event
+ * @return				true : the event is relevant, false : the event is ignored
+ */
+static bool this_isRelevantEvent (const CEPCUIWatcher *watcher, const struct inotify_event *event);
+
+
+/**
+ * Prepare the output destinations of the queries.<br>
+ * In spool mode, the result of the unnamed query is published to outgoing<br>
+ * directory, and the results of named queries are published to their own<br>
+ * subdirectories ("outgoing/<name>/"), so that each query has its own<br>
+ * sequence and consumer.<br>
+ * With rotation, the results are published to "results/" (or<br>
+ * "results/<name>/") in the same way, and only the newest files are kept.<br>
+ * Otherwise the results are written to "output.csv" (unnamed query) or<br>
+ * "output.<name>.csv" in the regulation directory.<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] querySet	Set of SELECT queries
+ * @param[in] spool		Spool queue object or NULL (in case of not spool mode)
+ * @param[in] option	Command line options (depth of the directories and rotation)
+ * @return				Output destinations of the queries (allocated in this function) or NULL (in case of error)
+ */
+static CEPCUIOutput *this_newOutputList (const M2MCEP *cep, const CEPCUIQuerySet *querySet, const CEPCUISpool *spool, const CEPCUIOption *option);
+
+
+/**
+ * Map the input file into memory and remove it from the directory.<br>
+ * An empty file is removed without mapping (the batch length is 0).<br>
+ * A binary input file whose header doesn't match the schema is left in the<br>
+ * directory, so that it isn't lost.<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] schema	Schema of the CEP table
+ * @param[in] filePath	Input file path string
+ * @param[out] batch	Mapped input file
+ * @return				true : success, false : the file doesn't exist or failure
+ */
+static bool this_openBatch (const M2MCEP *cep, const CEPCUISchema *schema, const M2MString *filePath, CEPCUIBatch *batch);
+
+
+/**
+ * Open the temporary file (".<file name>.tmp" in the same directory) for<br>
+ * writing the output file, so that it can be renamed into place when the<br>
+ * whole result is written.<br>
+ *
+ * @param[in] cep						CEP object
+ * @param[in] filePath					Output file path string
+ * @param[out] temporaryFilePath		Buffer for copying the temporary file path string
+ * @param[in] temporaryFilePathLength	Size of the buffer[Byte]
+ * @return								File descriptor or -1 (in case of error)
+ */
+static int this_openResult (const M2MCEP *cep, const M2MString *filePath, M2MString temporaryFilePath[], const size_t temporaryFilePathLength);
+
+
+/**
+ * Start watching the regulation directory with inotify.<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[out] watcher		inotify watcher object
+ * @param[in] spool			Spool queue object or NULL (in case of not spool mode)
+ * @param[in] querySet		Set of SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @return					true : success, false : failure
+ */
+static bool this_openWatcher (const M2MCEP *cep, CEPCUIWatcher *watcher, const CEPCUISpool *spool, const CEPCUIQuerySet *querySet, const CEPCUIOutput outputList[]);
+
+
+/**
+ * Print the usage of the command line to the standard error.<br>
+ *
+ * @param[in] programName	Name of the executable
+ */
+static void this_printUsage (const char *programName);
+
+
+/**
+ * Reading stage of the pipeline (thread function).<br>
+ * Maps the input files in the incoming directory in arrival order, starts<br>
+ * reading them ahead and passes them to the main thread.<br>
+ *
+ * @param[in,out] argument	Pipeline object
+ * @return					NULL
+ */
+static void *this_read (void *argument);
+
+
+/**
+ * Drain all the queued events of the inotify watcher.<br>
+ *
+ * @param[in] watcher	inotify watcher object
+ * @return				true : a relevant event occurred, false : no relevant event
+ */
+static bool this_readEvent (const CEPCUIWatcher *watcher);
+
+
+/**
+ * Insert the records received from a producer in server mode or ring<br>
+ * mode into the CEP table (called back by CEPCUIServer_receive() or<br>
+ * CEPCUIRing_receive()).<br>
+ *
+ * @param[in,out] argument	Receiver object
+ * @param[in] binary		true : typed binary records, false : CSV format records
+ * @param[in] data			Records (not NULL terminated)
+ * @param[in] dataLength	Size of the records[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_receive (void *argument, const bool binary, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Replace the queries with the modified query files.<br>
+ * The new queries are loaded and compiled first, and swapped in only when<br>
+ * all of them are compiled successfully; otherwise the current queries are<br>
+ * kept. The records accumulated in the CEP table are never touched.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in,out] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in] directoryPath		Regulation directory path string
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced in this function)
+ * @param[in,out] outputList	Output destinations of the queries (replaced in this function)
+ * @param[in] spool				Spool queue object or NULL (in case of not spool mode)
+ * @param[in] option			Command line options
+ * @param[in,out] watcher		inotify watcher object (re-opened for the new output destinations)
+ * @return						true : replaced, false : the current queries are kept
+ */
+static bool this_reload (M2MCEP *cep, CEPCUIShardSet *shardSet, const M2MString *directoryPath, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUISpool *spool, const CEPCUIOption *option, CEPCUIWatcher *watcher);
+
+
+/**
+ * Execute all the queries on the CEP table and output each result to the<br>
+ * output destination of the query.<br>
+ * Nothing is output for a query which matches no record.<br>
+ * The result is streamed to the output file through a fixed-size buffer as<br>
+ * the records are stepped, so it is never held in memory as a whole<br>
+ * (except for sharded tables, whose results are merged in memory).<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in,out] querySet		Set of prepared SELECT queries
+ * @param[in,out] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in,out] outputList	Output destinations of the queries
+ * @param[in,out] arena			Per-cycle arena (reset in this function)
+ * @return						Number of queries which matched records
+ */
+static size_t this_select (M2MCEP *cep, CEPCUIQuerySet *querySet, CEPCUIShardSet *shardSet, CEPCUIOutput outputList[], CEPCUIArena *arena);
+
+
+/**
+ * Execute the query on the CEP table, or on all the shards when the table<br>
+ * is sharded.<br>
+ *
+ * @param[in,out] querySet	Set of prepared SELECT queries
+ * @param[in,out] shardSet	Shard set object or NULL (in case of not sharded)
+ * @param[in] index			Index of the query
+ * @param[in,out] arena		Arena for the result string or NULL (in case of heap memory)
+ * @param[out] result		Pointer for copying the result string (allocated in the arena or heap memory)
+ * @return					Result string or NULL (in case of no record or error)
+ */
+static M2MString *this_selectQuery (CEPCUIQuerySet *querySet, CEPCUIShardSet *shardSet, const size_t index, CEPCUIArena *arena, M2MString **result);
+
+
+/**
+ * 規程のディレクトリ配下にCEP処理結果であるCSV形式のファイルを出力する。<br>
+ * 結果は同じディレクトリの一時ファイル(".<ファイル名>.tmp")に書き込んだ後に<br>
+ * リネームするため，読み込み側が書き込み途中のファイルを見る事はない。<br>
+ *
+ * @param[in] filePath		出力ファイルパスを示す文字列
+ * @param[in] result		CSV形式のCEP処理結果データを示す文字列
+ * @param[in] resultLength	CSV形式のCEP処理結果データを示す文字列サイズ[Byte]
+ * @return					true : ファイル出力に成功、false : ファイル出力に失敗
+ */
+static bool this_setResult (const M2MCEP *cep, const M2MString *filePath, const M2MString *result, const size_t resultLength);
+
+
+/**
+ * 引数で指定された時間[usec]だけスリープする。<br>
+ *
+ * @param[in] time	スリープ時間[usec]
+ */
+static void this_sleep (const M2MCEP *cep, unsigned long time);
+
+
+/**
+ * CEP実行の繰り返しを中止するかどうか判定する．
+ *
+ * @param[in] cep		CEP object
+ * @param[in] context	Runtime context (stop file path)
+ * @return				true : 中止する，false : 処理を継続する
+ */
+static bool this_stop (const M2MCEP *cep, const CEPCUIContext *context);
+
+
+/**
+ * Write the chunk of a query result to its output (writer of<br>
+ * CEPCUIQuerySet_selectEach()).<br>
+ * The temporary output file is opened on the first chunk.<br>
+ *
+ * @param[in,out] argument	Stream object
+ * @param[in] data			Chunk of the result
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_streamResult (void *argument, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Wait until the next CEP cycle should start.<br>
+ * If the inotify watcher is valid, returns as soon as a relevant file event<br>
+ * occurs in the regulation directory (or the time runs out), otherwise it<br>
+ * simply sleeps.<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] watcher	inotify watcher object (poll mode if its file descriptor is -1)
+ * @param[in] time		Maximum waiting time[usec]
+ */
+static void this_wait (const M2MCEP *cep, const CEPCUIWatcher *watcher, unsigned long time);
+
+
+/**
+ * Wait until the deadline of the next cycle set by the scheduler.<br>
+ * If the inotify watcher is valid, returns as soon as a relevant file event<br>
+ * occurs in the regulation directory (the deadline is kept for the next<br>
+ * wait).<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[in] watcher		inotify watcher object (poll mode if its file descriptor is -1)
+ * @param[in,out] scheduler	Scheduler object (the next deadline already set)
+ */
+static void this_waitDeadline (const M2MCEP *cep, const CEPCUIWatcher *watcher, CEPCUIScheduler *scheduler);
+
+
+/**
+ * Writing stage of the pipeline (thread function).<br>
+ * Publishes the results passed from the main thread until the pipeline is<br>
+ * stopped and all the results are written.<br>
+ *
+ * @param[in,out] argument	Pipeline object
+ * @return					NULL
+ */
+static void *this_write (void *argument);
+
+
+/**
+ * Write all the data to the file descriptor.<br>
+ *
+ * @param[in] fd			File descriptor
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of data[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_writeResult (const int fd, const M2MString *data, size_t dataLength);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Close the temporary output file, and rename it into place if committed<br>
+ * (otherwise it is removed).<br>
+ *
+ * @param[in] cep					CEP object
+ * @param[in] fd					File descriptor of the temporary output file
+ * @param[in] temporaryFilePath		Temporary output file path string
+ * @param[in] filePath				Output file path string
+ * @param[in] commit				true : rename into place, false : discard
+ * @return							true : renamed, false : discarded or failure
+ */
+static bool this_closeResult (const M2MCEP *cep, const int fd, const M2MString *temporaryFilePath, const M2MString *filePath, const bool commit)
+	{
+	//========== Variable ==========
+	bool written = commit;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_closeResult()";
+
+	if (close(fd)!=0)
+		{
+		written = false;
+		}
+	//===== Rename into place =====
+	if (written==true && rename((char *)temporaryFilePath, (char *)filePath)==0)
+		{
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		if (commit==true)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"出力ファイル(=\"%s\")の出力に失敗しました : %s", filePath, strerror(errno));
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			}
+		unlink((char *)temporaryFilePath);
+		return false;
+		}
+	}
+
+
+/**
+ * Apply the PRAGMA statements for bulk insertion to the memory database.<br>
+ *
+ * @param[in] cep	CEP object
+ * @return			true : success, false : failure
+ */
+static bool this_configureMemoryDatabase (const M2MCEP *cep)
+	{
+	//========== Variable ==========
+	M2MString *errorMessage = NULL;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_configureMemoryDatabase()";
+
+	//===== Execute PRAGMA statements =====
+	if (sqlite3_exec(this_getMemoryDatabase(cep), CEPCUI_MEMORY_DATABASE_PRAGMA, NULL, NULL, (char **)&errorMessage)==SQLITE_OK)
+		{
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to configure the memory database : %s", (errorMessage!=NULL) ? errorMessage : (M2MString *)"unknown error");
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+		sqlite3_free(errorMessage);
+		return false;
+		}
+	}
+
+
+/**
+ * Count the records of the result string (one per line after the header<br>
+ * line).<br>
+ *
+ * @param[in] result	Result string in CSV format
+ * @return				Number of records
+ */
+static uint64_t this_countRecords (const M2MString *result)
+	{
+	//========== Variable ==========
+	uint64_t records = 0;
+
+	while (result!=NULL && (result=(M2MString *)strchr((char *)result, '\n'))!=NULL)
+		{
+		records++;
+		result++;
+		}
+	return (records>0) ? records - 1 : 0;
+	}
+
+
+/**
+ * Release the output destinations of the queries.<br>
+ *
+ * @param[in] querySet			Set of SELECT queries
+ * @param[in,out] outputList	Output destinations of the queries
+ */
+static void this_deleteOutputList (const CEPCUIQuerySet *querySet, CEPCUIOutput **outputList)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (querySet!=NULL && outputList!=NULL && (*outputList)!=NULL)
+		{
+		for (i=0; i<querySet->count; i++)
+			{
+			CEPCUIPublisher_delete(&(*outputList)[i].publisher);
+			}
+		M2MHeap_free((*outputList));
+		}
+	return;
+	}
+
+
+/**
+ * Drain the input files in the spool directory in arrival order.<br>
+ * Each input file is inserted into the CEP table, and the result of each<br>
+ * query is published as a sequenced file in its outgoing directory.<br>
+ * In coalesced mode, all the pending input files are inserted first and the<br>
+ * queries are executed only once.<br>
+ * Input files are left in incoming directory while any outgoing directory<br>
+ * is full (back pressure to the slow consumer).<br>
+ * At most one page of input files is processed per call, so that the stop<br>
+ * file is still checked while a large backlog is drained.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table (for binary input files)
+ * @param[in,out] querySet		Set of prepared SELECT queries
+ * @param[in,out] outputList	Output destinations of the queries
+ * @param[in] spool				Spool queue object
+ * @param[in] coalesce			true : insert all the pending files as one batch, false : one batch per file
+ * @param[in] chunkSize			Size of the buffer for records passed to CEP at once[Byte]
+ * @param[in,out] arena			Per-cycle arena
+ * @param[out] received			Set to true if any input file was inserted (kept otherwise)
+ * @return						true : more input files may be pending, false : incoming directory was drained (or outgoing directory is full)
+ */
+static bool this_drainSpool (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet *querySet, CEPCUIOutput outputList[], const CEPCUISpool *spool, const bool coalesce, const size_t chunkSize, CEPCUIArena *arena, bool *received)
+	{
+	//========== Variable ==========
+	M2MString **fileList = NULL;
+	size_t vacancy = 0;
+	size_t count = 0;
+	size_t inserted = 0;
+	size_t consumed = 0;
+	size_t i = 0;
+	bool pending = false;
+	const size_t MAX_COALESCED_FILE = 1024;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_drainSpool()";
+
+	//===== Check the vacancy of outgoing directories =====
+	if ((vacancy=this_getVacancy(querySet, outputList))>0)
+		{
+		//===== Get input files in arrival order =====
+		if ((count=CEPCUISpool_getIncomingFileList(spool, &fileList, (coalesce==true) ? MAX_COALESCED_FILE : vacancy))>0)
+			{
+			for (i=0; i<count; i++)
+				{
+				//===== Insert input file =====
+				if (this_insertFile(cep, inserter, shardSet, schema, fileList[i], chunkSize)>0)
+					{
+					inserted++;
+					consumed++;
+					(*received) = true;
+					}
+				//===== No record or error (a file left in incoming directory is rejected) =====
+				else
+					{
+					if (access((char *)fileList[i], F_OK)!=0 || CEPCUISpool_reject(spool, fileList[i])==true)
+						{
+						consumed++;
+						}
+					continue;
+					}
+				//===== One batch per file =====
+				if (coalesce==false)
+					{
+					this_select(cep, querySet, shardSet, outputList, arena);
+					}
+				}
+			//===== Coalesced batch =====
+			if (coalesce==true && inserted>0)
+				{
+				this_select(cep, querySet, shardSet, outputList, arena);
+				}
+			//===== More files may be pending only if this page made progress =====
+			pending = (count==((coalesce==true) ? MAX_COALESCED_FILE : vacancy) && consumed>0);
+			CEPCUISpool_deleteFileList(&fileList, count);
+			}
+		//===== No input file =====
+		else
+			{
+			CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "There is no input file in incoming directory");
+			}
+		}
+	//===== Outgoing directory is full =====
+	else
+		{
+		CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "An outgoing directory is full, so CEP isn't executed");
+		}
+	return pending;
+	}
+
+
+/**
+ * Execute all the queries on the CEP table and pass each result to the<br>
+ * writing thread of the pipeline.<br>
+ * Nothing is passed for a query which matches no record.<br>
+ *
+ * @param[in,out] pipeline		Pipeline object
+ * @param[in,out] querySet		Set of prepared SELECT queries
+ * @param[in,out] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in,out] outputList	Output destinations of the queries
+ * @return						Number of queries which matched records
+ */
+static size_t this_enqueueResult (CEPCUIPipeline *pipeline, CEPCUIQuerySet *querySet, CEPCUIShardSet *shardSet, CEPCUIOutput outputList[])
+	{
+	//========== Variable ==========
+	CEPCUIResult *item = NULL;
+	M2MString *result = NULL;
+	size_t i = 0;
+	size_t count = 0;
+
+	for (i=0; i<querySet->count; i++)
+		{
+		//===== CEP実行 (with the cached statement) =====
+		if (this_selectQuery(querySet, shardSet, i, NULL, &result)!=NULL)
+			{
+			//===== Pass the result to the writing thread =====
+			if ((item=(CEPCUIResult *)M2MHeap_malloc(sizeof(CEPCUIResult)))!=NULL)
+				{
+				item->output = &outputList[i];
+				item->result = result;
+				atomic_fetch_add(&pipeline->pendingResult, 1);
+				CEPCUIQueue_push(pipeline->resultQueue, item);
+				count++;
+				}
+			else
+				{
+				M2MHeap_free(result);
+				}
+			}
+		}
+	return count;
+	}
+
+
+/**
+ * 入力ファイルの読み込み → CEP → 出力ファイル作成，を繰り返す．
+ * 出力ファイルについては，該当する出力が存在しない場合は作成せず，そのままループ<br>
+ * 処理を繰り返す．<br>
+ *
+ * イベント駆動モードの場合，スリープの代わりに規程のディレクトリのファイル<br>
+ * イベントを待ち受け，イベント発生次第CEPを繰り返す．<br>
+ * inotifyが利用できない場合はスリープによるポーリングにフォールバックする．<br>
+ * スプールモードの場合，入力ファイル・出力ファイルの代わりにincoming,<br>
+ * outgoingディレクトリを使用する．<br>
+ * 複数のクエリが定義されている場合，1回の挿入に対して全てのクエリを実行し，<br>
+ * クエリ毎の出力ファイル(またはoutgoingディレクトリ)に結果を出力する．<br>
+ * クエリはループ開始前に1度だけコンパイルし，毎回のCEPで再利用する．<br>
+ * ローテーションが指定された場合，結果を連番ファイルとして出力し，出力ファイル<br>
+ * が未読でもCEPを止めない(古いファイルから削除する)．<br>
+ * シャード数が指定された場合，キー列のハッシュ値によってレコードを複数の<br>
+ * CEPテーブルに振り分け，挿入とクエリをシャード毎のスレッドで並行して実行<br>
+ * する．<br>
+ * パイプモードの場合，入力ファイル・出力ファイルの代わりに標準入力から<br>
+ * レコードを読み込み，マイクロバッチ毎のCEP結果を標準出力に出力する．<br>
+ * サーバーモードの場合，Unixドメインソケットで複数のプロデューサーから<br>
+ * レコードを受信し，CEP結果を購読中の接続に送信する．<br>
+ * リングモードの場合，同一ホストのプロデューサーが共有メモリのリング<br>
+ * バッファに書き込んだレコードを，コピーせずにそのまま挿入する．<br>
+ * パイプラインモードの場合，入力ファイルの読み込みと結果の出力をそれぞれ<br>
+ * 専用のスレッドで行い，CEPと並行して実行する．<br>
+ * クエリファイルが更新された場合，蓄積済みのレコードはそのままに，新しい<br>
+ * クエリをコンパイルして差し替える(コンパイルに失敗した場合は現在のクエリ<br>
+ * を使い続ける)．<br>
+ *
+ * @param[in] cep				CEP実行オブジェクト
+ * @@aram[in] tableName			テーブル名を示す文字列
+ * @param[in] schema			テーブルのスキーマ(バイナリ入力ファイルの解釈に使用)
+ * @param[in,out] querySet		SELECT文の集合(再読み込みの際に差し替えられる)
+ * @param[in] option			コマンドラインオプション
+ */
+static void this_execute (M2MCEP *cep, const M2MString *tableName, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, const CEPCUIOption *option)
+	{
+	//========== Variable ==========
+	CEPCUIContext context;
+	bool inserted = false;
+	CEPCUIOutput *outputList = NULL;
+	CEPCUISpool *spool = NULL;
+	CEPCUIInserter *inserter = NULL;
+	CEPCUIShardSet *shardSet = NULL;
+	size_t i = 0;
+	CEPCUIWatcher watcher = {-1, -1, -1, -1};
+	CEPCUIScheduler *scheduler = NULL;
+	CEPCUISnapshot *snapshot = NULL;
+	bool received = false;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_execute()";
+
+	//===== Check argument =====
+	if (cep!=NULL
+			&& tableName!=NULL && M2MString_length(tableName)>0
+			&& schema!=NULL
+			&& querySet!=NULL && (*querySet)!=NULL && (*querySet)->count>0
+			&& option!=NULL
+			&& this_getInputFilePath(context.inputFilePath, sizeof(context.inputFilePath))!=NULL
+			&& this_getBinaryInputFilePath(context.binaryInputFilePath, sizeof(context.binaryInputFilePath))!=NULL
+			&& this_getStopFilePath(context.stopFilePath, sizeof(context.stopFilePath))!=NULL
+			&& this_getDirectoryPath(context.directoryPath, sizeof(context.directoryPath))!=NULL)
+		{
+		//===== Prepare the per-cycle arena =====
+		if ((context.arena=CEPCUIArena_new(CEPCUIArena_DEFAULT_CAPACITY))==NULL)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the arena of the CEP loop");
+			return;
+			}
+		//===== Configure the memory database for bulk insertion =====
+		this_configureMemoryDatabase(cep);
+		//===== Restore the window from the snapshot =====
+		if (option->snapshotInterval>0 && option->shardCount>1)
+			{
+			CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Snapshots aren't supported with the shards, so the window isn't persisted");
+			}
+		else if (option->snapshotInterval>0
+				&& (snapshot=CEPCUISnapshot_new(this_getMemoryDatabase(cep), context.directoryPath, option->snapshotInterval))!=NULL
+				&& CEPCUISnapshot_load(snapshot, tableName)==true)
+			{
+			CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Restored the CEP table from the snapshot");
+			}
+		//===== Prepare INSERT statement of the CEP table =====
+		if ((inserter=CEPCUIInserter_new(this_getMemoryDatabase(cep), tableName, option->maxRecord))==NULL
+				|| CEPCUIInserter_setBatchRecord(inserter, option->batchRecord)==NULL
+				|| CEPCUIInserter_setTimeWindow(inserter, tableName, option->windowColumn, option->windowTime, option->windowMemory)==NULL)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the insertion into CEP table");
+			CEPCUISnapshot_delete(&snapshot);
+			CEPCUIInserter_delete(&inserter);
+			CEPCUIArena_delete(&context.arena);
+			return;
+			}
+		//===== Replay the journal and start journaling the batches =====
+		else if (snapshot!=NULL && CEPCUISnapshot_start(snapshot, inserter, schema)<0)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to replay the journal of the CEP table");
+			CEPCUISnapshot_delete(&snapshot);
+			CEPCUIInserter_delete(&inserter);
+			CEPCUIArena_delete(&context.arena);
+			return;
+			}
+		//===== Compile the queries once =====
+		else if (CEPCUIQuerySet_prepare((*querySet), this_getMemoryDatabase(cep))==NULL
+				|| CEPCUIQuerySet_setIncremental((*querySet), option->incremental)==NULL
+				|| CEPCUIQuerySet_setDelta((*querySet), option->delta, option->retract)==NULL)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the SELECT queries");
+			CEPCUISnapshot_delete(&snapshot);
+			CEPCUIInserter_delete(&inserter);
+			CEPCUIArena_delete(&context.arena);
+			return;
+			}
+		//===== Partition the CEP table among the shards =====
+		else if (option->shardCount>1
+				&& ((shardSet=CEPCUIShardSet_new(option->shardCount, cep->databaseName, tableName, schema, option->shardKey, context.directoryPath, option->maxRecord, option->batchRecord, option->windowColumn, option->windowTime, option->windowMemory / option->shardCount))==NULL
+					|| CEPCUIShardSet_setDelta(shardSet, option->delta, option->retract)==false))
+			{
+			CEPCUIShardSet_delete(&shardSet);
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the shards of CEP table");
+			CEPCUISnapshot_delete(&snapshot);
+			CEPCUIInserter_delete(&inserter);
+			CEPCUIArena_delete(&context.arena);
+			return;
+			}
+		//===== Prepare spool directories =====
+		else if (option->spool==true && (spool=CEPCUISpool_new(context.directoryPath))==NULL)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the spool directories");
+			CEPCUIShardSet_delete(&shardSet);
+			CEPCUISnapshot_delete(&snapshot);
+			CEPCUIInserter_delete(&inserter);
+			CEPCUIArena_delete(&context.arena);
+			return;
+			}
+		//===== Prepare output destinations of the queries =====
+		else if ((outputList=this_newOutputList(cep, (*querySet), spool, option))==NULL)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the output destinations of the queries");
+			CEPCUISpool_delete(&spool);
+			CEPCUIShardSet_delete(&shardSet);
+			CEPCUISnapshot_delete(&snapshot);
+			CEPCUIInserter_delete(&inserter);
+			CEPCUIArena_delete(&context.arena);
+			return;
+			}
+		//===== Configure the memory databases of the shards =====
+		for (i=0; shardSet!=NULL && i<shardSet->count; i++)
+			{
+			this_configureMemoryDatabase(shardSet->shardList[i].cep);
+			}
+		//===== Start watching the regulation directory =====
+		if (option->eventDriven==true && this_openWatcher(cep, &watcher, spool, (*querySet), outputList)==false)
+			{
+			CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Failed to start inotify watcher, so fall back to polling");
+			}
+		//===== Pipe mode =====
+		if (option->pipe==true)
+			{
+			this_executePipe(cep, inserter, shardSet, querySet, &outputList, option, &context, &watcher);
+			}
+		//===== Ring mode =====
+		else if (option->ring==true)
+			{
+			this_executeRing(cep, inserter, shardSet, schema, querySet, &outputList, option, &context, &watcher);
+			}
+		//===== Server mode =====
+		else if (option->server==true)
+			{
+			this_executeServer(cep, inserter, shardSet, schema, querySet, &outputList, option, &context, &watcher);
+			}
+		//===== Pipelined execution =====
+		else if (option->pipeline==true && spool!=NULL)
+			{
+			this_executePipeline(cep, inserter, shardSet, schema, querySet, &outputList, spool, option, &context, &watcher);
+			}
+		//===== Serial execution =====
+		else
+			{
+			CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "一定間隔でCEPを繰り返すループ処理を開始します");
+			//===== Start the cycles on fixed deadlines =====
+			if ((scheduler=CEPCUIScheduler_new((option->sleepTime>0) ? option->sleepTime : CEPCUI_DEFAULT_SLEEP_TIME, option->minInterval, option->maxInterval))==NULL)
+				{
+				M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the scheduler of the cycles");
+				}
+			//===== 無限ループ =====
+			while (scheduler!=NULL && this_stop(cep, &context)==false)
+				{
+				//===== Reload the modified queries =====
+				if (CEPCUIQuerySet_isModified((*querySet), context.directoryPath)==true)
+					{
+					this_reload(cep, shardSet, context.directoryPath, querySet, &outputList, spool, option, &watcher);
+					}
+				//===== スプールモードの場合 =====
+				if (spool!=NULL)
+					{
+					//===== Continue without waiting while input files are pending =====
+					if (this_drainSpool(cep, inserter, shardSet, schema, (*querySet), outputList, spool, option->coalesce, option->chunkSize, context.arena, &received)==true)
+						{
+						continue;
+						}
+					}
+				//===== 出力ファイルが規程ディレクトリ内に存在しなかった場合 =====
+				else if (this_existsResult((*querySet), outputList)==false)
+					{
+					CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "規程のディレクトリに設置された出力ファイルが存在しない事を確認しました．．．CEPを実行します");
+					//===== CSV形式およびバイナリ形式のレコードをCEPデータベースへ挿入 =====
+					inserted = (this_insertFile(cep, inserter, shardSet, schema, context.inputFilePath, option->chunkSize)>0);
+					inserted = (this_insertFile(cep, inserter, shardSet, schema, context.binaryInputFilePath, option->chunkSize)>0) || inserted;
+					//===== レコードを挿入した場合 =====
+					if (inserted==true)
+						{
+						received = true;
+						CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "規程のディレクトリに設置されたファイルの入力データをSQLite3データベースに挿入しました");
+						CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "CEPを実行します");
+						//===== CEP実行と実行結果の出力 =====
+						if (this_select(cep, (*querySet), shardSet, outputList, context.arena)<=0)
+							{
+							CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "CEPで合致するレコードが見つかりませんでした");
+							}
+						}
+					//===== レコードを取得しなかった場合 =====
+					else
+						{
+						CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "規程のディレクトリに設置された入力ファイルが見つかりませんでした");
+						}
+					}
+				//===== 出力ファイルが規程ディレクトリ内に存在する場合 =====
+				else
+					{
+					CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "規程のディレクトリに設置された出力ファイルが存在するためCEPは実行しません");
+					}
+				//===== 次の期限までスリープ(またはファイルイベント待ち) =====
+				CEPCUIScheduler_schedule(scheduler, received);
+				this_waitDeadline(cep, &watcher, scheduler);
+				received = false;
+				CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "CEPを繰り返します");
+				}
+			CEPCUIScheduler_delete(&scheduler);
+			}
+		//===== Stop watching =====
+		if (watcher.fd>=0)
+			{
+			close(watcher.fd);
+			}
+		this_deleteOutputList((*querySet), &outputList);
+		CEPCUISpool_delete(&spool);
+		CEPCUIShardSet_delete(&shardSet);
+		//===== Take the last snapshot =====
+		if (snapshot!=NULL)
+			{
+			CEPCUISnapshot_save(snapshot);
+			CEPCUISnapshot_delete(&snapshot);
+			}
+		CEPCUIInserter_delete(&inserter);
+		CEPCUIArena_delete(&context.arena);
+		}
+	//===== Argument error =====
+	else if (cep==NULL)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたCEP実行オブジェクトがNULLです");
+		}
+	else if (tableName==NULL || M2MString_length(tableName)<=0)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたテーブル名がNULLです");
+		}
+	else if (schema==NULL)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated schema object is NULL");
+		}
+	else if (option==NULL)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated command line option is NULL");
+		}
+	else if (querySet==NULL || (*querySet)==NULL || (*querySet)->count<=0)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated query set is NULL or empty");
+		}
+	else
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to get the regulation file paths");
+		}
+	return;
+	}
+
+
+/**
+ * Repeat the CEP in pipe mode: CSV format records are read from stdin<br>
+ * continuously, and each micro-batch is inserted and queried as soon as it<br>
+ * has the indicated number of records or its first record has waited for<br>
+ * the indicated time. The results of all the queries are streamed to<br>
+ * stdout.<br>
+ * A record must not contain a line feed in pipe mode, since micro-batches<br>
+ * are split at line feeds. The records of one read are split into as many<br>
+ * micro-batches as needed, and stdin isn't read while a full micro-batch<br>
+ * is pending, so the buffer holds at most about one micro-batch and one<br>
+ * read. When stdin is closed, the rest of the records are processed before<br>
+ * returning; when stdout is closed, it returns at once.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executePipe (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher)
+	{
+	//========== Variable ==========
+	M2MString *buffer = NULL;
+	M2MString *enlarged = NULL;
+	const M2MString *lineFeed = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+	size_t end = 0;
+	size_t scanned = 0;
+	size_t records = 0;
+	ssize_t received = 0;
+	long elapsed = 0;
+	int timeout = 0;
+	bool closed = false;
+	struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+	struct timespec start;
+	struct timespec now;
+	const int STOP_CHECK_TIME = 1000;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_executePipe()";
+
+	//===== Detect the closed stdout by EPIPE =====
+	signal(SIGPIPE, SIG_IGN);
+	memset(&start, 0, sizeof(start));
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Started reading records from stdin");
+	while (true)
+		{
+		//===== Reload the modified queries =====
+		if (records==0 && CEPCUIQuerySet_isModified((*querySet), context->directoryPath)==true)
+			{
+			this_reload(cep, shardSet, context->directoryPath, querySet, outputList, NULL, option, watcher);
+			}
+		//===== Count the complete records up to the size of a micro-batch =====
+		while (records<option->pipeRecord && scanned<length)
+			{
+			if ((lineFeed=(M2MString *)memchr(&buffer[scanned], '\n', length-scanned))==NULL)
+				{
+				scanned = length;
+				}
+			else
+				{
+				//===== The first record of the micro-batch =====
+				if (records++==0)
+					{
+					clock_gettime(CLOCK_MONOTONIC, &start);
+					}
+				end = scanned = (size_t)(lineFeed - buffer) + 1;
+				}
+			}
+		//===== The last record may lack its line feed =====
+		if (closed==true && records<option->pipeRecord)
+			{
+			end = length;
+			}
+		//===== Get the waiting time until the micro-batch is due =====
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed = (now.tv_sec - start.tv_sec) * 1000L + (now.tv_nsec - start.tv_nsec) / 1000000L;
+		timeout = (records==0) ? STOP_CHECK_TIME : (records>=option->pipeRecord || elapsed>=(long)option->pipeInterval) ? 0 : (int)((long)option->pipeInterval - elapsed);
+		//===== Read records from stdin (not while a full micro-batch is pending) =====
+		if (closed==false && records<option->pipeRecord && poll(&input, 1, timeout)>0)
+			{
+			//===== Enlarge the buffer =====
+			if (capacity-length<CEPCUI_PIPE_READ_LENGTH)
+				{
+				if ((enlarged=(M2MString *)M2MHeap_malloc(capacity*2+CEPCUI_PIPE_READ_LENGTH))==NULL)
+					{
+					M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for the records from stdin");
+					break;
+					}
+				if (buffer!=NULL)
+					{
+					memcpy(enlarged, buffer, length);
+					M2MHeap_free(buffer);
+					}
+				buffer = enlarged;
+				capacity = capacity * 2 + CEPCUI_PIPE_READ_LENGTH;
+				}
+			if ((received=read(STDIN_FILENO, &buffer[length], CEPCUI_PIPE_READ_LENGTH))>0)
+				{
+				length += (size_t)received;
+				}
+			//===== End of stdin =====
+			else if (received==0 || (errno!=EINTR && errno!=EAGAIN))
+				{
+				closed = true;
+				}
+			continue;
+			}
+		//===== Execute the micro-batch =====
+		if (end>0 && (closed==true || records>=option->pipeRecord || timeout==0))
+			{
+			if (this_flushPipe(cep, inserter, shardSet, (*querySet), (*outputList), buffer, end, option->chunkSize, context->arena)==false)
+				{
+				CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "stdout was closed, so CEP is stopped");
+				break;
+				}
+			memmove(buffer, &buffer[end], length-end);
+			length -= end;
+			scanned -= end;
+			end = 0;
+			records = 0;
+			}
+		//===== Stop =====
+		if ((closed==true && length==0) || (records==0 && this_stop(cep, context)==true))
+			{
+			break;
+			}
+		}
+	M2MHeap_free(buffer);
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Stopped reading records from stdin");
+	return;
+	}
+
+
+/**
+ * Repeat the CEP in spool mode with the stages pipelined on three threads.<br>
+ * While the main thread inserts a batch and executes the queries, the next<br>
+ * input files are mapped and read ahead by the reading thread, and the<br>
+ * previous results are written by the writing thread.<br>
+ * When the stop file appears, the files already taken from the incoming<br>
+ * directory are still processed and written before returning.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] spool				Spool queue object
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executePipeline (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUISpool *spool, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher)
+	{
+	//========== Variable ==========
+	CEPCUIPipeline pipeline;
+	CEPCUIBatch *batch = NULL;
+	pthread_t reader;
+	pthread_t writer;
+	size_t inserted = 0;
+	bool stopping = false;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_executePipeline()";
+
+	//===== Prepare the queues between the stages =====
+	memset(&pipeline, 0, sizeof(pipeline));
+	pipeline.cep = cep;
+	pipeline.schema = schema;
+	pipeline.spool = spool;
+	atomic_init(&pipeline.reading, true);
+	atomic_init(&pipeline.readerStopped, false);
+	atomic_init(&pipeline.writing, true);
+	atomic_init(&pipeline.pendingResult, 0);
+	if (sem_init(&pipeline.resultDrained, 0, 0)!=0)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the semaphore of the pipeline");
+		return;
+		}
+	else if ((pipeline.batchQueue=CEPCUIQueue_new(CEPCUI_PIPELINE_DEPTH))==NULL
+			|| (pipeline.resultQueue=CEPCUIQueue_new(CEPCUI_PIPELINE_DEPTH * CEPCUIQuerySet_MAX_QUERY))==NULL)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the queues of the pipeline");
+		CEPCUIQueue_delete(&pipeline.batchQueue);
+		sem_destroy(&pipeline.resultDrained);
+		return;
+		}
+	//===== Start the writing thread =====
+	else if (pthread_create(&writer, NULL, this_write, &pipeline)!=0)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to start the writing thread of the pipeline");
+		CEPCUIQueue_delete(&pipeline.resultQueue);
+		CEPCUIQueue_delete(&pipeline.batchQueue);
+		sem_destroy(&pipeline.resultDrained);
+		return;
+		}
+	//===== Start the reading thread =====
+	else if (pthread_create(&reader, NULL, this_read, &pipeline)!=0)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to start the reading thread of the pipeline");
+		atomic_store(&pipeline.writing, false);
+		pthread_join(writer, NULL);
+		CEPCUIQueue_delete(&pipeline.resultQueue);
+		CEPCUIQueue_delete(&pipeline.batchQueue);
+		sem_destroy(&pipeline.resultDrained);
+		return;
+		}
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Started the pipelined execution");
+	//===== Insert and execute the queries until the reading thread stops =====
+	while (stopping==false || atomic_load(&pipeline.readerStopped)==false || CEPCUIQueue_isEmpty(pipeline.batchQueue)==false)
+		{
+		//===== Stop reading new input files =====
+		if (stopping==false && this_stop(cep, context)==true)
+			{
+			stopping = true;
+			atomic_store(&pipeline.reading, false);
+			}
+		//===== Reload the modified queries after all the results are written =====
+		if (stopping==false && CEPCUIQuerySet_isModified((*querySet), context->directoryPath)==true)
+			{
+			//===== Discard the stale signals and wait for the writing thread =====
+			while (sem_trywait(&pipeline.resultDrained)==0)
+				{
+				}
+			while (atomic_load(&pipeline.pendingResult)>0)
+				{
+				sem_wait(&pipeline.resultDrained);
+				}
+			this_reload(cep, shardSet, context->directoryPath, querySet, outputList, spool, option, watcher);
+			}
+		//===== Wait for the consumer while outgoing directories are full =====
+		if (stopping==false && this_getVacancy((*querySet), (*outputList))<=atomic_load(&pipeline.pendingResult))
+			{
+			this_wait(cep, watcher, CEPCUI_PIPELINE_POLL_TIME);
+			continue;
+			}
+		//===== Insert the next batch =====
+		if ((batch=(CEPCUIBatch *)CEPCUIQueue_pop(pipeline.batchQueue, CEPCUI_PIPELINE_POLL_TIME))!=NULL)
+			{
+			if (this_insertBatch(cep, inserter, shardSet, schema, batch, option->chunkSize)>0)
+				{
+				inserted++;
+				}
+			M2MHeap_free(batch);
+			}
+		//===== Execute the queries per batch (or after all the pending batches) =====
+		if (inserted>0 && (option->coalesce==false || CEPCUIQueue_isEmpty(pipeline.batchQueue)==true))
+			{
+			this_enqueueResult(&pipeline, (*querySet), shardSet, (*outputList));
+			inserted = 0;
+			}
+		}
+	//===== Stop the threads =====
+	pthread_join(reader, NULL);
+	atomic_store(&pipeline.writing, false);
+	pthread_join(writer, NULL);
+	CEPCUIQueue_delete(&pipeline.resultQueue);
+	CEPCUIQueue_delete(&pipeline.batchQueue);
+	sem_destroy(&pipeline.resultDrained);
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Stopped the pipelined execution");
+	return;
+	}
+
+
+/**
+ * Repeat the CEP in ring mode: producers on the same host write entries of<br>
+ * CSV format or binary records into the shared memory ring buffer, which<br>
+ * are inserted in place as soon as they are published. The queries are<br>
+ * executed after the published entries have been inserted, and their<br>
+ * results are written to the output files as usual; while the previous<br>
+ * results are not consumed yet, the records keep being inserted and the<br>
+ * queries wait.<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table (used for binary records)
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executeRing (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher)
+	{
+	//========== Variable ==========
+	CEPCUIRing *ring = NULL;
+	CEPCUIReceiver receiver = {cep, inserter, shardSet, schema, option->chunkSize, 0};
+	bool pending = false;
+	const int STOP_CHECK_TIME = 1000;
+	const int RESULT_CHECK_TIME = 10;
+	const char *NAME = (option->ringName!=NULL) ? (char *)option->ringName : CEPCUIRing_DEFAULT_NAME;
+	M2MString MESSAGE[NAME_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_executeRing()";
+
+	//===== Create the ring buffer =====
+	if ((ring=CEPCUIRing_new(NAME, option->ringCapacity))==NULL)
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to create the ring buffer(=\"%s\"), so CEP is stopped : %s", NAME, strerror(errno));
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+		return;
+		}
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Started consuming the ring buffer");
+	while (this_stop(cep, context)==false)
+		{
+		//===== Reload the modified queries =====
+		if (CEPCUIQuerySet_isModified((*querySet), context->directoryPath)==true)
+			{
+			this_reload(cep, shardSet, context->directoryPath, querySet, outputList, NULL, option, watcher);
+			}
+		//===== Insert the published records =====
+		receiver.records = 0;
+		if (CEPCUIRing_receive(ring, (pending==true) ? RESULT_CHECK_TIME : STOP_CHECK_TIME, this_receive, &receiver)<0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to consume the ring buffer(=\"%s\") : %s", NAME, strerror(errno));
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			}
+		pending = (pending==true || receiver.records>0);
+		//===== Execute the queries when the previous results are consumed =====
+		if (pending==true && this_existsResult((*querySet), (*outputList))==false)
+			{
+			this_select(cep, (*querySet), shardSet, (*outputList), context->arena);
+			pending = false;
+			}
+		}
+	CEPCUIRing_delete(&ring);
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Stopped consuming the ring buffer");
+	return;
+	}
+
+
+/**
+ * Repeat the CEP in server mode: many producers connect to the Unix domain<br>
+ * socket and send length-framed batches of CSV format or binary records,<br>
+ * which are inserted as soon as they arrive. After every round of received<br>
+ * batches, the queries are executed and their results are sent to the<br>
+ * connections which subscribed to them (the queries are skipped while<br>
+ * there is no subscriber).<br>
+ *
+ * @param[in] cep				CEP object
+ * @param[in] inserter			Inserter object of the CEP table
+ * @param[in] shardSet			Shard set object or NULL (in case of not sharded)
+ * @param[in] schema			Schema of the CEP table (used for binary records)
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced when reloaded)
+ * @param[in,out] outputList	Output destinations of the queries (replaced when reloaded)
+ * @param[in] option			Command line options
+ * @param[in,out] context		Runtime context (paths and per-cycle arena)
+ * @param[in,out] watcher		inotify watcher object
+ */
+static void this_executeServer (M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUIOption *option, CEPCUIContext *context, CEPCUIWatcher *watcher)
+	{
+	//========== Variable ==========
+	CEPCUIServer *server = NULL;
+	CEPCUIReceiver receiver = {cep, inserter, shardSet, schema, option->chunkSize, 0};
+	M2MString *result = NULL;
+	size_t i = 0;
+	int length = 0;
+	M2MString SOCKET_PATH[PATH_MAX];
+	const int STOP_CHECK_TIME = 1000;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_executeServer()";
+
+	//===== Listen on the socket =====
+	memset(SOCKET_PATH, 0, sizeof(SOCKET_PATH));
+	if (option->socketPath!=NULL)
+		{
+		length = snprintf((char *)SOCKET_PATH, sizeof(SOCKET_PATH), "%s", option->socketPath);
+		}
+	else
+		{
+		length = snprintf((char *)SOCKET_PATH, sizeof(SOCKET_PATH), "%s/%s", context->directoryPath, CEPCUI_SOCKET_FILE_NAME);
+		}
+	if (length<0 || length>=(int)sizeof(SOCKET_PATH) || (server=CEPCUIServer_new(SOCKET_PATH))==NULL)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to start the server, so CEP is stopped");
+		return;
+		}
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Started listening on the socket");
+	while (this_stop(cep, context)==false)
+		{
+		//===== Reload the modified queries =====
+		if (CEPCUIQuerySet_isModified((*querySet), context->directoryPath)==true)
+			{
+			this_reload(cep, shardSet, context->directoryPath, querySet, outputList, NULL, option, watcher);
+			}
+		//===== Insert the received records =====
+		receiver.records = 0;
+		if (CEPCUIServer_receive(server, STOP_CHECK_TIME, this_receive, &receiver)<0)
+			{
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to wait for the connections, so CEP is stopped");
+			break;
+			}
+		//===== Send the results to the subscribers =====
+		if (receiver.records>0 && CEPCUIServer_getSubscriberCount(server)>0)
+			{
+			CEPCUIArena_reset(context->arena);
+			for (i=0; i<(*querySet)->count; i++)
+				{
+				if (this_selectQuery((*querySet), shardSet, i, context->arena, &result)!=NULL)
+					{
+					CEPCUIServer_publish(server, (*querySet)->queryList[i].name, result, M2MString_length(result));
+					}
+				}
+			}
+		}
+	CEPCUIServer_delete(&server);
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Stopped listening on the socket");
+	return;
+	}
+
+
+/**
+ * Check whether any output file of the queries still exists in the<br>
+ * regulation directory (i.e. the consumer hasn't read it yet).<br>
+ * Rotated result files never block the CEP cycle.<br>
+ *
+ * @param[in] querySet		Set of SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @return					true : an output file exists, false : no output file exists
+ */
+static bool this_existsResult (const CEPCUIQuerySet *querySet, const CEPCUIOutput outputList[])
+	{
+	//========== Variable ==========
+	size_t i = 0;
+
+	for (i=0; i<querySet->count; i++)
+		{
+		if (outputList[i].publisher==NULL && access((char *)outputList[i].filePath, F_OK)==0)
+			{
+			return true;
+			}
+		}
+	return false;
+	}
+
+
+/**
+ * Insert the micro-batch of pipe mode into the CEP table and stream the<br>
+ * results of all the queries to stdout.<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[in] inserter		Inserter object of the CEP table
+ * @param[in] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in,out] querySet	Set of prepared SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @param[in] data			CSV format records of the micro-batch
+ * @param[in] length		Size of the records[Byte]
+ * @param[in] chunkSize		Size of the input data inserted in one transaction[Byte]
+ * @param[in,out] arena		Per-cycle arena (reset in this function)
+ * @return					true : success, false : stdout was closed
+ */
+static bool this_flushPipe (const M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, CEPCUIQuerySet *querySet, CEPCUIOutput outputList[], const M2MString *data, const size_t length, const size_t chunkSize, CEPCUIArena *arena)
+	{
+	//========== Variable ==========
+	CEPCUICSVTokenizer tokenizer;
+	CEPCUIStream stream;
+	M2MString *result = NULL;
+	int64_t inserted = 0;
+	int64_t records = 0;
+	size_t i = 0;
+	bool written = true;
+	struct timespec start;
+	M2MString BUFFER[CEPCUI_RESULT_BUFFER_LENGTH];
+
+	//===== Insert the records =====
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	CEPCUICSVTokenizer_init(&tokenizer, data, length);
+	while (tokenizer.position<length && inserted>=0)
+		{
+		if ((inserted=(shardSet!=NULL) ? CEPCUIShardSet_insertCSV(shardSet, &tokenizer, chunkSize) : CEPCUIInserter_insertCSV(inserter, &tokenizer, chunkSize))>0)
+			{
+			records += inserted;
+			}
+		}
+	CEPCUIMetrics_record(CEPCUIMetricsStage_INSERT, &start);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_BATCH, 1);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_INSERTED_ROW, (uint64_t)records);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_READ_BYTE, (uint64_t)length);
+	//===== Stream the results to stdout =====
+	errno = 0;
+	CEPCUIArena_reset(arena);
+	for (i=0; i<querySet->count && written==true; i++)
+		{
+		if (shardSet!=NULL)
+			{
+			if (this_selectQuery(querySet, shardSet, i, arena, &result)!=NULL)
+				{
+				written = this_writeResult(STDOUT_FILENO, result, M2MString_length(result));
+				}
+			}
+		else
+			{
+			stream.cep = cep;
+			stream.output = &outputList[i];
+			stream.fd = STDOUT_FILENO;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			written = ((records=CEPCUIQuerySet_selectEach(querySet, i, BUFFER, sizeof(BUFFER), this_streamResult, &stream))>=0 || errno!=EPIPE);
+			CEPCUIMetrics_record(CEPCUIMetricsStage_SELECT, &start);
+			CEPCUIMetrics_add(CEPCUIMetricsCounter_MATCHED_ROW, (records>0) ? (uint64_t)records : 0);
+			}
+		}
+	return (written==true || errno!=EPIPE);
+	}
+
+
+/**
+ * Get the regulation directory path.<br>
+ *
+ * @param[out] directoryPath		Buffer for copying the directory path string
+ * @param[in] directoryPathLength	Size of buffer[Byte]
+ * @return							Pointer of the buffer which the directory path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getDirectoryPath (M2MString directoryPath[], const size_t directoryPathLength)
+	{
+	//========== Variable ==========
+	const M2MString *HOME_DIRECTORY = M2MDirectory_getHomeDirectoryPath();
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_getDirectoryPath()";
+
+	//===== Check argument =====
+	if (directoryPath!=NULL && directoryPathLength>0)
+		{
+		//===== Create new directory pathname string =====
+		memset(directoryPath, 0, directoryPathLength);
+		snprintf(directoryPath, directoryPathLength-1, (M2MString *)"%s/%s", HOME_DIRECTORY, M2MCEP_DIRECTORY);
+		return directoryPath;
+		}
+	//===== Argument error =====
+	else if (directoryPath==NULL)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated \"directoryPath\" buffer is NULL");
+		return NULL;
+		}
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Size of indicated \"directoryPath\" buffer is 0[Byte] or less");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Get the file path in the regulation directory.<br>
+ *
+ * @param[out] filePath			Buffer for copying the file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @param[in] fileName			The file name string
+ * @return						Pointer of the buffer which the file path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getFilePath (M2MString filePath[], const size_t filePathLength, const M2MString fileName[])
+	{
+	//========== Variable ==========
+	const M2MString *HOME_DIRECTORY = M2MDirectory_getHomeDirectoryPath();
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_getFilePath()";
+
+	//===== Check argument =====
+	if (filePath!=NULL && filePathLength>0)
+		{
+		//===== Create new file pathname string =====
+		memset(filePath, 0, filePathLength);
+		snprintf(filePath, filePathLength-1, (M2MString *)"%s/%s/%s", HOME_DIRECTORY, M2MCEP_DIRECTORY, fileName);
+		return filePath;
+		}
+	//===== Argument error =====
+	else if (filePath==NULL)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated \"filePath\" buffer is NULL");
+		return NULL;
+		}
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Size of indicated \"filePath\" buffer is 0[Byte] or less");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Get the binary input file path in the regulation directory.<br>
+ *
+ * @param[out] filePath			Buffer for copying the binary input file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @return						Pointer of the buffer which the binary input file path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getBinaryInputFilePath (M2MString filePath[], const size_t filePathLength)
+	{
+	//========== Variable ==========
+	const M2MString *FILE_NAME = CEPCUI_BINARY_INPUT_FILE_NAME;
+
+	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	}
+
+
+/**
+ * Get the input file path in the regulation directory.<br>
+ *
+ * @param[out] filePath			Buffer for copying the input file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @return						Pointer of the buffer which the input file path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getInputFilePath (M2MString filePath[], const size_t filePathLength)
+	{
+	//========== Variable ==========
+	const M2MString *FILE_NAME = CEPCUI_INPUT_FILE_NAME;
+
+	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	}
+
+
+/**
+ * Get the output file path of the query in the regulation directory.<br>
+ * The result of the unnamed query is written to "output.csv", and that of<br>
+ * a named query is written to "output.<name>.csv".<br>
+ *
+ * @param[out] filePath			Buffer for copying the output file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @param[in] queryName			Query name string (empty for "output.csv")
+ * @return						Pointer of the buffer which the output file path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getOutputFilePath (M2MString filePath[], const size_t filePathLength, const M2MString *queryName)
+	{
+	//========== Variable ==========
+	M2MString FILE_NAME[CEPCUIQuerySet_NAME_LENGTH+16];
+
+	//===== Output file of named query =====
+	if (queryName!=NULL && M2MString_length(queryName)>0)
+		{
+		memset(FILE_NAME, 0, sizeof(FILE_NAME));
+		snprintf(FILE_NAME, sizeof(FILE_NAME)-1, (M2MString *)"%s%s.csv", CEPCUI_OUTPUT_FILE_PREFIX, queryName);
+		return this_getFilePath(filePath, filePathLength, FILE_NAME);
+		}
+	//===== Legacy output file =====
+	else
+		{
+		return this_getFilePath(filePath, filePathLength, CEPCUI_OUTPUT_FILE_NAME);
+		}
+	}
+
+
+/**
+ * Get the stop file path in the regulation directory.<br>
+ *
+ * @param[out] filePath			Buffer for copying the stop file path string
+ * @param[in] filePathLength	Size of buffer[Byte]
+ * @return						Pointer of the buffer which the stop file path string was copied or NULL (in case of error)
+ */
+static M2MString *this_getStopFilePath (M2MString filePath[], const size_t filePathLength)
+	{
+	//========== Variable ==========
+	const M2MString *FILE_NAME = CEPCUI_STOP_FILE_NAME;
+
+	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	}
+
+
+/**
+ * Get the SQLite3 memory database of the CEP object.<br>
+ * Records are inserted into (and selected from) this database directly with<br>
+ * prepared statements, bypassing the CSV string interface of CEP library.<br>
+ *
+ * @param[in] cep	CEP object
+ * @return			SQLite3 memory database or NULL (in case of error)
+ */
+static sqlite3 *this_getMemoryDatabase (const M2MCEP *cep)
+	{
+	return (cep!=NULL) ? cep->memoryDatabase : NULL;
+	}
+
+
+/**
+ * Get the number of result files which can still be published to every<br>
+ * outgoing directory of the queries.<br>
+ *
+ * @param[in] querySet		Set of SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @return					Minimum number of free slots in the outgoing directories
+ */
+static size_t this_getVacancy (const CEPCUIQuerySet *querySet, const CEPCUIOutput outputList[])
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	size_t vacancy = 0;
+	size_t minimum = SIZE_MAX;
+
+	for (i=0; i<querySet->count && minimum>0; i++)
+		{
+		if ((vacancy=CEPCUIPublisher_getVacancy(outputList[i].publisher))<minimum)
+			{
+			minimum = vacancy;
+			}
+		}
+	return (minimum!=SIZE_MAX) ? minimum : 0;
+	}
+
+
+/**
+ * Insert the records of the mapped input file into the CEP table and unmap<br>
+ * it.<br>
+ * A file whose name ends with ".bin" is read as typed binary records, and<br>
+ * any other file is read as CSV format records.<br>
+ * Records are tokenized (or decoded) in place and their fields are bound<br>
+ * directly to the prepared INSERT statement, so LF, CRLF and mixed line feed<br>
+ * codes are all accepted without converting or copying the data.<br>
+ * A truncated binary file is inserted up to the last complete record.<br>
+ * The pages which have already been inserted are released from the mapping<br>
+ * chunk by chunk, therefore the memory usage is bounded by the chunk size no<br>
+ * matter how big the file is.<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[in] inserter		Inserter object of the CEP table
+ * @param[in] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in] schema		Schema of the CEP table
+ * @param[in,out] batch		Mapped input file (unmapped in this function)
+ * @param[in] chunkSize		Size of the input data inserted in one transaction[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+static int64_t this_insertBatch (const M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, CEPCUIBatch *batch, const size_t chunkSize)
+	{
+	//========== Variable ==========
+	CEPCUICSVTokenizer tokenizer;
+	CEPCUIBinaryReader reader;
+	const size_t *position = &tokenizer.position;
+	bool binary = false;
+	size_t released = 0;
+	size_t releasing = 0;
+	int64_t inserted = 0;
+	int64_t records = 0;
+	struct timespec start;
+	M2MString MESSAGE[PATH_MAX+256];
+	const size_t PAGE_SIZE = (size_t)sysconf(_SC_PAGESIZE);
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_insertBatch()";
+
+	//===== Empty input file =====
+	if (batch->data==NULL || batch->length<=0)
+		{
+		return 0;
+		}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	//===== Binary input file =====
+	if ((binary=this_isBinaryFilePath(batch->filePath))==true)
+		{
+		//===== Check the header =====
+		if (CEPCUIBinaryReader_init(&reader, schema, batch->data, batch->length)==false)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Binary input file(=\"%s\") doesn't have a valid header for the schema", batch->filePath);
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			munmap(batch->data, batch->length);
+			batch->data = NULL;
+			return -1;
+			}
+		position = &reader.position;
+		}
+	//===== CSV input file =====
+	else
+		{
+		CEPCUICSVTokenizer_init(&tokenizer, batch->data, batch->length);
+		}
+	//===== Insert records chunk by chunk =====
+	while ((*position)<batch->length)
+		{
+		//===== Partition the chunk among the shards =====
+		if (shardSet!=NULL)
+			{
+			inserted = (binary==true) ? CEPCUIShardSet_insertBinary(shardSet, &reader, chunkSize) : CEPCUIShardSet_insertCSV(shardSet, &tokenizer, chunkSize);
+			}
+		else
+			{
+			inserted = (binary==true) ? CEPCUIInserter_insertBinary(inserter, &reader, chunkSize) : CEPCUIInserter_insertCSV(inserter, &tokenizer, chunkSize);
+			}
+		if (inserted<0)
+			{
+			break;
+			}
+		records += inserted;
+		//===== Release inserted pages =====
+		if ((releasing=((*position) / PAGE_SIZE) * PAGE_SIZE)>released)
+			{
+			madvise(batch->data+released, releasing-released, MADV_DONTNEED);
+			released = releasing;
+			}
+		}
+	//===== Truncated binary input file =====
+	if (binary==true && reader.broken==true)
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Binary input file(=\"%s\") is truncated, so its last record was discarded", batch->filePath);
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+		}
+	munmap(batch->data, batch->length);
+	batch->data = NULL;
+	//===== Record the insertion =====
+	CEPCUIMetrics_record(CEPCUIMetricsStage_INSERT, &start);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_BATCH, 1);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_INSERTED_ROW, (uint64_t)records);
+	return records;
+	}
+
+
+/**
+ * Insert the records in the indicated file into the CEP table.<br>
+ * A file whose name ends with ".bin" is read as typed binary records, and<br>
+ * any other file is read as CSV format records.<br>
+ * The file is mapped into memory and removed at once (the mapping keeps the<br>
+ * data alive), so that a producer can place the next file while the current<br>
+ * one is being inserted.<br>
+ * <br>
+ * 【CEP実行のための入出力ファイル有無の条件】<br>
+ * ・input.csv : ○, output.csv : ○ → CEP実行 : ×<br>
+ * ・input.csv : ○, output.csv : × → CEP実行 : ○<br>
+ * ・input.csv : ×, output.csv : ○ → CEP実行 : ×<br>
+ * ・input.csv : ×, output.csv : × → CEP実行 : ×<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] inserter	Inserter object of the CEP table
+ * @param[in] shardSet	Shard set object or NULL (in case of not sharded)
+ * @param[in] schema	Schema of the CEP table
+ * @param[in] filePath	Input file path string
+ * @param[in] chunkSize	Size of the input data inserted in one transaction[Byte]
+ * @return				Number of inserted records or -1 (in case of error)
+ */
+static int64_t this_insertFile (const M2MCEP *cep, CEPCUIInserter *inserter, CEPCUIShardSet *shardSet, const CEPCUISchema *schema, const M2MString *filePath, const size_t chunkSize)
+	{
+	//========== Variable ==========
+	CEPCUIBatch batch;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_insertFile()";
+
+	//===== Check argument =====
+	if (inserter!=NULL && schema!=NULL && filePath!=NULL && chunkSize>0)
+		{
+		//===== Map input file into memory =====
+		if (this_openBatch(cep, schema, filePath, &batch)==true)
+			{
+			return this_insertBatch(cep, inserter, shardSet, schema, &batch, chunkSize);
+			}
+		//===== 入力ファイルが存在しない場合 (or error) =====
+		else
+			{
+			return -1;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated inserter object, schema or file path is NULL, or chunk size is 0");
+		return -1;
+		}
+	}
+
+
+/**
+ * Check whether the file path is a binary input file (ends with ".bin").<br>
+ *
+ * @param[in] filePath	File path string
+ * @return				true : binary input file, false : CSV input file
+ */
+static bool this_isBinaryFilePath (const M2MString *filePath)
+	{
+	//========== Variable ==========
+	size_t length = 0;
+	const size_t EXTENSION_LENGTH = M2MString_length(CEPCUI_BINARY_FILE_EXTENSION);
+
+	//===== Check the extension =====
+	if (filePath!=NULL && (length=M2MString_length(filePath))>EXTENSION_LENGTH)
+		{
+		return (strcmp((char *)&filePath[length-EXTENSION_LENGTH], (char *)CEPCUI_BINARY_FILE_EXTENSION)==0);
+		}
+	else
+		{
+		return false;
+		}
+	}
+
+
+/**
+ * Check whether the file name is an output file name of the queries<br>
+ * ("output.csv" or "output.<name>.csv").<br>
+ *
+ * @param[in] fileName	File name string
+ * @return				true : output file, false : other file
+ */
+static bool this_isOutputFileName (const M2MString *fileName)
+	{
+	//========== Variable ==========
+	size_t length = 0;
+	const size_t PREFIX_LENGTH = M2MString_length(CEPCUI_OUTPUT_FILE_PREFIX);
+
+	//===== Legacy output file =====
+	if (M2MString_compareTo(fileName, CEPCUI_OUTPUT_FILE_NAME)==0)
+		{
+		return true;
+		}
+	//===== Output file of named query =====
+	else if ((length=M2MString_length(fileName))>PREFIX_LENGTH+4
+			&& strncmp((char *)fileName, (char *)CEPCUI_OUTPUT_FILE_PREFIX, PREFIX_LENGTH)==0)
+		{
+		return (strcmp((char *)&fileName[length-4], ".csv")==0);
+		}
+	else
+		{
+		return false;
+		}
+	}
+
+
+/**
+ * Check whether the inotify event should trigger a CEP cycle.<br>
+ * The following events are relevant.<br>
+ *<br>
+ * - input.csv, input.bin : closed after writing, or moved into the directory<br>
+ * - output.csv : deleted, or moved out of the directory (consumed)<br>
+ * - cepcui.stop : created, closed after writing, or moved into the directory<br>
+ * - select.sql : closed after writing, or moved into the directory<br>
+ * - queries/ : created, deleted, or moved<br>
+ * - files in queries/ : closed after writing, deleted, or moved (except dot-files)<br>
+ * - files in incoming/ : closed after writing, or moved into the directory (except dot-files)<br>
+ * - output.<name>.csv : deleted, or moved out of the directory (consumed)<br>
+ * - files in outgoing/ (and its query subdirectories) : deleted, or moved out of the directory (consumed)<br>
+ * - overflow of the inotify event queue (some events may be lost)<br>
+ *
+ * @param[in] watcher	inotify watcher object
+ * @param[in] event		inotify event
+ * @return				true : the event is relevant, false : the event is ignored
+ */
+static bool this_isRelevantEvent (const CEPCUIWatcher *watcher, const struct inotify_event *event)
+	{
+	//===== Check argument =====
+	if (watcher!=NULL && event!=NULL)
+		{
+		//===== Overflow of event queue =====
+		if ((event->mask & IN_Q_OVERFLOW)!=0)
+			{
+			return true;
+			}
+		//===== Event without file name =====
+		else if (event->len<=0)
+			{
+			return false;
+			}
+		//===== Input file in incoming directory =====
+		else if (event->wd==watcher->incoming)
+			{
+			return (event->name[0]!='.' && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))!=0);
+			}
+		//===== Query file in query directory =====
+		else if (event->wd==watcher->queries)
+			{
+			return (event->name[0]!='.');
+			}
+		//===== Result file in outgoing directories =====
+		else if (event->wd!=watcher->directory)
+			{
+			return ((event->mask & (IN_DELETE | IN_MOVED_FROM))!=0);
+			}
+		//===== Input file =====
+		else if (M2MString_compareTo((M2MString *)event->name, CEPCUI_INPUT_FILE_NAME)==0
+				|| M2MString_compareTo((M2MString *)event->name, CEPCUI_BINARY_INPUT_FILE_NAME)==0)
+			{
+			return ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))!=0);
+			}
+		//===== Output file =====
+		else if (this_isOutputFileName((M2MString *)event->name)==true)
+			{
+			return ((event->mask & (IN_DELETE | IN_MOVED_FROM))!=0);
+			}
+		//===== Stop file =====
+		else if (M2MString_compareTo((M2MString *)event->name, CEPCUI_STOP_FILE_NAME)==0)
+			{
+			return ((event->mask & (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO))!=0);
+			}
+		//===== SQL file =====
+		else if (M2MString_compareTo((M2MString *)event->name, CEPCUIQuerySet_SQL_FILE_NAME)==0)
+			{
+			return ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))!=0);
+			}
+		//===== Query directory =====
+		else if (M2MString_compareTo((M2MString *)event->name, CEPCUIQuerySet_DIRECTORY_NAME)==0)
+			{
+			return ((event->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))!=0);
+			}
+		//===== Other file =====
+		else
+			{
+			return false;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		return false;
+		}
+	}
 
 
 /**
- * Get the SQL file path in the regulation directory.<br>
+ * Prepare the output destinations of the queries.<br>
+ * In spool mode, the result of the unnamed query is published to outgoing<br>
+ * directory, and the results of named queries are published to their own<br>
+ * subdirectories ("outgoing/<name>/"), so that each query has its own<br>
+ * sequence and consumer.<br>
+ * With rotation, the results are published to "results/" (or<br>
+ * "results/<name>/") in the same way, and only the newest files are kept.<br>
+ * Otherwise the results are written to "output.csv" (unnamed query) or<br>
+ * "output.<name>.csv" in the regulation directory.<br>
  *
- * @param[out] filePath			Buffer for copying the SQL file path string
- * @param[in] filePathLength	Size of buffer[Byte]
- * @return						Pointer of the buffer which the SQL file path string was copied or NULL (in case of error)
+ * @param[in] cep		CEP object
+ * @param[in] querySet	Set of SELECT queries
+ * @param[in] spool		Spool queue object or NULL (in case of not spool mode)
+ * @param[in] option	Command line options (depth of the directories and rotation)
+ * @return				Output destinations of the queries (allocated in this function) or NULL (in case of error)
  */
-static M2MString *this_getSelectSQLFilePath (M2MString filePath[], const size_t filePathLength);
-
+static CEPCUIOutput *this_newOutputList (const M2MCEP *cep, const CEPCUIQuerySet *querySet, const CEPCUISpool *spool, const CEPCUIOption *option)
+	{
+	//========== Variable ==========
+	CEPCUIOutput *outputList = NULL;
+	size_t i = 0;
+	int length = 0;
+	M2MString ROOT_DIRECTORY_PATH[PATH_MAX];
+	M2MString DIRECTORY_PATH[PATH_MAX];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_newOutputList()";
 
-/**
- * 規程のディレクトリ配下にCEP処理結果であるCSV形式のファイルを出力する。<br>
- *
- * @param[in] result		CSV形式のCEP処理結果データを示す文字列
- * @param[in] resultLength	CSV形式のCEP処理結果データを示す文字列サイズ[Byte]
- * @return					true : ファイル出力に成功、false : ファイル出力に失敗
- */
-static bool this_setResult (const M2MCEP *cep, const M2MString *result, const size_t resultLength);
+	//===== Get the root directory of the published results =====
+	if (spool!=NULL)
+		{
+		snprintf((char *)ROOT_DIRECTORY_PATH, sizeof(ROOT_DIRECTORY_PATH), "%s", spool->outgoingDirectoryPath);
+		}
+	else if (option->rotation>0
+			&& (this_getFilePath(ROOT_DIRECTORY_PATH, sizeof(ROOT_DIRECTORY_PATH), CEPCUI_RESULT_DIRECTORY_NAME)==NULL
+				|| (mkdir((char *)ROOT_DIRECTORY_PATH, 0755)!=0 && errno!=EEXIST)))
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the directory of rotated result files");
+		return NULL;
+		}
+	//===== Allocate new heap memory =====
+	if ((outputList=(CEPCUIOutput *)M2MHeap_malloc(sizeof(CEPCUIOutput) * querySet->count))!=NULL)
+		{
+		for (i=0; i<querySet->count; i++)
+			{
+			//===== Spool mode (or rotation) =====
+			if (spool!=NULL || option->rotation>0)
+				{
+				if (M2MString_length(querySet->queryList[i].name)>0)
+					{
+					length = snprintf((char *)DIRECTORY_PATH, sizeof(DIRECTORY_PATH), "%s/%s", ROOT_DIRECTORY_PATH, querySet->queryList[i].name);
+					}
+				else
+					{
+					length = snprintf((char *)DIRECTORY_PATH, sizeof(DIRECTORY_PATH), "%s", ROOT_DIRECTORY_PATH);
+					}
+				if (length<0 || length>=(int)sizeof(DIRECTORY_PATH))
+					{
+					M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Path of the result directory is too long");
+					this_deleteOutputList(querySet, &outputList);
+					return NULL;
+					}
+				else if ((spool!=NULL && option->rotation<=0
+							&& (outputList[i].publisher=CEPCUIPublisher_new(DIRECTORY_PATH, option->spoolDepth))==NULL)
+						|| (option->rotation>0
+							&& ((outputList[i].publisher=CEPCUIPublisher_new(DIRECTORY_PATH, option->rotation))==NULL
+								|| CEPCUIPublisher_setRotation(outputList[i].publisher, true)==NULL)))
+					{
+					this_deleteOutputList(querySet, &outputList);
+					return NULL;
+					}
+				}
+			//===== Output file in the regulation directory =====
+			else if (this_getOutputFilePath(outputList[i].filePath, sizeof(outputList[i].filePath), querySet->queryList[i].name)==NULL)
+				{
+				this_deleteOutputList(querySet, &outputList);
+				return NULL;
+				}
+			}
+		return outputList;
+		}
+	//===== Error handling =====
+	else
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for output destinations");
+		return NULL;
+		}
+	}
 
 
 /**
- * 引数で指定された時間[usec]だけスリープする。<br>
+ * Map the input file into memory and remove it from the directory.<br>
+ * An empty file is removed without mapping (the batch length is 0).<br>
+ * A binary input file whose header doesn't match the schema is left in the<br>
+ * directory, so that it isn't lost.<br>
  *
- * @param[in] time	スリープ時間[usec]
+ * @param[in] cep		CEP object
+ * @param[in] schema	Schema of the CEP table
+ * @param[in] filePath	Input file path string
+ * @param[out] batch	Mapped input file
+ * @return				true : success, false : the file doesn't exist or failure
  */
-static void this_sleep (const M2MCEP *cep, unsigned long time);
+static bool this_openBatch (const M2MCEP *cep, const CEPCUISchema *schema, const M2MString *filePath, CEPCUIBatch *batch)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	struct stat fileStatus;
+	struct timespec start;
+	CEPCUIBinaryReader reader;
+	M2MString MESSAGE[PATH_MAX+256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_openBatch()";
+
+	//===== Open input file =====
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if ((fd=open((char *)filePath, O_RDONLY | O_CLOEXEC))>=0)
+		{
+		snprintf((char *)batch->filePath, sizeof(batch->filePath), "%s", filePath);
+		batch->data = NULL;
+		batch->length = 0;
+		//===== Get file size =====
+		if (fstat(fd, &fileStatus)!=0 || fileStatus.st_size<=0)
+			{
+			CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "入力ファイルにデータが存在しません");
+			close(fd);
+			unlink((char *)filePath);
+			return true;
+			}
+		//===== Map input file into memory =====
+		else if ((batch->data=(M2MString *)mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0))==MAP_FAILED)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"入力ファイル(=\"%s\")のメモリマップに失敗しました : %s", filePath, strerror(errno));
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			batch->data = NULL;
+			close(fd);
+			return false;
+			}
+		//===== Check the header of binary input file before removing it =====
+		else if (this_isBinaryFilePath(filePath)==true
+				&& CEPCUIBinaryReader_init(&reader, schema, batch->data, (size_t)fileStatus.st_size)==false)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Binary input file(=\"%s\") doesn't have a valid header for the schema", filePath);
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			munmap(batch->data, (size_t)fileStatus.st_size);
+			batch->data = NULL;
+			close(fd);
+			return false;
+			}
+		//===== 入力ファイルを削除 =====
+		close(fd);
+		unlink((char *)filePath);
+		batch->length = (size_t)fileStatus.st_size;
+		madvise(batch->data, batch->length, MADV_SEQUENTIAL);
+		CEPCUIMetrics_record(CEPCUIMetricsStage_READ, &start);
+		CEPCUIMetrics_add(CEPCUIMetricsCounter_READ_BYTE, (uint64_t)batch->length);
+		return true;
+		}
+	//===== 入力ファイルが存在しない場合 =====
+	else if (errno==ENOENT)
+		{
+		CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "入力ファイルが存在しません");
+		return false;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"入力ファイル(=\"%s\")のオープンに失敗しました : %s", filePath, strerror(errno));
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+		return false;
+		}
+	}
 
 
 /**
- * CEP実行の繰り返しを中止するかどうか判定する．
+ * Open the temporary file (".<file name>.tmp" in the same directory) for<br>
+ * writing the output file, so that it can be renamed into place when the<br>
+ * whole result is written.<br>
  *
- * @return	true : 中止する，false : 処理を継続する
+ * @param[in] cep						CEP object
+ * @param[in] filePath					Output file path string
+ * @param[out] temporaryFilePath		Buffer for copying the temporary file path string
+ * @param[in] temporaryFilePathLength	Size of the buffer[Byte]
+ * @return								File descriptor or -1 (in case of error)
  */
-static bool this_stop ();
+static int this_openResult (const M2MCEP *cep, const M2MString *filePath, M2MString temporaryFilePath[], const size_t temporaryFilePathLength)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	const M2MString *fileName = NULL;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_openResult()";
 
+	//===== Get the temporary file path =====
+	if (filePath!=NULL
+			&& (fileName=(M2MString *)strrchr((char *)filePath, '/'))!=NULL
+			&& snprintf((char *)temporaryFilePath, temporaryFilePathLength, "%.*s/.%s.tmp", (int)(fileName - filePath), filePath, fileName + 1)<(int)temporaryFilePathLength)
+		{
+		//===== 一時ファイルを新規に開く =====
+		if ((fd=open((char *)temporaryFilePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))>=0)
+			{
+			return fd;
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"出力ファイル(=\"%s\")のオープンに失敗しました : %s", temporaryFilePath, strerror(errno));
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			return -1;
+			}
+		}
+	//===== Error handling =====
+	else
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"出力ファイルパスを示す文字列が不正です");
+		return -1;
+		}
+	}
 
 
-/*******************************************************************************
- * Private function
- ******************************************************************************/
 /**
- * 入力ファイルの読み込み → CEP → 出力ファイル作成，を繰り返す．
- * 出力ファイルについては，該当する出力が存在しない場合は作成せず，そのままループ<br>
- * 処理を繰り返す．<br>
+ * Start watching the regulation directory with inotify.<br>
+ * In spool mode, incoming directory and the outgoing directories of all the<br>
+ * queries are also watched.<br>
+ * "queries" directory is watched too if it exists, so that modified query<br>
+ * files are reloaded at once.<br>
+ * Since the watch is registered before the loop processing begins, file<br>
+ * events which occur while CEP is running are queued and never lost.<br>
  *
- * @param[in] cep		CEP実行オブジェクト
- * @@aram[in] tableName	テーブル名を示す文字列
- * @param[in] sql		SELECT文を示す文字列
- * @param[in] sleepTime	CEP繰り返し毎のスリープ時間を示す整数[usec]
+ * @param[in] cep			CEP object
+ * @param[out] watcher		inotify watcher object
+ * @param[in] spool			Spool queue object or NULL (in case of not spool mode)
+ * @param[in] querySet		Set of SELECT queries
+ * @param[in] outputList	Output destinations of the queries
+ * @return					true : success, false : failure
  */
-static void this_execute (M2MCEP *cep, const M2MString *tableName, const M2MString *sql, const unsigned long sleepTime)
+static bool this_openWatcher (const M2MCEP *cep, CEPCUIWatcher *watcher, const CEPCUISpool *spool, const CEPCUIQuerySet *querySet, const CEPCUIOutput outputList[])
 	{
 	//========== Variable ==========
-	M2MString *csv = NULL;
-	M2MString *result = NULL;
+	size_t i = 0;
+	bool watching = false;
 	M2MString FILE_PATH[PATH_MAX];
-	M2MString *outputFilePath = NULL;
-	M2MFile *outputFile = NULL;
-	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_execute()";
+	M2MString QUERY_DIRECTORY_PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *DIRECTORY_PATH = this_getDirectoryPath(FILE_PATH, sizeof(FILE_PATH));
+	const uint32_t MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_openWatcher()";
 
 	//===== Check argument =====
-	if (cep!=NULL
-			&& tableName!=NULL && M2MString_length(tableName)>0
-			&& sql!=NULL && M2MString_length(sql)>0
-			&& (outputFilePath=this_getOutputFilePath(FILE_PATH, sizeof(FILE_PATH)))!=NULL
-			&& (outputFile=M2MFile_new(outputFilePath))!=NULL)
+	if (watcher!=NULL && DIRECTORY_PATH!=NULL)
 		{
-		M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"一定間隔でCEPを繰り返すループ処理を開始します");
-		//===== 無限ループ =====
-		while (this_stop(cep)==false)
+		watcher->directory = -1;
+		watcher->incoming = -1;
+		watcher->queries = -1;
+		//===== Create inotify instance =====
+		if ((watcher->fd=inotify_init1(IN_NONBLOCK | IN_CLOEXEC))>=0)
 			{
-			//===== 出力ファイルが規程ディレクトリ内に存在しなかった場合 =====
-			if (M2MFile_exists(outputFile)==false)
+			//===== Watch the regulation directory (and spool directories) =====
+			watching = ((watcher->directory=inotify_add_watch(watcher->fd, (char *)DIRECTORY_PATH, MASK))>=0
+					&& (spool==NULL || (watcher->incoming=inotify_add_watch(watcher->fd, (char *)spool->incomingDirectoryPath, IN_CLOSE_WRITE | IN_MOVED_TO))>=0));
+			for (i=0; watching==true && spool!=NULL && i<querySet->count; i++)
 				{
-				M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"規程のディレクトリに設置された出力ファイルが存在しない事を確認しました．．．CEPを実行します");
-				//===== CSV形式のレコードを取得した場合 =====
-				if (this_getCSV(cep, &csv)!=NULL)
-					{
-					M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"規程のディレクトリに設置されたファイルからCSV形式の入力データを取得しました");
-					//===== CEPデータベースへ挿入 =====
-					M2MCEP_insertCSV(cep, tableName, csv);
-					M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"CSV形式の入力データをSQLite3データベースに挿入しました");
-					M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"CEPを実行します");
-					//===== CEP実行 =====
-					if (M2MCEP_select(cep, sql, &result)!=NULL)
-						{
-						M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"CEP実行結果のCSV形式の文字列を規程ディレクトリのファイルに出力します");
-						//===== CEP実行結果を出力 =====
-						this_setResult(cep, result, M2MString_length(result));
-						//===== メモリ領域の解放 =====
-						M2MHeap_free(result);
-						}
-					//===== CEPで条件に合致するデータが存在しなかった場合 =====
-					else
-						{
-						M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"CEPで合致するレコードが見つかりませんでした");
-						}
-					//===== メモリ領域の解放 =====
-					M2MHeap_free(csv);
-					}
-				//===== CSV形式のレコードを取得しなかった場合 =====
-				else if (csv==NULL)
+				watching = (inotify_add_watch(watcher->fd, (char *)outputList[i].publisher->directoryPath, IN_DELETE | IN_MOVED_FROM)>=0);
+				}
+			if (watching==true)
+				{
+				//===== Watch the query directory (only if it exists) =====
+				if (snprintf((char *)QUERY_DIRECTORY_PATH, sizeof(QUERY_DIRECTORY_PATH), "%s/%s", DIRECTORY_PATH, CEPCUIQuerySet_DIRECTORY_NAME)<(int)sizeof(QUERY_DIRECTORY_PATH))
 					{
-					M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"規程のディレクトリに設置された入力ファイルが見つかりませんでした");
+					watcher->queries = inotify_add_watch(watcher->fd, (char *)QUERY_DIRECTORY_PATH, IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
 					}
+				CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Started watching the directory(=\"%s\") with inotify", DIRECTORY_PATH);
+				return true;
 				}
-			//===== 出力ファイルが規程ディレクトリ内に存在する場合 =====
+			//===== Error handling =====
 			else
 				{
-				M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"規程のディレクトリに設置された出力ファイルが存在するためCEPは実行しません");
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to watch the directory(=\"%s\") : %s", DIRECTORY_PATH, strerror(errno));
+				M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+				close(watcher->fd);
+				watcher->fd = -1;
+				return false;
 				}
-			//===== 一定時間スリープ =====
-			this_sleep(cep, sleepTime);
-			M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"CEPを繰り返します");
 			}
-		M2MFile_delete(&outputFile);
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to create inotify instance : %s", strerror(errno));
+			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+			return false;
+			}
 		}
 	//===== Argument error =====
-	else if (cep==NULL)
-		{
-		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたCEP実行オブジェクトがNULLです");
-		}
-	else if (tableName==NULL || M2MString_length(tableName)<=0)
+	else if (watcher==NULL)
 		{
-		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたテーブル名がNULLです");
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated watcher object is NULL");
+		return false;
 		}
+	//===== Error handling =====
 	else
 		{
-		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたSQLを示す文字列がNULL，または文字列数が0以下です");
+		watcher->fd = -1;
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to get the regulation directory path");
+		return false;
 		}
+	}
+
+
+/**
+ * Print the usage of the command line to the standard error.<br>
+ *
+ * @param[in] programName	Name of the executable
+ */
+static void this_printUsage (const char *programName)
+	{
+	fprintf(stderr,
+			"Usage: %s [options] [sleep time[usec] [maximum number of records]]\n"
+			"\n"
+			"  --poll                 Don't use inotify, poll the folder at the sleep time intervals\n"
+			"  --spool                Use the spool folders instead of input.csv and output.csv\n"
+			"  --coalesce             Coalesce all the pending input files into one batch in spool mode\n"
+			"  --spool-depth=N        Maximum number of unconsumed result files in spool mode\n"
+			"  --chunk-size=N         Size of the input data inserted in one transaction[Byte]\n"
+			"  --batch-rows=N         Maximum number of records inserted in one transaction\n"
+			"  --pipeline             Run reading, CEP and writing on their own threads in spool mode\n"
+			"  --shards=N             Number of shards of the table executed on their own threads\n"
+			"  --shard-key=NAME       Column by which the records are partitioned among the shards\n"
+			"  --rotate=N             Publish every result as a new sequenced file and keep the newest N files\n"
+			"  --pipe                 Read records from stdin and write results to stdout\n"
+			"  --pipe-rows=N          Number of records which closes a micro-batch in pipe mode\n"
+			"  --pipe-interval=N      Maximum waiting time[msec] of a micro-batch in pipe mode\n"
+			"  --listen[=PATH]        Receive records from producers on the Unix domain socket\n"
+			"  --ring[=NAME]          Receive records from producers through the shared memory ring buffer\n"
+			"  --ring-size=N          Size of the data area of the ring buffer[Byte]\n"
+			"  --stats=N              Interval of rewriting the stats file[sec] (0 : disabled)\n"
+			"  --metrics-port=N       Serve the metrics in Prometheus text format on 127.0.0.1:N\n"
+			"  --window=N             Keep the records of the last N seconds in the table\n"
+			"  --window-column=NAME   Time column of the time window\n"
+			"  --window-memory=N      Maximum size of the table[MiB]\n"
+			"  --incremental          Maintain the results of simple aggregate queries incrementally\n"
+			"  --delta                Write only the records which weren't in the previous result\n"
+			"  --delta-retract        Write the new records with \"+\" and the retracted ones with \"-\"\n"
+			"  --min-interval=N       Minimum interval of the adaptive cycles[usec]\n"
+			"  --max-interval=N       Maximum interval of the adaptive cycles[usec]\n"
+			"  --snapshot=N           Interval of the snapshots of the CEP table[sec]\n"
+			"  --log-level=LEVEL      Minimum level of the logged messages (\"debug\", \"info\" or \"error\")\n",
+			programName);
 	return;
 	}
 
 
 /**
- * 規程のディレクトリ配下に入力ファイルが存在するかどうか確認し、ファイルが存在<br>
- * する場合は当該ファイルのデータを読み取り、引数で指定されたポインタにコピー<br>
- * する。<br>
- * なお、入力ファイル名は同一であるため、データのコピーが済み次第、入力ファイル<br>
- * 自体は当該関数が削除する。<br>
- * <br>
- * 【CEP実行のための入出力ファイル有無の条件】<br>
- * ・input.csv : ○, output.csv : ○ → CEP実行 : ×<br>
- * ・input.csv : ○, output.csv : × → CEP実行 : ○<br>
- * ・input.csv : ×, output.csv : ○ → CEP実行 : ×<br>
- * ・input.csv : ×, output.csv : × → CEP実行 : ×<br>
+ * Reading stage of the pipeline (thread function).<br>
+ * Maps the input files in the incoming directory in arrival order, starts<br>
+ * reading them ahead and passes them to the main thread.<br>
  *
- * @param[out] csv	CSV形式の入力データをコピーするためのポインタ(関数内部でヒープメモリを獲得する)
- * @return			コピーした入力データのポインタ or NULL(エラーの場合)
+ * @param[in,out] argument	Pipeline object
+ * @return					NULL
  */
-static M2MString *this_getCSV (const M2MCEP *cep, M2MString **csv)
+static void *this_read (void *argument)
 	{
 	//========== Variable ==========
-	M2MString *inputData = NULL;
-	M2MString FILE_PATH[PATH_MAX];
-	M2MFile *inputFile = NULL;
-	M2MString MESSAGE[256];
-	const M2MString *INPUT_FILE_PATH = this_getInputFilePath(FILE_PATH, sizeof(FILE_PATH));
-	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_getCSV()";
+	CEPCUIPipeline *pipeline = (CEPCUIPipeline *)argument;
+	CEPCUIWatcher watcher = {-1, -1, -1, -1};
+	CEPCUIBatch *batch = NULL;
+	M2MString **fileList = NULL;
+	size_t count = 0;
+	size_t consumed = 0;
+	size_t i = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_read()";
 
-	//===== Check argument =====
-	if (csv!=NULL && (inputFile=M2MFile_new(INPUT_FILE_PATH))!=NULL)
+	//===== Watch the incoming directory (or poll it) =====
+	if ((watcher.fd=inotify_init1(IN_NONBLOCK | IN_CLOEXEC))>=0
+			&& (watcher.incoming=inotify_add_watch(watcher.fd, (char *)pipeline->spool->incomingDirectoryPath, IN_CLOSE_WRITE | IN_MOVED_TO))<0)
+		{
+		close(watcher.fd);
+		watcher.fd = -1;
+		}
+	while (atomic_load(&pipeline->reading)==true)
 		{
-		//===== 入力ファイルが存在する場合 =====
-		if (M2MFile_exists(inputFile)==true)
+		//===== Get input files in arrival order =====
+		if ((count=CEPCUISpool_getIncomingFileList(pipeline->spool, &fileList, CEPCUI_PIPELINE_DEPTH))>0)
 			{
-			//===== 入力ファイルを開く =====
-			if (M2MFile_open(inputFile)!=NULL)
+			for (i=0, consumed=0; i<count && atomic_load(&pipeline->reading)==true; i++)
 				{
-				//===== CSV形式の入力データをファイルから取得 =====
-				if (M2MFile_read(inputFile, &inputData)>0)
+				//===== Map the input file and read it ahead =====
+				if ((batch=(CEPCUIBatch *)M2MHeap_malloc(sizeof(CEPCUIBatch)))!=NULL
+						&& this_openBatch(pipeline->cep, pipeline->schema, fileList[i], batch)==true
+						&& batch->length>0)
 					{
-					//===== ファイルを閉じる =====
-					M2MFile_close(inputFile);
+					madvise(batch->data, batch->length, MADV_WILLNEED);
+					CEPCUIQueue_push(pipeline->batchQueue, batch);
+					consumed++;
 					}
-				//===== Error handling =====
+				//===== Empty file or error (a file left in incoming directory is rejected) =====
 				else
 					{
-					memset(MESSAGE, 0, sizeof(MESSAGE));
-					snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"規程のディレクトリの入力ファイル(=\"%s\")からのデータ読み取りに失敗しました", INPUT_FILE_PATH);
-					M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
-					//===== ファイルを閉じる =====
-					M2MFile_close(inputFile);
-					}
-				//===== 改行コードを補正 =====
-				if (M2MString_convertFromLFToCRLF(inputData, csv)!=NULL)
-					{
-					//===== 入力データが存在する場合 =====
-					if (inputData!=NULL)
-						{
-						//===== ヒープメモリ領域を解放 =====
-						M2MHeap_free(inputData);
-						}
-					//===== 入力データが存在しない場合 =====
-					else
-						{
-						// 何もしない
-						}
-					//===== 入力ファイルを削除 =====
-					M2MFile_remove(inputFile);
-					M2MFile_delete(&inputFile);
-					//===== 正常終了 =====
-					return (*csv);
-					}
-				//===== Error handling =====
-				else
-					{
-					//===== 入力データが存在する場合 =====
-					if (inputData!=NULL)
-						{
-						//===== ヒープメモリ領域を解放 =====
-						M2MHeap_free(inputData);
-						}
-					//===== 入力データが存在しない場合 =====
-					else
+					if (batch!=NULL && (access((char *)fileList[i], F_OK)!=0 || CEPCUISpool_reject(pipeline->spool, fileList[i])==true))
 						{
-						// 何もしない
+						consumed++;
 						}
-					M2MFile_delete(&inputFile);
-					return NULL;
+					M2MHeap_free(batch);
 					}
 				}
-			//===== Error handling =====
-			else
+			CEPCUISpool_deleteFileList(&fileList, count);
+			//===== Wait instead of retrying the files which can't be removed =====
+			if (consumed==0)
 				{
-				memset(MESSAGE, 0, sizeof(MESSAGE));
-				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"規程のディレクトリに入力ファイル(=\"%s\")が存在しません", INPUT_FILE_PATH);
-				M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
-				M2MFile_delete(&inputFile);
-				return NULL;
+				this_wait(pipeline->cep, &watcher, CEPCUI_PIPELINE_POLL_TIME);
 				}
 			}
-		//===== 入力ファイルが存在しない場合 =====
+		//===== Wait for new input files =====
 		else
 			{
-			M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"規程のディレクトリに入力ファイルが存在しません");
-			M2MFile_delete(&inputFile);
-			return NULL;
+			this_wait(pipeline->cep, &watcher, CEPCUI_PIPELINE_POLL_TIME);
 			}
 		}
-	//===== Argument error =====
-	else
+	//===== Stop watching =====
+	if (watcher.fd>=0)
 		{
-		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたCSV形式の入力データをコピーするためのポインタがNULLです");
-		return NULL;
+		close(watcher.fd);
 		}
+	CEPCUILog_debug(M2MCEP_getLogger(pipeline->cep), METHOD_NAME, __LINE__, "Stopped the reading thread");
+	atomic_store(&pipeline->readerStopped, true);
+	return NULL;
 	}
 
 
 /**
- * Get the file path in the regulation directory.<br>
+ * Drain all the queued events of the inotify watcher.<br>
  *
- * @param[out] filePath			Buffer for copying the file path string
- * @param[in] filePathLength	Size of buffer[Byte]
- * @param[in] fileName			The file name string
- * @return						Pointer of the buffer which the file path string was copied or NULL (in case of error)
+ * @param[in] watcher	inotify watcher object
+ * @return				true : a relevant event occurred, false : no relevant event
  */
-static M2MString *this_getFilePath (M2MString filePath[], const size_t filePathLength, const M2MString fileName[])
+static bool this_readEvent (const CEPCUIWatcher *watcher)
 	{
 	//========== Variable ==========
-	const M2MString *HOME_DIRECTORY = M2MDirectory_getHomeDirectoryPath();
-	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_getFilePath()";
+	ssize_t length = 0;
+	char *pointer = NULL;
+	const struct inotify_event *event = NULL;
+	bool relevant = false;
+	char EVENT[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
 
-	//===== Check argument =====
-	if (filePath!=NULL && filePathLength>0)
-		{
-		//===== Create new file pathname string =====
-		memset(filePath, 0, filePathLength);
-		snprintf(filePath, filePathLength-1, (M2MString *)"%s/%s/%s", HOME_DIRECTORY, M2MCEP_DIRECTORY, fileName);
-		return filePath;
-		}
-	//===== Argument error =====
-	else if (filePath==NULL)
-		{
-		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated \"filePath\" buffer is NULL");
-		return NULL;
-		}
-	else
+	while ((length=read(watcher->fd, EVENT, sizeof(EVENT)))>0)
 		{
-		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Size of indicated \"filePath\" buffer is 0[Byte] or less");
-		return NULL;
+		for (pointer=EVENT; pointer<EVENT+length; pointer+=sizeof(struct inotify_event)+event->len)
+			{
+			event = (const struct inotify_event *)pointer;
+			if (this_isRelevantEvent(watcher, event)==true)
+				{
+				relevant = true;
+				}
+			}
 		}
+	return relevant;
 	}
 
 
 /**
- * Get the input file path in the regulation directory.<br>
+ * Insert the records received from a producer in server mode or ring<br>
+ * mode into the CEP table (called back by CEPCUIServer_receive() or<br>
+ * CEPCUIRing_receive()).<br>
  *
- * @param[out] filePath			Buffer for copying the input file path string
- * @param[in] filePathLength	Size of buffer[Byte]
- * @return						Pointer of the buffer which the input file path string was copied or NULL (in case of error)
+ * @param[in,out] argument	Receiver object
+ * @param[in] binary		true : typed binary records, false : CSV format records
+ * @param[in] data			Records (not NULL terminated)
+ * @param[in] dataLength	Size of the records[Byte]
+ * @return					true : success, false : failure
  */
-static M2MString *this_getInputFilePath (M2MString filePath[], const size_t filePathLength)
+static bool this_receive (void *argument, const bool binary, const M2MString *data, const size_t dataLength)
 	{
 	//========== Variable ==========
-	const M2MString *FILE_NAME = (M2MString *)"input.csv";
+	CEPCUIReceiver *receiver = (CEPCUIReceiver *)argument;
+	CEPCUICSVTokenizer tokenizer;
+	CEPCUIBinaryReader reader;
+	const size_t *position = &tokenizer.position;
+	int64_t inserted = 0;
+	int64_t records = 0;
+	struct timespec start;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_receive()";
 
-	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_READ_BYTE, (uint64_t)dataLength);
+	//===== Binary records =====
+	if (binary==true)
+		{
+		if (CEPCUIBinaryReader_init(&reader, receiver->schema, data, dataLength)==false)
+			{
+			M2MLogger_error(M2MCEP_getLogger(receiver->cep), METHOD_NAME, __LINE__, (M2MString *)"Received binary records don't have a valid header for the schema");
+			return false;
+			}
+		position = &reader.position;
+		}
+	//===== CSV format records =====
+	else
+		{
+		CEPCUICSVTokenizer_init(&tokenizer, data, dataLength);
+		}
+	//===== Insert records chunk by chunk =====
+	while ((*position)<dataLength)
+		{
+		if (receiver->shardSet!=NULL)
+			{
+			inserted = (binary==true) ? CEPCUIShardSet_insertBinary(receiver->shardSet, &reader, receiver->chunkSize) : CEPCUIShardSet_insertCSV(receiver->shardSet, &tokenizer, receiver->chunkSize);
+			}
+		else
+			{
+			inserted = (binary==true) ? CEPCUIInserter_insertBinary(receiver->inserter, &reader, receiver->chunkSize) : CEPCUIInserter_insertCSV(receiver->inserter, &tokenizer, receiver->chunkSize);
+			}
+		if (inserted<0)
+			{
+			break;
+			}
+		records += inserted;
+		}
+	//===== Record the insertion =====
+	receiver->records += records;
+	CEPCUIMetrics_record(CEPCUIMetricsStage_INSERT, &start);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_BATCH, 1);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_INSERTED_ROW, (uint64_t)records);
+	if (inserted<0)
+		{
+		return false;
+		}
+	//===== Truncated binary records =====
+	else if (binary==true && reader.broken==true)
+		{
+		M2MLogger_error(M2MCEP_getLogger(receiver->cep), METHOD_NAME, __LINE__, (M2MString *)"Received binary records are truncated, so the last record was discarded");
+		}
+	return true;
 	}
 
 
 /**
- * Get the output file path in the regulation directory.<br>
+ * Replace the queries with the modified query files.<br>
+ * The new queries are loaded and compiled first, and swapped in only when<br>
+ * all of them are compiled successfully; otherwise the current queries are<br>
+ * kept. The records accumulated in the CEP table are never touched.<br>
  *
- * @param[out] filePath			Buffer for copying the output file path string
- * @param[in] filePathLength	Size of buffer[Byte]
- * @return						Pointer of the buffer which the output file path string was copied or NULL (in case of error)
+ * @param[in] cep				CEP object
+ * @param[in,out] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in] directoryPath		Regulation directory path string
+ * @param[in,out] querySet		Set of prepared SELECT queries (replaced in this function)
+ * @param[in,out] outputList	Output destinations of the queries (replaced in this function)
+ * @param[in] spool				Spool queue object or NULL (in case of not spool mode)
+ * @param[in] option			Command line options
+ * @param[in,out] watcher		inotify watcher object (re-opened for the new output destinations)
+ * @return						true : replaced, false : the current queries are kept
  */
-static M2MString *this_getOutputFilePath (M2MString filePath[], const size_t filePathLength)
+static bool this_reload (M2MCEP *cep, CEPCUIShardSet *shardSet, const M2MString *directoryPath, CEPCUIQuerySet **querySet, CEPCUIOutput **outputList, const CEPCUISpool *spool, const CEPCUIOption *option, CEPCUIWatcher *watcher)
 	{
 	//========== Variable ==========
-	const M2MString *FILE_NAME = (M2MString *)"output.csv";
+	CEPCUIQuerySet *newQuerySet = NULL;
+	CEPCUIOutput *newOutputList = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_reload()";
 
-	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	//===== Load and compile the modified queries =====
+	if ((newQuerySet=CEPCUIQuerySet_new(directoryPath))==NULL
+			|| CEPCUIQuerySet_prepare(newQuerySet, this_getMemoryDatabase(cep))==NULL
+			|| CEPCUIQuerySet_setIncremental(newQuerySet, option->incremental)==NULL
+			|| CEPCUIQuerySet_setDelta(newQuerySet, option->delta, option->retract)==NULL)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"The modified queries are invalid, so the current queries are kept");
+		CEPCUIQuerySet_delete(&newQuerySet);
+		return false;
+		}
+	//===== Prepare the output destinations of the new queries =====
+	else if ((newOutputList=this_newOutputList(cep, newQuerySet, spool, option))==NULL)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the output destinations of the modified queries, so the current queries are kept");
+		CEPCUIQuerySet_delete(&newQuerySet);
+		return false;
+		}
+	//===== Compile the modified queries on every shard =====
+	else if (shardSet!=NULL && CEPCUIShardSet_reload(shardSet, directoryPath)==false)
+		{
+		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to compile the modified queries on the shards, so the current queries are kept");
+		this_deleteOutputList(newQuerySet, &newOutputList);
+		CEPCUIQuerySet_delete(&newQuerySet);
+		return false;
+		}
+	//===== Swap the queries =====
+	this_deleteOutputList((*querySet), outputList);
+	CEPCUIQuerySet_delete(querySet);
+	(*querySet) = newQuerySet;
+	(*outputList) = newOutputList;
+	//===== Watch the new output destinations =====
+	if (option->eventDriven==true)
+		{
+		if (watcher->fd>=0)
+			{
+			close(watcher->fd);
+			watcher->fd = -1;
+			}
+		if (this_openWatcher(cep, watcher, spool, (*querySet), (*outputList))==false)
+			{
+			CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Failed to restart inotify watcher, so fall back to polling");
+			}
+		}
+	CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Reloaded %zu queries", (*querySet)->count);
+	return true;
 	}
 
 
 /**
- * 規程のディレクトリ配下にSELECT用SQLを示すファイル(＝"select.sql")が存在<br>
- * するかどうか確認し、ファイルが存在する場合は当該ファイルのデータを読み取り、<br>
- * 引数で指定されたポインタにコピーする。<br>
+ * Execute all the queries on the CEP table and output each result to the<br>
+ * output destination of the query.<br>
+ * Nothing is output for a query which matches no record.<br>
+ * The result is streamed to the output file through a fixed-size buffer as<br>
+ * the records are stepped, so it is never held in memory as a whole<br>
+ * (except for sharded tables, whose results are merged in memory).<br>
  *
- * @param[out] sql	SELECT用SQL文字列をコピーするためのポインタ(関数内部でヒープメモリを獲得する)
- * @return			コピーしたSQL文字列のポインタ or NULL(エラーの場合)
+ * @param[in] cep				CEP object
+ * @param[in,out] querySet		Set of prepared SELECT queries
+ * @param[in,out] shardSet		Shard set object or NULL (in case of not sharded)
+ * @param[in,out] outputList	Output destinations of the queries
+ * @param[in,out] arena			Per-cycle arena (reset in this function)
+ * @return						Number of queries which matched records
  */
-static M2MString *this_getSelectSQL (M2MString **sql)
+static size_t this_select (M2MCEP *cep, CEPCUIQuerySet *querySet, CEPCUIShardSet *shardSet, CEPCUIOutput outputList[], CEPCUIArena *arena)
 	{
 	//========== Variable ==========
-	M2MString FILE_PATH[PATH_MAX];
-	M2MString *sqlFilePath = NULL;
-	M2MFile *sqlFile = NULL;
-	M2MString MESSAGE[256];
-	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_getSelectSQL()";
+	M2MString *result = NULL;
+	CEPCUIStream stream;
+	int64_t records = 0;
+	size_t i = 0;
+	size_t count = 0;
+	struct timespec start;
+	M2MString BUFFER[CEPCUI_RESULT_BUFFER_LENGTH];
 
-	//===== Check argument =====
-	if (sql!=NULL 
-			&& (sqlFilePath=this_getSelectSQLFilePath(FILE_PATH, sizeof(FILE_PATH)))!=NULL
-			&& (sqlFile=M2MFile_new(sqlFilePath))!=NULL)
+	//===== Release the buffers of the previous cycle =====
+	CEPCUIArena_reset(arena);
+	for (i=0; i<querySet->count; i++)
 		{
-		//===== 入力ファイルを開く =====
-		if (M2MFile_exists(sqlFile)==true)
+		//===== Merge the results of the shards (in the arena) =====
+		if (shardSet!=NULL)
 			{
-			if (M2MFile_open(sqlFile)!=NULL)
+			if (this_selectQuery(querySet, shardSet, i, arena, &result)!=NULL)
 				{
-				//===== CSV形式の入力データをファイルから取得 =====
-				if (M2MFile_read(sqlFile, sql)>0)
+				//===== CEP実行結果を出力 =====
+				if (outputList[i].publisher!=NULL)
 					{
-					//===== ファイルを閉じる =====
-					M2MFile_close(sqlFile);
+					CEPCUIPublisher_publish(outputList[i].publisher, result, M2MString_length(result));
 					}
-				//===== Error handling =====
 				else
 					{
-					memset(MESSAGE, 0, sizeof(MESSAGE));
-					snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"規程のディレクトリの入力ファイル(=\"%s\")からデータ読み取りに失敗しました", sqlFilePath);
-					M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
-					//===== ファイルを閉じる =====
-					M2MFile_close(sqlFile);
+					this_setResult(cep, outputList[i].filePath, result, M2MString_length(result));
 					}
-				//===== 正常終了 =====
-				M2MFile_delete(&sqlFile);
-				return (*sql);
-				}
-			//===== Error handling =====
-			else
-				{
-				memset(MESSAGE, 0, sizeof(MESSAGE));
-				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"規程のディレクトリの入力ファイル(=\"%s\")のオープン処理に失敗しました", sqlFilePath);
-				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
-				M2MFile_delete(&sqlFile);
-				return NULL;
+				count++;
 				}
 			}
+		//===== CEP実行 (streaming the result from the cached statement) =====
 		else
 			{
-			memset(MESSAGE, 0, sizeof(MESSAGE));
-			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"The input file(=\"%s\") on regulation directory can't be found", sqlFilePath);
-			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
-			M2MFile_delete(&sqlFile);
-			return NULL;
+			stream.cep = cep;
+			stream.output = &outputList[i];
+			stream.fd = -1;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			records = CEPCUIQuerySet_selectEach(querySet, i, BUFFER, sizeof(BUFFER), this_streamResult, &stream);
+			CEPCUIMetrics_record(CEPCUIMetricsStage_SELECT, &start);
+			CEPCUIMetrics_add(CEPCUIMetricsCounter_MATCHED_ROW, (records>0) ? (uint64_t)records : 0);
+			//===== Publish the output (or discard it in case of error) =====
+			if (stream.fd>=0 && outputList[i].publisher!=NULL)
+				{
+				CEPCUIPublisher_close(outputList[i].publisher, stream.fd, records>0);
+				}
+			else if (stream.fd>=0)
+				{
+				this_closeResult(cep, stream.fd, stream.temporaryFilePath, outputList[i].filePath, records>0);
+				}
+			if (records>0)
+				{
+				count++;
+				}
 			}
 		}
-	//===== Argument error =====
-	else
-		{
-		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"引数で指定されたSELECT用SQL文字列をコピーするためのポインタがNULLです");
-		return NULL;
-		}
-	}
-
-
-/**
- * Get the SQL file path in the regulation directory.<br>
- *
- * @param[out] filePath			Buffer for copying the SQL file path string
- * @param[in] filePathLength	Size of buffer[Byte]
- * @return						Pointer of the buffer which the SQL file path string was copied or NULL (in case of error)
- */
-static M2MString *this_getSelectSQLFilePath (M2MString filePath[], const size_t filePathLength)
-	{
-	//========== Variable ==========
-	const M2MString *FILE_NAME = (M2MString *)"select.sql";
-
-	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	return count;
 	}
 
 
 /**
- * Get the stop file path in the regulation directory.<br>
+ * Execute the query on the CEP table, or on all the shards when the table<br>
+ * is sharded.<br>
  *
- * @param[out] filePath			Buffer for copying the stop file path string
- * @param[in] filePathLength	Size of buffer[Byte]
- * @return						Pointer of the buffer which the stop file path string was copied or NULL (in case of error)
+ * @param[in,out] querySet	Set of prepared SELECT queries
+ * @param[in,out] shardSet	Shard set object or NULL (in case of not sharded)
+ * @param[in] index			Index of the query
+ * @param[in,out] arena		Arena for the result string or NULL (in case of heap memory)
+ * @param[out] result		Pointer for copying the result string (allocated in the arena or heap memory)
+ * @return					Result string or NULL (in case of no record or error)
  */
-static M2MString *this_getStopFilePath (M2MString filePath[], const size_t filePathLength)
+static M2MString *this_selectQuery (CEPCUIQuerySet *querySet, CEPCUIShardSet *shardSet, const size_t index, CEPCUIArena *arena, M2MString **result)
 	{
 	//========== Variable ==========
-	const M2MString *FILE_NAME = (M2MString *)"cepcui.stop";
+	M2MString *selected = NULL;
+	struct timespec start;
 
-	return this_getFilePath(filePath, filePathLength, FILE_NAME);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (shardSet!=NULL)
+		{
+		selected = CEPCUIShardSet_select(shardSet, index, arena, result);
+		}
+	else
+		{
+		selected = CEPCUIQuerySet_select(querySet, index, arena, result);
+		}
+	CEPCUIMetrics_record(CEPCUIMetricsStage_SELECT, &start);
+	CEPCUIMetrics_add(CEPCUIMetricsCounter_MATCHED_ROW, this_countRecords(selected));
+	return selected;
 	}
 
 
 /**
  * 規程のディレクトリ配下にCEP処理結果であるCSV形式のファイルを出力する。<br>
+ * 結果は同じディレクトリの一時ファイル(".<ファイル名>.tmp")に書き込んだ後に<br>
+ * リネームするため，読み込み側が書き込み途中のファイルを見る事はない。<br>
  *
+ * @param[in] filePath		出力ファイルパスを示す文字列
  * @param[in] result		CSV形式のCEP処理結果データを示す文字列
  * @param[in] resultLength	CSV形式のCEP処理結果データを示す文字列サイズ[Byte]
  * @return					true : ファイル出力に成功、false : ファイル出力に失敗
  */
-static bool this_setResult (const M2MCEP *cep, const M2MString *result, const size_t resultLength)
+static bool this_setResult (const M2MCEP *cep, const M2MString *filePath, const M2MString *result, const size_t resultLength)
 	{
 	//========== Variable ==========
-	M2MFile *file = NULL;
-	M2MString FILE_PATH[PATH_MAX];
-	M2MString MESSAGE[256];
-	const M2MString *OUTPUT_FILE_PATH = this_getOutputFilePath(FILE_PATH, sizeof(FILE_PATH));
+	int fd = -1;
+	M2MString TEMPORARY_FILE_PATH[PATH_MAX];
 	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_setResult()";
 
 	//===== Check argument =====
 	if (result!=NULL && resultLength)
 		{
-		//===== 出力ファイルパスの確認 =====
-		if (OUTPUT_FILE_PATH!=NULL && (file=M2MFile_new(OUTPUT_FILE_PATH))!=NULL)
+		//===== 一時ファイルに出力してリネーム =====
+		if ((fd=this_openResult(cep, filePath, TEMPORARY_FILE_PATH, sizeof(TEMPORARY_FILE_PATH)))>=0)
 			{
-			//===== 出力ファイルを新規に開く =====
-			if ((file=M2MFile_open(file))!=NULL)
-				{
-				//===== 出力ファイルにデータ出力 =====
-				M2MFile_write(file, result, resultLength);
-				M2MFile_close(file);
-				M2MFile_delete(&file);
-				return true;
-				}
-			//===== Error handling =====
-			else
-				{
-				memset(MESSAGE, 0, sizeof(MESSAGE));
-				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"出力ファイル(=\"%s\")のオープンに失敗しました", OUTPUT_FILE_PATH);
-				M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
-				M2MFile_delete(&file);
-				return false;
-				}
+			return this_closeResult(cep, fd, TEMPORARY_FILE_PATH, filePath, this_writeResult(fd, result, resultLength));
 			}
 		//===== Error handling =====
 		else
 			{
-			M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"出力ファイルパスを示す文字列がNULLです");
 			return false;
 			}
 		}
@@ -567,9 +3276,8 @@ static bool this_setResult (const M2MCEP *cep, const M2MString *result, const si
 static void this_sleep (const M2MCEP *cep, unsigned long time)
 	{
 	//========== Variable ==========
-	M2MString MESSAGE[128];
 	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_sleep()";
-	const unsigned long DEFAULT_SLEEP_TIME = 15000000;
+	const unsigned long DEFAULT_SLEEP_TIME = CEPCUI_DEFAULT_SLEEP_TIME;
 
 	//===== Check argument =====
 	if (time>0)
@@ -582,9 +3290,7 @@ static void this_sleep (const M2MCEP *cep, unsigned long time)
 		//===== スリープ時間をデフォルト値にセット =====
 		time = DEFAULT_SLEEP_TIME;
 		}
-	memset(MESSAGE, 0, sizeof(MESSAGE));
-	snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"\"%lu\"[usec]の間スリープします", time);
-	M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
+	CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "\"%lu\"[usec]の間スリープします", time);
 	//===== スリープ =====
 	usleep(time);
 	return;
@@ -597,46 +3303,257 @@ static void this_sleep (const M2MCEP *cep, unsigned long time)
  * 場合，即座にループ処理を中止する（ファイルの中身は空でよい)．<br>
  * 当該ファイルが存在しない場合，そのまま処理を継続する．<br>
  *
- * @return	true : 中止する，false : 処理を継続する
+ * The path resolved in the runtime context is checked with access(), so<br>
+ * no object is created on every check.<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] context	Runtime context (stop file path)
+ * @return				true : 中止する，false : 処理を継続する
  */
-static bool this_stop (const M2MCEP *cep)
+static bool this_stop (const M2MCEP *cep, const CEPCUIContext *context)
 	{
 	//========== Variable ==========
-	M2MString *stopFilePath = NULL;
-	M2MString FILE_PATH[PATH_MAX];
-	M2MFile *stopFile = NULL;
-	M2MString MESSAGE[256];
 	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_stop()";
 
-	//===== Create file path =====
-	if ((stopFilePath=this_getStopFilePath(FILE_PATH, sizeof(FILE_PATH)))!=NULL
-			&& (stopFile=M2MFile_new(stopFilePath))!=NULL)
+	//===== 中止ファイルが存在している場合 =====
+	if (access((char *)context->stopFilePath, F_OK)==0)
+		{
+		CEPCUILog_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "ループ処理を中止するためのファイル（＝\"%s\")が存在するため，処理を中止します", context->stopFilePath);
+		return true;
+		}
+	//===== 中止ファイルが存在しない場合 =====
+	else
+		{
+		CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "ループ処理を中止するためのファイル（＝\"%s\")が存在しないため，処理を継続します", context->stopFilePath);
+		return false;
+		}
+	}
+
+
+/**
+ * Write the chunk of a query result to its output (writer of<br>
+ * CEPCUIQuerySet_selectEach()).<br>
+ * The temporary output file is opened on the first chunk.<br>
+ *
+ * @param[in,out] argument	Stream object
+ * @param[in] data			Chunk of the result
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_streamResult (void *argument, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	CEPCUIStream *stream = (CEPCUIStream *)argument;
+
+	//===== Open the output on the first chunk =====
+	if (stream->fd<0)
 		{
-		//===== 中止ファイルが存在している場合 =====
-		if (M2MFile_exists(stopFile)==true)
+		if (stream->output->publisher!=NULL)
 			{
-			memset(MESSAGE, 0, sizeof(MESSAGE));
-			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"ループ処理を中止するためのファイル（＝\"%s\")が存在するため，処理を中止します", FILE_PATH);
-			M2MLogger_info(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
-			M2MFile_delete(&stopFile);
-			return true;
+			stream->fd = CEPCUIPublisher_open(stream->output->publisher);
 			}
-		//===== 中止ファイルが存在しない場合 =====
 		else
 			{
-			memset(MESSAGE, 0, sizeof(MESSAGE));
-			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"ループ処理を中止するためのファイル（＝\"%s\")が存在しないため，処理を継続します", FILE_PATH);
-			M2MLogger_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, MESSAGE);
-			M2MFile_delete(&stopFile);
-			return false;
+			stream->fd = this_openResult(stream->cep, stream->output->filePath, stream->temporaryFilePath, sizeof(stream->temporaryFilePath));
 			}
 		}
-	//===== Error handling =====
+	return (stream->fd>=0 && this_writeResult(stream->fd, data, dataLength)==true);
+	}
+
+
+/**
+ * Wait until the next CEP cycle should start.<br>
+ * If the inotify watcher is valid, this function blocks until a relevant<br>
+ * file event occurs in the regulation directory, or until the waiting time<br>
+ * runs out (so that the directory is re-checked periodically even if some<br>
+ * events are missed).<br>
+ * Otherwise, it simply sleeps for the indicated time.<br>
+ *
+ * @param[in] cep		CEP object
+ * @param[in] watcher	inotify watcher object (poll mode if its file descriptor is -1)
+ * @param[in] time		Maximum waiting time[usec]
+ */
+static void this_wait (const M2MCEP *cep, const CEPCUIWatcher *watcher, unsigned long time)
+	{
+	//========== Variable ==========
+	struct pollfd pollFD;
+	struct timespec now;
+	struct timespec deadline;
+	long timeout = 0;
+	int result = 0;
+	bool relevant = false;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_wait()";
+
+	//===== Poll mode =====
+	if (watcher==NULL || watcher->fd<0)
+		{
+		this_sleep(cep, time);
+		return;
+		}
+	//===== Check argument =====
+	else if (time<=0)
+		{
+		time = CEPCUI_DEFAULT_SLEEP_TIME;
+		}
 	else
 		{
-		M2MLogger_error(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, (M2MString *)"Failed to create new \"M2MFile\" structure object");
-		return false;
+		// do nothing
+		}
+	//===== Calculate deadline =====
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += (time_t)(time / 1000000UL);
+	deadline.tv_nsec += (long)(time % 1000000UL) * 1000L;
+	if (deadline.tv_nsec>=1000000000L)
+		{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+		}
+	//===== Wait for relevant event =====
+	while (relevant==false)
+		{
+		//===== Calculate remaining time[msec] =====
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		timeout = (long)(deadline.tv_sec - now.tv_sec) * 1000L + (deadline.tv_nsec - now.tv_nsec + 999999L) / 1000000L;
+		if (timeout<=0)
+			{
+			break;
+			}
+		//===== Wait for event =====
+		pollFD.fd = watcher->fd;
+		pollFD.events = POLLIN;
+		pollFD.revents = 0;
+		if ((result=poll(&pollFD, 1, (int)timeout))>0)
+			{
+			//===== Drain all queued events =====
+			relevant = this_readEvent(watcher);
+			}
+		//===== Interrupted by signal =====
+		else if (result<0 && errno==EINTR)
+			{
+			continue;
+			}
+		//===== Timeout or error =====
+		else
+			{
+			break;
+			}
+		}
+	//===== Relevant event occurred =====
+	if (relevant==true)
+		{
+		CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Detected file event in the regulation directory");
+		}
+	return;
+	}
+
+
+/**
+ * Wait until the deadline of the next cycle set by the scheduler.<br>
+ * If the inotify watcher is valid, returns as soon as a relevant file event<br>
+ * occurs in the regulation directory (the deadline is kept for the next<br>
+ * wait).<br>
+ *
+ * @param[in] cep			CEP object
+ * @param[in] watcher		inotify watcher object (poll mode if its file descriptor is -1)
+ * @param[in,out] scheduler	Scheduler object (the next deadline already set)
+ */
+static void this_waitDeadline (const M2MCEP *cep, const CEPCUIWatcher *watcher, CEPCUIScheduler *scheduler)
+	{
+	//========== Variable ==========
+	const int fd = (watcher!=NULL) ? watcher->fd : -1;
+	bool relevant = false;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_waitDeadline()";
+
+	//===== Wait until the deadline or a relevant event =====
+	while (relevant==false && CEPCUIScheduler_wait(scheduler, fd)>0)
+		{
+		relevant = this_readEvent(watcher);
+		}
+	//===== Relevant event occurred =====
+	if (relevant==true)
+		{
+		CEPCUILog_debug(M2MCEP_getLogger(cep), METHOD_NAME, __LINE__, "Detected file event in the regulation directory");
+		}
+	return;
+	}
+
+
+/**
+ * Writing stage of the pipeline (thread function).<br>
+ * Publishes the results passed from the main thread until the pipeline is<br>
+ * stopped and all the results are written.<br>
+ *
+ * @param[in,out] argument	Pipeline object
+ * @return					NULL
+ */
+static void *this_write (void *argument)
+	{
+	//========== Variable ==========
+	CEPCUIPipeline *pipeline = (CEPCUIPipeline *)argument;
+	CEPCUIResult *item = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUI.this_write()";
+
+	while (atomic_load(&pipeline->writing)==true || CEPCUIQueue_isEmpty(pipeline->resultQueue)==false)
+		{
+		//===== Write the next result =====
+		if ((item=(CEPCUIResult *)CEPCUIQueue_pop(pipeline->resultQueue, CEPCUI_PIPELINE_POLL_TIME))!=NULL)
+			{
+			if (item->output->publisher!=NULL)
+				{
+				CEPCUIPublisher_publish(item->output->publisher, item->result, M2MString_length(item->result));
+				}
+			else
+				{
+				this_setResult(pipeline->cep, item->output->filePath, item->result, M2MString_length(item->result));
+				}
+			M2MHeap_free(item->result);
+			M2MHeap_free(item);
+			//===== Signal the main thread when all the results are written =====
+			if (atomic_fetch_sub(&pipeline->pendingResult, 1)==1)
+				{
+				sem_post(&pipeline->resultDrained);
+				}
+			}
+		}
+	CEPCUILog_debug(M2MCEP_getLogger(pipeline->cep), METHOD_NAME, __LINE__, "Stopped the writing thread");
+	return NULL;
+	}
+
+
+/**
+ * Write all the data to the file descriptor.<br>
+ *
+ * @param[in] fd			File descriptor
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of data[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_writeResult (const int fd, const M2MString *data, size_t dataLength)
+	{
+	//========== Variable ==========
+	ssize_t length = 0;
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (dataLength>0)
+		{
+		if ((length=write(fd, data, dataLength))>0)
+			{
+			data += length;
+			dataLength -= (size_t)length;
+			CEPCUIMetrics_add(CEPCUIMetricsCounter_WRITTEN_BYTE, (uint64_t)length);
+			}
+		else if (length<0 && errno==EINTR)
+			{
+			continue;
+			}
+		else
+			{
+			return false;
+			}
 		}
+	CEPCUIMetrics_record(CEPCUIMetricsStage_WRITE, &start);
+	return true;
 	}
 
 
@@ -663,6 +3580,20 @@ static bool this_stop (const M2MCEP *cep)
  *<br>
  * Detect input file → store record → execute SELECT → file output<br>
  *<br>
+ * Input files are mapped into memory and stored chunk by chunk, so the<br>
+ * memory usage doesn't depend on the size of input file.<br>
+ * Records may be separated with LF, CRLF or a mixture of them.<br>
+ * All the records are inserted with one prepared INSERT statement, and they<br>
+ * are grouped into transactions by "--chunk-size" and "--batch-rows".<br>
+ * The memory database runs without journal and sync, since its contents<br>
+ * don't survive the process in any case.<br>
+ *<br>
+ * By default, the folder is watched with inotify and a cycle starts as soon<br>
+ * as input.csv is closed after writing, output.csv is consumed or the stop<br>
+ * file appears; the interval is then only used as the maximum waiting time.<br>
+ * If inotify isn't available (or "--poll" option is specified), the folder<br>
+ * is polled at the interval instead.<br>
+ *<br>
  * In the input file detection processing, if the corresponding file can't <br>
  * be found, it repeats as it is forever.<br>
  * In the file output processing, if the corresponding record can't be <br>
@@ -675,9 +3606,227 @@ static bool this_stop (const M2MCEP *cep)
  * However, please keep in mind that since log files are always overwritten <br>
  * output, past log files autoregulated will not remain.<br>
  *
- * @param[in] argc	Number of arguments (max 2)
+ * [Multiple queries]<br>
+ * Any number of detection rules can share one ingested table.<br>
+ * If ~/.m2m/cep/queries/ contains "*.sql" files, each file is one query<br>
+ * named after the file. Otherwise select.sql may contain several statements<br>
+ * separated with ";", each optionally preceded by a "-- name: xxx" line<br>
+ * (an unnamed statement is named query<N> after its position, from 1).<br>
+ * Every query is executed once per cycle and its result is written to<br>
+ * output.<name>.csv (or outgoing/<name>/ in spool mode).<br>
+ * A cycle starts only after all of these output files are consumed.<br>
+ * A select.sql with a single unnamed statement behaves as before.<br>
+ *<br>
+ * Queries are compiled once and reused in every cycle. When select.sql or<br>
+ * a file in queries/ is modified, the queries are compiled again and swapped<br>
+ * in without dropping the accumulated records; if the modified queries can't<br>
+ * be compiled, the current ones are kept running.<br>
+ *
+ * [Schema]<br>
+ * The columns of the table can be defined in ~/.m2m/cep/schema.conf, one<br>
+ * "name TYPE" line per column in table order ("#" begins a comment line).<br>
+ * TYPE is one of BLOB, BOOL, CHAR, DATETIME, DOUBLE, FLOAT, INTEGER,<br>
+ * NUMERIC, REAL, TEXT and VARCHAR. Without the file, the table has the<br>
+ * columns "date DATETIME, name TEXT, value DOUBLE".<br>
+ *
+ * [Binary input]<br>
+ * Records can also be written to input.bin (or "*.bin" files in spool mode)<br>
+ * in the following little endian format, which is bound to the table<br>
+ * without parsing any text.<br>
+ *<br>
+ * - Header : "CEPCUIB1" (8 bytes) + number of columns (uint32)<br>
+ * - Record : null bitmap (1 bit per column, LSB first) + non-null fields in column order<br>
+ * - INTEGER, BOOL : int64<br>
+ * - DOUBLE, FLOAT, REAL, NUMERIC : IEEE 754 double<br>
+ * - BLOB : length (uint32) + bytes<br>
+ * - other types (including DATETIME) : length (uint32) + UTF-8 string<br>
+ *<br>
+ * The number of columns must match the schema. A truncated file is inserted<br>
+ * up to its last complete record.<br>
+ *
+ * [Spool mode]<br>
+ * With "--spool" option, input.csv and output.csv are replaced with the<br>
+ * following queue folders, so that any number of producers can drop files<br>
+ * without waiting for each other or for the consumer.<br>
+ *<br>
+ * - Input folder: ~/.m2m/cep/incoming/ (uniquely named CSV files, processed in arrival order)<br>
+ * - Output folder: ~/.m2m/cep/outgoing/ (sequenced result files, e.g. 00000000000000000001.csv)<br>
+ *<br>
+ * Producers should write to a file whose name begins with "." and rename it<br>
+ * when finished; such dot-files are never read.<br>
+ * Each input file is processed as one batch, or all pending files are<br>
+ * coalesced into one batch with "--coalesce" option.<br>
+ * When the output folder holds "--spool-depth" (default 16) unconsumed<br>
+ * result files, input files are left in the input folder until the<br>
+ * consumer catches up.<br>
+ *<br>
+ * With "--pipeline" option, input files are mapped and read ahead on one<br>
+ * thread and results are written on another, connected to the CEP thread<br>
+ * by bounded queues, so that the next batch is read and the previous result<br>
+ * is written while the current batch is inserted and queried.<br>
+ *
+ * [Sharding]<br>
+ * With "--shards=N" option (2 to 64), the table is partitioned into N<br>
+ * tables by the hash of the "--shard-key" column (default "name"), each<br>
+ * owned by its own thread. Every chunk of records is routed to the shards,<br>
+ * inserted on all of them in parallel, and every query is executed on all<br>
+ * of them in parallel; the results are concatenated under one header line.<br>
+ * Therefore a query gives the same result as without sharding only when it<br>
+ * is computed per key, e.g. "GROUP BY name" with the key column "name";<br>
+ * global aggregates, ORDER BY and LIMIT are applied per shard. The maximum<br>
+ * number of records is also kept per shard.<br>
+ *
+ * [Result rotation]<br>
+ * Output files are always written to a temporary dot-file and renamed into<br>
+ * place, so a consumer never reads a half-written result.<br>
+ * With "--rotate=N" option, every result is published as a new sequenced<br>
+ * file in ~/.m2m/cep/results/ (or results/<name>/ for a named query) and<br>
+ * only the newest N files are kept. A cycle is then never skipped for an<br>
+ * unconsumed result, so ingestion and querying run at full rate regardless<br>
+ * of the consumer, which reads the latest files at its own pace.<br>
+ * In spool mode the same applies to the outgoing folders in place of<br>
+ * "--spool-depth": old results are deleted instead of holding back input.<br>
+ *
+ * [Pipe mode]<br>
+ * With "--pipe" option, CSV format records are read from stdin continuously<br>
+ * instead of input.csv, and the results are written to stdout instead of<br>
+ * output.csv, so that the application can be chained as a filter:<br>
+ *<br>
+ * producer | cepcui.exe --pipe | consumer<br>
+ *<br>
+ * Records are grouped into micro-batches, each of which is inserted and<br>
+ * queried once it has "--pipe-rows" records or its first record has waited<br>
+ * for "--pipe-interval" milliseconds. The results of all the queries are<br>
+ * written in order, each with its header line. A record must fit on one<br>
+ * line in this mode. The application ends when stdin is closed (after the<br>
+ * last micro-batch), when stdout is closed, or when the stop file appears.<br>
+ *<br>
+ * [Server mode]<br>
+ * With "--listen" option, the application listens on a Unix domain socket<br>
+ * (~/.m2m/cep/cepcui.sock by default) instead of watching input.csv, so that<br>
+ * many producers can send records at the same time. Every message on the<br>
+ * socket is a frame of 1 byte of type and 4 bytes of payload length<br>
+ * (big endian) followed by the payload:<br>
+ *<br>
+ * 'C' : CSV format records (producer to server)<br>
+ * 'B' : Typed binary records in the format of input.bin (producer to server)<br>
+ * 'S' : Subscription to the query results, with empty payload (subscriber to server)<br>
+ * 'R' : Query result; the query name and a line feed followed by the CSV<br>
+ *       result with its header line (server to subscriber)<br>
+ *<br>
+ * The batches which arrive together are inserted together, and then the<br>
+ * queries are executed once and their results are sent to all the<br>
+ * subscribers. A subscriber which doesn't read its results fast enough<br>
+ * misses some of them, and never holds back the producers.<br>
+ *<br>
+ * [Ring mode]<br>
+ * With "--ring" option, the application creates a POSIX shared memory ring<br>
+ * buffer (/dev/shm/cepcui by default) instead of watching input.csv, and<br>
+ * producers on the same host write records into it with the producer<br>
+ * library "libcepcuiring.a" (see CEPCUIRing.h for the API and the layout).<br>
+ * The records are inserted in place, without being copied by the kernel,<br>
+ * and wakeups use futexes in the shared memory, so an idle ring costs no<br>
+ * system call on either side. The results are written to the output files<br>
+ * in the same way as input.csv mode (with "--rotate" if needed).<br>
+ *<br>
+ * [Metrics]<br>
+ * The application counts the batches, the inserted and matched records and<br>
+ * the bytes read and written, and records the durations of reading,<br>
+ * inserting, querying and writing in latency histograms. They are written<br>
+ * to ~/.m2m/cep/stats.txt every "--stats" seconds (and at the end), and<br>
+ * with "--metrics-port" also served over HTTP on the loopback interface for<br>
+ * Prometheus, both in the Prometheus text format:<br>
+ *<br>
+ * curl http://127.0.0.1:9464/metrics<br>
+ *<br>
+ * [Time window]<br>
+ * With "--window=N", the table keeps the records of the last N seconds<br>
+ * instead of the last records of the maximum number (which then applies<br>
+ * only when specified explicitly). The time is read from the "date" column<br>
+ * (or "--window-column") in ISO 8601 format or as UNIX time, and the<br>
+ * window ends at the newest time in the table, so that it follows the<br>
+ * event time of the records rather than the clock. The column is indexed<br>
+ * and the expired records are evicted with one range DELETE per batch.<br>
+ * "--window-memory" additionally caps the size of the table (split evenly<br>
+ * among the shards): beyond it, the oldest records are evicted regardless<br>
+ * of their time, so a burst can't grow the window without bound.<br>
+ *<br>
+ * [Incremental aggregation]<br>
+ * With "--incremental" option, a query of the form<br>
+ * "SELECT [key,] COUNT/SUM/AVG/MIN/MAX(column)... FROM table [GROUP BY key]"<br>
+ * isn't executed over the whole table every cycle; running sums, counts<br>
+ * and min/max deques are kept per group and updated with the records<br>
+ * inserted and evicted since the previous cycle, so a cycle costs in<br>
+ * proportion to the batch instead of the window. Other queries (and any<br>
+ * query once its data can't be reproduced exactly, e.g. text in a summed<br>
+ * column) are executed by SQLite3 as before. Not applied to the shards.<br>
+ *<br>
+ * [Delta output]<br>
+ * With "--delta" option, each query remembers the records it has written<br>
+ * (as a hash set of 64-bit record identities) and writes only the records<br>
+ * which weren't in its previous result, so a result which changes little<br>
+ * between the cycles isn't written over and over again. An identical<br>
+ * record matched several times is written as many times as its count<br>
+ * grows. With "--delta-retract", the records are preceded by a "delta"<br>
+ * column, "+" for the new records and "-" for the records no longer<br>
+ * matched. The remembered results are discarded when the queries are<br>
+ * reloaded, so the next result is written in full.<br>
+ *<br>
+ * [Cycle scheduling]<br>
+ * The cycles of input.csv mode and spool mode start on fixed deadlines of<br>
+ * the monotonic clock (armed on a timerfd), every sleep time apart, so the<br>
+ * period doesn't drift by the processing time; a deadline missed by a long<br>
+ * cycle is skipped and counted as "cepcui_missed_deadlines_total". With<br>
+ * "--min-interval" or "--max-interval", the interval adapts between the<br>
+ * bounds, starting from the sleep time: it is halved after every cycle<br>
+ * which received records, and doubled after every idle cycle.<br>
+ *<br>
+ * [Snapshot]<br>
+ * With "--snapshot=N", the window of the CEP table survives a restart. Every<br>
+ * inserted batch is appended to ~/.m2m/cep/cepcui.journal, and every N<br>
+ * seconds the memory database is copied between transactions and written<br>
+ * to ~/.m2m/cep/cepcui.snapshot, after which the journal is truncated. The<br>
+ * files are written by a background thread, so the inserting thread only<br>
+ * copies memory. On startup, the snapshot is restored and the batches of<br>
+ * the journal newer than it are inserted again; a torn entry at the end of<br>
+ * the journal (left by a crash) is discarded. The snapshot is ignored if<br>
+ * the CEP table is defined differently. Not supported with "--shards".<br>
+ *<br>
+ * [Usage]<br>
+ * cepcui.exe [options] [sleep time[usec] [maximum number of records]]<br>
+ *<br>
+ * --poll : Don't use inotify, poll the folder at the sleep time intervals<br>
+ * --spool : Use the spool folders instead of input.csv and output.csv<br>
+ * --coalesce : Coalesce all the pending input files into one batch in spool mode<br>
+ * --spool-depth=N : Maximum number of unconsumed result files in spool mode<br>
+ * --chunk-size=N : Size of the input data inserted in one transaction[Byte] (default 1[MiB])<br>
+ * --batch-rows=N : Maximum number of records inserted in one transaction (default 0 : bounded only by the chunk size)<br>
+ * --pipeline : Run reading, CEP and writing on their own threads in spool mode (implies "--spool")<br>
+ * --shards=N : Number of shards of the table executed on their own threads (default 1 : not sharded)<br>
+ * --shard-key=NAME : Column by which the records are partitioned among the shards (default "name")<br>
+ * --rotate=N : Publish every result as a new sequenced file and keep only the newest N files<br>
+ * --pipe : Read records from stdin and write results to stdout instead of the files<br>
+ * --pipe-rows=N : Number of records which closes a micro-batch in pipe mode (default 1000)<br>
+ * --pipe-interval=N : Maximum waiting time[msec] of the first record of a micro-batch in pipe mode (default 100)<br>
+ * --listen[=PATH] : Receive records from producers on the Unix domain socket (default ~/.m2m/cep/cepcui.sock)<br>
+ * --ring[=NAME] : Receive records from producers through the shared memory ring buffer (default "/cepcui")<br>
+ * --ring-size=N : Size of the data area of the ring buffer[Byte] (default 64[MiB])<br>
+ * --stats=N : Interval of rewriting ~/.m2m/cep/stats.txt[sec] (default 10, 0 : disabled)<br>
+ * --metrics-port=N : Serve the metrics in Prometheus text format on 127.0.0.1:N (default 0 : disabled)<br>
+ * --window=N : Keep the records of the last N seconds in the table (default 0 : keep the maximum number of records)<br>
+ * --window-column=NAME : Time column of the time window (default "date")<br>
+ * --window-memory=N : Maximum size of the table[MiB] (default 0 : unlimited)<br>
+ * --incremental : Maintain the results of simple aggregate queries incrementally instead of re-executing them<br>
+ * --delta : Write only the records which weren't in the previous result of the query<br>
+ * --delta-retract : Write the new records with "+" and the records no longer matched with "-" (implies "--delta")<br>
+ * --min-interval=N : Minimum interval of the adaptive cycles[usec] (default 0 : the sleep time)<br>
+ * --max-interval=N : Maximum interval of the adaptive cycles[usec] (default 0 : the sleep time)<br>
+ * --snapshot=N : Interval of the snapshots of the CEP table[sec], journaling every batch in between (default 0 : disabled)<br>
+ * --log-level=LEVEL : Minimum level of the logged messages, "debug", "info" or "error" (default "info")<br>
+ *
+ * @param[in] argc	Number of arguments (max 2 except for options)
  * @param[in] argv	The sleep time[usec] of the loop processing and the maximum number of accumulated records (default value = 50)
- * @return			0
+ * @return			0 : success, 1 : unknown command line option
  */
 int main (int argc, char **argv)
 	{
@@ -687,11 +3836,226 @@ int main (int argc, char **argv)
 	M2MCEP *cep = NULL;												// CEP object
 	M2MTableManager *tableManager = NULL;							// Table information object
 	M2MColumnList *columnList = NULL;								// Column information object
-	M2MString *sql = NULL;											// SELECT SQL string
+	CEPCUISchema *schema = NULL;									// Schema of the CEP table
+	CEPCUIQuerySet *querySet = NULL;								// Set of SELECT queries
+	M2MString DIRECTORY_PATH[PATH_MAX];								// Regulation directory path
+	M2MString STATS_FILE_PATH[PATH_MAX];							// Stats file path
+	CEPCUIOption option = {0, true, false, false, CEPCUIPublisher_DEFAULT_DEPTH, CEPCUI_DEFAULT_CHUNK_SIZE, CEPCUI_DEFAULT_MAX_RECORD, 0, false, 1, CEPCUI_DEFAULT_SHARD_KEY, 0, false, CEPCUI_DEFAULT_PIPE_RECORD, CEPCUI_DEFAULT_PIPE_INTERVAL, false, NULL, false, NULL, CEPCUIRing_DEFAULT_CAPACITY, CEPCUIMetrics_DEFAULT_INTERVAL, 0, false, 0, CEPCUI_DEFAULT_WINDOW_COLUMN, 0, false, false, 0, 0, 0};	// Command line options
+	int character = 0;												// Command line option character
+	int logLevel = 0;												// Log level at runtime
+	const struct option OPTIONS[] =									// Long options
+		{
+		{"poll", no_argument, NULL, 'p'},
+		{"spool", no_argument, NULL, 's'},
+		{"coalesce", no_argument, NULL, 'c'},
+		{"spool-depth", required_argument, NULL, 'd'},
+		{"chunk-size", required_argument, NULL, 'k'},
+		{"batch-rows", required_argument, NULL, 'b'},
+		{"pipeline", no_argument, NULL, 'P'},
+		{"shards", required_argument, NULL, 'S'},
+		{"shard-key", required_argument, NULL, 'K'},
+		{"rotate", required_argument, NULL, 'r'},
+		{"pipe", no_argument, NULL, 'i'},
+		{"pipe-rows", required_argument, NULL, 'n'},
+		{"pipe-interval", required_argument, NULL, 't'},
+		{"listen", optional_argument, NULL, 'l'},
+		{"ring", optional_argument, NULL, 'm'},
+		{"ring-size", required_argument, NULL, 'z'},
+		{"stats", required_argument, NULL, 'T'},
+		{"metrics-port", required_argument, NULL, 'M'},
+		{"log-level", required_argument, NULL, 'L'},
+		{"incremental", no_argument, NULL, 'A'},
+		{"window", required_argument, NULL, 'w'},
+		{"window-column", required_argument, NULL, 'W'},
+		{"window-memory", required_argument, NULL, 'X'},
+		{"delta", no_argument, NULL, 'D'},
+		{"delta-retract", no_argument, NULL, 'R'},
+		{"min-interval", required_argument, NULL, 'I'},
+		{"max-interval", required_argument, NULL, 'x'},
+		{"snapshot", required_argument, NULL, 'y'},
+		{NULL, 0, NULL, 0}
+		};
 	const M2MString *TABLE_NAME = (M2MString *)"cep_test";			// Table name
 	const M2MString *DATABASE_NAME = (M2MString *)"cep";			// Database file name
 	const M2MString *FUNCTION_NAME = (M2MString *)"CEPCUI.main()";	// Method name
 
+	//===== Get options =====
+	while ((character=getopt_long(argc, argv, "pscd:k:b:PS:K:r:in:t:l::m::z:T:M:L:Aw:W:X:DRI:x:y:", OPTIONS, NULL))!=-1)
+		{
+		//===== Polling mode =====
+		if (character=='p')
+			{
+			option.eventDriven = false;
+			}
+		//===== Spool mode =====
+		else if (character=='s')
+			{
+			option.spool = true;
+			}
+		//===== Coalesce the pending input files in spool mode =====
+		else if (character=='c')
+			{
+			option.coalesce = true;
+			}
+		//===== Depth of outgoing directory in spool mode =====
+		else if (character=='d')
+			{
+			option.spoolDepth = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Size of the chunk buffer for input records =====
+		else if (character=='k')
+			{
+			if ((option.chunkSize=(size_t)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg)))<=0)
+				{
+				option.chunkSize = CEPCUI_DEFAULT_CHUNK_SIZE;
+				}
+			}
+		//===== Number of records inserted in one transaction =====
+		else if (character=='b')
+			{
+			option.batchRecord = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Pipelined execution (in spool mode) =====
+		else if (character=='P')
+			{
+			option.pipeline = true;
+			option.spool = true;
+			}
+		//===== Number of shards of the CEP table =====
+		else if (character=='S')
+			{
+			option.shardCount = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Key column of the shards =====
+		else if (character=='K')
+			{
+			option.shardKey = optarg;
+			}
+		//===== Number of rotated result files =====
+		else if (character=='r')
+			{
+			option.rotation = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Pipe mode (no file is watched) =====
+		else if (character=='i')
+			{
+			option.pipe = true;
+			option.eventDriven = false;
+			}
+		//===== Number of records per micro-batch in pipe mode =====
+		else if (character=='n')
+			{
+			if ((option.pipeRecord=(unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg)))<=0)
+				{
+				option.pipeRecord = CEPCUI_DEFAULT_PIPE_RECORD;
+				}
+			}
+		//===== Maximum waiting time of a micro-batch in pipe mode =====
+		else if (character=='t')
+			{
+			option.pipeInterval = (unsigned long)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Server mode (no file is watched) =====
+		else if (character=='l')
+			{
+			option.server = true;
+			option.socketPath = optarg;
+			option.eventDriven = false;
+			}
+		//===== Ring mode (no file is watched) =====
+		else if (character=='m')
+			{
+			option.ring = true;
+			option.ringName = optarg;
+			option.eventDriven = false;
+			}
+		//===== Size of the ring buffer =====
+		else if (character=='z')
+			{
+			if ((option.ringCapacity=(size_t)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg)))<=0)
+				{
+				option.ringCapacity = CEPCUIRing_DEFAULT_CAPACITY;
+				}
+			}
+		//===== Interval of rewriting the stats file =====
+		else if (character=='T')
+			{
+			option.statsInterval = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Port of the metrics endpoint =====
+		else if (character=='M')
+			{
+			option.metricsPort = (unsigned short)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Log level at runtime =====
+		else if (character=='L')
+			{
+			if ((logLevel=CEPCUILog_parseLevel(optarg))>=0)
+				{
+				CEPCUILog_setLevel(logLevel);
+				}
+			else
+				{
+				M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"Unknown log level is specified (\"debug\", \"info\" or \"error\")");
+				}
+			}
+		//===== Incremental aggregation =====
+		else if (character=='A')
+			{
+			option.incremental = true;
+			}
+		//===== Length of the time window =====
+		else if (character=='w')
+			{
+			option.windowTime = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Time column of the time window =====
+		else if (character=='W')
+			{
+			option.windowColumn = optarg;
+			}
+		//===== Maximum size of the table =====
+		else if (character=='X')
+			{
+			option.windowMemory = (size_t)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg)) * 1024 * 1024;
+			}
+		//===== Delta output =====
+		else if (character=='D')
+			{
+			option.delta = true;
+			}
+		//===== Delta output with retraction =====
+		else if (character=='R')
+			{
+			option.delta = true;
+			option.retract = true;
+			}
+		//===== Minimum interval of the adaptive cycles =====
+		else if (character=='I')
+			{
+			option.minInterval = M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Maximum interval of the adaptive cycles =====
+		else if (character=='x')
+			{
+			option.maxInterval = M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Interval of the snapshots =====
+		else if (character=='y')
+			{
+			option.snapshotInterval = (unsigned int)M2MString_convertFromStringToUnsignedLong(optarg, M2MString_length(optarg));
+			}
+		//===== Unknown option =====
+		else
+			{
+			M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"Unknown command line option is specified");
+			this_printUsage(argv[0]);
+			return 1;
+			}
+		}
+	//===== Skip options =====
+	argc -= optind - 1;
+	argv += optind - 1;
 	//===== When one argument is specified =====
 	if (argc==2)
 		{
@@ -733,14 +4097,13 @@ int main (int argc, char **argv)
 		// do nothing
 		}
 	M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"********** Startup CEP sample program **********");
-	//===== Get SELECT SQL string =====
-	if (this_getSelectSQL(&sql)!=NULL)
+	//===== Get SELECT queries and table schema =====
+	if (this_getDirectoryPath(DIRECTORY_PATH, sizeof(DIRECTORY_PATH))!=NULL
+			&& (querySet=CEPCUIQuerySet_new(DIRECTORY_PATH))!=NULL
+			&& (schema=CEPCUISchema_new(DIRECTORY_PATH))!=NULL)
 		{
 		//===== Create new CEP database =====
-		if ((columnList=M2MColumnList_new())!=NULL
-				&& M2MColumnList_add(columnList, (M2MString *)"date", M2MSQLiteDataType_DATETIME, false, false, false, false)!=NULL
-				&& M2MColumnList_add(columnList, (M2MString *)"name", M2MSQLiteDataType_TEXT, false, false, false, false)!=NULL
-				&& M2MColumnList_add(columnList, (M2MString *)"value", M2MSQLiteDataType_DOUBLE, false, false, false, false)!=NULL
+		if ((columnList=CEPCUISchema_getColumnList(schema))!=NULL
 				&& (tableManager=M2MTableManager_new())!=NULL
 				&& M2MTableManager_setConfig(tableManager, TABLE_NAME, columnList)!=NULL
 				&& (cep=M2MCEP_new(DATABASE_NAME, tableManager))!=NULL)
@@ -750,14 +4113,31 @@ int main (int argc, char **argv)
 				{
 				//===== Set the number of maximum accumulated record in memory database =====
 				M2MCEP_setMaxRecord(cep, (unsigned int)maxRecord);
+				option.maxRecord = (unsigned int)maxRecord;
+				}
+			//===== The time window replaces the default maximum number =====
+			else if (option.windowTime>0)
+				{
+				option.maxRecord = 0;
 				}
 			else
 				{
 				}
+			//===== Start exposing the metrics =====
+			if (option.statsInterval>0
+					&& snprintf((char *)STATS_FILE_PATH, sizeof(STATS_FILE_PATH), "%s/%s", DIRECTORY_PATH, CEPCUI_STATS_FILE_NAME)>=(int)sizeof(STATS_FILE_PATH))
+				{
+				M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"Path of the stats file is too long, so the stats file isn't written");
+				option.statsInterval = 0;
+				}
+			CEPCUIMetrics_start((option.statsInterval>0) ? STATS_FILE_PATH : NULL, option.statsInterval, option.metricsPort);
 			//===== Execute CEP =====
-			this_execute(cep, TABLE_NAME, sql, sleepTime);
-			//===== Release heap memory for SQL string =====
-			M2MHeap_free(sql);
+			option.sleepTime = sleepTime;
+			this_execute(cep, TABLE_NAME, schema, &querySet, &option);
+			CEPCUIMetrics_stop();
+			//===== Release heap memory for SELECT queries and table schema =====
+			CEPCUIQuerySet_delete(&querySet);
+			CEPCUISchema_delete(&schema);
 			//===== Release heap memory for CEP object =====
 			M2MCEP_delete(&cep);
 			}
@@ -765,14 +4145,16 @@ int main (int argc, char **argv)
 		else
 			{
 			M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"Failed to construct CEP database");
-			//===== Release heap memory for SQL string =====
-			M2MHeap_free(sql);
+			//===== Release heap memory for SELECT queries and table schema =====
+			CEPCUIQuerySet_delete(&querySet);
+			CEPCUISchema_delete(&schema);
 			}
 		}
 	//===== Error handling =====
 	else
 		{
-		M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"Failed to get SQL string for CEP table search");
+		M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"Failed to get SQL string or table schema for CEP table search");
+		CEPCUIQuerySet_delete(&querySet);
 		}
 	M2MLogger_error(NULL, FUNCTION_NAME, __LINE__, (M2MString *)"********** Quit CEP sample program **********");
 	return 0;
@@ -0,0 +1,1397 @@
+/*******************************************************************************
+ * CEPCUIAggregate.c : Incremental state of aggregate queries over the sliding window
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIAggregate.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Token of an aggregate query (type is 'w' for identifiers and keywords,<br>
+ * the character itself for "(", ")", ",", "*" and ";", 0 for the end and<br>
+ * -1 for anything else)<br>
+ */
+typedef struct
+	{
+	int type;
+	char text[CEPCUIAggregate_NAME_LENGTH];
+	} CEPCUIAggregateToken;
+
+
+/**
+ * Maximum number of tokens of a recognized aggregate query
+ */
+#define CEPCUIAggregate_MAX_TOKEN 128
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Add the floating point number to the running sum with Neumaier<br>
+ * compensation.<br>
+ *
+ * @param[in,out] slot	Running state of the column
+ * @param[in] real		Floating point number
+ */
+static void this_addReal (CEPCUIAggregateSlot *slot, const double real);
+
+
+/**
+ * Add the current record of the delta statement to the window.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				true : success, false : the record can't be reproduced or failed to allocate memory
+ */
+static bool this_addRecord (CEPCUIAggregate *self);
+
+
+/**
+ * Add the value of a record to the running state of the column.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] index		Index of the aggregated column
+ * @param[in,out] slot	Running state of the column in the group
+ * @param[in] rowid		rowid of the record
+ * @param[in] value		Value of the column
+ * @return				true : success, false : integer overflow or failed to allocate memory
+ */
+static bool this_addValue (CEPCUIAggregate *self, const size_t index, CEPCUIAggregateSlot *slot, const int64_t rowid, const CEPCUIAggregateValue *value);
+
+
+/**
+ * Forget all the records and groups, so that the window is read from the<br>
+ * whole table again.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ */
+static void this_clear (CEPCUIAggregate *self);
+
+
+/**
+ * Compare the GROUP BY keys of the groups in the order of SQLite3 (NULL<br>
+ * first, then BINARY collation) for qsort().<br>
+ *
+ * @param[in] first		Pointer to the first group
+ * @param[in] second	Pointer to the second group
+ * @return				Negative, 0 or positive number
+ */
+static int this_compareGroup (const void *first, const void *second);
+
+
+/**
+ * Compare the numbers in the same way as SQLite3 does.<br>
+ *
+ * @param[in] first		First value
+ * @param[in] second	Second value
+ * @return				Negative, 0 or positive number
+ */
+static int this_compareValue (const CEPCUIAggregateValue *first, const CEPCUIAggregateValue *second);
+
+
+/**
+ * Format the floating point number into the text buffer with SQLite3<br>
+ * itself, so that it matches the result of the SQL query exactly.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] real		Floating point number
+ * @param[out] length	Pointer for copying the size of the text[Byte]
+ * @return				Formatted text or NULL (in case of error)
+ */
+static const M2MString *this_formatReal (CEPCUIAggregate *self, const double real, size_t *length);
+
+
+/**
+ * Get the group of the GROUP BY key, creating it if it doesn't exist.<br>
+ *
+ * @param[in,out] self		Aggregate object
+ * @param[in] key			GROUP BY key or NULL (in case of NULL key)
+ * @param[in] keyLength		Size of the key[Byte]
+ * @return					Index of the group or -1 (in case of failed to allocate memory)
+ */
+static int64_t this_getGroup (CEPCUIAggregate *self, const M2MString *key, const size_t keyLength);
+
+
+/**
+ * Get the FNV-1a hash of the GROUP BY key.<br>
+ *
+ * @param[in] key		GROUP BY key or NULL (in case of NULL key)
+ * @param[in] keyLength	Size of the key[Byte]
+ * @return				Hash of the key
+ */
+static uint64_t this_getHash (const M2MString *key, const size_t keyLength);
+
+
+/**
+ * Split the SQL into tokens, skipping white spaces and comments.<br>
+ *
+ * @param[in] sql			SQL string
+ * @param[out] tokenList	Array for copying the tokens (terminated with the end token)
+ * @param[in] maxToken		Number of elements of the array
+ * @return					true : success, false : the SQL contains a token which isn't recognized
+ */
+static bool this_getTokenList (const char *sql, CEPCUIAggregateToken tokenList[], const size_t maxToken);
+
+
+/**
+ * Double the capacity of the deque.<br>
+ *
+ * @param[in,out] deque	Deque
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growDeque (CEPCUIAggregateDeque *deque);
+
+
+/**
+ * Double the number of groups (and the hash buckets, which are rehashed).<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growGroupList (CEPCUIAggregate *self);
+
+
+/**
+ * Double the capacity of the window.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growWindow (CEPCUIAggregate *self);
+
+
+/**
+ * Parse the aggregate query into the result columns, and build the SQL<br>
+ * which reads the records inserted since the last update.<br>
+ *
+ * @param[in,out] self			Aggregate object
+ * @param[in] sql				SQL string of the query
+ * @param[out] deltaSQL			Buffer for copying the SQL reading the inserted records
+ * @param[out] rangeSQL			Buffer for copying the SQL reading the range of rowid and the number of records
+ * @param[in] sqlLength			Size of the buffers[Byte]
+ * @return						true : recognized, false : not recognized
+ */
+static bool this_parse (CEPCUIAggregate *self, const char *sql, M2MString deltaSQL[], M2MString rangeSQL[], const size_t sqlLength);
+
+
+/**
+ * Drop the entry of the record from the front of the deque.<br>
+ *
+ * @param[in,out] deque	Deque
+ * @param[in] rowid		rowid of the record leaving the window
+ */
+static void this_popDeque (CEPCUIAggregateDeque *deque, const int64_t rowid);
+
+
+/**
+ * Push the value to the back of the monotonic deque, dropping the values<br>
+ * which can never be the extremum again.<br>
+ *
+ * @param[in,out] deque		Deque
+ * @param[in] rowid			rowid of the record
+ * @param[in] value			Value of the column
+ * @param[in] maximum		true : deque for MAX(), false : deque for MIN()
+ * @return					true : success, false : failed to allocate memory
+ */
+static bool this_pushDeque (CEPCUIAggregateDeque *deque, const int64_t rowid, const CEPCUIAggregateValue *value, const bool maximum);
+
+
+/**
+ * Release the empty group for reuse (its deques keep their memory).<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] index		Index of the group
+ */
+static void this_releaseGroup (CEPCUIAggregate *self, const size_t index);
+
+
+/**
+ * Remove the oldest record from the window.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ */
+static void this_removeRecord (CEPCUIAggregate *self);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Add the floating point number to the running sum with Neumaier<br>
+ * compensation.<br>
+ *
+ * @param[in,out] slot	Running state of the column
+ * @param[in] real		Floating point number
+ */
+static void this_addReal (CEPCUIAggregateSlot *slot, const double real)
+	{
+	//========== Variable ==========
+	const double SUM = slot->realSum + real;
+
+	if (((slot->realSum<0) ? -slot->realSum : slot->realSum)>=((real<0) ? -real : real))
+		{
+		slot->compensation += (slot->realSum - SUM) + real;
+		}
+	else
+		{
+		slot->compensation += (real - SUM) + slot->realSum;
+		}
+	slot->realSum = SUM;
+	return;
+	}
+
+
+/**
+ * Add the current record of the delta statement to the window.<br>
+ * The columns of the delta statement are rowid, the GROUP BY key and the<br>
+ * aggregated columns in order.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				true : success, false : the record can't be reproduced or failed to allocate memory
+ */
+static bool this_addRecord (CEPCUIAggregate *self)
+	{
+	//========== Variable ==========
+	sqlite3_stmt *statement = self->deltaStatement;
+	CEPCUIAggregateValue *value = NULL;
+	CEPCUIAggregateGroup *group = NULL;
+	int64_t rowid = sqlite3_column_int64(statement, 0);
+	int64_t index = 0;
+	size_t position = 0;
+	size_t i = 0;
+	int type = SQLITE_NULL;
+
+	//===== Group of the key (only text or NULL keys are sorted like SQLite3) =====
+	if (self->grouped==true)
+		{
+		if ((type=sqlite3_column_type(statement, 1))==SQLITE_TEXT)
+			{
+			index = this_getGroup(self, sqlite3_column_text(statement, 1), (size_t)sqlite3_column_bytes(statement, 1));
+			}
+		else if (type==SQLITE_NULL)
+			{
+			index = this_getGroup(self, NULL, 0);
+			}
+		else
+			{
+			return false;
+			}
+		if (index<0)
+			{
+			return false;
+			}
+		}
+	//===== Append the record to the window =====
+	if (self->count>=self->capacity && this_growWindow(self)==false)
+		{
+		return false;
+		}
+	position = (self->head + self->count) & (self->capacity - 1);
+	self->rowidList[position] = rowid;
+	self->groupIndexList[position] = (size_t)index;
+	group = &self->groupList[index];
+	group->records++;
+	self->count++;
+	self->lastRowid = rowid;
+	//===== Aggregated columns =====
+	for (i=0; i<self->slotCount; i++)
+		{
+		value = &self->valueList[position * self->slotCount + i];
+		memset(value, 0, sizeof(CEPCUIAggregateValue));
+		if ((value->type=sqlite3_column_type(statement, (int)i + 2))==SQLITE_INTEGER)
+			{
+			value->integer = sqlite3_column_int64(statement, (int)i + 2);
+			}
+		else if (value->type==SQLITE_FLOAT)
+			{
+			value->real = sqlite3_column_double(statement, (int)i + 2);
+			}
+		//===== Text or BLOB can be counted, but not summed or compared =====
+		else if (value->type!=SQLITE_NULL)
+			{
+			if (self->numericList[i]==true)
+				{
+				return false;
+				}
+			value->type = SQLITE_INTEGER;
+			}
+		if (this_addValue(self, i, &group->slotList[i], rowid, value)==false)
+			{
+			return false;
+			}
+		}
+	return true;
+	}
+
+
+/**
+ * Add the value of a record to the running state of the column.<br>
+ * NULL is ignored like the aggregate functions of SQLite3 do.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] index		Index of the aggregated column
+ * @param[in,out] slot	Running state of the column in the group
+ * @param[in] rowid		rowid of the record
+ * @param[in] value		Value of the column
+ * @return				true : success, false : integer overflow or failed to allocate memory
+ */
+static bool this_addValue (CEPCUIAggregate *self, const size_t index, CEPCUIAggregateSlot *slot, const int64_t rowid, const CEPCUIAggregateValue *value)
+	{
+	if (value->type==SQLITE_NULL)
+		{
+		return true;
+		}
+	slot->count++;
+	if (value->type==SQLITE_INTEGER)
+		{
+		if (__builtin_add_overflow(slot->integerSum, value->integer, &slot->integerSum))
+			{
+			return false;
+			}
+		}
+	else
+		{
+		slot->realCount++;
+		this_addReal(slot, value->real);
+		}
+	return (self->minimumList[index]==false || this_pushDeque(&slot->minimum, rowid, value, false)==true)
+			&& (self->maximumList[index]==false || this_pushDeque(&slot->maximum, rowid, value, true)==true);
+	}
+
+
+/**
+ * Forget all the records and groups, so that the window is read from the<br>
+ * whole table again.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ */
+static void this_clear (CEPCUIAggregate *self)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+
+	for (i=0; i<self->groupCapacity; i++)
+		{
+		if (self->groupList[i].used==true)
+			{
+			this_releaseGroup(self, i);
+			}
+		}
+	self->head = 0;
+	self->count = 0;
+	self->lastRowid = 0;
+	//===== The only group of the query without GROUP BY =====
+	if (self->grouped==false)
+		{
+		this_getGroup(self, NULL, 0);
+		}
+	return;
+	}
+
+
+/**
+ * Compare the GROUP BY keys of the groups in the order of SQLite3 (NULL<br>
+ * first, then BINARY collation) for qsort().<br>
+ *
+ * @param[in] first		Pointer to the first group
+ * @param[in] second	Pointer to the second group
+ * @return				Negative, 0 or positive number
+ */
+static int this_compareGroup (const void *first, const void *second)
+	{
+	//========== Variable ==========
+	const CEPCUIAggregateGroup *FIRST = *(CEPCUIAggregateGroup * const *)first;
+	const CEPCUIAggregateGroup *SECOND = *(CEPCUIAggregateGroup * const *)second;
+	int result = 0;
+
+	if (FIRST->key==NULL || SECOND->key==NULL)
+		{
+		return (FIRST->key!=NULL) - (SECOND->key!=NULL);
+		}
+	else if ((result=memcmp(FIRST->key, SECOND->key, (FIRST->keyLength<SECOND->keyLength) ? FIRST->keyLength : SECOND->keyLength))!=0)
+		{
+		return result;
+		}
+	else
+		{
+		return (FIRST->keyLength>SECOND->keyLength) - (FIRST->keyLength<SECOND->keyLength);
+		}
+	}
+
+
+/**
+ * Compare the numbers in the same way as SQLite3 does (integers exactly,<br>
+ * otherwise as floating point numbers).<br>
+ *
+ * @param[in] first		First value
+ * @param[in] second	Second value
+ * @return				Negative, 0 or positive number
+ */
+static int this_compareValue (const CEPCUIAggregateValue *first, const CEPCUIAggregateValue *second)
+	{
+	//========== Variable ==========
+	double firstReal = 0;
+	double secondReal = 0;
+
+	if (first->type==SQLITE_INTEGER && second->type==SQLITE_INTEGER)
+		{
+		return (first->integer>second->integer) - (first->integer<second->integer);
+		}
+	else
+		{
+		firstReal = (first->type==SQLITE_INTEGER) ? (double)first->integer : first->real;
+		secondReal = (second->type==SQLITE_INTEGER) ? (double)second->integer : second->real;
+		return (firstReal>secondReal) - (firstReal<secondReal);
+		}
+	}
+
+
+/**
+ * Format the floating point number into the text buffer with SQLite3<br>
+ * itself, so that it matches the result of the SQL query exactly.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] real		Floating point number
+ * @param[out] length	Pointer for copying the size of the text[Byte]
+ * @return				Formatted text or NULL (in case of error)
+ */
+static const M2MString *this_formatReal (CEPCUIAggregate *self, const double real, size_t *length)
+	{
+	//========== Variable ==========
+	const unsigned char *text = NULL;
+
+	(*length) = 0;
+	sqlite3_bind_double(self->formatStatement, 1, real);
+	if (sqlite3_step(self->formatStatement)==SQLITE_ROW
+			&& (text=sqlite3_column_text(self->formatStatement, 0))!=NULL)
+		{
+		(*length) = (size_t)snprintf((char *)self->text, sizeof(self->text), "%s", text);
+		}
+	sqlite3_reset(self->formatStatement);
+	return (text!=NULL) ? self->text : NULL;
+	}
+
+
+/**
+ * Get the group of the GROUP BY key, creating it if it doesn't exist.<br>
+ *
+ * @param[in,out] self		Aggregate object
+ * @param[in] key			GROUP BY key or NULL (in case of NULL key)
+ * @param[in] keyLength		Size of the key[Byte]
+ * @return					Index of the group or -1 (in case of failed to allocate memory)
+ */
+static int64_t this_getGroup (CEPCUIAggregate *self, const M2MString *key, const size_t keyLength)
+	{
+	//========== Variable ==========
+	CEPCUIAggregateGroup *group = NULL;
+	const uint64_t HASH = this_getHash(key, keyLength);
+	int64_t index = -1;
+	size_t bucket = 0;
+
+	//===== Search the bucket =====
+	for (index=(self->bucketCount>0) ? self->bucketList[HASH & (self->bucketCount - 1)] : -1; index>=0; index=group->next)
+		{
+		group = &self->groupList[index];
+		if (group->hash==HASH
+				&& ((key==NULL && group->key==NULL)
+					|| (key!=NULL && group->key!=NULL && group->keyLength==keyLength && memcmp(group->key, key, keyLength)==0)))
+			{
+			return index;
+			}
+		}
+	//===== Take an unused group =====
+	if (self->freeGroup<0 && this_growGroupList(self)==false)
+		{
+		return -1;
+		}
+	index = self->freeGroup;
+	group = &self->groupList[index];
+	if (key!=NULL)
+		{
+		if ((group->key=(M2MString *)M2MHeap_malloc(keyLength + 1))==NULL)
+			{
+			return -1;
+			}
+		memcpy(group->key, key, keyLength);
+		}
+	self->freeGroup = group->next;
+	group->keyLength = keyLength;
+	group->hash = HASH;
+	group->records = 0;
+	group->used = true;
+	//===== Chain the group to the bucket =====
+	bucket = HASH & (self->bucketCount - 1);
+	group->next = self->bucketList[bucket];
+	self->bucketList[bucket] = index;
+	self->groupCount++;
+	return index;
+	}
+
+
+/**
+ * Get the FNV-1a hash of the GROUP BY key.<br>
+ *
+ * @param[in] key		GROUP BY key or NULL (in case of NULL key)
+ * @param[in] keyLength	Size of the key[Byte]
+ * @return				Hash of the key
+ */
+static uint64_t this_getHash (const M2MString *key, const size_t keyLength)
+	{
+	//========== Variable ==========
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i = 0;
+
+	for (i=0; key!=NULL && i<keyLength; i++)
+		{
+		hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+		}
+	return (key!=NULL) ? hash : 0;
+	}
+
+
+/**
+ * Split the SQL into tokens, skipping white spaces and comments.<br>
+ * Identifiers and keywords are recognized without quotes only.<br>
+ *
+ * @param[in] sql			SQL string
+ * @param[out] tokenList	Array for copying the tokens (terminated with the end token)
+ * @param[in] maxToken		Number of elements of the array
+ * @return					true : success, false : the SQL contains a token which isn't recognized
+ */
+static bool this_getTokenList (const char *sql, CEPCUIAggregateToken tokenList[], const size_t maxToken)
+	{
+	//========== Variable ==========
+	const char *cursor = sql;
+	size_t count = 0;
+	size_t length = 0;
+
+	while (count<maxToken)
+		{
+		//===== Skip white spaces and comments =====
+		while (true)
+			{
+			if (isspace((unsigned char)(*cursor))!=0)
+				{
+				cursor++;
+				}
+			else if (cursor[0]=='-' && cursor[1]=='-')
+				{
+				cursor += strcspn(cursor, "\n");
+				}
+			else if (cursor[0]=='/' && cursor[1]=='*' && strstr(cursor + 2, "*/")!=NULL)
+				{
+				cursor = strstr(cursor + 2, "*/") + 2;
+				}
+			else
+				{
+				break;
+				}
+			}
+		memset(&tokenList[count], 0, sizeof(CEPCUIAggregateToken));
+		//===== End =====
+		if ((*cursor)=='\0')
+			{
+			return true;
+			}
+		//===== Identifier or keyword =====
+		else if (isalpha((unsigned char)(*cursor))!=0 || (*cursor)=='_')
+			{
+			for (length=0; isalnum((unsigned char)cursor[length])!=0 || cursor[length]=='_'; length++)
+				{
+				}
+			if (length>=sizeof(tokenList[count].text))
+				{
+				return false;
+				}
+			tokenList[count].type = 'w';
+			memcpy(tokenList[count].text, cursor, length);
+			cursor += length;
+			}
+		//===== Punctuation =====
+		else if (strchr("(),*;", (*cursor))!=NULL)
+			{
+			tokenList[count].type = (*cursor);
+			cursor++;
+			}
+		else
+			{
+			return false;
+			}
+		count++;
+		}
+	return false;
+	}
+
+
+/**
+ * Double the capacity of the deque.<br>
+ *
+ * @param[in,out] deque	Deque
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growDeque (CEPCUIAggregateDeque *deque)
+	{
+	//========== Variable ==========
+	int64_t *rowidList = NULL;
+	CEPCUIAggregateValue *valueList = NULL;
+	const size_t CAPACITY = (deque->capacity>0) ? deque->capacity * 2 : 8;
+	size_t i = 0;
+
+	if ((rowidList=(int64_t *)M2MHeap_malloc(CAPACITY * sizeof(int64_t)))==NULL
+			|| (valueList=(CEPCUIAggregateValue *)M2MHeap_malloc(CAPACITY * sizeof(CEPCUIAggregateValue)))==NULL)
+		{
+		M2MHeap_free(rowidList);
+		return false;
+		}
+	//===== Unwrap the entries =====
+	for (i=0; i<deque->count; i++)
+		{
+		rowidList[i] = deque->rowidList[(deque->head + i) & (deque->capacity - 1)];
+		valueList[i] = deque->valueList[(deque->head + i) & (deque->capacity - 1)];
+		}
+	M2MHeap_free(deque->rowidList);
+	M2MHeap_free(deque->valueList);
+	deque->rowidList = rowidList;
+	deque->valueList = valueList;
+	deque->capacity = CAPACITY;
+	deque->head = 0;
+	return true;
+	}
+
+
+/**
+ * Double the number of groups (and the hash buckets, which are rehashed).<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growGroupList (CEPCUIAggregate *self)
+	{
+	//========== Variable ==========
+	CEPCUIAggregateGroup *groupList = NULL;
+	CEPCUIAggregateGroup **recordList = NULL;
+	int64_t *bucketList = NULL;
+	const size_t CAPACITY = (self->groupCapacity>0) ? self->groupCapacity * 2 : 16;
+	size_t bucket = 0;
+	size_t i = 0;
+
+	if ((groupList=(CEPCUIAggregateGroup *)realloc(self->groupList, CAPACITY * sizeof(CEPCUIAggregateGroup)))==NULL)
+		{
+		return false;
+		}
+	self->groupList = groupList;
+	if ((recordList=(CEPCUIAggregateGroup **)realloc(self->recordList, CAPACITY * sizeof(CEPCUIAggregateGroup *)))==NULL)
+		{
+		return false;
+		}
+	self->recordList = recordList;
+	if ((bucketList=(int64_t *)M2MHeap_malloc(CAPACITY * sizeof(int64_t)))==NULL)
+		{
+		return false;
+		}
+	//===== Chain the new groups as unused ones =====
+	memset(&self->groupList[self->groupCapacity], 0, (CAPACITY - self->groupCapacity) * sizeof(CEPCUIAggregateGroup));
+	for (i=CAPACITY; i>self->groupCapacity; i--)
+		{
+		self->groupList[i-1].next = self->freeGroup;
+		self->freeGroup = (int64_t)(i - 1);
+		}
+	//===== Rehash the groups in use =====
+	for (i=0; i<CAPACITY; i++)
+		{
+		bucketList[i] = -1;
+		}
+	for (i=0; i<self->groupCapacity; i++)
+		{
+		if (self->groupList[i].used==true)
+			{
+			bucket = self->groupList[i].hash & (CAPACITY - 1);
+			self->groupList[i].next = bucketList[bucket];
+			bucketList[bucket] = (int64_t)i;
+			}
+		}
+	M2MHeap_free(self->bucketList);
+	self->bucketList = bucketList;
+	self->bucketCount = CAPACITY;
+	self->groupCapacity = CAPACITY;
+	return true;
+	}
+
+
+/**
+ * Double the capacity of the window.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growWindow (CEPCUIAggregate *self)
+	{
+	//========== Variable ==========
+	int64_t *rowidList = NULL;
+	size_t *groupIndexList = NULL;
+	CEPCUIAggregateValue *valueList = NULL;
+	const size_t CAPACITY = (self->capacity>0) ? self->capacity * 2 : 1024;
+	const size_t SLOT_COUNT = (self->slotCount>0) ? self->slotCount : 1;
+	size_t position = 0;
+	size_t i = 0;
+
+	if ((rowidList=(int64_t *)M2MHeap_malloc(CAPACITY * sizeof(int64_t)))==NULL
+			|| (groupIndexList=(size_t *)M2MHeap_malloc(CAPACITY * sizeof(size_t)))==NULL
+			|| (valueList=(CEPCUIAggregateValue *)M2MHeap_malloc(CAPACITY * SLOT_COUNT * sizeof(CEPCUIAggregateValue)))==NULL)
+		{
+		M2MHeap_free(rowidList);
+		M2MHeap_free(groupIndexList);
+		return false;
+		}
+	//===== Unwrap the records =====
+	for (i=0; i<self->count; i++)
+		{
+		position = (self->head + i) & (self->capacity - 1);
+		rowidList[i] = self->rowidList[position];
+		groupIndexList[i] = self->groupIndexList[position];
+		memcpy(&valueList[i * SLOT_COUNT], &self->valueList[position * SLOT_COUNT], SLOT_COUNT * sizeof(CEPCUIAggregateValue));
+		}
+	M2MHeap_free(self->rowidList);
+	M2MHeap_free(self->groupIndexList);
+	M2MHeap_free(self->valueList);
+	self->rowidList = rowidList;
+	self->groupIndexList = groupIndexList;
+	self->valueList = valueList;
+	self->capacity = CAPACITY;
+	self->head = 0;
+	return true;
+	}
+
+
+/**
+ * Parse the aggregate query into the result columns, and build the SQL<br>
+ * which reads the records inserted since the last update.<br>
+ *
+ * @param[in,out] self			Aggregate object
+ * @param[in] sql				SQL string of the query
+ * @param[out] deltaSQL			Buffer for copying the SQL reading the inserted records
+ * @param[out] rangeSQL			Buffer for copying the SQL reading the range of rowid and the number of records
+ * @param[in] sqlLength			Size of the buffers[Byte]
+ * @return						true : recognized, false : not recognized
+ */
+static bool this_parse (CEPCUIAggregate *self, const char *sql, M2MString deltaSQL[], M2MString rangeSQL[], const size_t sqlLength)
+	{
+	//========== Variable ==========
+	CEPCUIAggregateToken tokenList[CEPCUIAggregate_MAX_TOKEN];
+	const CEPCUIAggregateToken *token = tokenList;
+	const char *keyList[CEPCUIAggregate_MAX_COLUMN];
+	const char *slotList[CEPCUIAggregate_MAX_SLOT];
+	const char *table = NULL;
+	const char *key = NULL;
+	const char *column = NULL;
+	CEPCUIAggregateItem *item = NULL;
+	size_t keyCount = 0;
+	size_t slot = 0;
+	size_t i = 0;
+	int length = 0;
+	const char *FUNCTION_LIST[] = {"COUNT", "SUM", "AVG", "MIN", "MAX"};
+	const CEPCUIAggregateFunction FUNCTION_TYPE_LIST[] = {CEPCUIAggregateFunction_COUNT, CEPCUIAggregateFunction_SUM, CEPCUIAggregateFunction_AVG, CEPCUIAggregateFunction_MIN, CEPCUIAggregateFunction_MAX};
+
+	if (this_getTokenList(sql, tokenList, CEPCUIAggregate_MAX_TOKEN)==false
+			|| token->type!='w' || strcasecmp(token->text, "SELECT")!=0)
+		{
+		return false;
+		}
+	//===== Result columns =====
+	do
+		{
+		token++;
+		if (token->type!='w' || self->itemCount>=CEPCUIAggregate_MAX_COLUMN)
+			{
+			return false;
+			}
+		item = &self->itemList[self->itemCount++];
+		//===== Aggregate function =====
+		if (token[1].type=='(')
+			{
+			for (i=0; i<sizeof(FUNCTION_LIST)/sizeof(FUNCTION_LIST[0]) && strcasecmp(token->text, FUNCTION_LIST[i])!=0; i++)
+				{
+				}
+			if (i>=sizeof(FUNCTION_LIST)/sizeof(FUNCTION_LIST[0]) || token[3].type!=')')
+				{
+				return false;
+				}
+			item->function = FUNCTION_TYPE_LIST[i];
+			//===== COUNT(*) =====
+			if (token[2].type=='*' && item->function==CEPCUIAggregateFunction_COUNT)
+				{
+				item->function = CEPCUIAggregateFunction_COUNT_ALL;
+				}
+			//===== Aggregated column (shared by the functions of the same column) =====
+			else if (token[2].type=='w')
+				{
+				column = token[2].text;
+				for (slot=0; slot<self->slotCount && strcasecmp(slotList[slot], column)!=0; slot++)
+					{
+					}
+				if (slot>=CEPCUIAggregate_MAX_SLOT)
+					{
+					return false;
+					}
+				else if (slot==self->slotCount)
+					{
+					slotList[self->slotCount++] = column;
+					}
+				item->slot = slot;
+				self->numericList[slot] = self->numericList[slot] || item->function!=CEPCUIAggregateFunction_COUNT;
+				self->minimumList[slot] = self->minimumList[slot] || item->function==CEPCUIAggregateFunction_MIN;
+				self->maximumList[slot] = self->maximumList[slot] || item->function==CEPCUIAggregateFunction_MAX;
+				}
+			else
+				{
+				return false;
+				}
+			token += 4;
+			}
+		//===== Bare column (must be the GROUP BY column) =====
+		else
+			{
+			item->function = CEPCUIAggregateFunction_KEY;
+			keyList[keyCount++] = token->text;
+			token++;
+			}
+		//===== Alias =====
+		if (token->type=='w' && strcasecmp(token->text, "AS")==0)
+			{
+			token++;
+			}
+		if (token->type=='w' && strcasecmp(token->text, "FROM")!=0)
+			{
+			token++;
+			}
+		} while (token->type==',');
+	//===== FROM table [GROUP BY column] [;] =====
+	if (token->type!='w' || strcasecmp(token->text, "FROM")!=0 || token[1].type!='w')
+		{
+		return false;
+		}
+	table = token[1].text;
+	token += 2;
+	if (token[0].type=='w' && strcasecmp(token[0].text, "GROUP")==0
+			&& token[1].type=='w' && strcasecmp(token[1].text, "BY")==0
+			&& token[2].type=='w')
+		{
+		self->grouped = true;
+		key = token[2].text;
+		token += 3;
+		}
+	if (token->type==';')
+		{
+		token++;
+		}
+	if (token->type!=0)
+		{
+		return false;
+		}
+	for (i=0; i<keyCount; i++)
+		{
+		if (key==NULL || strcasecmp(keyList[i], key)!=0)
+			{
+			return false;
+			}
+		}
+	//===== SQL reading the inserted records and the range of rowid =====
+	length = snprintf((char *)deltaSQL, sqlLength, "SELECT rowid, %s", (key!=NULL) ? key : "NULL");
+	for (slot=0; slot<self->slotCount && length>0 && (size_t)length<sqlLength; slot++)
+		{
+		length += snprintf((char *)&deltaSQL[length], sqlLength - (size_t)length, ", %s", slotList[slot]);
+		}
+	if (length<=0 || (size_t)length>=sqlLength
+			|| (size_t)snprintf((char *)&deltaSQL[length], sqlLength - (size_t)length, " FROM %s WHERE rowid>?1 ORDER BY rowid", table)>=sqlLength - (size_t)length
+			|| (size_t)snprintf((char *)rangeSQL, sqlLength, "SELECT (SELECT MIN(rowid) FROM %s), (SELECT MAX(rowid) FROM %s), (SELECT COUNT(*) FROM %s)", table, table, table)>=sqlLength)
+		{
+		return false;
+		}
+	return true;
+	}
+
+
+/**
+ * Drop the entry of the record from the front of the deque.<br>
+ * The entries are in the order of rowid, so the record is at the front if<br>
+ * it is still in the deque.<br>
+ *
+ * @param[in,out] deque	Deque
+ * @param[in] rowid		rowid of the record leaving the window
+ */
+static void this_popDeque (CEPCUIAggregateDeque *deque, const int64_t rowid)
+	{
+	if (deque->count>0 && deque->rowidList[deque->head]==rowid)
+		{
+		deque->head = (deque->head + 1) & (deque->capacity - 1);
+		deque->count--;
+		}
+	return;
+	}
+
+
+/**
+ * Push the value to the back of the monotonic deque, dropping the values<br>
+ * which can never be the extremum again.<br>
+ * Equal values are kept, so that the earliest one is the result like the<br>
+ * MIN() and MAX() of SQLite3.<br>
+ *
+ * @param[in,out] deque		Deque
+ * @param[in] rowid			rowid of the record
+ * @param[in] value			Value of the column
+ * @param[in] maximum		true : deque for MAX(), false : deque for MIN()
+ * @return					true : success, false : failed to allocate memory
+ */
+static bool this_pushDeque (CEPCUIAggregateDeque *deque, const int64_t rowid, const CEPCUIAggregateValue *value, const bool maximum)
+	{
+	//========== Variable ==========
+	size_t position = 0;
+	int result = 0;
+
+	//===== Drop the values superseded by the new one =====
+	while (deque->count>0)
+		{
+		position = (deque->head + deque->count - 1) & (deque->capacity - 1);
+		result = this_compareValue(&deque->valueList[position], value);
+		if ((maximum==true && result<0) || (maximum==false && result>0))
+			{
+			deque->count--;
+			}
+		else
+			{
+			break;
+			}
+		}
+	//===== Append the value =====
+	if (deque->count>=deque->capacity && this_growDeque(deque)==false)
+		{
+		return false;
+		}
+	position = (deque->head + deque->count) & (deque->capacity - 1);
+	deque->rowidList[position] = rowid;
+	deque->valueList[position] = (*value);
+	deque->count++;
+	return true;
+	}
+
+
+/**
+ * Release the empty group for reuse (its deques keep their memory).<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] index		Index of the group
+ */
+static void this_releaseGroup (CEPCUIAggregate *self, const size_t index)
+	{
+	//========== Variable ==========
+	CEPCUIAggregateGroup *group = &self->groupList[index];
+	CEPCUIAggregateSlot *slot = NULL;
+	int64_t *link = &self->bucketList[group->hash & (self->bucketCount - 1)];
+	size_t i = 0;
+
+	//===== Unchain the group from the bucket =====
+	while ((*link)>=0 && (size_t)(*link)!=index)
+		{
+		link = &self->groupList[(*link)].next;
+		}
+	if ((*link)>=0)
+		{
+		(*link) = group->next;
+		}
+	//===== Reset the running state =====
+	M2MHeap_free(group->key);
+	group->keyLength = 0;
+	group->records = 0;
+	group->used = false;
+	for (i=0; i<self->slotCount; i++)
+		{
+		slot = &group->slotList[i];
+		slot->count = 0;
+		slot->realCount = 0;
+		slot->integerSum = 0;
+		slot->realSum = 0;
+		slot->compensation = 0;
+		slot->minimum.head = slot->minimum.count = 0;
+		slot->maximum.head = slot->maximum.count = 0;
+		}
+	group->next = self->freeGroup;
+	self->freeGroup = (int64_t)index;
+	self->groupCount--;
+	return;
+	}
+
+
+/**
+ * Remove the oldest record from the window.<br>
+ * Integers are subtracted with wrap-around, which leaves the exact sum of<br>
+ * the rest of the records whenever it is representable.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ */
+static void this_removeRecord (CEPCUIAggregate *self)
+	{
+	//========== Variable ==========
+	const size_t POSITION = self->head;
+	const size_t INDEX = self->groupIndexList[POSITION];
+	const int64_t ROWID = self->rowidList[POSITION];
+	CEPCUIAggregateGroup *group = &self->groupList[INDEX];
+	CEPCUIAggregateSlot *slot = NULL;
+	const CEPCUIAggregateValue *value = NULL;
+	size_t i = 0;
+
+	for (i=0; i<self->slotCount; i++)
+		{
+		slot = &group->slotList[i];
+		value = &self->valueList[POSITION * self->slotCount + i];
+		if (value->type==SQLITE_NULL)
+			{
+			continue;
+			}
+		slot->count--;
+		if (value->type==SQLITE_INTEGER)
+			{
+			slot->integerSum = (int64_t)((uint64_t)slot->integerSum - (uint64_t)value->integer);
+			}
+		//===== Reset the floating point sum when its last value leaves =====
+		else if (--slot->realCount==0)
+			{
+			slot->realSum = 0;
+			slot->compensation = 0;
+			}
+		else
+			{
+			this_addReal(slot, -value->real);
+			}
+		if (self->minimumList[i]==true)
+			{
+			this_popDeque(&slot->minimum, ROWID);
+			}
+		if (self->maximumList[i]==true)
+			{
+			this_popDeque(&slot->maximum, ROWID);
+			}
+		}
+	group->records--;
+	self->head = (self->head + 1) & (self->capacity - 1);
+	self->count--;
+	//===== Forget the group when its last record leaves =====
+	if (self->grouped==true && group->records==0)
+		{
+		this_releaseGroup(self, INDEX);
+		}
+	return;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the statements and heap memory of aggregate object.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ */
+void CEPCUIAggregate_delete (CEPCUIAggregate **self)
+	{
+	//========== Variable ==========
+	CEPCUIAggregateGroup *group = NULL;
+	size_t i = 0;
+	size_t j = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		sqlite3_finalize((*self)->deltaStatement);
+		sqlite3_finalize((*self)->rangeStatement);
+		sqlite3_finalize((*self)->formatStatement);
+		for (i=0; i<(*self)->groupCapacity; i++)
+			{
+			group = &(*self)->groupList[i];
+			M2MHeap_free(group->key);
+			for (j=0; j<CEPCUIAggregate_MAX_SLOT; j++)
+				{
+				M2MHeap_free(group->slotList[j].minimum.rowidList);
+				M2MHeap_free(group->slotList[j].minimum.valueList);
+				M2MHeap_free(group->slotList[j].maximum.rowidList);
+				M2MHeap_free(group->slotList[j].maximum.valueList);
+				}
+			}
+		free((*self)->groupList);
+		free((*self)->recordList);
+		M2MHeap_free((*self)->bucketList);
+		M2MHeap_free((*self)->rowidList);
+		M2MHeap_free((*self)->groupIndexList);
+		M2MHeap_free((*self)->valueList);
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Get the text of a column of the result, formatted in the same way as<br>
+ * sqlite3_column_text() would for the SQL query.<br>
+ * The text is valid until the next call.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] record	Index of the record (less than the count returned by CEPCUIAggregate_update())
+ * @param[in] column	Index of the column
+ * @param[out] length	Pointer for copying the size of the text[Byte]
+ * @return				Text of the column or NULL (in case of NULL value)
+ */
+const M2MString *CEPCUIAggregate_getText (CEPCUIAggregate *self, const size_t record, const size_t column, size_t *length)
+	{
+	//========== Variable ==========
+	const CEPCUIAggregateGroup *group = NULL;
+	const CEPCUIAggregateItem *item = NULL;
+	const CEPCUIAggregateSlot *slot = NULL;
+	const CEPCUIAggregateValue *value = NULL;
+	const CEPCUIAggregateDeque *deque = NULL;
+
+	//===== Check argument =====
+	if (self!=NULL && record<self->recordCount && column<self->itemCount && length!=NULL)
+		{
+		(*length) = 0;
+		group = self->recordList[record];
+		item = &self->itemList[column];
+		slot = &group->slotList[item->slot];
+		//===== GROUP BY key =====
+		if (item->function==CEPCUIAggregateFunction_KEY)
+			{
+			(*length) = group->keyLength;
+			return group->key;
+			}
+		//===== COUNT(*) and COUNT(column) =====
+		else if (item->function==CEPCUIAggregateFunction_COUNT_ALL || item->function==CEPCUIAggregateFunction_COUNT)
+			{
+			(*length) = (size_t)snprintf((char *)self->text, sizeof(self->text), "%" PRIu64, (item->function==CEPCUIAggregateFunction_COUNT_ALL) ? group->records : slot->count);
+			return self->text;
+			}
+		//===== NULL for no value =====
+		else if (slot->count==0)
+			{
+			return NULL;
+			}
+		//===== SUM(column) (integer while all the values are integers) =====
+		else if (item->function==CEPCUIAggregateFunction_SUM && slot->realCount==0)
+			{
+			(*length) = (size_t)snprintf((char *)self->text, sizeof(self->text), "%" PRId64, slot->integerSum);
+			return self->text;
+			}
+		else if (item->function==CEPCUIAggregateFunction_SUM)
+			{
+			return this_formatReal(self, (double)slot->integerSum + (slot->realSum + slot->compensation), length);
+			}
+		//===== AVG(column) =====
+		else if (item->function==CEPCUIAggregateFunction_AVG)
+			{
+			return this_formatReal(self, ((double)slot->integerSum + (slot->realSum + slot->compensation)) / (double)slot->count, length);
+			}
+		//===== MIN(column) and MAX(column) =====
+		else
+			{
+			deque = (item->function==CEPCUIAggregateFunction_MIN) ? &slot->minimum : &slot->maximum;
+			value = &deque->valueList[deque->head];
+			if (value->type==SQLITE_INTEGER)
+				{
+				(*length) = (size_t)snprintf((char *)self->text, sizeof(self->text), "%" PRId64, value->integer);
+				return self->text;
+				}
+			else
+				{
+				return this_formatReal(self, value->real, length);
+				}
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		if (length!=NULL)
+			{
+			(*length) = 0;
+			}
+		return NULL;
+		}
+	}
+
+
+/**
+ * Construct new aggregate object for the prepared query, if the query is<br>
+ * recognized as an aggregate over the whole table, that is<br>
+ * "SELECT item[, item...] FROM table [GROUP BY column]" where each item is<br>
+ * COUNT(*), COUNT(column), SUM(column), AVG(column), MIN(column),<br>
+ * MAX(column) or the GROUP BY column itself (optionally with an alias).<br>
+ * Any other query (WHERE, HAVING, ORDER BY, expressions, ...) isn't<br>
+ * recognized, and is executed by SQLite3 as before.<br>
+ *
+ * @param[in] statement	Prepared statement of the query
+ * @return				Created aggregate object or NULL (in case of not recognized or error)
+ */
+CEPCUIAggregate *CEPCUIAggregate_new (sqlite3_stmt *statement)
+	{
+	//========== Variable ==========
+	CEPCUIAggregate *self = NULL;
+	sqlite3 *database = NULL;
+	M2MString DELTA_SQL[1024];
+	M2MString RANGE_SQL[1024];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIAggregate_new()";
+
+	//===== Check argument =====
+	if (statement!=NULL && (database=sqlite3_db_handle(statement))!=NULL && sqlite3_sql(statement)!=NULL)
+		{
+		if ((self=(CEPCUIAggregate *)M2MHeap_malloc(sizeof(CEPCUIAggregate)))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for aggregate object");
+			return NULL;
+			}
+		self->freeGroup = -1;
+		//===== Recognize the query and prepare the statements =====
+		if (this_parse(self, sqlite3_sql(statement), DELTA_SQL, RANGE_SQL, sizeof(DELTA_SQL))==true
+				&& self->itemCount==(size_t)sqlite3_column_count(statement)
+				&& sqlite3_prepare_v3(database, (char *)DELTA_SQL, -1, SQLITE_PREPARE_PERSISTENT, &self->deltaStatement, NULL)==SQLITE_OK
+				&& sqlite3_prepare_v3(database, (char *)RANGE_SQL, -1, SQLITE_PREPARE_PERSISTENT, &self->rangeStatement, NULL)==SQLITE_OK
+				&& sqlite3_prepare_v3(database, "SELECT ?1", -1, SQLITE_PREPARE_PERSISTENT, &self->formatStatement, NULL)==SQLITE_OK
+				&& this_growGroupList(self)==true
+				&& (self->grouped==true || this_getGroup(self, NULL, 0)==0))
+			{
+			return self;
+			}
+		//===== Not recognized =====
+		else
+			{
+			CEPCUIAggregate_delete(&self);
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated statement is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Bring the state up to date with the table: the records inserted since<br>
+ * the last update are added, and the oldest records deleted from the table<br>
+ * are removed.<br>
+ * The first update reads the whole table, and so does an update which<br>
+ * finds records deleted out of the order of insertion (e.g. late records<br>
+ * evicted by the time window) or rowid reused.<br>
+ * When the table holds values which can't be reproduced exactly (e.g.<br>
+ * text in an aggregated numeric column, a non-text GROUP BY key or integer<br>
+ * overflow), -1 is returned and the query must be executed by SQLite3.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				Number of result records or -1 (in case of not reproducible or error)
+ */
+int64_t CEPCUIAggregate_update (CEPCUIAggregate *self)
+	{
+	//========== Variable ==========
+	int64_t minimum = 0;
+	int64_t maximum = 0;
+	int64_t records = 0;
+	bool reproducible = true;
+	bool synchronized = false;
+	int status = SQLITE_OK;
+	size_t attempt = 0;
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		for (attempt=0; attempt<2 && reproducible==true && synchronized==false; attempt++)
+			{
+			//===== Start over from the whole table =====
+			if (attempt>0)
+				{
+				this_clear(self);
+				}
+			//===== Add the inserted records =====
+			sqlite3_bind_int64(self->deltaStatement, 1, self->lastRowid);
+			while (reproducible==true && (status=sqlite3_step(self->deltaStatement))==SQLITE_ROW)
+				{
+				reproducible = this_addRecord(self);
+				}
+			sqlite3_reset(self->deltaStatement);
+			//===== Remove the records deleted from the table =====
+			if (reproducible==true && status==SQLITE_DONE
+					&& sqlite3_step(self->rangeStatement)==SQLITE_ROW)
+				{
+				minimum = (sqlite3_column_type(self->rangeStatement, 0)!=SQLITE_NULL) ? sqlite3_column_int64(self->rangeStatement, 0) : INT64_MAX;
+				maximum = sqlite3_column_int64(self->rangeStatement, 1);
+				records = sqlite3_column_int64(self->rangeStatement, 2);
+				while (self->count>0 && self->rowidList[self->head]<minimum)
+					{
+					this_removeRecord(self);
+					}
+				//===== rowid starts over in the empty table =====
+				if (records==0)
+					{
+					self->lastRowid = 0;
+					}
+				//===== The window must hold just the records of the table =====
+				synchronized = ((int64_t)self->count==records && maximum>=self->lastRowid);
+				}
+			else
+				{
+				reproducible = false;
+				}
+			sqlite3_reset(self->rangeStatement);
+			}
+		//===== Groups in the order of GROUP BY =====
+		if (reproducible==true && synchronized==true)
+			{
+			self->recordCount = 0;
+			for (i=0; i<self->groupCapacity; i++)
+				{
+				if (self->groupList[i].used==true)
+					{
+					self->recordList[self->recordCount++] = &self->groupList[i];
+					}
+				}
+			if (self->grouped==true && self->recordCount>1)
+				{
+				qsort(self->recordList, self->recordCount, sizeof(CEPCUIAggregateGroup *), this_compareGroup);
+				}
+			return (int64_t)self->recordCount;
+			}
+		}
+	return -1;
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,279 @@
+/*******************************************************************************
+ * CEPCUIAggregate.h : Incremental state of aggregate queries over the sliding window
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIAGGREGATE_H_
+#define CEPCUIAGGREGATE_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <ctype.h>
+#include <inttypes.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Maximum number of result columns of an aggregate query
+ */
+#ifndef CEPCUIAggregate_MAX_COLUMN
+#define CEPCUIAggregate_MAX_COLUMN 16
+#endif /* CEPCUIAggregate_MAX_COLUMN */
+
+
+/**
+ * Maximum number of distinct columns aggregated by a query
+ */
+#ifndef CEPCUIAggregate_MAX_SLOT
+#define CEPCUIAggregate_MAX_SLOT 8
+#endif /* CEPCUIAggregate_MAX_SLOT */
+
+
+/**
+ * Maximum length of identifiers in an aggregate query (including the<br>
+ * terminating NULL)<br>
+ */
+#ifndef CEPCUIAggregate_NAME_LENGTH
+#define CEPCUIAggregate_NAME_LENGTH 64
+#endif /* CEPCUIAggregate_NAME_LENGTH */
+
+
+/**
+ * Function of a result column of an aggregate query.<br>
+ * CEPCUIAggregateFunction_KEY is the bare GROUP BY column.<br>
+ */
+#ifndef CEPCUIAggregateFunction
+typedef enum
+	{
+	CEPCUIAggregateFunction_KEY,
+	CEPCUIAggregateFunction_COUNT_ALL,
+	CEPCUIAggregateFunction_COUNT,
+	CEPCUIAggregateFunction_SUM,
+	CEPCUIAggregateFunction_AVG,
+	CEPCUIAggregateFunction_MIN,
+	CEPCUIAggregateFunction_MAX
+	} CEPCUIAggregateFunction;
+#endif /* CEPCUIAggregateFunction */
+
+
+/**
+ * Value of an aggregated column as stored by SQLite3 ("type" is<br>
+ * SQLITE_INTEGER, SQLITE_FLOAT or SQLITE_NULL).<br>
+ */
+#ifndef CEPCUIAggregateValue
+typedef struct
+	{
+	int type;
+	int64_t integer;
+	double real;
+	} CEPCUIAggregateValue;
+#endif /* CEPCUIAggregateValue */
+
+
+/**
+ * Monotonic deque of the values of a group for MIN() or MAX().<br>
+ * The front is the current extremum, and an entry is dropped from the<br>
+ * front when the record of its rowid leaves the window.<br>
+ */
+#ifndef CEPCUIAggregateDeque
+typedef struct
+	{
+	int64_t *rowidList;
+	CEPCUIAggregateValue *valueList;
+	size_t capacity;
+	size_t head;
+	size_t count;
+	} CEPCUIAggregateDeque;
+#endif /* CEPCUIAggregateDeque */
+
+
+/**
+ * Running state of one aggregated column in a group.<br>
+ * Floating point values are summed with Neumaier compensation, so that<br>
+ * adding and subtracting them doesn't accumulate rounding errors.<br>
+ */
+#ifndef CEPCUIAggregateSlot
+typedef struct
+	{
+	uint64_t count;
+	uint64_t realCount;
+	int64_t integerSum;
+	double realSum;
+	double compensation;
+	CEPCUIAggregateDeque minimum;
+	CEPCUIAggregateDeque maximum;
+	} CEPCUIAggregateSlot;
+#endif /* CEPCUIAggregateSlot */
+
+
+/**
+ * Group of the records in the window which share the GROUP BY key.<br>
+ * "key" is NULL for the NULL key, and "next" chains the groups of the<br>
+ * same hash bucket (or the unused groups).<br>
+ */
+#ifndef CEPCUIAggregateGroup
+typedef struct
+	{
+	M2MString *key;
+	size_t keyLength;
+	uint64_t hash;
+	int64_t next;
+	uint64_t records;
+	bool used;
+	CEPCUIAggregateSlot slotList[CEPCUIAggregate_MAX_SLOT];
+	} CEPCUIAggregateGroup;
+#endif /* CEPCUIAggregateGroup */
+
+
+/**
+ * Result column of an aggregate query.<br>
+ */
+#ifndef CEPCUIAggregateItem
+typedef struct
+	{
+	CEPCUIAggregateFunction function;
+	size_t slot;
+	} CEPCUIAggregateItem;
+#endif /* CEPCUIAggregateItem */
+
+
+/**
+ * Incremental state of an aggregate query.<br>
+ * The records of the window are kept in a ring (rowid, group and the<br>
+ * aggregated values), and each update reads only the records inserted<br>
+ * since the last update and drops the records deleted from the table, so<br>
+ * that the cost of a cycle depends on the batch rather than the window.<br>
+ */
+#ifndef CEPCUIAggregate
+typedef struct
+	{
+	sqlite3_stmt *deltaStatement;
+	sqlite3_stmt *rangeStatement;
+	sqlite3_stmt *formatStatement;
+	CEPCUIAggregateItem itemList[CEPCUIAggregate_MAX_COLUMN];
+	size_t itemCount;
+	size_t slotCount;
+	bool numericList[CEPCUIAggregate_MAX_SLOT];
+	bool minimumList[CEPCUIAggregate_MAX_SLOT];
+	bool maximumList[CEPCUIAggregate_MAX_SLOT];
+	bool grouped;
+	int64_t lastRowid;
+	int64_t *rowidList;
+	size_t *groupIndexList;
+	CEPCUIAggregateValue *valueList;
+	size_t capacity;
+	size_t head;
+	size_t count;
+	CEPCUIAggregateGroup *groupList;
+	size_t groupCount;
+	size_t groupCapacity;
+	int64_t freeGroup;
+	int64_t *bucketList;
+	size_t bucketCount;
+	CEPCUIAggregateGroup **recordList;
+	size_t recordCount;
+	M2MString text[64];
+	} CEPCUIAggregate;
+#endif /* CEPCUIAggregate */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the statements and heap memory of aggregate object.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ */
+void CEPCUIAggregate_delete (CEPCUIAggregate **self);
+
+
+/**
+ * Get the text of a column of the result, formatted in the same way as<br>
+ * sqlite3_column_text() would for the SQL query.<br>
+ * The text is valid until the next call.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @param[in] record	Index of the record (less than the count returned by CEPCUIAggregate_update())
+ * @param[in] column	Index of the column
+ * @param[out] length	Pointer for copying the size of the text[Byte]
+ * @return				Text of the column or NULL (in case of NULL value)
+ */
+const M2MString *CEPCUIAggregate_getText (CEPCUIAggregate *self, const size_t record, const size_t column, size_t *length);
+
+
+/**
+ * Construct new aggregate object for the prepared query, if the query is<br>
+ * recognized as an aggregate over the whole table, that is<br>
+ * "SELECT item[, item...] FROM table [GROUP BY column]" where each item is<br>
+ * COUNT(*), COUNT(column), SUM(column), AVG(column), MIN(column),<br>
+ * MAX(column) or the GROUP BY column itself (optionally with an alias).<br>
+ * Any other query (WHERE, HAVING, ORDER BY, expressions, ...) isn't<br>
+ * recognized, and is executed by SQLite3 as before.<br>
+ *
+ * @param[in] statement	Prepared statement of the query
+ * @return				Created aggregate object or NULL (in case of not recognized or error)
+ */
+CEPCUIAggregate *CEPCUIAggregate_new (sqlite3_stmt *statement);
+
+
+/**
+ * Bring the state up to date with the table: the records inserted since<br>
+ * the last update are added, and the oldest records deleted from the table<br>
+ * are removed.<br>
+ * The first update reads the whole table, and so does an update which<br>
+ * finds records deleted out of the order of insertion (e.g. late records<br>
+ * evicted by the time window) or rowid reused.<br>
+ * When the table holds values which can't be reproduced exactly (e.g.<br>
+ * text in an aggregated numeric column, a non-text GROUP BY key or integer<br>
+ * overflow), -1 is returned and the query must be executed by SQLite3.<br>
+ *
+ * @param[in,out] self	Aggregate object
+ * @return				Number of result records or -1 (in case of not reproducible or error)
+ */
+int64_t CEPCUIAggregate_update (CEPCUIAggregate *self);
+
+
+
+#endif /* CEPCUIAGGREGATE_H_ */
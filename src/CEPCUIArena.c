@@ -0,0 +1,293 @@
+/*******************************************************************************
+ * CEPCUIArena.c : Arena of the buffers released together at the end of every cycle
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIArena.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Round up the size to the alignment of the buffers.<br>
+ *
+ * @param[in] size	Size[Byte]
+ * @return			Aligned size[Byte]
+ */
+static size_t this_align (const size_t size);
+
+
+/**
+ * Construct new block of heap memory.<br>
+ *
+ * @param[in] capacity	Size of the data area[Byte]
+ * @param[in] next		Block chained after the new block or NULL
+ * @return				Created block or NULL (in case of error)
+ */
+static CEPCUIArenaBlock *this_newBlock (const size_t capacity, CEPCUIArenaBlock *next);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Round up the size to the alignment of the buffers.<br>
+ *
+ * @param[in] size	Size[Byte]
+ * @return			Aligned size[Byte]
+ */
+static size_t this_align (const size_t size)
+	{
+	return (size + CEPCUIArena_ALIGNMENT - 1) & ~((size_t)CEPCUIArena_ALIGNMENT - 1);
+	}
+
+
+/**
+ * Construct new block of heap memory.<br>
+ *
+ * @param[in] capacity	Size of the data area[Byte]
+ * @param[in] next		Block chained after the new block or NULL
+ * @return				Created block or NULL (in case of error)
+ */
+static CEPCUIArenaBlock *this_newBlock (const size_t capacity, CEPCUIArenaBlock *next)
+	{
+	//========== Variable ==========
+	CEPCUIArenaBlock *block = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIArena.this_newBlock()";
+
+	if ((block=(CEPCUIArenaBlock *)M2MHeap_malloc(sizeof(CEPCUIArenaBlock) + capacity))!=NULL)
+		{
+		block->next = next;
+		block->capacity = capacity;
+		block->length = 0;
+		return block;
+		}
+	//===== Error handling =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for arena block");
+		return NULL;
+		}
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Allocate the buffer in the arena.<br>
+ * The buffer is valid until the next CEPCUIArena_reset().<br>
+ *
+ * @param[in,out] self	Arena object
+ * @param[in] size		Size of the buffer[Byte]
+ * @return				Buffer or NULL (in case of error)
+ */
+void *CEPCUIArena_allocate (CEPCUIArena *self, const size_t size)
+	{
+	//========== Variable ==========
+	CEPCUIArenaBlock *block = NULL;
+	const size_t ALIGNED_SIZE = this_align(size);
+
+	//===== Check argument =====
+	if (self!=NULL && self->blockList!=NULL)
+		{
+		block = self->blockList;
+		//===== Chain a new block when the current one is full =====
+		if (block->capacity - block->length<ALIGNED_SIZE)
+			{
+			if ((block=this_newBlock((ALIGNED_SIZE>block->capacity * 2) ? ALIGNED_SIZE : block->capacity * 2, block))==NULL)
+				{
+				return NULL;
+				}
+			self->blockList = block;
+			}
+		self->last = (M2MString *)(block + 1) + block->length;
+		block->length += ALIGNED_SIZE;
+		return self->last;
+		}
+	else
+		{
+		return NULL;
+		}
+	}
+
+
+/**
+ * Release the heap memory of arena object (and all of its buffers).<br>
+ *
+ * @param[in,out] self	Arena object
+ */
+void CEPCUIArena_delete (CEPCUIArena **self)
+	{
+	//========== Variable ==========
+	CEPCUIArenaBlock *block = NULL;
+
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		while ((block=(*self)->blockList)!=NULL)
+			{
+			(*self)->blockList = block->next;
+			M2MHeap_free(block);
+			}
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Construct new arena object.<br>
+ *
+ * @param[in] capacity	Size of the first block[Byte]
+ * @return				Created arena object or NULL (in case of error)
+ */
+CEPCUIArena *CEPCUIArena_new (const size_t capacity)
+	{
+	//========== Variable ==========
+	CEPCUIArena *self = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIArena_new()";
+
+	//===== Check argument =====
+	if (capacity>0)
+		{
+		if ((self=(CEPCUIArena *)M2MHeap_malloc(sizeof(CEPCUIArena)))!=NULL
+				&& (self->blockList=this_newBlock(this_align(capacity), NULL))!=NULL)
+			{
+			self->last = NULL;
+			return self;
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for arena object");
+			M2MHeap_free(self);
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated capacity is 0");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Enlarge the buffer allocated in the arena, in place if it is the last<br>
+ * allocated one and the block has room, otherwise by copying it into a new<br>
+ * buffer.<br>
+ *
+ * @param[in,out] self	Arena object
+ * @param[in] buffer	Buffer allocated in the arena or NULL
+ * @param[in] length	Size of the data in the buffer[Byte] (copied to the enlarged buffer)
+ * @param[in] size		New size of the buffer[Byte]
+ * @return				Enlarged buffer or NULL (in case of error)
+ */
+void *CEPCUIArena_reallocate (CEPCUIArena *self, void *buffer, const size_t length, const size_t size)
+	{
+	//========== Variable ==========
+	CEPCUIArenaBlock *block = NULL;
+	size_t offset = 0;
+	void *enlarged = NULL;
+
+	//===== Check argument =====
+	if (self!=NULL && self->blockList!=NULL)
+		{
+		block = self->blockList;
+		//===== Enlarge the last buffer in place =====
+		if (buffer!=NULL && buffer==self->last
+				&& (offset=(size_t)((M2MString *)buffer - (M2MString *)(block + 1)))<block->capacity
+				&& block->capacity - offset>=this_align(size))
+			{
+			block->length = offset + this_align(size);
+			return buffer;
+			}
+		//===== Copy into a new buffer =====
+		else if ((enlarged=CEPCUIArena_allocate(self, size))!=NULL)
+			{
+			if (buffer!=NULL && length>0)
+				{
+				memcpy(enlarged, buffer, (length<size) ? length : size);
+				}
+			return enlarged;
+			}
+		}
+	return NULL;
+	}
+
+
+/**
+ * Release all the buffers allocated in the arena at once.<br>
+ *
+ * @param[in,out] self	Arena object
+ */
+void CEPCUIArena_reset (CEPCUIArena *self)
+	{
+	//========== Variable ==========
+	CEPCUIArenaBlock *block = NULL;
+	CEPCUIArenaBlock *merged = NULL;
+	size_t capacity = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && self->blockList!=NULL)
+		{
+		self->last = NULL;
+		//===== Replace the chained blocks with one block for the whole cycle =====
+		if (self->blockList->next!=NULL)
+			{
+			for (block=self->blockList; block!=NULL; block=block->next)
+				{
+				capacity += block->capacity;
+				}
+			if ((merged=this_newBlock(capacity, NULL))!=NULL)
+				{
+				while ((block=self->blockList)!=NULL)
+					{
+					self->blockList = block->next;
+					M2MHeap_free(block);
+					}
+				self->blockList = merged;
+				}
+			}
+		//===== Rewind all the blocks (if the merged block isn't available) =====
+		for (block=self->blockList; block!=NULL; block=block->next)
+			{
+			block->length = 0;
+			}
+		}
+	return;
+	}
+
+
+
+/* End Of File */
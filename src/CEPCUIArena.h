@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * CEPCUIArena.h : Arena of the buffers released together at the end of every cycle
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIARENA_H_
+#define CEPCUIARENA_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Default size of the first block of an arena[Byte]
+ */
+#ifndef CEPCUIArena_DEFAULT_CAPACITY
+#define CEPCUIArena_DEFAULT_CAPACITY 1048576
+#endif /* CEPCUIArena_DEFAULT_CAPACITY */
+
+
+/**
+ * Alignment of the allocated buffers[Byte]
+ */
+#ifndef CEPCUIArena_ALIGNMENT
+#define CEPCUIArena_ALIGNMENT 16
+#endif /* CEPCUIArena_ALIGNMENT */
+
+
+/**
+ * Block of heap memory which the buffers are carved out of.<br>
+ * The data area follows the block in the same heap memory ("padding"<br>
+ * keeps it aligned to CEPCUIArena_ALIGNMENT).<br>
+ */
+#ifndef CEPCUIArenaBlock
+typedef struct CEPCUIArenaBlock
+	{
+	struct CEPCUIArenaBlock *next;
+	size_t capacity;
+	size_t length;
+	size_t padding;
+	} CEPCUIArenaBlock;
+#endif /* CEPCUIArenaBlock */
+
+
+/**
+ * Arena which hands out buffers by bumping an offset, and releases all of<br>
+ * them at once by CEPCUIArena_reset().<br>
+ * When a cycle needs more than the current block, new blocks are chained;<br>
+ * the reset then replaces them with one block large enough for the whole<br>
+ * cycle, so that a steady loop allocates no heap memory at all.<br>
+ * An arena must be used by one thread at a time.<br>
+ */
+#ifndef CEPCUIArena
+typedef struct
+	{
+	CEPCUIArenaBlock *blockList;
+	void *last;
+	} CEPCUIArena;
+#endif /* CEPCUIArena */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Allocate the buffer in the arena.<br>
+ * The buffer is valid until the next CEPCUIArena_reset().<br>
+ *
+ * @param[in,out] self	Arena object
+ * @param[in] size		Size of the buffer[Byte]
+ * @return				Buffer or NULL (in case of error)
+ */
+void *CEPCUIArena_allocate (CEPCUIArena *self, const size_t size);
+
+
+/**
+ * Release the heap memory of arena object (and all of its buffers).<br>
+ *
+ * @param[in,out] self	Arena object
+ */
+void CEPCUIArena_delete (CEPCUIArena **self);
+
+
+/**
+ * Construct new arena object.<br>
+ *
+ * @param[in] capacity	Size of the first block[Byte]
+ * @return				Created arena object or NULL (in case of error)
+ */
+CEPCUIArena *CEPCUIArena_new (const size_t capacity);
+
+
+/**
+ * Enlarge the buffer allocated in the arena, in place if it is the last<br>
+ * allocated one and the block has room, otherwise by copying it into a new<br>
+ * buffer.<br>
+ *
+ * @param[in,out] self	Arena object
+ * @param[in] buffer	Buffer allocated in the arena or NULL
+ * @param[in] length	Size of the data in the buffer[Byte] (copied to the enlarged buffer)
+ * @param[in] size		New size of the buffer[Byte]
+ * @return				Enlarged buffer or NULL (in case of error)
+ */
+void *CEPCUIArena_reallocate (CEPCUIArena *self, void *buffer, const size_t length, const size_t size);
+
+
+/**
+ * Release all the buffers allocated in the arena at once.<br>
+ *
+ * @param[in,out] self	Arena object
+ */
+void CEPCUIArena_reset (CEPCUIArena *self);
+
+
+
+#endif /* CEPCUIARENA_H_ */
@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * CEPCUIBinaryReader.c : Reader of typed binary records
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIBinaryReader.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Read a little endian 32bit unsigned integer.<br>
+ *
+ * @param[in] data	Pointer of the integer (not necessarily aligned)
+ * @return			Integer
+ */
+static uint32_t this_readUInt32 (const M2MString *data);
+
+
+/**
+ * Read a little endian 64bit unsigned integer.<br>
+ *
+ * @param[in] data	Pointer of the integer (not necessarily aligned)
+ * @return			Integer
+ */
+static uint64_t this_readUInt64 (const M2MString *data);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Read a little endian 32bit unsigned integer.<br>
+ *
+ * @param[in] data	Pointer of the integer (not necessarily aligned)
+ * @return			Integer
+ */
+static uint32_t this_readUInt32 (const M2MString *data)
+	{
+	//========== Variable ==========
+	uint32_t value = 0;
+
+	memcpy(&value, data, sizeof(value));
+	return le32toh(value);
+	}
+
+
+/**
+ * Read a little endian 64bit unsigned integer.<br>
+ *
+ * @param[in] data	Pointer of the integer (not necessarily aligned)
+ * @return			Integer
+ */
+static uint64_t this_readUInt64 (const M2MString *data)
+	{
+	//========== Variable ==========
+	uint64_t value = 0;
+
+	memcpy(&value, data, sizeof(value));
+	return le64toh(value);
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Initialize the reader with the indicated buffer and check its header.<br>
+ *
+ * @param[out] self		Reader object
+ * @param[in] schema	Schema of the records
+ * @param[in] data		Buffer of binary records
+ * @param[in] length	Size of the buffer[Byte]
+ * @return				true : success, false : the header doesn't match the schema
+ */
+bool CEPCUIBinaryReader_init (CEPCUIBinaryReader *self, const CEPCUISchema *schema, const M2MString *data, const size_t length)
+	{
+	const size_t MAGIC_LENGTH = strlen(CEPCUIBinaryReader_MAGIC);
+
+	//===== Check argument =====
+	if (self!=NULL && schema!=NULL && data!=NULL)
+		{
+		self->data = data;
+		self->length = length;
+		self->position = length;
+		self->schema = schema;
+		self->broken = false;
+		//===== Check header =====
+		if (length>=CEPCUIBinaryReader_HEADER_LENGTH
+				&& memcmp(data, CEPCUIBinaryReader_MAGIC, MAGIC_LENGTH)==0
+				&& this_readUInt32(&data[MAGIC_LENGTH])==schema->count)
+			{
+			self->position = CEPCUIBinaryReader_HEADER_LENGTH;
+			return true;
+			}
+		}
+	return false;
+	}
+
+
+/**
+ * Get the fields of next record.<br>
+ * Every field is bounds-checked, so a truncated or corrupted buffer never<br>
+ * causes reading beyond its end; the rest of the buffer is skipped instead.<br>
+ *
+ * @param[in,out] self		Reader object
+ * @param[out] fieldList	Array for copying the fields
+ * @param[in] maxField		Number of elements of the array
+ * @return					Number of fields in the record or 0 (in case of the end of buffer or broken record)
+ */
+size_t CEPCUIBinaryReader_next (CEPCUIBinaryReader *self, CEPCUIBinaryField fieldList[], const size_t maxField)
+	{
+	//========== Variable ==========
+	size_t position = 0;
+	size_t bitmap = 0;
+	size_t length = 0;
+	size_t i = 0;
+	uint64_t bits = 0;
+	CEPCUIBinaryField field;
+
+	//===== Check argument =====
+	if (self==NULL || self->data==NULL || self->schema==NULL || self->position>=self->length)
+		{
+		return 0;
+		}
+	//===== NULL bitmap =====
+	bitmap = self->position;
+	position = bitmap + (self->schema->count + 7) / 8;
+	for (i=0; i<self->schema->count && position<=self->length; i++)
+		{
+		memset(&field, 0, sizeof(field));
+		field.type = self->schema->columnList[i].fieldType;
+		field.null = ((self->data[bitmap+i/8] >> (i%8)) & 1)!=0;
+		//===== NULL field =====
+		if (field.null==true)
+			{
+			}
+		//===== Number =====
+		else if (field.type==CEPCUIFieldType_INTEGER || field.type==CEPCUIFieldType_DOUBLE)
+			{
+			if (position+8>self->length)
+				{
+				break;
+				}
+			bits = this_readUInt64(&self->data[position]);
+			if (field.type==CEPCUIFieldType_INTEGER)
+				{
+				field.integer = (int64_t)bits;
+				}
+			else
+				{
+				memcpy(&field.real, &bits, sizeof(field.real));
+				}
+			position += 8;
+			}
+		//===== String or byte sequence =====
+		else
+			{
+			if (position+4>self->length || (length=this_readUInt32(&self->data[position]))>self->length-position-4)
+				{
+				break;
+				}
+			field.offset = position + 4;
+			field.length = length;
+			position += 4 + length;
+			}
+		if (i<maxField)
+			{
+			fieldList[i] = field;
+			}
+		}
+	//===== Broken record =====
+	if (i<self->schema->count || position>self->length)
+		{
+		self->broken = true;
+		self->position = self->length;
+		return 0;
+		}
+	self->position = position;
+	return i;
+	}
+
+
+
+/* End Of File */
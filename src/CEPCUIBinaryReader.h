@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * CEPCUIBinaryReader.h : Reader of typed binary records
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIBINARYREADER_H_
+#define CEPCUIBINARYREADER_H_
+
+
+
+#include "CEPCUISchema.h"
+#include "m2m/lib/lang/M2MString.h"
+#include <endian.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Magic number at the beginning of binary input files
+ */
+#ifndef CEPCUIBinaryReader_MAGIC
+#define CEPCUIBinaryReader_MAGIC "CEPCUIB1"
+#endif /* CEPCUIBinaryReader_MAGIC */
+
+
+/**
+ * Size of the file header (magic number and the number of columns)[Byte]
+ */
+#ifndef CEPCUIBinaryReader_HEADER_LENGTH
+#define CEPCUIBinaryReader_HEADER_LENGTH 12
+#endif /* CEPCUIBinaryReader_HEADER_LENGTH */
+
+
+/**
+ * Typed field decoded from a binary record.<br>
+ * Numbers are decoded into "integer" or "real", while strings and byte<br>
+ * sequences are referred by their position in the buffer.<br>
+ */
+#ifndef CEPCUIBinaryField
+typedef struct
+	{
+	CEPCUIFieldType type;
+	bool null;
+	int64_t integer;
+	double real;
+	size_t offset;
+	size_t length;
+	} CEPCUIBinaryField;
+#endif /* CEPCUIBinaryField */
+
+
+/**
+ * Reader of binary records in a buffer.<br>
+ * The buffer has the following layout (all numbers are little endian).<br>
+ *<br>
+ * - Header: "CEPCUIB1" (8 bytes), number of columns (uint32)<br>
+ * - Record: NULL bitmap (1 bit per column, LSB first, set for NULL), and<br>
+ *   the non-NULL fields in column order<br>
+ * - Field: int64 (integral types), IEEE 754 binary64 (floating point types),<br>
+ *   or uint32 length followed by the bytes (strings and BLOB)<br>
+ *<br>
+ * Like the CSV tokenizer, the reader never allocates nor modifies the<br>
+ * buffer. "broken" is set when the buffer ends in the middle of a record.<br>
+ */
+#ifndef CEPCUIBinaryReader
+typedef struct
+	{
+	const M2MString *data;
+	size_t length;
+	size_t position;
+	const CEPCUISchema *schema;
+	bool broken;
+	} CEPCUIBinaryReader;
+#endif /* CEPCUIBinaryReader */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Initialize the reader with the indicated buffer and check its header.<br>
+ *
+ * @param[out] self		Reader object
+ * @param[in] schema	Schema of the records
+ * @param[in] data		Buffer of binary records
+ * @param[in] length	Size of the buffer[Byte]
+ * @return				true : success, false : the header doesn't match the schema
+ */
+bool CEPCUIBinaryReader_init (CEPCUIBinaryReader *self, const CEPCUISchema *schema, const M2MString *data, const size_t length);
+
+
+/**
+ * Get the fields of next record.<br>
+ *
+ * @param[in,out] self		Reader object
+ * @param[out] fieldList	Array for copying the fields
+ * @param[in] maxField		Number of elements of the array
+ * @return					Number of fields in the record or 0 (in case of the end of buffer or broken record)
+ */
+size_t CEPCUIBinaryReader_next (CEPCUIBinaryReader *self, CEPCUIBinaryField fieldList[], const size_t maxField);
+
+
+
+#endif /* CEPCUIBINARYREADER_H_ */
@@ -0,0 +1,678 @@
+/*******************************************************************************
+ * CEPCUICSVTokenizer.c : Zero-copy tokenizer of CSV format records
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUICSVTokenizer.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Whether the vector scanners of x86 are compiled (each of them is compiled<br>
+ * for its own instruction set, and used only if the CPU supports it)<br>
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CEPCUICSVTokenizer_X86
+#endif
+
+
+/**
+ * Maximum mantissa which is exactly representable in a double (2^53)
+ */
+#define CEPCUICSVTokenizer_MAX_EXACT_MANTISSA 9007199254740992ULL
+
+
+/**
+ * Powers of ten which are exactly representable in a double
+ */
+static const double POWER_OF_TEN[] =
+	{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Find the end of unquoted field (comma or LF) with the bit mask of the<br>
+ * block, scanning the next blocks as needed.<br>
+ *
+ * @param[in,out] self	Tokenizer object
+ * @param[in] position	Start position of the search
+ * @return				Position of the delimiter or the length of buffer (in case of not found)
+ */
+static size_t this_findDelimiter (CEPCUICSVTokenizer *self, size_t position);
+
+
+/**
+ * Find the closing double quote of quoted field.<br>
+ *
+ * @param[in] self		Tokenizer object
+ * @param[in] position	Position next to the opening double quote
+ * @param[out] escaped	true : the field contains doubled double quotes
+ * @return				Position of the closing double quote or the length of buffer (in case of not found)
+ */
+static size_t this_findQuote (const CEPCUICSVTokenizer *self, size_t position, bool *escaped);
+
+
+/**
+ * Scan the block for the delimiters with the scanner of the tokenizer, and<br>
+ * keep their bit mask.<br>
+ *
+ * @param[in,out] self	Tokenizer object
+ * @param[in] block		Start position of the block (a multiple of CEPCUICSVTokenizer_BLOCK_LENGTH)
+ */
+static void this_scan (CEPCUICSVTokenizer *self, const size_t block);
+
+
+#ifdef CEPCUICSVTokenizer_X86
+/**
+ * Get the bit mask of the delimiters in the block with AVX2 (32 bytes at once).<br>
+ *
+ * @param[in] data	Block (CEPCUICSVTokenizer_BLOCK_LENGTH bytes)
+ * @return			Bit mask of the delimiters
+ */
+__attribute__((target("avx2"))) static uint64_t this_scanAVX2 (const M2MString *data);
+#endif /* CEPCUICSVTokenizer_X86 */
+
+
+/**
+ * Get the bit mask of the delimiters in the block byte by byte (for the<br>
+ * last block, which is shorter than a vector).<br>
+ *
+ * @param[in] data		Block
+ * @param[in] length	Size of the block[Byte] (at most CEPCUICSVTokenizer_BLOCK_LENGTH)
+ * @return				Bit mask of the delimiters
+ */
+static uint64_t this_scanScalar (const M2MString *data, const size_t length);
+
+
+#ifdef CEPCUICSVTokenizer_X86
+/**
+ * Get the bit mask of the delimiters in the block with SSE2 (16 bytes at once).<br>
+ *
+ * @param[in] data	Block (CEPCUICSVTokenizer_BLOCK_LENGTH bytes)
+ * @return			Bit mask of the delimiters
+ */
+__attribute__((target("sse2"))) static uint64_t this_scanSSE2 (const M2MString *data);
+#endif /* CEPCUICSVTokenizer_X86 */
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Find the end of unquoted field (comma or LF) with the bit mask of the<br>
+ * block, scanning the next blocks as needed.<br>
+ *
+ * @param[in,out] self	Tokenizer object
+ * @param[in] position	Start position of the search
+ * @return				Position of the delimiter or the length of buffer (in case of not found)
+ */
+static size_t this_findDelimiter (CEPCUICSVTokenizer *self, size_t position)
+	{
+	//========== Variable ==========
+	size_t block = 0;
+	uint64_t mask = 0;
+
+	//===== Scalar scanner (byte by byte, without the bit mask) =====
+	if (self->scanner==CEPCUICSVScanner_SCALAR)
+		{
+		while (position<self->length && self->data[position]!=',' && self->data[position]!='\n')
+			{
+			position++;
+			}
+		return position;
+		}
+	while (position<self->length)
+		{
+		//===== Scan the block once for all of its fields =====
+		if ((block=position & ~((size_t)CEPCUICSVTokenizer_BLOCK_LENGTH - 1))!=self->maskPosition)
+			{
+			this_scan(self, block);
+			}
+		//===== Delimiter in the rest of the block =====
+		if ((mask=self->mask >> (position - block))!=0)
+			{
+			return position + (size_t)__builtin_ctzll(mask);
+			}
+		position = block + CEPCUICSVTokenizer_BLOCK_LENGTH;
+		}
+	return self->length;
+	}
+
+
+/**
+ * Find the closing double quote of quoted field.<br>
+ *
+ * @param[in] self		Tokenizer object
+ * @param[in] position	Position next to the opening double quote
+ * @param[out] escaped	true : the field contains doubled double quotes
+ * @return				Position of the closing double quote or the length of buffer (in case of not found)
+ */
+static size_t this_findQuote (const CEPCUICSVTokenizer *self, size_t position, bool *escaped)
+	{
+	const M2MString *quote = NULL;
+
+	(*escaped) = false;
+	while (position<self->length
+			&& (quote=(const M2MString *)memchr(&self->data[position], '"', self->length-position))!=NULL)
+		{
+		position = (size_t)(quote - self->data);
+		//===== Doubled double quote =====
+		if (position+1<self->length && self->data[position+1]=='"')
+			{
+			(*escaped) = true;
+			position += 2;
+			}
+		//===== Closing double quote =====
+		else
+			{
+			return position;
+			}
+		}
+	return self->length;
+	}
+
+
+/**
+ * Scan the block for the delimiters with the scanner of the tokenizer, and<br>
+ * keep their bit mask.<br>
+ *
+ * @param[in,out] self	Tokenizer object
+ * @param[in] block		Start position of the block (a multiple of CEPCUICSVTokenizer_BLOCK_LENGTH)
+ */
+static void this_scan (CEPCUICSVTokenizer *self, const size_t block)
+	{
+	//========== Variable ==========
+	const size_t length = self->length - block;
+
+#ifdef CEPCUICSVTokenizer_X86
+	//===== Whole block =====
+	if (length>=CEPCUICSVTokenizer_BLOCK_LENGTH && self->scanner==CEPCUICSVScanner_AVX2)
+		{
+		self->mask = this_scanAVX2(&self->data[block]);
+		}
+	else if (length>=CEPCUICSVTokenizer_BLOCK_LENGTH && self->scanner==CEPCUICSVScanner_SSE2)
+		{
+		self->mask = this_scanSSE2(&self->data[block]);
+		}
+	//===== Last block (never read beyond the buffer) =====
+	else
+#endif /* CEPCUICSVTokenizer_X86 */
+		{
+		self->mask = this_scanScalar(&self->data[block], (length<CEPCUICSVTokenizer_BLOCK_LENGTH) ? length : CEPCUICSVTokenizer_BLOCK_LENGTH);
+		}
+	self->maskPosition = block;
+	return;
+	}
+
+
+#ifdef CEPCUICSVTokenizer_X86
+/**
+ * Get the bit mask of the delimiters in the block with AVX2 (32 bytes at once).<br>
+ *
+ * @param[in] data	Block (CEPCUICSVTokenizer_BLOCK_LENGTH bytes)
+ * @return			Bit mask of the delimiters
+ */
+__attribute__((target("avx2"))) static uint64_t this_scanAVX2 (const M2MString *data)
+	{
+	//========== Variable ==========
+	const __m256i COMMA = _mm256_set1_epi8(',');
+	const __m256i LINE_FEED = _mm256_set1_epi8('\n');
+	const __m256i LOW = _mm256_loadu_si256((const __m256i *)data);
+	const __m256i HIGH = _mm256_loadu_si256((const __m256i *)(data + 32));
+	const uint32_t lowMask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(LOW, COMMA), _mm256_cmpeq_epi8(LOW, LINE_FEED)));
+	const uint32_t highMask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(HIGH, COMMA), _mm256_cmpeq_epi8(HIGH, LINE_FEED)));
+
+	return (uint64_t)lowMask | ((uint64_t)highMask << 32);
+	}
+#endif /* CEPCUICSVTokenizer_X86 */
+
+
+/**
+ * Get the bit mask of the delimiters in the block byte by byte (for the<br>
+ * last block, which is shorter than a vector).<br>
+ *
+ * @param[in] data		Block
+ * @param[in] length	Size of the block[Byte] (at most CEPCUICSVTokenizer_BLOCK_LENGTH)
+ * @return				Bit mask of the delimiters
+ */
+static uint64_t this_scanScalar (const M2MString *data, const size_t length)
+	{
+	//========== Variable ==========
+	uint64_t mask = 0;
+	size_t i = 0;
+
+	for (i=0; i<length; i++)
+		{
+		mask |= (uint64_t)(data[i]==',' || data[i]=='\n') << i;
+		}
+	return mask;
+	}
+
+
+#ifdef CEPCUICSVTokenizer_X86
+/**
+ * Get the bit mask of the delimiters in the block with SSE2 (16 bytes at once).<br>
+ *
+ * @param[in] data	Block (CEPCUICSVTokenizer_BLOCK_LENGTH bytes)
+ * @return			Bit mask of the delimiters
+ */
+__attribute__((target("sse2"))) static uint64_t this_scanSSE2 (const M2MString *data)
+	{
+	//========== Variable ==========
+	const __m128i COMMA = _mm_set1_epi8(',');
+	const __m128i LINE_FEED = _mm_set1_epi8('\n');
+	__m128i vector;
+	uint64_t mask = 0;
+	size_t i = 0;
+
+	for (i=0; i<CEPCUICSVTokenizer_BLOCK_LENGTH; i+=16)
+		{
+		vector = _mm_loadu_si128((const __m128i *)(data + i));
+		mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(vector, COMMA), _mm_cmpeq_epi8(vector, LINE_FEED))) << i;
+		}
+	return mask;
+	}
+#endif /* CEPCUICSVTokenizer_X86 */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Get the fastest scanner supported by the CPU.<br>
+ *
+ * @return	Instruction set of the scanner
+ */
+CEPCUICSVScanner CEPCUICSVTokenizer_getScanner (void)
+	{
+#ifdef CEPCUICSVTokenizer_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		{
+		return CEPCUICSVScanner_AVX2;
+		}
+	else if (__builtin_cpu_supports("sse2"))
+		{
+		return CEPCUICSVScanner_SSE2;
+		}
+#endif /* CEPCUICSVTokenizer_X86 */
+	return CEPCUICSVScanner_SCALAR;
+	}
+
+
+/**
+ * Initialize the tokenizer with the indicated buffer.<br>
+ * The fastest scanner supported by the CPU is used.<br>
+ *
+ * @param[out] self		Tokenizer object
+ * @param[in] data		Buffer of CSV format records (not necessarily NULL terminated)
+ * @param[in] length	Size of the buffer[Byte]
+ */
+void CEPCUICSVTokenizer_init (CEPCUICSVTokenizer *self, const M2MString *data, const size_t length)
+	{
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		self->data = data;
+		self->length = (data!=NULL) ? length : 0;
+		self->position = 0;
+		self->scanner = CEPCUICSVTokenizer_getScanner();
+		self->mask = 0;
+		self->maskPosition = SIZE_MAX;
+		}
+	return;
+	}
+
+
+/**
+ * Get the fields of next record.<br>
+ * Records may be separated with LF, CRLF or a mixture of them, and empty<br>
+ * lines are skipped.<br>
+ * A field may be enclosed in double quotes, in which case it can contain<br>
+ * commas and line feeds.<br>
+ * Fields beyond the indicated maximum number are skipped but counted.<br>
+ *
+ * @param[in,out] self		Tokenizer object
+ * @param[out] fieldList	Array for copying the field positions
+ * @param[in] maxField		Number of elements of the array
+ * @return					Number of fields in the record or 0 (in case of the end of buffer)
+ */
+size_t CEPCUICSVTokenizer_next (CEPCUICSVTokenizer *self, CEPCUICSVField fieldList[], const size_t maxField)
+	{
+	//========== Variable ==========
+	size_t position = 0;
+	size_t start = 0;
+	size_t end = 0;
+	size_t count = 0;
+	bool escaped = false;
+
+	//===== Check argument =====
+	if (self==NULL || self->data==NULL)
+		{
+		return 0;
+		}
+	position = self->position;
+	//===== Skip empty lines =====
+	while (position<self->length && (self->data[position]=='\n' || self->data[position]=='\r'))
+		{
+		position++;
+		}
+	//===== End of buffer =====
+	if (position>=self->length)
+		{
+		self->position = self->length;
+		return 0;
+		}
+	//===== Tokenize fields =====
+	while (true)
+		{
+		//===== Quoted field =====
+		if (position<self->length && self->data[position]=='"')
+			{
+			start = position + 1;
+			end = this_findQuote(self, start, &escaped);
+			//===== Ignore the garbage after the closing double quote =====
+			position = this_findDelimiter(self, (end<self->length) ? end + 1 : end);
+			}
+		//===== Unquoted field =====
+		else
+			{
+			start = position;
+			end = position = this_findDelimiter(self, position);
+			escaped = false;
+			//===== Remove CR of CRLF =====
+			if (end>start && (end>=self->length || self->data[end]=='\n') && self->data[end-1]=='\r')
+				{
+				end--;
+				}
+			}
+		//===== Record field position =====
+		if (count<maxField)
+			{
+			fieldList[count].offset = start;
+			fieldList[count].length = end - start;
+			fieldList[count].escaped = escaped;
+			}
+		count++;
+		//===== Next field =====
+		if (position<self->length && self->data[position]==',')
+			{
+			position++;
+			}
+		//===== End of record =====
+		else
+			{
+			self->position = (position<self->length) ? position + 1 : self->length;
+			return count;
+			}
+		}
+	}
+
+
+/**
+ * Convert the field into a floating point number, as exactly as strtod().<br>
+ * Only decimal numbers ("-12", "0.25", "1.5e3" and so on) of at most 19<br>
+ * significant digits which are exactly convertible with one multiplication<br>
+ * or division are accepted; the others (including the escaped fields and<br>
+ * the fields with spaces) are left to SQLite3.<br>
+ *
+ * @param[in] self		Tokenizer object
+ * @param[in] field		Field position
+ * @param[out] value	Converted number
+ * @return				true : converted, false : not converted by the fast path
+ */
+bool CEPCUICSVTokenizer_parseDouble (const CEPCUICSVTokenizer *self, const CEPCUICSVField *field, double *value)
+	{
+	//========== Variable ==========
+	const M2MString *character = NULL;
+	const M2MString *end = NULL;
+	uint64_t mantissa = 0;
+	unsigned int digits = 0;
+	int exponent = 0;
+	int exponentPart = 0;
+	bool negative = false;
+	bool negativeExponent = false;
+	bool found = false;
+
+	//===== Check argument =====
+	if (self==NULL || field==NULL || value==NULL || field->escaped==true || field->length<=0)
+		{
+		return false;
+		}
+	character = &self->data[field->offset];
+	end = character + field->length;
+	//===== Sign =====
+	if ((*character)=='-' || (*character)=='+')
+		{
+		negative = ((*character)=='-');
+		character++;
+		}
+	//===== Integer part (leading zeros are not significant) =====
+	for (; character<end && '0'<=(*character) && (*character)<='9'; character++)
+		{
+		found = true;
+		if (mantissa==0 && (*character)=='0')
+			{
+			continue;
+			}
+		else if (digits>=19)
+			{
+			return false;
+			}
+		mantissa = mantissa * 10 + (uint64_t)((*character) - '0');
+		digits++;
+		}
+	//===== Fraction part =====
+	if (character<end && (*character)=='.')
+		{
+		for (character++; character<end && '0'<=(*character) && (*character)<='9'; character++)
+			{
+			found = true;
+			exponent--;
+			if (mantissa==0 && (*character)=='0')
+				{
+				continue;
+				}
+			else if (digits>=19)
+				{
+				return false;
+				}
+			mantissa = mantissa * 10 + (uint64_t)((*character) - '0');
+			digits++;
+			}
+		}
+	//===== Exponent part =====
+	if (found==true && character<end && ((*character)=='e' || (*character)=='E'))
+		{
+		character++;
+		if (character<end && ((*character)=='-' || (*character)=='+'))
+			{
+			negativeExponent = ((*character)=='-');
+			character++;
+			}
+		if (character>=end)
+			{
+			return false;
+			}
+		for (; character<end && '0'<=(*character) && (*character)<='9'; character++)
+			{
+			if ((exponentPart=exponentPart * 10 + ((*character) - '0'))>9999)
+				{
+				return false;
+				}
+			}
+		exponent += (negativeExponent==true) ? -exponentPart : exponentPart;
+		}
+	//===== Not a decimal number =====
+	if (found==false || character!=end)
+		{
+		return false;
+		}
+	//===== Zero =====
+	else if (mantissa==0)
+		{
+		(*value) = (negative==true) ? -0.0 : 0.0;
+		return true;
+		}
+	//===== Not exactly convertible (left to SQLite3) =====
+	else if (mantissa>CEPCUICSVTokenizer_MAX_EXACT_MANTISSA || exponent<-22 || 22<exponent)
+		{
+		return false;
+		}
+	//===== Both operands are exact, so the result is correctly rounded =====
+	(*value) = (exponent<0) ? (double)mantissa / POWER_OF_TEN[-exponent] : (double)mantissa * POWER_OF_TEN[exponent];
+	if (negative==true)
+		{
+		(*value) = -(*value);
+		}
+	return true;
+	}
+
+
+/**
+ * Convert the field into an integer.<br>
+ * Only an optional sign and at most 18 digits are accepted; the others are<br>
+ * left to SQLite3.<br>
+ *
+ * @param[in] self		Tokenizer object
+ * @param[in] field		Field position
+ * @param[out] value	Converted number
+ * @return				true : converted, false : not converted by the fast path
+ */
+bool CEPCUICSVTokenizer_parseInteger (const CEPCUICSVTokenizer *self, const CEPCUICSVField *field, int64_t *value)
+	{
+	//========== Variable ==========
+	const M2MString *character = NULL;
+	const M2MString *end = NULL;
+	const M2MString *start = NULL;
+	int64_t integer = 0;
+	bool negative = false;
+
+	//===== Check argument =====
+	if (self==NULL || field==NULL || value==NULL || field->escaped==true || field->length<=0)
+		{
+		return false;
+		}
+	character = &self->data[field->offset];
+	end = character + field->length;
+	//===== Sign =====
+	if ((*character)=='-' || (*character)=='+')
+		{
+		negative = ((*character)=='-');
+		character++;
+		}
+	//===== Digits (never overflow) =====
+	for (start=character; character<end && '0'<=(*character) && (*character)<='9'; character++)
+		{
+		if (character-start>=18)
+			{
+			return false;
+			}
+		integer = integer * 10 + ((*character) - '0');
+		}
+	//===== Not an integer =====
+	if (character==start || character!=end)
+		{
+		return false;
+		}
+	(*value) = (negative==true) ? -integer : integer;
+	return true;
+	}
+
+
+/**
+ * Use the indicated scanner instead of the detected one (for comparing the<br>
+ * scanners).<br>
+ * A scanner not supported by the CPU falls back to the fastest supported one.<br>
+ *
+ * @param[in,out] self	Tokenizer object
+ * @param[in] scanner	Instruction set of the scanner
+ * @return				Instruction set of the scanner in use
+ */
+CEPCUICSVScanner CEPCUICSVTokenizer_setScanner (CEPCUICSVTokenizer *self, const CEPCUICSVScanner scanner)
+	{
+	//========== Variable ==========
+	const CEPCUICSVScanner SUPPORTED = CEPCUICSVTokenizer_getScanner();
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		// the scanners are in ascending order of the required instruction set
+		self->scanner = (scanner<=SUPPORTED) ? scanner : SUPPORTED;
+		self->maskPosition = SIZE_MAX;
+		return self->scanner;
+		}
+	return SUPPORTED;
+	}
+
+
+/**
+ * Copy the escaped field into the buffer with its doubled double quotes<br>
+ * replaced with single ones.<br>
+ *
+ * @param[in] self			Tokenizer object
+ * @param[in] field			Escaped field position
+ * @param[out] buffer		Buffer for copying the unescaped field
+ * @param[in] bufferLength	Size of the buffer[Byte] (at least the field length)
+ * @return					Length of the unescaped field[Byte]
+ */
+size_t CEPCUICSVTokenizer_unescape (const CEPCUICSVTokenizer *self, const CEPCUICSVField *field, M2MString buffer[], const size_t bufferLength)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	size_t length = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && field!=NULL && buffer!=NULL)
+		{
+		for (i=0; i<field->length && length<bufferLength; i++)
+			{
+			buffer[length++] = self->data[field->offset+i];
+			//===== Skip the second double quote =====
+			if (self->data[field->offset+i]=='"' && i+1<field->length && self->data[field->offset+i+1]=='"')
+				{
+				i++;
+				}
+			}
+		}
+	return length;
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * CEPCUICSVTokenizer.h : Zero-copy tokenizer of CSV format records
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUICSVTOKENIZER_H_
+#define CEPCUICSVTOKENIZER_H_
+
+
+
+#include "m2m/lib/lang/M2MString.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Size of the block scanned for the delimiters at once[Byte]
+ */
+#ifndef CEPCUICSVTokenizer_BLOCK_LENGTH
+#define CEPCUICSVTokenizer_BLOCK_LENGTH 64
+#endif /* CEPCUICSVTokenizer_BLOCK_LENGTH */
+
+
+/**
+ * Instruction set which scans the blocks of the buffer for the delimiters.<br>
+ * The best one supported by the CPU is detected at runtime, so the same<br>
+ * binary runs on any x86 CPU (and on the other architectures with the<br>
+ * scalar scanner).<br>
+ */
+#ifndef CEPCUICSVScanner
+typedef enum
+	{
+	CEPCUICSVScanner_SCALAR,
+	CEPCUICSVScanner_SSE2,
+	CEPCUICSVScanner_AVX2
+	} CEPCUICSVScanner;
+#endif /* CEPCUICSVScanner */
+
+
+/**
+ * Position of a field in the tokenized buffer.<br>
+ * Surrounding double quotes are not included.<br>
+ * If "escaped" is true, the field contains doubled double quotes ("") which<br>
+ * must be unescaped with CEPCUICSVTokenizer_unescape() before use.<br>
+ */
+#ifndef CEPCUICSVField
+typedef struct
+	{
+	size_t offset;
+	size_t length;
+	bool escaped;
+	} CEPCUICSVField;
+#endif /* CEPCUICSVField */
+
+
+/**
+ * Tokenizer of CSV format records in a buffer.<br>
+ * The tokenizer never allocates nor modifies the buffer; it only records the<br>
+ * offsets of fields, so the buffer may be a read-only memory mapped file.<br>
+ * The commas and line feeds of the current block are kept as a bit mask<br>
+ * ("mask" bit i for data[maskPosition+i]), so the fields of the several<br>
+ * records in a block are found with one vector scan.<br>
+ */
+#ifndef CEPCUICSVTokenizer
+typedef struct
+	{
+	const M2MString *data;
+	size_t length;
+	size_t position;
+	CEPCUICSVScanner scanner;
+	uint64_t mask;
+	size_t maskPosition;
+	} CEPCUICSVTokenizer;
+#endif /* CEPCUICSVTokenizer */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Get the fastest scanner supported by the CPU.<br>
+ *
+ * @return	Instruction set of the scanner
+ */
+CEPCUICSVScanner CEPCUICSVTokenizer_getScanner (void);
+
+
+/**
+ * Initialize the tokenizer with the indicated buffer.<br>
+ * The fastest scanner supported by the CPU is used.<br>
+ *
+ * @param[out] self		Tokenizer object
+ * @param[in] data		Buffer of CSV format records (not necessarily NULL terminated)
+ * @param[in] length	Size of the buffer[Byte]
+ */
+void CEPCUICSVTokenizer_init (CEPCUICSVTokenizer *self, const M2MString *data, const size_t length);
+
+
+/**
+ * Get the fields of next record.<br>
+ * Records may be separated with LF, CRLF or a mixture of them, and empty<br>
+ * lines are skipped.<br>
+ * Fields beyond the indicated maximum number are skipped but counted.<br>
+ *
+ * @param[in,out] self		Tokenizer object
+ * @param[out] fieldList	Array for copying the field positions
+ * @param[in] maxField		Number of elements of the array
+ * @return					Number of fields in the record or 0 (in case of the end of buffer)
+ */
+size_t CEPCUICSVTokenizer_next (CEPCUICSVTokenizer *self, CEPCUICSVField fieldList[], const size_t maxField);
+
+
+/**
+ * Convert the field into a floating point number, as exactly as strtod().<br>
+ * Only decimal numbers ("-12", "0.25", "1.5e3" and so on) of at most 19<br>
+ * significant digits which are exactly convertible with one multiplication<br>
+ * or division are accepted; the others (including the escaped fields and<br>
+ * the fields with spaces) are left to SQLite3.<br>
+ *
+ * @param[in] self		Tokenizer object
+ * @param[in] field		Field position
+ * @param[out] value	Converted number
+ * @return				true : converted, false : not converted by the fast path
+ */
+bool CEPCUICSVTokenizer_parseDouble (const CEPCUICSVTokenizer *self, const CEPCUICSVField *field, double *value);
+
+
+/**
+ * Convert the field into an integer.<br>
+ * Only an optional sign and at most 18 digits are accepted; the others are<br>
+ * left to SQLite3.<br>
+ *
+ * @param[in] self		Tokenizer object
+ * @param[in] field		Field position
+ * @param[out] value	Converted number
+ * @return				true : converted, false : not converted by the fast path
+ */
+bool CEPCUICSVTokenizer_parseInteger (const CEPCUICSVTokenizer *self, const CEPCUICSVField *field, int64_t *value);
+
+
+/**
+ * Use the indicated scanner instead of the detected one (for comparing the<br>
+ * scanners).<br>
+ * A scanner not supported by the CPU falls back to the fastest supported one.<br>
+ *
+ * @param[in,out] self	Tokenizer object
+ * @param[in] scanner	Instruction set of the scanner
+ * @return				Instruction set of the scanner in use
+ */
+CEPCUICSVScanner CEPCUICSVTokenizer_setScanner (CEPCUICSVTokenizer *self, const CEPCUICSVScanner scanner);
+
+
+/**
+ * Copy the escaped field into the buffer with its doubled double quotes<br>
+ * replaced with single ones.<br>
+ *
+ * @param[in] self			Tokenizer object
+ * @param[in] field			Escaped field position
+ * @param[out] buffer		Buffer for copying the unescaped field
+ * @param[in] bufferLength	Size of the buffer[Byte] (at least the field length)
+ * @return					Length of the unescaped field[Byte]
+ */
+size_t CEPCUICSVTokenizer_unescape (const CEPCUICSVTokenizer *self, const CEPCUICSVField *field, M2MString buffer[], const size_t bufferLength);
+
+
+
+#endif /* CEPCUICSVTOKENIZER_H_ */
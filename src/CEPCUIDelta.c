@@ -0,0 +1,485 @@
+/*******************************************************************************
+ * CEPCUIDelta.c : Set of the result records already emitted, for delta output
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIDelta.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Remove all the entries of the hash set (keeping its memory).<br>
+ *
+ * @param[in,out] set	Hash set
+ */
+static void this_clearSet (CEPCUIDeltaSet *set);
+
+
+/**
+ * Release the heap memory of the hash set.<br>
+ *
+ * @param[in,out] set	Hash set
+ */
+static void this_deleteSet (CEPCUIDeltaSet *set);
+
+
+/**
+ * Find the slot of the hash: the entry of the hash, or the empty slot where<br>
+ * it would be inserted (linear probing).<br>
+ *
+ * @param[in] set	Hash set (with at least one empty slot)
+ * @param[in] hash	Hash of the record (not 0)
+ * @return			Slot of the hash
+ */
+static CEPCUIDeltaEntry *this_findEntry (const CEPCUIDeltaSet *set, const uint64_t hash);
+
+
+/**
+ * Get the FNV-1a hash of the record.<br>
+ *
+ * @param[in] record		Record
+ * @param[in] recordLength	Size of the record[Byte]
+ * @return					Hash of the record
+ */
+static uint64_t this_getHash (const M2MString *record, const size_t recordLength);
+
+
+/**
+ * Double the number of the slots of the hash set (rehashing the entries).<br>
+ *
+ * @param[in,out] set	Hash set
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growSet (CEPCUIDeltaSet *set);
+
+
+/**
+ * Enlarge the buffer so that it can hold the indicated size of data.<br>
+ *
+ * @param[in,out] buffer	Buffer (reallocated in this function)
+ * @param[in] length		Size of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] size			Required size[Byte]
+ * @return					true : success, false : failed to allocate memory
+ */
+static bool this_reserve (M2MString **buffer, const size_t length, size_t *capacity, const size_t size);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Remove all the entries of the hash set (keeping its memory).<br>
+ *
+ * @param[in,out] set	Hash set
+ */
+static void this_clearSet (CEPCUIDeltaSet *set)
+	{
+	if (set->entryList!=NULL && set->count>0)
+		{
+		memset(set->entryList, 0, set->capacity * sizeof(CEPCUIDeltaEntry));
+		}
+	set->count = 0;
+	set->textLength = 0;
+	return;
+	}
+
+
+/**
+ * Release the heap memory of the hash set.<br>
+ *
+ * @param[in,out] set	Hash set
+ */
+static void this_deleteSet (CEPCUIDeltaSet *set)
+	{
+	M2MHeap_free(set->entryList);
+	M2MHeap_free(set->text);
+	memset(set, 0, sizeof(CEPCUIDeltaSet));
+	return;
+	}
+
+
+/**
+ * Find the slot of the hash: the entry of the hash, or the empty slot where<br>
+ * it would be inserted (linear probing).<br>
+ *
+ * @param[in] set	Hash set (with at least one empty slot)
+ * @param[in] hash	Hash of the record (not 0)
+ * @return			Slot of the hash
+ */
+static CEPCUIDeltaEntry *this_findEntry (const CEPCUIDeltaSet *set, const uint64_t hash)
+	{
+	//========== Variable ==========
+	size_t position = (size_t)hash & (set->capacity - 1);
+
+	while (set->entryList[position].hash!=0 && set->entryList[position].hash!=hash)
+		{
+		position = (position + 1) & (set->capacity - 1);
+		}
+	return &set->entryList[position];
+	}
+
+
+/**
+ * Get the FNV-1a hash of the record.<br>
+ *
+ * @param[in] record		Record
+ * @param[in] recordLength	Size of the record[Byte]
+ * @return					Hash of the record
+ */
+static uint64_t this_getHash (const M2MString *record, const size_t recordLength)
+	{
+	//========== Variable ==========
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i = 0;
+
+	for (i=0; i<recordLength; i++)
+		{
+		hash = (hash ^ (unsigned char)record[i]) * 1099511628211ULL;
+		}
+	return hash;
+	}
+
+
+/**
+ * Double the number of the slots of the hash set (rehashing the entries).<br>
+ *
+ * @param[in,out] set	Hash set
+ * @return				true : success, false : failed to allocate memory
+ */
+static bool this_growSet (CEPCUIDeltaSet *set)
+	{
+	//========== Variable ==========
+	CEPCUIDeltaSet grown;
+	size_t i = 0;
+
+	grown = (*set);
+	grown.capacity = (set->capacity>0) ? set->capacity * 2 : CEPCUIDelta_INITIAL_CAPACITY;
+	if ((grown.entryList=(CEPCUIDeltaEntry *)M2MHeap_malloc(grown.capacity * sizeof(CEPCUIDeltaEntry)))==NULL)
+		{
+		return false;
+		}
+	for (i=0; i<set->capacity; i++)
+		{
+		if (set->entryList[i].hash!=0)
+			{
+			(*this_findEntry(&grown, set->entryList[i].hash)) = set->entryList[i];
+			}
+		}
+	M2MHeap_free(set->entryList);
+	(*set) = grown;
+	return true;
+	}
+
+
+/**
+ * Enlarge the buffer so that it can hold the indicated size of data.<br>
+ *
+ * @param[in,out] buffer	Buffer (reallocated in this function)
+ * @param[in] length		Size of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] size			Required size[Byte]
+ * @return					true : success, false : failed to allocate memory
+ */
+static bool this_reserve (M2MString **buffer, const size_t length, size_t *capacity, const size_t size)
+	{
+	//========== Variable ==========
+	M2MString *enlarged = NULL;
+	size_t newCapacity = ((*capacity)>0) ? (*capacity) : 256;
+
+	if (size<=(*capacity))
+		{
+		return true;
+		}
+	while (newCapacity<size)
+		{
+		newCapacity *= 2;
+		}
+	if ((enlarged=(M2MString *)M2MHeap_malloc(newCapacity))==NULL)
+		{
+		return false;
+		}
+	if ((*buffer)!=NULL)
+		{
+		memcpy(enlarged, (*buffer), length);
+		M2MHeap_free((*buffer));
+		}
+	(*buffer) = enlarged;
+	(*capacity) = newCapacity;
+	return true;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Close the record built by CEPCUIDelta_append() and add it to the current<br>
+ * result.<br>
+ *
+ * @param[in,out] self		Delta object
+ * @param[out] record		Pointer for copying the record (valid until the next CEPCUIDelta_append())
+ * @param[out] recordLength	Pointer for copying the size of the record[Byte]
+ * @return					1 : new record, 0 : already emitted in the previous result, -1 : error
+ */
+int CEPCUIDelta_add (CEPCUIDelta *self, const M2MString **record, size_t *recordLength)
+	{
+	//========== Variable ==========
+	CEPCUIDeltaSet *current = NULL;
+	CEPCUIDeltaSet *previous = NULL;
+	CEPCUIDeltaEntry *entry = NULL;
+	uint64_t base = 0;
+	uint64_t hash = 0;
+	uint64_t occurrence = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIDelta_add()";
+
+	//===== Check argument =====
+	if (self!=NULL && record!=NULL && recordLength!=NULL)
+		{
+		current = &self->setList[self->current];
+		previous = &self->setList[1 - self->current];
+		(*record) = self->record;
+		(*recordLength) = self->recordLength;
+		self->recordLength = 0;
+		//===== Keep the load factor at most 1/2 =====
+		if ((current->count + 1) * 2>current->capacity && this_growSet(current)==false)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for the hash set");
+			return -1;
+			}
+		//===== Identity of the record (its hash and occurrence in the result) =====
+		base = this_getHash((*record), (*recordLength));
+		do
+			{
+			hash = base + occurrence++ * 0x9E3779B97F4A7C15ULL;
+			hash = (hash!=0) ? hash : 1;
+			entry = this_findEntry(current, hash);
+			} while (entry->hash!=0);
+		entry->hash = hash;
+		entry->length = (*recordLength);
+		current->count++;
+		//===== Text for the retraction =====
+		if (self->retract==true)
+			{
+			if (this_reserve(&current->text, current->textLength, &current->textCapacity, current->textLength + (*recordLength))==false)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for the record");
+				return -1;
+				}
+			memcpy(&current->text[current->textLength], (*record), (*recordLength));
+			entry->offset = current->textLength;
+			current->textLength += (*recordLength);
+			}
+		//===== Emitted in the previous result =====
+		if (previous->capacity>0 && (entry=this_findEntry(previous, hash))->hash==hash)
+			{
+			entry->seen = true;
+			return 0;
+			}
+		return 1;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated delta object or pointer is NULL");
+		return -1;
+		}
+	}
+
+
+/**
+ * Append the data to the record being built.<br>
+ *
+ * @param[in,out] self		Delta object
+ * @param[in] data			Data (a field or a separator)
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failed to allocate memory
+ */
+bool CEPCUIDelta_append (CEPCUIDelta *self, const void *data, const size_t dataLength)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (data!=NULL || dataLength==0))
+		{
+		if (this_reserve(&self->record, self->recordLength, &self->recordCapacity, self->recordLength + dataLength)==false)
+			{
+			return false;
+			}
+		if (dataLength>0)
+			{
+			memcpy(&self->record[self->recordLength], data, dataLength);
+			self->recordLength += dataLength;
+			}
+		return true;
+		}
+	//===== Argument error =====
+	else
+		{
+		return false;
+		}
+	}
+
+
+/**
+ * Make the current result (written completely) the previous one.<br>
+ *
+ * @param[in,out] self	Delta object
+ */
+void CEPCUIDelta_commit (CEPCUIDelta *self)
+	{
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		this_clearSet(&self->setList[1 - self->current]);
+		self->current = 1 - self->current;
+		}
+	return;
+	}
+
+
+/**
+ * Release the heap memory of delta object.<br>
+ *
+ * @param[in,out] self	Delta object
+ */
+void CEPCUIDelta_delete (CEPCUIDelta **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		this_deleteSet(&(*self)->setList[0]);
+		this_deleteSet(&(*self)->setList[1]);
+		M2MHeap_free((*self)->record);
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Construct new delta object.<br>
+ *
+ * @param[in] retract	true : keep the text of the records for the retraction, false : keep the hashes only
+ * @return				Created delta object or NULL (in case of error)
+ */
+CEPCUIDelta *CEPCUIDelta_new (const bool retract)
+	{
+	//========== Variable ==========
+	CEPCUIDelta *self = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIDelta_new()";
+
+	//===== Allocate new heap memory =====
+	if ((self=(CEPCUIDelta *)M2MHeap_malloc(sizeof(CEPCUIDelta)))!=NULL)
+		{
+		self->retract = retract;
+		return self;
+		}
+	//===== Error handling =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for delta object");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Pass the records of the previous result which are no longer matched by<br>
+ * the current one to the receiver (only in case of retraction).<br>
+ *
+ * @param[in,out] self		Delta object
+ * @param[in] receiver		Function which receives the retracted records
+ * @param[in,out] argument	Argument passed to the receiver
+ * @return					Number of the retracted records or -1 (in case of the receiver failed)
+ */
+int64_t CEPCUIDelta_retract (CEPCUIDelta *self, CEPCUIDelta_Receiver receiver, void *argument)
+	{
+	//========== Variable ==========
+	const CEPCUIDeltaSet *previous = NULL;
+	const CEPCUIDeltaEntry *entry = NULL;
+	int64_t retracted = 0;
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && receiver!=NULL)
+		{
+		previous = &self->setList[1 - self->current];
+		for (i=0; self->retract==true && i<previous->capacity && previous->count>0; i++)
+			{
+			entry = &previous->entryList[i];
+			if (entry->hash!=0 && entry->seen==false)
+				{
+				if (receiver(argument, &previous->text[entry->offset], entry->length)==false)
+					{
+					return -1;
+					}
+				retracted++;
+				}
+			}
+		return retracted;
+		}
+	//===== Argument error =====
+	else
+		{
+		return -1;
+		}
+	}
+
+
+/**
+ * Discard the current result (e.g. when it couldn't be written), so that<br>
+ * its records are emitted again next time.<br>
+ *
+ * @param[in,out] self	Delta object
+ */
+void CEPCUIDelta_rollback (CEPCUIDelta *self)
+	{
+	//========== Variable ==========
+	CEPCUIDeltaSet *previous = NULL;
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		this_clearSet(&self->setList[self->current]);
+		previous = &self->setList[1 - self->current];
+		for (i=0; i<previous->capacity && previous->count>0; i++)
+			{
+			previous->entryList[i].seen = false;
+			}
+		self->recordLength = 0;
+		}
+	return;
+	}
+
+
+
+/* End Of File */
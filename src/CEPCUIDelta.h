@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * CEPCUIDelta.h : Set of the result records already emitted, for delta output
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIDELTA_H_
+#define CEPCUIDELTA_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Initial number of the slots of a hash set (power of 2)
+ */
+#ifndef CEPCUIDelta_INITIAL_CAPACITY
+#define CEPCUIDelta_INITIAL_CAPACITY 1024
+#endif /* CEPCUIDelta_INITIAL_CAPACITY */
+
+
+/**
+ * Function which receives a retracted record.<br>
+ * The record is valid only during the call.<br>
+ *
+ * @param[in,out] argument		Argument given to CEPCUIDelta_retract()
+ * @param[in] record			Record (CSV format line without the line break)
+ * @param[in] recordLength		Size of the record[Byte]
+ * @return						true : success, false : abort
+ */
+#ifndef CEPCUIDelta_Receiver
+typedef bool (*CEPCUIDelta_Receiver) (void *argument, const M2MString *record, const size_t recordLength);
+#endif /* CEPCUIDelta_Receiver */
+
+
+/**
+ * Slot of a hash set, identifying a record by the 64-bit hash of its text<br>
+ * (0 : empty slot).<br>
+ * The text is kept only for the retraction.<br>
+ */
+#ifndef CEPCUIDeltaEntry
+typedef struct
+	{
+	uint64_t hash;
+	size_t offset;
+	size_t length;
+	bool seen;
+	} CEPCUIDeltaEntry;
+#endif /* CEPCUIDeltaEntry */
+
+
+/**
+ * Open addressing hash set of the records of one result.<br>
+ */
+#ifndef CEPCUIDeltaSet
+typedef struct
+	{
+	CEPCUIDeltaEntry *entryList;
+	size_t capacity;
+	size_t count;
+	M2MString *text;
+	size_t textLength;
+	size_t textCapacity;
+	} CEPCUIDeltaSet;
+#endif /* CEPCUIDeltaSet */
+
+
+/**
+ * Records of the previous result of a query (already emitted) and of the<br>
+ * current one (being emitted).<br>
+ * Identical records in a result are told apart by their occurrence, so<br>
+ * that a result is compared as a multiset.<br>
+ */
+#ifndef CEPCUIDelta
+typedef struct
+	{
+	CEPCUIDeltaSet setList[2];
+	size_t current;
+	bool retract;
+	M2MString *record;
+	size_t recordLength;
+	size_t recordCapacity;
+	} CEPCUIDelta;
+#endif /* CEPCUIDelta */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Close the record built by CEPCUIDelta_append() and add it to the current<br>
+ * result.<br>
+ *
+ * @param[in,out] self		Delta object
+ * @param[out] record		Pointer for copying the record (valid until the next CEPCUIDelta_append())
+ * @param[out] recordLength	Pointer for copying the size of the record[Byte]
+ * @return					1 : new record, 0 : already emitted in the previous result, -1 : error
+ */
+int CEPCUIDelta_add (CEPCUIDelta *self, const M2MString **record, size_t *recordLength);
+
+
+/**
+ * Append the data to the record being built.<br>
+ *
+ * @param[in,out] self		Delta object
+ * @param[in] data			Data (a field or a separator)
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failed to allocate memory
+ */
+bool CEPCUIDelta_append (CEPCUIDelta *self, const void *data, const size_t dataLength);
+
+
+/**
+ * Make the current result (written completely) the previous one.<br>
+ *
+ * @param[in,out] self	Delta object
+ */
+void CEPCUIDelta_commit (CEPCUIDelta *self);
+
+
+/**
+ * Release the heap memory of delta object.<br>
+ *
+ * @param[in,out] self	Delta object
+ */
+void CEPCUIDelta_delete (CEPCUIDelta **self);
+
+
+/**
+ * Construct new delta object.<br>
+ *
+ * @param[in] retract	true : keep the text of the records for the retraction, false : keep the hashes only
+ * @return				Created delta object or NULL (in case of error)
+ */
+CEPCUIDelta *CEPCUIDelta_new (const bool retract);
+
+
+/**
+ * Pass the records of the previous result which are no longer matched by<br>
+ * the current one to the receiver (only in case of retraction).<br>
+ *
+ * @param[in,out] self		Delta object
+ * @param[in] receiver		Function which receives the retracted records
+ * @param[in,out] argument	Argument passed to the receiver
+ * @return					Number of the retracted records or -1 (in case of the receiver failed)
+ */
+int64_t CEPCUIDelta_retract (CEPCUIDelta *self, CEPCUIDelta_Receiver receiver, void *argument);
+
+
+/**
+ * Discard the current result (e.g. when it couldn't be written), so that<br>
+ * its records are emitted again next time.<br>
+ *
+ * @param[in,out] self	Delta object
+ */
+void CEPCUIDelta_rollback (CEPCUIDelta *self);
+
+
+
+#endif /* CEPCUIDELTA_H_ */
@@ -0,0 +1,903 @@
+/*******************************************************************************
+ * CEPCUIInserter.c : Direct insertion of records into the CEP table
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIInserter.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Begin the transaction of a batch with the prepared BEGIN statement.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @return				true : success, false : failure
+ */
+static bool this_begin (CEPCUIInserter *self);
+
+
+/**
+ * Bind the typed binary field to the parameter of INSERT statement.<br>
+ * Numbers are bound as they are, and strings and byte sequences are bound<br>
+ * in place (SQLITE_STATIC) without any conversion.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @param[in] reader	Reader which holds the buffer of the field
+ * @param[in] field		Typed field
+ * @param[in] index		Index of the parameter (1 origin)
+ * @return				SQLite3 result code
+ */
+static int this_bindBinaryField (CEPCUIInserter *self, const CEPCUIBinaryReader *reader, const CEPCUIBinaryField *field, const int index);
+
+
+/**
+ * Bind the field to the parameter of INSERT statement.<br>
+ * A number in a column of numeric affinity is bound as a number.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] tokenizer		Tokenizer which holds the buffer of the field
+ * @param[in] field			Field position
+ * @param[in] index			Index of the parameter (1 origin)
+ * @return					SQLite3 result code
+ */
+static int this_bindField (CEPCUIInserter *self, const CEPCUICSVTokenizer *tokenizer, const CEPCUICSVField *field, const int index);
+
+
+/**
+ * Commit the transaction of a batch with the prepared COMMIT statement.<br>
+ * If the COMMIT fails (e.g. SQLITE_BUSY or SQLITE_FULL), the transaction<br>
+ * is rolled back so that the next batch can begin a new one.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @return				true : success, false : failure (rolled back)
+ */
+static bool this_commit (CEPCUIInserter *self);
+
+
+/**
+ * Evict the records out of the window: the oldest records exceeding the<br>
+ * maximum number, the records older than the time window and the oldest<br>
+ * records exceeding the memory limit, each with one DELETE per batch.<br>
+ *
+ * @param[in] self	Inserter object
+ */
+static void this_deleteOldRecord (CEPCUIInserter *self);
+
+
+/**
+ * Get the type into which the CSV fields of the column are converted, by<br>
+ * the affinity of its declared type (the rules of SQLite3):<br>
+ * INTEGER affinity into integers, REAL and NUMERIC affinity into numbers,<br>
+ * and the others are bound as text.<br>
+ *
+ * @param[in] declaredType	Declared type of the column or NULL
+ * @return					Type of the converted fields
+ */
+static CEPCUIFieldType this_getFieldType (const char *declaredType);
+
+
+/**
+ * Execute the INSERT statement with the bound parameters and reset it.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @param[in] result	Result code of binding the parameters
+ * @return				true : the record was inserted, false : failure
+ */
+static bool this_insert (CEPCUIInserter *self, int result);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Begin the transaction of a batch with the prepared BEGIN statement.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @return				true : success, false : failure
+ */
+static bool this_begin (CEPCUIInserter *self)
+	{
+	//========== Variable ==========
+	int result = SQLITE_OK;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter.this_begin()";
+
+	result = sqlite3_step(self->beginStatement);
+	sqlite3_reset(self->beginStatement);
+	if (result==SQLITE_DONE)
+		{
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to begin the transaction : %s", sqlite3_errstr(result));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		return false;
+		}
+	}
+
+
+/**
+ * Bind the typed binary field to the parameter of INSERT statement.<br>
+ * Numbers are bound as they are, and strings and byte sequences are bound<br>
+ * in place (SQLITE_STATIC) without any conversion.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @param[in] reader	Reader which holds the buffer of the field
+ * @param[in] field		Typed field
+ * @param[in] index		Index of the parameter (1 origin)
+ * @return				SQLite3 result code
+ */
+static int this_bindBinaryField (CEPCUIInserter *self, const CEPCUIBinaryReader *reader, const CEPCUIBinaryField *field, const int index)
+	{
+	//===== NULL field =====
+	if (field->null==true)
+		{
+		return sqlite3_bind_null(self->insertStatement, index);
+		}
+	//===== Integer =====
+	else if (field->type==CEPCUIFieldType_INTEGER)
+		{
+		return sqlite3_bind_int64(self->insertStatement, index, (sqlite3_int64)field->integer);
+		}
+	//===== Floating point number =====
+	else if (field->type==CEPCUIFieldType_DOUBLE)
+		{
+		return sqlite3_bind_double(self->insertStatement, index, field->real);
+		}
+	//===== String =====
+	else if (field->type==CEPCUIFieldType_TEXT)
+		{
+		return sqlite3_bind_text(self->insertStatement, index, (const char *)&reader->data[field->offset], (int)field->length, SQLITE_STATIC);
+		}
+	//===== Byte sequence =====
+	else
+		{
+		return sqlite3_bind_blob(self->insertStatement, index, &reader->data[field->offset], (int)field->length, SQLITE_STATIC);
+		}
+	}
+
+
+/**
+ * Bind the field to the parameter of INSERT statement.<br>
+ * The field is bound in place (SQLITE_STATIC) since the buffer outlives the<br>
+ * statement execution; only escaped fields are copied.<br>
+ * An empty field is bound as NULL.<br>
+ * A number in a column of numeric affinity is converted here and bound as a<br>
+ * number, instead of being converted by SQLite3 from the text.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] tokenizer		Tokenizer which holds the buffer of the field
+ * @param[in] field			Field position
+ * @param[in] index			Index of the parameter (1 origin)
+ * @return					SQLite3 result code
+ */
+static int this_bindField (CEPCUIInserter *self, const CEPCUICSVTokenizer *tokenizer, const CEPCUICSVField *field, const int index)
+	{
+	//========== Variable ==========
+	M2MString *buffer = NULL;
+	size_t length = 0;
+	int64_t integer = 0;
+	double real = 0;
+
+	//===== Empty field =====
+	if (field->length<=0)
+		{
+		return sqlite3_bind_null(self->insertStatement, index);
+		}
+	//===== Integer =====
+	else if (self->fieldTypeList[index-1]!=CEPCUIFieldType_TEXT
+			&& CEPCUICSVTokenizer_parseInteger(tokenizer, field, &integer)==true
+			&& (self->fieldTypeList[index-1]==CEPCUIFieldType_INTEGER || (-CEPCUIInserter_MAX_EXACT_INTEGER<=integer && integer<=CEPCUIInserter_MAX_EXACT_INTEGER)))
+		{
+		return sqlite3_bind_int64(self->insertStatement, index, (sqlite3_int64)integer);
+		}
+	//===== Real number =====
+	else if (self->fieldTypeList[index-1]==CEPCUIFieldType_DOUBLE
+			&& CEPCUICSVTokenizer_parseDouble(tokenizer, field, &real)==true)
+		{
+		return sqlite3_bind_double(self->insertStatement, index, real);
+		}
+	//===== Field without escape =====
+	else if (field->escaped==false)
+		{
+		return sqlite3_bind_text(self->insertStatement, index, (const char *)&tokenizer->data[field->offset], (int)field->length, SQLITE_STATIC);
+		}
+	//===== Escaped field =====
+	else
+		{
+		if (self->bufferLength<field->length)
+			{
+			if ((buffer=(M2MString *)realloc(self->buffer, field->length))==NULL)
+				{
+				return SQLITE_NOMEM;
+				}
+			self->buffer = buffer;
+			self->bufferLength = field->length;
+			}
+		length = CEPCUICSVTokenizer_unescape(tokenizer, field, self->buffer, self->bufferLength);
+		return sqlite3_bind_text(self->insertStatement, index, (const char *)self->buffer, (int)length, SQLITE_TRANSIENT);
+		}
+	}
+
+
+/**
+ * Commit the transaction of a batch with the prepared COMMIT statement.<br>
+ * If the COMMIT fails (e.g. SQLITE_BUSY or SQLITE_FULL), the transaction<br>
+ * is rolled back so that the next batch can begin a new one.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @return				true : success, false : failure (rolled back)
+ */
+static bool this_commit (CEPCUIInserter *self)
+	{
+	//========== Variable ==========
+	int result = SQLITE_OK;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter.this_commit()";
+
+	result = sqlite3_step(self->commitStatement);
+	sqlite3_reset(self->commitStatement);
+	if (result==SQLITE_DONE)
+		{
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to commit the transaction, so it's rolled back : %s", sqlite3_errstr(result));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		sqlite3_step(self->rollbackStatement);
+		sqlite3_reset(self->rollbackStatement);
+		return false;
+		}
+	}
+
+
+/**
+ * Evict the records out of the window: the oldest records exceeding the<br>
+ * maximum number, the records older than the time window and the oldest<br>
+ * records exceeding the memory limit, each with one DELETE per batch.<br>
+ *
+ * @param[in] self	Inserter object
+ */
+static void this_deleteOldRecord (CEPCUIInserter *self)
+	{
+	//========== Variable ==========
+	int64_t used = 0;
+	int64_t records = 0;
+	uint64_t evicted = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter.this_deleteOldRecord()";
+
+	//===== Check the maximum number of records =====
+	if (self->deleteStatement!=NULL)
+		{
+		if (sqlite3_step(self->deleteStatement)==SQLITE_DONE)
+			{
+			evicted += (uint64_t)sqlite3_changes(self->database);
+			}
+		sqlite3_reset(self->deleteStatement);
+		}
+	//===== Check the time window =====
+	if (self->cutoffStatement!=NULL)
+		{
+		if (sqlite3_step(self->cutoffStatement)==SQLITE_ROW)
+			{
+			//===== Evict the records older than the cutoff time =====
+			if (sqlite3_column_type(self->cutoffStatement, 1)!=SQLITE_NULL)
+				{
+				sqlite3_bind_value(self->windowStatement, 1, sqlite3_column_value(self->cutoffStatement, 1));
+				if (sqlite3_step(self->windowStatement)==SQLITE_DONE)
+					{
+					evicted += (uint64_t)sqlite3_changes(self->database);
+					}
+				sqlite3_reset(self->windowStatement);
+				}
+			//===== Time which cannot be parsed (only reported once) =====
+			else if (sqlite3_column_type(self->cutoffStatement, 0)!=SQLITE_NULL && self->cutoffError==false)
+				{
+				self->cutoffError = true;
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to compute the cutoff of the time window because the newest time isn't in ISO 8601 format, so no record is evicted by time");
+				}
+			}
+		sqlite3_reset(self->cutoffStatement);
+		}
+	//===== Check the memory limit =====
+	if (self->memoryStatement!=NULL)
+		{
+		if (sqlite3_step(self->memoryStatement)==SQLITE_ROW)
+			{
+			used = sqlite3_column_int64(self->memoryStatement, 0);
+			records = sqlite3_column_int64(self->memoryStatement, 1);
+			}
+		sqlite3_reset(self->memoryStatement);
+		//===== Evict the oldest records in proportion to the excess =====
+		if (used>0 && (size_t)used>self->memoryLimit && records>0)
+			{
+			sqlite3_bind_int64(self->trimStatement, 1, (int64_t)((double)records * (1.0 - (double)self->memoryLimit * CEPCUIInserter_TRIM_RATIO / 100.0 / (double)used)) + 1);
+			if (sqlite3_step(self->trimStatement)==SQLITE_DONE)
+				{
+				evicted += (uint64_t)sqlite3_changes(self->database);
+				}
+			sqlite3_reset(self->trimStatement);
+			}
+		}
+	if (evicted>0)
+		{
+		CEPCUIMetrics_add(CEPCUIMetricsCounter_EVICTED_ROW, evicted);
+		}
+	return;
+	}
+
+
+/**
+ * Get the type into which the CSV fields of the column are converted, by<br>
+ * the affinity of its declared type (the rules of SQLite3):<br>
+ * INTEGER affinity into integers, REAL and NUMERIC affinity into numbers,<br>
+ * and the others are bound as text.<br>
+ *
+ * @param[in] declaredType	Declared type of the column or NULL
+ * @return					Type of the converted fields
+ */
+static CEPCUIFieldType this_getFieldType (const char *declaredType)
+	{
+	//========== Variable ==========
+	char TYPE[64];
+	size_t i = 0;
+
+	//===== No declared type (BLOB affinity) =====
+	if (declaredType==NULL)
+		{
+		return CEPCUIFieldType_TEXT;
+		}
+	for (i=0; declaredType[i]!='\0' && i<sizeof(TYPE)-1; i++)
+		{
+		TYPE[i] = (char)toupper((unsigned char)declaredType[i]);
+		}
+	TYPE[i] = '\0';
+	//===== INTEGER affinity =====
+	if (strstr(TYPE, "INT")!=NULL)
+		{
+		return CEPCUIFieldType_INTEGER;
+		}
+	//===== TEXT or BLOB affinity =====
+	else if (strstr(TYPE, "CHAR")!=NULL || strstr(TYPE, "CLOB")!=NULL || strstr(TYPE, "TEXT")!=NULL || strstr(TYPE, "BLOB")!=NULL || TYPE[0]=='\0')
+		{
+		return CEPCUIFieldType_TEXT;
+		}
+	//===== REAL or NUMERIC affinity =====
+	else
+		{
+		return CEPCUIFieldType_DOUBLE;
+		}
+	}
+
+
+/**
+ * Execute the INSERT statement with the bound parameters and reset it.<br>
+ *
+ * @param[in,out] self	Inserter object
+ * @param[in] result	Result code of binding the parameters
+ * @return				true : the record was inserted, false : failure
+ */
+static bool this_insert (CEPCUIInserter *self, int result)
+	{
+	//========== Variable ==========
+	bool inserted = false;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter.this_insert()";
+
+	//===== Execute INSERT =====
+	if (result==SQLITE_OK && (result=sqlite3_step(self->insertStatement))==SQLITE_DONE)
+		{
+		inserted = true;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to insert the record : %s", sqlite3_errstr(result));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		}
+	sqlite3_reset(self->insertStatement);
+	return inserted;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the prepared statements and heap memory of inserter object.<br>
+ *
+ * @param[in,out] self	Inserter object
+ */
+void CEPCUIInserter_delete (CEPCUIInserter **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		sqlite3_finalize((*self)->insertStatement);
+		sqlite3_finalize((*self)->beginStatement);
+		sqlite3_finalize((*self)->commitStatement);
+		sqlite3_finalize((*self)->rollbackStatement);
+		sqlite3_finalize((*self)->deleteStatement);
+		sqlite3_finalize((*self)->cutoffStatement);
+		sqlite3_finalize((*self)->windowStatement);
+		sqlite3_finalize((*self)->memoryStatement);
+		sqlite3_finalize((*self)->trimStatement);
+		M2MHeap_free((*self)->buffer);
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Insert the typed records from the binary reader into the CEP table.<br>
+ * Records are consumed until the reader has advanced by the indicated<br>
+ * length, the number of records per transaction is reached (or the end of<br>
+ * buffer), inserted in one transaction, and then the records out of the<br>
+ * window (see CEPCUIInserter_setTimeWindow()) are deleted.<br>
+ * Fields are bound as typed values, so neither text parsing nor type<br>
+ * conversion takes place.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in,out] reader	Reader of binary records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIInserter_insertBinary (CEPCUIInserter *self, CEPCUIBinaryReader *reader, const size_t maxLength)
+	{
+	//========== Variable ==========
+	CEPCUIBinaryField fieldList[CEPCUIInserter_MAX_COLUMN];
+	size_t fieldCount = 0;
+	size_t start = 0;
+	size_t i = 0;
+	unsigned int rows = 0;
+	int64_t records = 0;
+	int result = SQLITE_OK;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter_insertBinary()";
+
+	//===== Check argument =====
+	if (self!=NULL && reader!=NULL)
+		{
+		start = reader->position;
+		if (this_begin(self)==false)
+			{
+			return -1;
+			}
+		//===== Insert records =====
+		while (reader->position-start<maxLength
+				&& (self->batchRecord==0 || rows++<self->batchRecord)
+				&& (fieldCount=CEPCUIBinaryReader_next(reader, fieldList, CEPCUIInserter_MAX_COLUMN))>0)
+			{
+			//===== Bind fields =====
+			for (i=0, result=SQLITE_OK; i<self->columnCount && result==SQLITE_OK; i++)
+				{
+				if (i<fieldCount)
+					{
+					result = this_bindBinaryField(self, reader, &fieldList[i], (int)i + 1);
+					}
+				else
+					{
+					result = sqlite3_bind_null(self->insertStatement, (int)i + 1);
+					}
+				}
+			//===== Execute INSERT =====
+			if (this_insert(self, result)==true)
+				{
+				records++;
+				}
+			}
+		if (this_commit(self)==false)
+			{
+			return -1;
+			}
+		//===== Keep the maximum number of records =====
+		if (records>0)
+			{
+			this_deleteOldRecord(self);
+			//===== Journal the consumed records =====
+			if (self->journal!=NULL)
+				{
+				self->journal(self->journalArgument, true, &reader->data[start], reader->position - start);
+				}
+			}
+		return records;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated inserter or reader object is NULL");
+		return -1;
+		}
+	}
+
+
+/**
+ * Insert the records from the tokenizer into the CEP table.<br>
+ * Records are consumed until the tokenizer has advanced by the indicated<br>
+ * length, the number of records per transaction is reached (or the end of<br>
+ * buffer), inserted in one transaction, and then the records out of the<br>
+ * window (see CEPCUIInserter_setTimeWindow()) are deleted.<br>
+ * Missing fields are inserted as NULL and surplus fields are ignored.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in,out] tokenizer	Tokenizer of CSV format records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIInserter_insertCSV (CEPCUIInserter *self, CEPCUICSVTokenizer *tokenizer, const size_t maxLength)
+	{
+	//========== Variable ==========
+	CEPCUICSVField fieldList[CEPCUIInserter_MAX_COLUMN];
+	size_t fieldCount = 0;
+	size_t start = 0;
+	size_t i = 0;
+	unsigned int rows = 0;
+	int64_t records = 0;
+	int result = SQLITE_OK;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter_insertCSV()";
+
+	//===== Check argument =====
+	if (self!=NULL && tokenizer!=NULL)
+		{
+		start = tokenizer->position;
+		if (this_begin(self)==false)
+			{
+			return -1;
+			}
+		//===== Insert records =====
+		while (tokenizer->position-start<maxLength
+				&& (self->batchRecord==0 || rows++<self->batchRecord)
+				&& (fieldCount=CEPCUICSVTokenizer_next(tokenizer, fieldList, self->columnCount))>0)
+			{
+			//===== Bind fields =====
+			for (i=0, result=SQLITE_OK; i<self->columnCount && result==SQLITE_OK; i++)
+				{
+				if (i<fieldCount)
+					{
+					result = this_bindField(self, tokenizer, &fieldList[i], (int)i + 1);
+					}
+				else
+					{
+					result = sqlite3_bind_null(self->insertStatement, (int)i + 1);
+					}
+				}
+			//===== Execute INSERT =====
+			if (this_insert(self, result)==true)
+				{
+				records++;
+				}
+			}
+		if (this_commit(self)==false)
+			{
+			return -1;
+			}
+		//===== Keep the maximum number of records =====
+		if (records>0)
+			{
+			this_deleteOldRecord(self);
+			//===== Journal the consumed records =====
+			if (self->journal!=NULL)
+				{
+				self->journal(self->journalArgument, false, &tokenizer->data[start], tokenizer->position - start);
+				}
+			}
+		return records;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated inserter or tokenizer object is NULL");
+		return -1;
+		}
+	}
+
+
+/**
+ * Construct new inserter object for the indicated table.<br>
+ * The number of columns is taken from the table definition itself.<br>
+ *
+ * @param[in] database	SQLite3 database which contains the CEP table
+ * @param[in] tableName	Table name string
+ * @param[in] maxRecord	Maximum number of records kept in the table (0 : unlimited)
+ * @return				Created inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_new (sqlite3 *database, const M2MString *tableName, const unsigned int maxRecord)
+	{
+	//========== Variable ==========
+	CEPCUIInserter *self = NULL;
+	sqlite3_stmt *statement = NULL;
+	size_t i = 0;
+	int length = 0;
+	M2MString SQL[1024];
+	M2MString MESSAGE[1280];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter_new()";
+
+	//===== Check argument =====
+	if (database!=NULL && tableName!=NULL && M2MString_length(tableName)>0)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUIInserter *)M2MHeap_malloc(sizeof(CEPCUIInserter)))!=NULL)
+			{
+			self->database = database;
+			self->maxRecord = maxRecord;
+			self->batchRecord = 0;
+			//===== Get the number of columns =====
+			snprintf((char *)SQL, sizeof(SQL), "SELECT * FROM %s LIMIT 0", tableName);
+			if (sqlite3_prepare_v2(database, (char *)SQL, -1, &statement, NULL)==SQLITE_OK
+					&& (self->columnCount=(size_t)sqlite3_column_count(statement))>0
+					&& self->columnCount<=CEPCUIInserter_MAX_COLUMN)
+				{
+				//===== Get the types into which the fields are converted =====
+				for (i=0; i<self->columnCount; i++)
+					{
+					self->fieldTypeList[i] = this_getFieldType(sqlite3_column_decltype(statement, (int)i));
+					}
+				sqlite3_finalize(statement);
+				//===== Prepare INSERT statement =====
+				length = snprintf((char *)SQL, sizeof(SQL), "INSERT INTO %s VALUES (", tableName);
+				for (i=0; i<self->columnCount && length<(int)sizeof(SQL); i++)
+					{
+					length += snprintf((char *)&SQL[length], sizeof(SQL)-(size_t)length, (i==0) ? "?" : ",?");
+					}
+				if (length<(int)sizeof(SQL))
+					{
+					snprintf((char *)&SQL[length], sizeof(SQL)-(size_t)length, ")");
+					}
+				if (sqlite3_prepare_v2(database, (char *)SQL, -1, &self->insertStatement, NULL)==SQLITE_OK
+						&& sqlite3_prepare_v2(database, "BEGIN", -1, &self->beginStatement, NULL)==SQLITE_OK
+						&& sqlite3_prepare_v2(database, "COMMIT", -1, &self->commitStatement, NULL)==SQLITE_OK
+						&& sqlite3_prepare_v2(database, "ROLLBACK", -1, &self->rollbackStatement, NULL)==SQLITE_OK)
+					{
+					//===== Prepare DELETE statement for the oldest records =====
+					if (maxRecord>0)
+						{
+						snprintf((char *)SQL, sizeof(SQL), "DELETE FROM %s WHERE rowid <= (SELECT MAX(rowid) FROM %s) - %u", tableName, tableName, maxRecord);
+						if (sqlite3_prepare_v2(database, (char *)SQL, -1, &self->deleteStatement, NULL)!=SQLITE_OK)
+							{
+							memset(MESSAGE, 0, sizeof(MESSAGE));
+							snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to prepare SQL(=\"%s\") : %s", SQL, sqlite3_errmsg(database));
+							M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+							CEPCUIInserter_delete(&self);
+							return NULL;
+							}
+						}
+					return self;
+					}
+				//===== Error handling =====
+				else
+					{
+					memset(MESSAGE, 0, sizeof(MESSAGE));
+					snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to prepare SQL(=\"%s\") : %s", SQL, sqlite3_errmsg(database));
+					M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+					CEPCUIInserter_delete(&self);
+					return NULL;
+					}
+				}
+			//===== Error handling =====
+			else
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to get the columns of the table(=\"%s\")", tableName);
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				sqlite3_finalize(statement);
+				CEPCUIInserter_delete(&self);
+				return NULL;
+				}
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for inserter object");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated database or table name is NULL");
+		return NULL;
+		}
+	}
+
+
+
+/**
+ * Set the maximum number of records inserted in one transaction.<br>
+ * A transaction is also closed when the indicated length of the buffer has<br>
+ * been consumed, whichever comes first.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] batchRecord	Maximum number of records per transaction (0 : bounded only by the length)
+ * @return					Inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_setBatchRecord (CEPCUIInserter *self, const unsigned int batchRecord)
+	{
+	//========== Variable ==========
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter_setBatchRecord()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		self->batchRecord = batchRecord;
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated inserter object is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Set the function which receives the input consumed by every insertion<br>
+ * (e.g. to journal the batches for replaying them after a restart).<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] journal		Function which receives the consumed input or NULL (in case of not journaled)
+ * @param[in,out] argument	Argument passed to the function
+ * @return					Inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_setJournal (CEPCUIInserter *self, CEPCUIInserter_Journal journal, void *argument)
+	{
+	//========== Variable ==========
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter_setJournal()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		self->journal = journal;
+		self->journalArgument = argument;
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated inserter object is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Keep only the records of the last indicated seconds in the table, and<br>
+ * optionally keep the table under the indicated size of memory.<br>
+ * The time column is indexed, and after each transaction the records older<br>
+ * than the window (relative to the newest time in the table, so that the<br>
+ * window follows the event time) are evicted with one range DELETE on the<br>
+ * index. Text times are compared in ISO 8601 format ("YYYY-MM-DD HH:MM:SS"<br>
+ * with optional fractional seconds) against a cutoff truncated to whole<br>
+ * seconds, so the records of the last indicated seconds are kept<br>
+ * inclusive. A "T" separator is indexed and compared as a space, so both<br>
+ * separators can be mixed in the column. Numeric times are compared as<br>
+ * seconds (e.g. UNIX time). If the newest time cannot be parsed, an error<br>
+ * is logged once and no record is evicted by time.<br>
+ * If the table (with the index) exceeds the memory limit, the oldest<br>
+ * records are evicted in one DELETE until it shrinks to<br>
+ * CEPCUIInserter_TRIM_RATIO[%] of the limit.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] tableName		Table name string
+ * @param[in] columnName	Name of the time column
+ * @param[in] windowTime	Length of the time window[sec] (0 : not bounded by time)
+ * @param[in] memoryLimit	Maximum size of the table[Byte] (0 : not bounded by memory)
+ * @return					Inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_setTimeWindow (CEPCUIInserter *self, const M2MString *tableName, const M2MString *columnName, const unsigned int windowTime, const size_t memoryLimit)
+	{
+	//========== Variable ==========
+	M2MString MODIFIER[64];
+	M2MString KEY[512];
+	M2MString SQL[1024];
+	M2MString MESSAGE[1280];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIInserter_setTimeWindow()";
+
+	//===== Check argument =====
+	if (self!=NULL && tableName!=NULL && columnName!=NULL)
+		{
+		//===== Index of the time column and DELETE statement of the time window =====
+		if (windowTime>0)
+			{
+			// text times are keyed with a space separator, so that "T" and " " are in the same order
+			snprintf((char *)KEY, sizeof(KEY), "(CASE WHEN typeof(%s)='text' THEN replace(%s, 'T', ' ') ELSE %s END)", columnName, columnName, columnName);
+			snprintf((char *)SQL, sizeof(SQL), "CREATE INDEX IF NOT EXISTS %s_%s_window ON %s(%s)", tableName, columnName, tableName, KEY);
+			if (sqlite3_exec(self->database, (char *)SQL, NULL, NULL, NULL)!=SQLITE_OK)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to execute SQL(=\"%s\") : %s", SQL, sqlite3_errmsg(self->database));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				return NULL;
+				}
+			snprintf((char *)SQL, sizeof(SQL),
+					"SELECT m, CASE WHEN typeof(m)!='text' THEN m - ?2 "
+					"ELSE strftime('%%Y-%%m-%%d %%H:%%M:%%S', m, ?1) END FROM (SELECT MAX(%s) AS m FROM %s)",
+					KEY, tableName);
+			snprintf((char *)MODIFIER, sizeof(MODIFIER), "-%u seconds", windowTime);
+			if (sqlite3_prepare_v3(self->database, (char *)SQL, -1, SQLITE_PREPARE_PERSISTENT, &self->cutoffStatement, NULL)!=SQLITE_OK
+					|| sqlite3_bind_text(self->cutoffStatement, 1, (char *)MODIFIER, -1, SQLITE_TRANSIENT)!=SQLITE_OK
+					|| sqlite3_bind_int64(self->cutoffStatement, 2, (sqlite3_int64)windowTime)!=SQLITE_OK)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to prepare SQL(=\"%s\") : %s", SQL, sqlite3_errmsg(self->database));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				return NULL;
+				}
+			snprintf((char *)SQL, sizeof(SQL), "DELETE FROM %s WHERE %s < ?1", tableName, KEY);
+			if (sqlite3_prepare_v3(self->database, (char *)SQL, -1, SQLITE_PREPARE_PERSISTENT, &self->windowStatement, NULL)!=SQLITE_OK)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to prepare SQL(=\"%s\") : %s", SQL, sqlite3_errmsg(self->database));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				return NULL;
+				}
+			}
+		//===== Statements measuring the table and evicting the oldest records =====
+		if (memoryLimit>0)
+			{
+			self->memoryLimit = memoryLimit;
+			snprintf((char *)SQL, sizeof(SQL),
+					"SELECT ((SELECT page_count FROM pragma_page_count()) - (SELECT freelist_count FROM pragma_freelist_count())) "
+					"* (SELECT page_size FROM pragma_page_size()), (SELECT COUNT(*) FROM %s)", tableName);
+			if (sqlite3_prepare_v3(self->database, (char *)SQL, -1, SQLITE_PREPARE_PERSISTENT, &self->memoryStatement, NULL)==SQLITE_OK)
+				{
+				snprintf((char *)SQL, sizeof(SQL), "DELETE FROM %s WHERE rowid < (SELECT rowid FROM %s ORDER BY rowid LIMIT 1 OFFSET ?1)", tableName, tableName);
+				}
+			if (self->memoryStatement==NULL
+					|| sqlite3_prepare_v3(self->database, (char *)SQL, -1, SQLITE_PREPARE_PERSISTENT, &self->trimStatement, NULL)!=SQLITE_OK)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to prepare SQL(=\"%s\") : %s", SQL, sqlite3_errmsg(self->database));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				return NULL;
+				}
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated inserter object, table name or column name is NULL");
+		return NULL;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * CEPCUIInserter.h : Direct insertion of records into the CEP table
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIINSERTER_H_
+#define CEPCUIINSERTER_H_
+
+
+
+#include "CEPCUIBinaryReader.h"
+#include "CEPCUICSVTokenizer.h"
+#include "CEPCUIMetrics.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <ctype.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Maximum number of columns of the CEP table
+ */
+#ifndef CEPCUIInserter_MAX_COLUMN
+#define CEPCUIInserter_MAX_COLUMN 64
+#endif /* CEPCUIInserter_MAX_COLUMN */
+
+
+/**
+ * Maximum integer which is bound as it is to a column of REAL affinity<br>
+ * (2^53, converted into a double exactly)<br>
+ */
+#ifndef CEPCUIInserter_MAX_EXACT_INTEGER
+#define CEPCUIInserter_MAX_EXACT_INTEGER 9007199254740992LL
+#endif /* CEPCUIInserter_MAX_EXACT_INTEGER */
+
+
+/**
+ * Ratio of the memory limit to which the table is trimmed when it exceeds<br>
+ * the limit[%] (the margin keeps the next batches from trimming again)<br>
+ */
+#ifndef CEPCUIInserter_TRIM_RATIO
+#define CEPCUIInserter_TRIM_RATIO 90
+#endif /* CEPCUIInserter_TRIM_RATIO */
+
+
+/**
+ * Function which receives the input consumed by an insertion, called after<br>
+ * its transaction is committed and the old records are deleted, so that<br>
+ * inserting the same input again reproduces the same table.<br>
+ *
+ * @param[in,out] argument	Argument given to CEPCUIInserter_setJournal()
+ * @param[in] binary		true : typed binary records (without the header), false : CSV format records
+ * @param[in] data			Consumed input (not NULL terminated)
+ * @param[in] dataLength	Size of the input[Byte]
+ */
+#ifndef CEPCUIInserter_Journal
+typedef void (*CEPCUIInserter_Journal) (void *argument, const bool binary, const M2MString *data, const size_t dataLength);
+#endif /* CEPCUIInserter_Journal */
+
+
+/**
+ * Inserter object which binds tokenized fields directly to a prepared<br>
+ * INSERT statement of the CEP table.<br>
+ */
+#ifndef CEPCUIInserter
+typedef struct
+	{
+	sqlite3 *database;
+	sqlite3_stmt *insertStatement;
+	sqlite3_stmt *beginStatement;
+	sqlite3_stmt *commitStatement;
+	sqlite3_stmt *rollbackStatement;
+	sqlite3_stmt *deleteStatement;
+	sqlite3_stmt *cutoffStatement;
+	sqlite3_stmt *windowStatement;
+	sqlite3_stmt *memoryStatement;
+	sqlite3_stmt *trimStatement;
+	size_t columnCount;
+	CEPCUIFieldType fieldTypeList[CEPCUIInserter_MAX_COLUMN];
+	unsigned int maxRecord;
+	unsigned int batchRecord;
+	size_t memoryLimit;
+	bool cutoffError;
+	M2MString *buffer;
+	size_t bufferLength;
+	CEPCUIInserter_Journal journal;
+	void *journalArgument;
+	} CEPCUIInserter;
+#endif /* CEPCUIInserter */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the prepared statements and heap memory of inserter object.<br>
+ *
+ * @param[in,out] self	Inserter object
+ */
+void CEPCUIInserter_delete (CEPCUIInserter **self);
+
+
+/**
+ * Insert the typed records from the binary reader into the CEP table.<br>
+ * Records are consumed until the reader has advanced by the indicated<br>
+ * length, the number of records per transaction is reached (or the end of<br>
+ * buffer), inserted in one transaction, and then the oldest records<br>
+ * exceeding the maximum number are deleted.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in,out] reader	Reader of binary records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIInserter_insertBinary (CEPCUIInserter *self, CEPCUIBinaryReader *reader, const size_t maxLength);
+
+
+/**
+ * Insert the records from the tokenizer into the CEP table.<br>
+ * Records are consumed until the tokenizer has advanced by the indicated<br>
+ * length, the number of records per transaction is reached (or the end of<br>
+ * buffer), inserted in one transaction, and then the oldest records<br>
+ * exceeding the maximum number are deleted.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in,out] tokenizer	Tokenizer of CSV format records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIInserter_insertCSV (CEPCUIInserter *self, CEPCUICSVTokenizer *tokenizer, const size_t maxLength);
+
+
+/**
+ * Construct new inserter object for the indicated table.<br>
+ * The number of columns is taken from the table definition itself.<br>
+ *
+ * @param[in] database	SQLite3 database which contains the CEP table
+ * @param[in] tableName	Table name string
+ * @param[in] maxRecord	Maximum number of records kept in the table (0 : unlimited)
+ * @return				Created inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_new (sqlite3 *database, const M2MString *tableName, const unsigned int maxRecord);
+
+
+/**
+ * Set the maximum number of records inserted in one transaction.<br>
+ * A transaction is also closed when the indicated length of the buffer has<br>
+ * been consumed, whichever comes first.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] batchRecord	Maximum number of records per transaction (0 : bounded only by the length)
+ * @return					Inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_setBatchRecord (CEPCUIInserter *self, const unsigned int batchRecord);
+
+
+/**
+ * Set the function which receives the input consumed by every insertion<br>
+ * (e.g. to journal the batches for replaying them after a restart).<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] journal		Function which receives the consumed input or NULL (in case of not journaled)
+ * @param[in,out] argument	Argument passed to the function
+ * @return					Inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_setJournal (CEPCUIInserter *self, CEPCUIInserter_Journal journal, void *argument);
+
+
+/**
+ * Keep only the records of the last indicated seconds in the table, and<br>
+ * optionally keep the table under the indicated size of memory.<br>
+ * The time column is indexed, and after each transaction the records older<br>
+ * than the window (relative to the newest time in the table, so that the<br>
+ * window follows the event time) are evicted with one range DELETE on the<br>
+ * index. Text times are compared in ISO 8601 format ("YYYY-MM-DD HH:MM:SS"<br>
+ * with optional fractional seconds) against a cutoff truncated to whole<br>
+ * seconds, so the records of the last indicated seconds are kept<br>
+ * inclusive. A "T" separator is indexed and compared as a space, so both<br>
+ * separators can be mixed in the column. Numeric times are compared as<br>
+ * seconds (e.g. UNIX time). If the newest time cannot be parsed, an error<br>
+ * is logged once and no record is evicted by time.<br>
+ * If the table (with the index) exceeds the memory limit, the oldest<br>
+ * records are evicted in one DELETE until it shrinks to<br>
+ * CEPCUIInserter_TRIM_RATIO[%] of the limit.<br>
+ *
+ * @param[in,out] self		Inserter object
+ * @param[in] tableName		Table name string
+ * @param[in] columnName	Name of the time column
+ * @param[in] windowTime	Length of the time window[sec] (0 : not bounded by time)
+ * @param[in] memoryLimit	Maximum size of the table[Byte] (0 : not bounded by memory)
+ * @return					Inserter object or NULL (in case of error)
+ */
+CEPCUIInserter *CEPCUIInserter_setTimeWindow (CEPCUIInserter *self, const M2MString *tableName, const M2MString *columnName, const unsigned int windowTime, const size_t memoryLimit);
+
+
+
+#endif /* CEPCUIINSERTER_H_ */
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * CEPCUILog.c : Log level gating of the debug and information messages
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUILog.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Minimum log level at runtime (read by every thread without locking)
+ */
+static atomic_int this_level = CEPCUILog_DEFAULT_LEVEL;
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Check whether the messages of the level are logged at runtime.<br>
+ *
+ * @param[in] level	Log level
+ * @return			true : logged, false : suppressed
+ */
+bool CEPCUILog_isEnabled (const int level)
+	{
+	return (level>=atomic_load_explicit(&this_level, memory_order_relaxed));
+	}
+
+
+/**
+ * Convert the name of the log level ("debug", "info" or "error").<br>
+ *
+ * @param[in] name	Name of the log level
+ * @return			Log level or -1 (in case of unknown name)
+ */
+int CEPCUILog_parseLevel (const M2MString *name)
+	{
+	//===== Check argument =====
+	if (name==NULL)
+		{
+		return -1;
+		}
+	else if (strcmp((char *)name, "debug")==0)
+		{
+		return CEPCUILog_DEBUG;
+		}
+	else if (strcmp((char *)name, "info")==0)
+		{
+		return CEPCUILog_INFO;
+		}
+	else if (strcmp((char *)name, "error")==0)
+		{
+		return CEPCUILog_ERROR;
+		}
+	else
+		{
+		return -1;
+		}
+	}
+
+
+/**
+ * Set the minimum log level at runtime.<br>
+ *
+ * @param[in] level	Log level
+ */
+void CEPCUILog_setLevel (const int level)
+	{
+	atomic_store_explicit(&this_level, level, memory_order_relaxed);
+	return;
+	}
+
+
+
+/* End Of File */
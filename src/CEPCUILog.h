@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * CEPCUILog.h : Log level gating of the debug and information messages
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUILOG_H_
+#define CEPCUILOG_H_
+
+
+
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Log level of the debug messages
+ */
+#ifndef CEPCUILog_DEBUG
+#define CEPCUILog_DEBUG 0
+#endif /* CEPCUILog_DEBUG */
+
+
+/**
+ * Log level of the information messages
+ */
+#ifndef CEPCUILog_INFO
+#define CEPCUILog_INFO 1
+#endif /* CEPCUILog_INFO */
+
+
+/**
+ * Log level of the error messages (which are never suppressed)
+ */
+#ifndef CEPCUILog_ERROR
+#define CEPCUILog_ERROR 2
+#endif /* CEPCUILog_ERROR */
+
+
+/**
+ * Minimum log level compiled into the application.<br>
+ * The messages below this level are removed by the compiler entirely<br>
+ * (e.g. "-DCEPCUILog_MIN_LEVEL=1" removes all the debug messages).<br>
+ */
+#ifndef CEPCUILog_MIN_LEVEL
+#define CEPCUILog_MIN_LEVEL CEPCUILog_DEBUG
+#endif /* CEPCUILog_MIN_LEVEL */
+
+
+/**
+ * Default log level at runtime
+ */
+#ifndef CEPCUILog_DEFAULT_LEVEL
+#define CEPCUILog_DEFAULT_LEVEL CEPCUILog_INFO
+#endif /* CEPCUILog_DEFAULT_LEVEL */
+
+
+/**
+ * Length of the buffer for a formatted message[Byte]
+ */
+#ifndef CEPCUILog_MESSAGE_LENGTH
+#define CEPCUILog_MESSAGE_LENGTH (PATH_MAX+256)
+#endif /* CEPCUILog_MESSAGE_LENGTH */
+
+
+/**
+ * Format and log the message only when the level is compiled in and enabled<br>
+ * at runtime; otherwise neither the arguments nor the logger are evaluated.<br>
+ *
+ * @param[in] level			Log level of the message
+ * @param[in] function		Logging function (M2MLogger_debug or M2MLogger_info)
+ * @param[in] logger		Logger object
+ * @param[in] methodName	Method name string
+ * @param[in] lineNumber	Line number
+ * @param[in] ...			Format string of printf() and its arguments
+ */
+#ifndef CEPCUILog_log
+#define CEPCUILog_log(level, function, logger, methodName, lineNumber, ...) \
+	do \
+		{ \
+		if ((level)>=CEPCUILog_MIN_LEVEL && CEPCUILog_isEnabled(level)==true) \
+			{ \
+			M2MString CEPCUILog_MESSAGE[CEPCUILog_MESSAGE_LENGTH]; \
+			snprintf((char *)CEPCUILog_MESSAGE, sizeof(CEPCUILog_MESSAGE), __VA_ARGS__); \
+			function((logger), (methodName), (lineNumber), CEPCUILog_MESSAGE); \
+			} \
+		} \
+	while (0)
+#endif /* CEPCUILog_log */
+
+
+/**
+ * Log the debug message (see CEPCUILog_log()).<br>
+ */
+#ifndef CEPCUILog_debug
+#define CEPCUILog_debug(logger, methodName, lineNumber, ...) CEPCUILog_log(CEPCUILog_DEBUG, M2MLogger_debug, logger, methodName, lineNumber, __VA_ARGS__)
+#endif /* CEPCUILog_debug */
+
+
+/**
+ * Log the information message (see CEPCUILog_log()).<br>
+ */
+#ifndef CEPCUILog_info
+#define CEPCUILog_info(logger, methodName, lineNumber, ...) CEPCUILog_log(CEPCUILog_INFO, M2MLogger_info, logger, methodName, lineNumber, __VA_ARGS__)
+#endif /* CEPCUILog_info */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Check whether the messages of the level are logged at runtime.<br>
+ *
+ * @param[in] level	Log level
+ * @return			true : logged, false : suppressed
+ */
+bool CEPCUILog_isEnabled (const int level);
+
+
+/**
+ * Convert the name of the log level ("debug", "info" or "error").<br>
+ *
+ * @param[in] name	Name of the log level
+ * @return			Log level or -1 (in case of unknown name)
+ */
+int CEPCUILog_parseLevel (const M2MString *name);
+
+
+/**
+ * Set the minimum log level at runtime.<br>
+ *
+ * @param[in] level	Log level
+ */
+void CEPCUILog_setLevel (const int level);
+
+
+
+#endif /* CEPCUILOG_H_ */
@@ -0,0 +1,666 @@
+/*******************************************************************************
+ * CEPCUIMetrics.c : Process-wide counters and latency histograms of the CEP stages
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIMetrics.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * State of the metrics shared by the whole process, so that every stage<br>
+ * (including the worker threads of the shards) can record into it without<br>
+ * being handed an object.<br>
+ */
+typedef struct
+	{
+	_Atomic uint64_t counterList[CEPCUIMetricsCounter_COUNT];
+	CEPCUIMetricsHistogram histogramList[CEPCUIMetricsStage_COUNT];
+	struct timespec startTime;
+	pthread_t thread;
+	bool running;
+	int fd;
+	int wakeFD[2];
+	M2MString filePath[PATH_MAX];
+	unsigned int interval;
+	} CEPCUIMetrics;
+
+
+/**
+ * Counters and histograms of this process
+ */
+static CEPCUIMetrics this_metrics = {.fd = -1, .wakeFD = {-1, -1}};
+
+
+/**
+ * Names of the counters (in the order of CEPCUIMetricsCounter)
+ */
+static const char *COUNTER_NAME_LIST[CEPCUIMetricsCounter_COUNT][2] =
+	{
+		{"cepcui_batches_total", "Number of the inserted batches"},
+		{"cepcui_evicted_rows_total", "Number of the records evicted from the window"},
+		{"cepcui_inserted_rows_total", "Number of the inserted records"},
+		{"cepcui_matched_rows_total", "Number of the records of the query results"},
+		{"cepcui_missed_deadlines_total", "Number of the cycle deadlines skipped because the previous cycle overran"},
+		{"cepcui_read_bytes_total", "Size of the read input[Byte]"},
+		{"cepcui_written_bytes_total", "Size of the written results[Byte]"}
+	};
+
+
+/**
+ * Names of the stages (in the order of CEPCUIMetricsStage)
+ */
+static const char *STAGE_NAME_LIST[CEPCUIMetricsStage_COUNT] = {"read", "insert", "select", "write"};
+
+
+/**
+ * Quantiles exported for each stage
+ */
+static const double QUANTILE_LIST[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Get the index of the histogram bucket which counts the duration.<br>
+ *
+ * @param[in] value	Duration[nsec]
+ * @return			Index of the bucket
+ */
+static size_t this_getIndex (const uint64_t value);
+
+
+/**
+ * Get the duration at the indicated quantile from the snapshot of the<br>
+ * histogram (the upper bound of the bucket, but never above the maximum).<br>
+ *
+ * @param[in] bucketList	Snapshot of the buckets
+ * @param[in] count			Number of the recorded durations
+ * @param[in] max			Maximum recorded duration[nsec]
+ * @param[in] quantile		Quantile (0.0 - 1.0)
+ * @return					Duration[nsec]
+ */
+static uint64_t this_getQuantile (const uint64_t bucketList[], const uint64_t count, const uint64_t max, const double quantile);
+
+
+/**
+ * Get the largest duration counted by the histogram bucket.<br>
+ *
+ * @param[in] index	Index of the bucket
+ * @return			Duration[nsec]
+ */
+static uint64_t this_getUpperBound (const size_t index);
+
+
+/**
+ * Main loop of the background thread: serve the scrapes and rewrite the<br>
+ * stats file periodically until CEPCUIMetrics_stop() is called.<br>
+ *
+ * @param[in] argument	Unused
+ * @return				NULL
+ */
+static void *this_loop (void *argument);
+
+
+/**
+ * Append the formatted string to the buffer as far as it fits.<br>
+ *
+ * @param[out] buffer		Buffer
+ * @param[in] bufferLength	Size of the buffer[Byte]
+ * @param[in,out] length	Length of the string in the buffer[Byte]
+ * @param[in] format		Format string of printf()
+ */
+static void this_print (M2MString *buffer, const size_t bufferLength, size_t *length, const char *format, ...) __attribute__ ((format(printf, 4, 5)));
+
+
+/**
+ * Accept a connection to the metrics endpoint and answer it with the<br>
+ * metrics as a HTTP/1.0 response, whatever the request is.<br>
+ *
+ * @param[in] fd	Listening socket
+ */
+static void this_serve (const int fd);
+
+
+/**
+ * Rewrite the stats file atomically (by renaming a temporary file into<br>
+ * place).<br>
+ */
+static void this_writeFile (void);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Get the index of the histogram bucket which counts the duration.<br>
+ *
+ * @param[in] value	Duration[nsec]
+ * @return			Index of the bucket
+ */
+static size_t this_getIndex (const uint64_t value)
+	{
+	//========== Variable ==========
+	unsigned int exponent = 0;
+	size_t index = 0;
+	const uint64_t SUB_BUCKET_COUNT = 1U << CEPCUIMetrics_SUB_BUCKET_BITS;
+
+	if (value<SUB_BUCKET_COUNT)
+		{
+		return (size_t)value;
+		}
+	else
+		{
+		exponent = 63 - (unsigned int)__builtin_clzll(value);
+		index = (exponent - CEPCUIMetrics_SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT
+				+ ((value >> (exponent - CEPCUIMetrics_SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+		return (index<CEPCUIMetrics_BUCKET_COUNT) ? index : CEPCUIMetrics_BUCKET_COUNT - 1;
+		}
+	}
+
+
+/**
+ * Get the duration at the indicated quantile from the snapshot of the<br>
+ * histogram (the upper bound of the bucket, but never above the maximum).<br>
+ *
+ * @param[in] bucketList	Snapshot of the buckets
+ * @param[in] count			Number of the recorded durations
+ * @param[in] max			Maximum recorded duration[nsec]
+ * @param[in] quantile		Quantile (0.0 - 1.0)
+ * @return					Duration[nsec]
+ */
+static uint64_t this_getQuantile (const uint64_t bucketList[], const uint64_t count, const uint64_t max, const double quantile)
+	{
+	//========== Variable ==========
+	uint64_t rank = 0;
+	uint64_t total = 0;
+	uint64_t value = 0;
+	size_t i = 0;
+
+	if (count==0)
+		{
+		return 0;
+		}
+	else if (quantile>=1.0)
+		{
+		return max;
+		}
+	//===== Find the bucket of the rank =====
+	if ((rank=(uint64_t)(quantile * (double)count + 0.999999))<1)
+		{
+		rank = 1;
+		}
+	for (i=0; i<CEPCUIMetrics_BUCKET_COUNT; i++)
+		{
+		if ((total+=bucketList[i])>=rank)
+			{
+			value = this_getUpperBound(i);
+			return (value<max) ? value : max;
+			}
+		}
+	return max;
+	}
+
+
+/**
+ * Get the largest duration counted by the histogram bucket.<br>
+ *
+ * @param[in] index	Index of the bucket
+ * @return			Duration[nsec]
+ */
+static uint64_t this_getUpperBound (const size_t index)
+	{
+	//========== Variable ==========
+	unsigned int shift = 0;
+	const size_t SUB_BUCKET_COUNT = 1U << CEPCUIMetrics_SUB_BUCKET_BITS;
+
+	if (index<SUB_BUCKET_COUNT)
+		{
+		return (uint64_t)index;
+		}
+	else
+		{
+		shift = (unsigned int)(index / SUB_BUCKET_COUNT) - 1;
+		return ((((uint64_t)(SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT)) + 1) << shift) - 1;
+		}
+	}
+
+
+/**
+ * Main loop of the background thread: serve the scrapes and rewrite the<br>
+ * stats file periodically until CEPCUIMetrics_stop() is called.<br>
+ *
+ * @param[in] argument	Unused
+ * @return				NULL
+ */
+static void *this_loop (void *argument)
+	{
+	//========== Variable ==========
+	struct pollfd pollList[2];
+	struct timespec now;
+	time_t nextWrite = 0;
+	const int TIMEOUT = 1000;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	nextWrite = now.tv_sec + (time_t)this_metrics.interval;
+	pollList[0].fd = this_metrics.wakeFD[0];
+	pollList[0].events = POLLIN;
+	pollList[1].fd = this_metrics.fd;
+	pollList[1].events = POLLIN;
+	while (true)
+		{
+		//===== Wait for a scrape or the stop =====
+		if (poll(pollList, (this_metrics.fd>=0) ? 2 : 1, TIMEOUT)>0)
+			{
+			if ((pollList[0].revents & POLLIN)!=0)
+				{
+				break;
+				}
+			else if (this_metrics.fd>=0 && (pollList[1].revents & POLLIN)!=0)
+				{
+				this_serve(this_metrics.fd);
+				}
+			}
+		//===== Rewrite the stats file =====
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (this_metrics.filePath[0]!='\0' && now.tv_sec>=nextWrite)
+			{
+			this_writeFile();
+			nextWrite = now.tv_sec + (time_t)this_metrics.interval;
+			}
+		}
+	return NULL;
+	}
+
+
+/**
+ * Append the formatted string to the buffer as far as it fits.<br>
+ *
+ * @param[out] buffer		Buffer
+ * @param[in] bufferLength	Size of the buffer[Byte]
+ * @param[in,out] length	Length of the string in the buffer[Byte]
+ * @param[in] format		Format string of printf()
+ */
+static void this_print (M2MString *buffer, const size_t bufferLength, size_t *length, const char *format, ...)
+	{
+	//========== Variable ==========
+	va_list argumentList;
+	int result = 0;
+
+	if ((*length)+1<bufferLength)
+		{
+		va_start(argumentList, format);
+		result = vsnprintf((char *)buffer + (*length), bufferLength - (*length), format, argumentList);
+		va_end(argumentList);
+		if (result>0)
+			{
+			(*length) += ((size_t)result<bufferLength - (*length)) ? (size_t)result : bufferLength - (*length) - 1;
+			}
+		}
+	return;
+	}
+
+
+/**
+ * Accept a connection to the metrics endpoint and answer it with the<br>
+ * metrics as a HTTP/1.0 response, whatever the request is.<br>
+ *
+ * @param[in] fd	Listening socket
+ */
+static void this_serve (const int fd)
+	{
+	//========== Variable ==========
+	int client = -1;
+	struct timeval timeout = {1, 0};
+	size_t length = 0;
+	size_t headerLength = 0;
+	ssize_t result = 0;
+	size_t offset = 0;
+	M2MString REQUEST[4096];
+	M2MString HEADER[256];
+	M2MString BUFFER[CEPCUIMetrics_FORMAT_LENGTH];
+
+	if ((client=accept(fd, NULL, NULL))>=0)
+		{
+		//===== Read (and ignore) the request =====
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		recv(client, REQUEST, sizeof(REQUEST), 0);
+		//===== Send the metrics =====
+		length = CEPCUIMetrics_format(BUFFER, sizeof(BUFFER));
+		headerLength = (size_t)snprintf((char *)HEADER, sizeof(HEADER), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", length);
+		if (send(client, HEADER, headerLength, MSG_NOSIGNAL)==(ssize_t)headerLength)
+			{
+			while (offset<length && (result=send(client, BUFFER + offset, length - offset, MSG_NOSIGNAL))>0)
+				{
+				offset += (size_t)result;
+				}
+			}
+		close(client);
+		}
+	return;
+	}
+
+
+/**
+ * Rewrite the stats file atomically (by renaming a temporary file into<br>
+ * place).<br>
+ */
+static void this_writeFile (void)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	bool written = false;
+	size_t length = 0;
+	const M2MString *fileName = NULL;
+	M2MString temporaryFilePath[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	M2MString BUFFER[CEPCUIMetrics_FORMAT_LENGTH];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIMetrics.this_writeFile()";
+
+	//===== Get the temporary file path =====
+	if ((fileName=(M2MString *)strrchr((char *)this_metrics.filePath, '/'))!=NULL
+			&& snprintf((char *)temporaryFilePath, sizeof(temporaryFilePath), "%.*s/.%s.tmp", (int)(fileName - this_metrics.filePath), this_metrics.filePath, fileName + 1)<(int)sizeof(temporaryFilePath))
+		{
+		length = CEPCUIMetrics_format(BUFFER, sizeof(BUFFER));
+		if ((fd=open((char *)temporaryFilePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))>=0)
+			{
+			written = (write(fd, BUFFER, length)==(ssize_t)length);
+			written = (close(fd)==0 && written==true);
+			}
+		if (written==true && rename((char *)temporaryFilePath, (char *)this_metrics.filePath)==0)
+			{
+			return;
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to write the stats file(=\"%s\") : %s", this_metrics.filePath, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			unlink((char *)temporaryFilePath);
+			return;
+			}
+		}
+	return;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Add the value to the counter.<br>
+ *
+ * @param[in] counter	Counter
+ * @param[in] value		Added value
+ */
+void CEPCUIMetrics_add (const CEPCUIMetricsCounter counter, const uint64_t value)
+	{
+	if (counter<CEPCUIMetricsCounter_COUNT)
+		{
+		atomic_fetch_add_explicit(&this_metrics.counterList[counter], value, memory_order_relaxed);
+		}
+	return;
+	}
+
+
+/**
+ * Format the counters and histograms in the Prometheus text exposition<br>
+ * format (which is also the content of the stats file).<br>
+ *
+ * @param[out] buffer		Buffer for the formatted metrics
+ * @param[in] bufferLength	Size of the buffer[Byte]
+ * @return					Length of the formatted metrics[Byte]
+ */
+size_t CEPCUIMetrics_format (M2MString *buffer, const size_t bufferLength)
+	{
+	//========== Variable ==========
+	CEPCUIMetricsHistogram *histogram = NULL;
+	uint64_t bucketList[CEPCUIMetricsStage_COUNT][CEPCUIMetrics_BUCKET_COUNT];
+	uint64_t countList[CEPCUIMetricsStage_COUNT];
+	uint64_t sumList[CEPCUIMetricsStage_COUNT];
+	uint64_t maxList[CEPCUIMetricsStage_COUNT];
+	uint64_t total = 0;
+	struct timespec now;
+	size_t length = 0;
+	size_t i = 0;
+	size_t j = 0;
+	size_t k = 0;
+	unsigned int exponent = 0;
+	const unsigned int MIN_EXPONENT = 10;
+	const unsigned int MAX_EXPONENT = 36;
+
+	//===== Check argument =====
+	if (buffer==NULL || bufferLength==0)
+		{
+		return 0;
+		}
+	buffer[0] = '\0';
+	//===== Counters =====
+	for (i=0; i<CEPCUIMetricsCounter_COUNT; i++)
+		{
+		this_print(buffer, bufferLength, &length, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+				COUNTER_NAME_LIST[i][0], COUNTER_NAME_LIST[i][1], COUNTER_NAME_LIST[i][0], COUNTER_NAME_LIST[i][0],
+				(unsigned long long)atomic_load_explicit(&this_metrics.counterList[i], memory_order_relaxed));
+		}
+	//===== Take a snapshot of the histograms =====
+	for (i=0; i<CEPCUIMetricsStage_COUNT; i++)
+		{
+		histogram = &this_metrics.histogramList[i];
+		countList[i] = 0;
+		for (j=0; j<CEPCUIMetrics_BUCKET_COUNT; j++)
+			{
+			bucketList[i][j] = atomic_load_explicit(&histogram->bucketList[j], memory_order_relaxed);
+			countList[i] += bucketList[i][j];
+			}
+		sumList[i] = atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+		maxList[i] = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+		}
+	//===== Histograms (cumulative buckets at every power of 4) =====
+	this_print(buffer, bufferLength, &length, "# HELP cepcui_stage_duration_seconds Duration of the stages of the CEP loop\n# TYPE cepcui_stage_duration_seconds histogram\n");
+	for (i=0; i<CEPCUIMetricsStage_COUNT; i++)
+		{
+		total = 0;
+		k = 0;
+		for (exponent=MIN_EXPONENT; exponent<=MAX_EXPONENT; exponent+=2)
+			{
+			for (; k<this_getIndex((uint64_t)1 << exponent); k++)
+				{
+				total += bucketList[i][k];
+				}
+			this_print(buffer, bufferLength, &length, "cepcui_stage_duration_seconds_bucket{stage=\"%s\",le=\"%.9g\"} %llu\n",
+					STAGE_NAME_LIST[i], (double)((uint64_t)1 << exponent) / 1e9, (unsigned long long)total);
+			}
+		this_print(buffer, bufferLength, &length, "cepcui_stage_duration_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n", STAGE_NAME_LIST[i], (unsigned long long)countList[i]);
+		this_print(buffer, bufferLength, &length, "cepcui_stage_duration_seconds_sum{stage=\"%s\"} %.9f\n", STAGE_NAME_LIST[i], (double)sumList[i] / 1e9);
+		this_print(buffer, bufferLength, &length, "cepcui_stage_duration_seconds_count{stage=\"%s\"} %llu\n", STAGE_NAME_LIST[i], (unsigned long long)countList[i]);
+		}
+	//===== Quantiles (with the precision of the histogram buckets) =====
+	this_print(buffer, bufferLength, &length, "# HELP cepcui_stage_duration_quantile_seconds Quantiles of the duration of the stages since the start\n# TYPE cepcui_stage_duration_quantile_seconds gauge\n");
+	for (i=0; i<CEPCUIMetricsStage_COUNT; i++)
+		{
+		for (j=0; j<sizeof(QUANTILE_LIST)/sizeof(QUANTILE_LIST[0]); j++)
+			{
+			this_print(buffer, bufferLength, &length, "cepcui_stage_duration_quantile_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+					STAGE_NAME_LIST[i], QUANTILE_LIST[j], (double)this_getQuantile(bucketList[i], countList[i], maxList[i], QUANTILE_LIST[j]) / 1e9);
+			}
+		}
+	//===== Uptime =====
+	if (this_metrics.startTime.tv_sec!=0)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		this_print(buffer, bufferLength, &length, "# HELP cepcui_uptime_seconds Time since the metrics were started\n# TYPE cepcui_uptime_seconds gauge\ncepcui_uptime_seconds %.3f\n",
+				(double)(now.tv_sec - this_metrics.startTime.tv_sec) + (double)(now.tv_nsec - this_metrics.startTime.tv_nsec) / 1e9);
+		}
+	return length;
+	}
+
+
+/**
+ * Record the duration of the stage from the indicated start time until now.<br>
+ *
+ * @param[in] stage	Stage
+ * @param[in] start	Start time of the stage (CLOCK_MONOTONIC)
+ */
+void CEPCUIMetrics_record (const CEPCUIMetricsStage stage, const struct timespec *start)
+	{
+	//========== Variable ==========
+	CEPCUIMetricsHistogram *histogram = NULL;
+	struct timespec now;
+	int64_t duration = 0;
+	uint64_t max = 0;
+
+	//===== Check argument =====
+	if (stage<CEPCUIMetricsStage_COUNT && start!=NULL)
+		{
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if ((duration=(int64_t)(now.tv_sec - start->tv_sec) * 1000000000 + (now.tv_nsec - start->tv_nsec))<0)
+			{
+			duration = 0;
+			}
+		histogram = &this_metrics.histogramList[stage];
+		atomic_fetch_add_explicit(&histogram->bucketList[this_getIndex((uint64_t)duration)], 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&histogram->sum, (uint64_t)duration, memory_order_relaxed);
+		max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+		while (max<(uint64_t)duration
+				&& atomic_compare_exchange_weak_explicit(&histogram->max, &max, (uint64_t)duration, memory_order_relaxed, memory_order_relaxed)==false)
+			{
+			}
+		}
+	return;
+	}
+
+
+/**
+ * Start the background thread which rewrites the stats file periodically<br>
+ * and serves the metrics over HTTP on 127.0.0.1 (for Prometheus).<br>
+ * Nothing is started when both of them are disabled; the counters and<br>
+ * histograms are recorded anyway.<br>
+ *
+ * @param[in] filePath	Path of the stats file or NULL (in case of disabled)
+ * @param[in] interval	Interval of rewriting the stats file[sec]
+ * @param[in] port		TCP port of the metrics endpoint (0 : disabled)
+ * @return				true : success, false : failure
+ */
+bool CEPCUIMetrics_start (const M2MString *filePath, const unsigned int interval, const unsigned short port)
+	{
+	//========== Variable ==========
+	struct sockaddr_in address;
+	int option = 1;
+	M2MString MESSAGE[128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIMetrics_start()";
+
+	clock_gettime(CLOCK_MONOTONIC, &this_metrics.startTime);
+	memset(this_metrics.filePath, 0, sizeof(this_metrics.filePath));
+	if (filePath!=NULL && interval>0 && M2MString_length(filePath)<sizeof(this_metrics.filePath))
+		{
+		memcpy(this_metrics.filePath, filePath, M2MString_length(filePath));
+		this_metrics.interval = interval;
+		}
+	//===== Nothing to start =====
+	if (this_metrics.running==true || (this_metrics.filePath[0]=='\0' && port==0))
+		{
+		return true;
+		}
+	//===== Listen on the loopback interface =====
+	if (port>0)
+		{
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if ((this_metrics.fd=socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0))<0
+				|| setsockopt(this_metrics.fd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option))!=0
+				|| bind(this_metrics.fd, (struct sockaddr *)&address, sizeof(address))!=0
+				|| listen(this_metrics.fd, SOMAXCONN)!=0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to listen on the metrics port(=%u) : %s", (unsigned int)port, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			CEPCUIMetrics_stop();
+			return false;
+			}
+		}
+	//===== Start the background thread =====
+	if (pipe(this_metrics.wakeFD)!=0
+			|| pthread_create(&this_metrics.thread, NULL, this_loop, NULL)!=0)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to start the thread of the metrics");
+		CEPCUIMetrics_stop();
+		return false;
+		}
+	this_metrics.running = true;
+	return true;
+	}
+
+
+/**
+ * Stop the background thread, rewriting the stats file for the last time.<br>
+ */
+void CEPCUIMetrics_stop (void)
+	{
+	//===== Stop the background thread =====
+	if (this_metrics.running==true)
+		{
+		if (write(this_metrics.wakeFD[1], "", 1)==1)
+			{
+			pthread_join(this_metrics.thread, NULL);
+			}
+		this_metrics.running = false;
+		}
+	//===== Rewrite the stats file for the last time =====
+	if (this_metrics.filePath[0]!='\0')
+		{
+		this_writeFile();
+		}
+	//===== Release the resources =====
+	if (this_metrics.fd>=0)
+		{
+		close(this_metrics.fd);
+		this_metrics.fd = -1;
+		}
+	if (this_metrics.wakeFD[0]>=0)
+		{
+		close(this_metrics.wakeFD[0]);
+		close(this_metrics.wakeFD[1]);
+		this_metrics.wakeFD[0] = -1;
+		this_metrics.wakeFD[1] = -1;
+		}
+	return;
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * CEPCUIMetrics.h : Process-wide counters and latency histograms of the CEP stages
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIMETRICS_H_
+#define CEPCUIMETRICS_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Number of bits of the sub-buckets in each power of 2 of the histogram<br>
+ * (16 sub-buckets, i.e. the relative error of a quantile is at most 6.25%)<br>
+ */
+#ifndef CEPCUIMetrics_SUB_BUCKET_BITS
+#define CEPCUIMetrics_SUB_BUCKET_BITS 4
+#endif /* CEPCUIMetrics_SUB_BUCKET_BITS */
+
+
+/**
+ * Number of buckets of the histogram, which covers up to 2^41[nsec]<br>
+ * (about 36 minutes; longer durations are counted in the last bucket)<br>
+ */
+#ifndef CEPCUIMetrics_BUCKET_COUNT
+#define CEPCUIMetrics_BUCKET_COUNT 608
+#endif /* CEPCUIMetrics_BUCKET_COUNT */
+
+
+/**
+ * Default interval of rewriting the stats file[sec]
+ */
+#ifndef CEPCUIMetrics_DEFAULT_INTERVAL
+#define CEPCUIMetrics_DEFAULT_INTERVAL 10
+#endif /* CEPCUIMetrics_DEFAULT_INTERVAL */
+
+
+/**
+ * Length of the buffer for the formatted metrics[Byte]
+ */
+#ifndef CEPCUIMetrics_FORMAT_LENGTH
+#define CEPCUIMetrics_FORMAT_LENGTH 16384
+#endif /* CEPCUIMetrics_FORMAT_LENGTH */
+
+
+/**
+ * Counter of the processed data.<br>
+ */
+#ifndef CEPCUIMetricsCounter
+typedef enum
+	{
+	CEPCUIMetricsCounter_BATCH,
+	CEPCUIMetricsCounter_EVICTED_ROW,
+	CEPCUIMetricsCounter_INSERTED_ROW,
+	CEPCUIMetricsCounter_MATCHED_ROW,
+	CEPCUIMetricsCounter_MISSED_DEADLINE,
+	CEPCUIMetricsCounter_READ_BYTE,
+	CEPCUIMetricsCounter_WRITTEN_BYTE,
+	CEPCUIMetricsCounter_COUNT
+	} CEPCUIMetricsCounter;
+#endif /* CEPCUIMetricsCounter */
+
+
+/**
+ * Stage of the CEP loop whose duration is recorded in a histogram.<br>
+ * READ : mapping an input file (formerly this_getCSV())<br>
+ * INSERT : inserting a batch of records (formerly M2MCEP_insertCSV())<br>
+ * SELECT : executing a query, including streaming its result (formerly M2MCEP_select())<br>
+ * WRITE : writing a result or a chunk of it (formerly this_setResult())<br>
+ */
+#ifndef CEPCUIMetricsStage
+typedef enum
+	{
+	CEPCUIMetricsStage_READ,
+	CEPCUIMetricsStage_INSERT,
+	CEPCUIMetricsStage_SELECT,
+	CEPCUIMetricsStage_WRITE,
+	CEPCUIMetricsStage_COUNT
+	} CEPCUIMetricsStage;
+#endif /* CEPCUIMetricsStage */
+
+
+/**
+ * Log-linear latency histogram in nanoseconds (in the manner of HDR<br>
+ * histogram): the durations less than 16[nsec] have their own buckets, and<br>
+ * each following power of 2 is divided into 16 buckets.<br>
+ * The number of the durations is the sum of the buckets.<br>
+ * All the members are updated with relaxed atomic operations, so that the<br>
+ * recording threads never wait for each other or for the reader.<br>
+ */
+#ifndef CEPCUIMetricsHistogram
+typedef struct
+	{
+	_Atomic uint64_t bucketList[CEPCUIMetrics_BUCKET_COUNT];
+	_Atomic uint64_t sum;
+	_Atomic uint64_t max;
+	} CEPCUIMetricsHistogram;
+#endif /* CEPCUIMetricsHistogram */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Add the value to the counter.<br>
+ *
+ * @param[in] counter	Counter
+ * @param[in] value		Added value
+ */
+void CEPCUIMetrics_add (const CEPCUIMetricsCounter counter, const uint64_t value);
+
+
+/**
+ * Format the counters and histograms in the Prometheus text exposition<br>
+ * format (which is also the content of the stats file).<br>
+ *
+ * @param[out] buffer		Buffer for the formatted metrics
+ * @param[in] bufferLength	Size of the buffer[Byte]
+ * @return					Length of the formatted metrics[Byte]
+ */
+size_t CEPCUIMetrics_format (M2MString *buffer, const size_t bufferLength);
+
+
+/**
+ * Record the duration of the stage from the indicated start time until now.<br>
+ *
+ * @param[in] stage	Stage
+ * @param[in] start	Start time of the stage (CLOCK_MONOTONIC)
+ */
+void CEPCUIMetrics_record (const CEPCUIMetricsStage stage, const struct timespec *start);
+
+
+/**
+ * Start the background thread which rewrites the stats file periodically<br>
+ * and serves the metrics over HTTP on 127.0.0.1 (for Prometheus).<br>
+ * Nothing is started when both of them are disabled; the counters and<br>
+ * histograms are recorded anyway.<br>
+ *
+ * @param[in] filePath	Path of the stats file or NULL (in case of disabled)
+ * @param[in] interval	Interval of rewriting the stats file[sec]
+ * @param[in] port		TCP port of the metrics endpoint (0 : disabled)
+ * @return				true : success, false : failure
+ */
+bool CEPCUIMetrics_start (const M2MString *filePath, const unsigned int interval, const unsigned short port);
+
+
+/**
+ * Stop the background thread, rewriting the stats file for the last time.<br>
+ */
+void CEPCUIMetrics_stop (void);
+
+
+
+#endif /* CEPCUIMETRICS_H_ */
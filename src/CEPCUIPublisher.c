@@ -0,0 +1,581 @@
+/*******************************************************************************
+ * CEPCUIPublisher.c : Sequenced publication of CEP result files
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIPublisher.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Count the number of result files in the directory.<br>
+ *
+ * @param[in] self	Publisher object
+ * @return			Number of result files
+ */
+static size_t this_countFile (const CEPCUIPublisher *self);
+
+
+/**
+ * Create the directory if it doesn't exist.<br>
+ *
+ * @param[in] directoryPath	Directory path string
+ * @return					true : the directory exists, false : failed to create the directory
+ */
+static bool this_createDirectory (const M2MString *directoryPath);
+
+
+/**
+ * Delete the result files which are older than the newest "depth" files.<br>
+ *
+ * @param[in] self	Publisher object
+ */
+static void this_deleteOldFile (const CEPCUIPublisher *self);
+
+
+/**
+ * Get the path of the next sequenced result file (or its temporary file).<br>
+ *
+ * @param[in] self				Publisher object
+ * @param[in] temporary			true : temporary dot-file, false : result file
+ * @param[out] filePath			Buffer for copying the file path string
+ * @param[in] filePathLength	Size of the buffer[Byte]
+ * @return						Pointer of the buffer or NULL (in case the path is too long)
+ */
+static M2MString *this_getFilePath (const CEPCUIPublisher *self, const bool temporary, M2MString filePath[], const size_t filePathLength);
+
+
+/**
+ * Get the sequence number of the result file name.<br>
+ *
+ * @param[in] fileName	Result file name string
+ * @return				Sequence number or 0 (in case of not result file)
+ */
+static uint64_t this_getSequence (const M2MString *fileName);
+
+
+/**
+ * Write all the data to the file descriptor.<br>
+ *
+ * @param[in] fd			File descriptor
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of data[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_write (const int fd, const M2MString *data, size_t dataLength);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Count the number of result files in the directory.<br>
+ *
+ * @param[in] self	Publisher object
+ * @return			Number of result files
+ */
+static size_t this_countFile (const CEPCUIPublisher *self)
+	{
+	//========== Variable ==========
+	DIR *directory = NULL;
+	struct dirent *entry = NULL;
+	size_t count = 0;
+
+	//===== Open the directory =====
+	if (self!=NULL && (directory=opendir((char *)self->directoryPath))!=NULL)
+		{
+		while ((entry=readdir(directory))!=NULL)
+			{
+			if (this_getSequence((M2MString *)entry->d_name)>0)
+				{
+				count++;
+				}
+			}
+		closedir(directory);
+		}
+	return count;
+	}
+
+
+/**
+ * Create the directory if it doesn't exist.<br>
+ *
+ * @param[in] directoryPath	Directory path string
+ * @return					true : the directory exists, false : failed to create the directory
+ */
+static bool this_createDirectory (const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIPublisher.this_createDirectory()";
+
+	//===== Create directory =====
+	if (mkdir((char *)directoryPath, 0755)==0 || errno==EEXIST)
+		{
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to create the result directory(=\"%s\") : %s", directoryPath, strerror(errno));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		return false;
+		}
+	}
+
+
+/**
+ * Delete the result files which are older than the newest "depth" files.<br>
+ *
+ * @param[in] self	Publisher object
+ */
+static void this_deleteOldFile (const CEPCUIPublisher *self)
+	{
+	//========== Variable ==========
+	DIR *directory = NULL;
+	struct dirent *entry = NULL;
+	uint64_t sequence = 0;
+	M2MString FILE_PATH[PATH_MAX];
+
+	//===== Check the sequence numbers in the directory =====
+	if (self!=NULL && self->sequence>self->depth && (directory=opendir((char *)self->directoryPath))!=NULL)
+		{
+		while ((entry=readdir(directory))!=NULL)
+			{
+			if ((sequence=this_getSequence((M2MString *)entry->d_name))>0 && sequence<=self->sequence-self->depth)
+				{
+				if (snprintf((char *)FILE_PATH, sizeof(FILE_PATH), "%s/%s", self->directoryPath, entry->d_name)<(int)sizeof(FILE_PATH))
+					{
+					unlink((char *)FILE_PATH);
+					}
+				}
+			}
+		closedir(directory);
+		}
+	return;
+	}
+
+
+/**
+ * Get the path of the next sequenced result file (or its temporary file).<br>
+ *
+ * @param[in] self				Publisher object
+ * @param[in] temporary			true : temporary dot-file, false : result file
+ * @param[out] filePath			Buffer for copying the file path string
+ * @param[in] filePathLength	Size of the buffer[Byte]
+ * @return						Pointer of the buffer or NULL (in case the path is too long)
+ */
+static M2MString *this_getFilePath (const CEPCUIPublisher *self, const bool temporary, M2MString filePath[], const size_t filePathLength)
+	{
+	if (snprintf((char *)filePath, filePathLength, (temporary==true) ? "%s/.%020llu.csv.tmp" : "%s/%020llu.csv", self->directoryPath, (unsigned long long)(self->sequence + 1))<(int)filePathLength)
+		{
+		return filePath;
+		}
+	else
+		{
+		return NULL;
+		}
+	}
+
+
+/**
+ * Get the sequence number of the result file name.<br>
+ * Result file name consists of 20 decimal digits and ".csv" extension.<br>
+ *
+ * @param[in] fileName	Result file name string
+ * @return				Sequence number or 0 (in case of not result file)
+ */
+static uint64_t this_getSequence (const M2MString *fileName)
+	{
+	//========== Variable ==========
+	char *end = NULL;
+	uint64_t sequence = 0;
+
+	//===== Check file name =====
+	if (fileName!=NULL && fileName[0]>='0' && fileName[0]<='9')
+		{
+		sequence = (uint64_t)strtoull((char *)fileName, &end, 10);
+		if (end!=NULL && strcmp(end, ".csv")==0)
+			{
+			return sequence;
+			}
+		}
+	return 0;
+	}
+
+
+/**
+ * Write all the data to the file descriptor.<br>
+ *
+ * @param[in] fd			File descriptor
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of data[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_write (const int fd, const M2MString *data, size_t dataLength)
+	{
+	//========== Variable ==========
+	ssize_t length = 0;
+
+	while (dataLength>0)
+		{
+		if ((length=write(fd, data, dataLength))>0)
+			{
+			data += length;
+			dataLength -= (size_t)length;
+			}
+		else if (length<0 && errno==EINTR)
+			{
+			continue;
+			}
+		else
+			{
+			return false;
+			}
+		}
+	return true;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Close the result file opened by CEPCUIPublisher_open().<br>
+ * If committed, the file is renamed into place as the next sequenced file<br>
+ * (and the oldest file is deleted in case of rotation); otherwise it is<br>
+ * discarded.<br>
+ *
+ * @param[in,out] self	Publisher object
+ * @param[in] fd		File descriptor of the temporary result file
+ * @param[in] commit	true : publish the file, false : discard the file
+ * @return				true : published, false : discarded or failure
+ */
+bool CEPCUIPublisher_close (CEPCUIPublisher *self, const int fd, const bool commit)
+	{
+	//========== Variable ==========
+	bool written = commit;
+	M2MString TEMPORARY_FILE_PATH[PATH_MAX];
+	M2MString FILE_PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIPublisher_close()";
+
+	//===== Check argument =====
+	if (self!=NULL && fd>=0)
+		{
+		if (this_getFilePath(self, true, TEMPORARY_FILE_PATH, sizeof(TEMPORARY_FILE_PATH))==NULL
+				|| this_getFilePath(self, false, FILE_PATH, sizeof(FILE_PATH))==NULL)
+			{
+			close(fd);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Path of the result file is too long");
+			return false;
+			}
+		else if (close(fd)!=0)
+			{
+			written = false;
+			}
+		//===== Discard the temporary file =====
+		if (written==false)
+			{
+			if (commit==true)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to write the result file(=\"%s\") : %s", TEMPORARY_FILE_PATH, strerror(errno));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				}
+			unlink((char *)TEMPORARY_FILE_PATH);
+			return false;
+			}
+		//===== Rename into place =====
+		else if (rename((char *)TEMPORARY_FILE_PATH, (char *)FILE_PATH)==0)
+			{
+			self->sequence++;
+			//===== Delete the oldest result file =====
+			if (self->rotating==true && self->sequence>self->depth
+					&& snprintf((char *)FILE_PATH, sizeof(FILE_PATH), "%s/%020llu.csv", self->directoryPath, (unsigned long long)(self->sequence - self->depth))<(int)sizeof(FILE_PATH))
+				{
+				unlink((char *)FILE_PATH);
+				}
+			return true;
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to rename the result file(=\"%s\") : %s", FILE_PATH, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			unlink((char *)TEMPORARY_FILE_PATH);
+			return false;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated publisher object or file descriptor is invalid");
+		return false;
+		}
+	}
+
+
+/**
+ * Release the heap memory of publisher object.<br>
+ *
+ * @param[in,out] self	Publisher object
+ */
+void CEPCUIPublisher_delete (CEPCUIPublisher **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Get the number of result files which can still be published before the<br>
+ * directory reaches its depth.<br>
+ *
+ * @param[in] self	Publisher object
+ * @return			Number of free slots in the directory
+ */
+size_t CEPCUIPublisher_getVacancy (const CEPCUIPublisher *self)
+	{
+	//========== Variable ==========
+	size_t count = 0;
+
+	//===== Rotating publisher never gets full =====
+	if (self!=NULL && self->rotating==true)
+		{
+		return self->depth;
+		}
+	//===== Check argument =====
+	else if (self!=NULL)
+		{
+		count = this_countFile(self);
+		return (count<self->depth) ? (self->depth - count) : 0;
+		}
+	//===== Argument error =====
+	else
+		{
+		return 0;
+		}
+	}
+
+
+/**
+ * Construct new publisher object.<br>
+ * The directory is created if it doesn't exist, and the sequence number<br>
+ * continues from the last result file left in the directory.<br>
+ *
+ * @param[in] directoryPath	Path of the directory where result files are published
+ * @param[in] depth			Maximum number of unconsumed result files in the directory
+ * @return					Created publisher object or NULL (in case of error)
+ */
+CEPCUIPublisher *CEPCUIPublisher_new (const M2MString *directoryPath, const unsigned int depth)
+	{
+	//========== Variable ==========
+	CEPCUIPublisher *self = NULL;
+	DIR *directory = NULL;
+	struct dirent *entry = NULL;
+	uint64_t sequence = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIPublisher_new()";
+
+	//===== Check argument =====
+	if (directoryPath!=NULL && M2MString_length(directoryPath)>0)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUIPublisher *)M2MHeap_malloc(sizeof(CEPCUIPublisher)))!=NULL)
+			{
+			snprintf((char *)self->directoryPath, sizeof(self->directoryPath), "%s", directoryPath);
+			self->depth = (depth>0) ? depth : CEPCUIPublisher_DEFAULT_DEPTH;
+			//===== Create the directory =====
+			if (this_createDirectory(self->directoryPath)==true
+					&& (directory=opendir((char *)self->directoryPath))!=NULL)
+				{
+				//===== Continue from the last sequence number =====
+				while ((entry=readdir(directory))!=NULL)
+					{
+					if ((sequence=this_getSequence((M2MString *)entry->d_name))>self->sequence)
+						{
+						self->sequence = sequence;
+						}
+					}
+				closedir(directory);
+				return self;
+				}
+			//===== Error handling =====
+			else
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the result directory");
+				CEPCUIPublisher_delete(&self);
+				return NULL;
+				}
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for publisher object");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated directory path is NULL or empty");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Open the temporary dot-file of the next sequenced result file, so that a<br>
+ * result can be written to it piece by piece.<br>
+ * The file must be closed with CEPCUIPublisher_close().<br>
+ *
+ * @param[in] self	Publisher object
+ * @return			File descriptor or -1 (in case of error)
+ */
+int CEPCUIPublisher_open (const CEPCUIPublisher *self)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	M2MString TEMPORARY_FILE_PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIPublisher_open()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		if (this_getFilePath(self, true, TEMPORARY_FILE_PATH, sizeof(TEMPORARY_FILE_PATH))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Path of the result file is too long");
+			return -1;
+			}
+		else if ((fd=open((char *)TEMPORARY_FILE_PATH, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))>=0)
+			{
+			return fd;
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to open the result file(=\"%s\") : %s", TEMPORARY_FILE_PATH, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return -1;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated publisher object is NULL");
+		return -1;
+		}
+	}
+
+
+/**
+ * Publish the result data as a new sequenced file in the directory.<br>
+ * The data is written to a temporary dot-file first and renamed, so that<br>
+ * consumers never see a half-written file.<br>
+ *
+ * @param[in,out] self		Publisher object
+ * @param[in] data			Result data string
+ * @param[in] dataLength	Size of result data[Byte]
+ * @return					true : success, false : failure
+ */
+bool CEPCUIPublisher_publish (CEPCUIPublisher *self, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIPublisher_publish()";
+
+	//===== Check argument =====
+	if (self!=NULL && data!=NULL && dataLength>0)
+		{
+		//===== Write to temporary file and rename it =====
+		if ((fd=CEPCUIPublisher_open(self))>=0)
+			{
+			return CEPCUIPublisher_close(self, fd, this_write(fd, data, dataLength));
+			}
+		//===== Error handling =====
+		else
+			{
+			return false;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated publisher object or result data is NULL or empty");
+		return false;
+		}
+	}
+
+
+/**
+ * Set whether the oldest result files are deleted to keep the directory<br>
+ * within its depth (rotation), rather than waiting for the consumer.<br>
+ * When rotation is enabled, the result files already exceeding the depth<br>
+ * are deleted at once.<br>
+ *
+ * @param[in,out] self	Publisher object
+ * @param[in] rotating	true : rotate the result files, false : keep them until consumed
+ * @return				Publisher object or NULL (in case of error)
+ */
+CEPCUIPublisher *CEPCUIPublisher_setRotation (CEPCUIPublisher *self, const bool rotating)
+	{
+	//========== Variable ==========
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIPublisher_setRotation()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		if ((self->rotating=rotating)==true)
+			{
+			this_deleteOldFile(self);
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated publisher object is NULL");
+		return NULL;
+		}
+	}
+
+
+
+/* End Of File */
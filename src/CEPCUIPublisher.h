@@ -0,0 +1,171 @@
+/*******************************************************************************
+ * CEPCUIPublisher.h : Sequenced publication of CEP result files
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIPUBLISHER_H_
+#define CEPCUIPUBLISHER_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Default maximum number of unconsumed result files in the directory
+ */
+#ifndef CEPCUIPublisher_DEFAULT_DEPTH
+#define CEPCUIPublisher_DEFAULT_DEPTH 16
+#endif /* CEPCUIPublisher_DEFAULT_DEPTH */
+
+
+/**
+ * Publisher object which writes result files with sequence numbers into a<br>
+ * directory.<br>
+ * If "rotating" is true, the oldest result files are deleted so that the<br>
+ * directory never holds more than "depth" files, instead of waiting for the<br>
+ * consumer.<br>
+ */
+#ifndef CEPCUIPublisher
+typedef struct
+	{
+	M2MString directoryPath[PATH_MAX];
+	uint64_t sequence;
+	unsigned int depth;
+	bool rotating;
+	} CEPCUIPublisher;
+#endif /* CEPCUIPublisher */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Close the result file opened by CEPCUIPublisher_open().<br>
+ * If committed, the file is renamed into place as the next sequenced file<br>
+ * (and the oldest file is deleted in case of rotation); otherwise it is<br>
+ * discarded.<br>
+ *
+ * @param[in,out] self	Publisher object
+ * @param[in] fd		File descriptor of the temporary result file
+ * @param[in] commit	true : publish the file, false : discard the file
+ * @return				true : published, false : discarded or failure
+ */
+bool CEPCUIPublisher_close (CEPCUIPublisher *self, const int fd, const bool commit);
+
+
+/**
+ * Release the heap memory of publisher object.<br>
+ *
+ * @param[in,out] self	Publisher object
+ */
+void CEPCUIPublisher_delete (CEPCUIPublisher **self);
+
+
+/**
+ * Get the number of result files which can still be published before the<br>
+ * directory reaches its depth.<br>
+ * A rotating publisher always has the full depth of vacancy.<br>
+ *
+ * @param[in] self	Publisher object
+ * @return			Number of free slots in the directory
+ */
+size_t CEPCUIPublisher_getVacancy (const CEPCUIPublisher *self);
+
+
+/**
+ * Construct new publisher object.<br>
+ * The directory is created if it doesn't exist, and the sequence number<br>
+ * continues from the last result file left in the directory.<br>
+ *
+ * @param[in] directoryPath	Path of the directory where result files are published
+ * @param[in] depth			Maximum number of unconsumed result files in the directory
+ * @return					Created publisher object or NULL (in case of error)
+ */
+CEPCUIPublisher *CEPCUIPublisher_new (const M2MString *directoryPath, const unsigned int depth);
+
+
+/**
+ * Open the temporary dot-file of the next sequenced result file, so that a<br>
+ * result can be written to it piece by piece.<br>
+ * The file must be closed with CEPCUIPublisher_close().<br>
+ *
+ * @param[in] self	Publisher object
+ * @return			File descriptor or -1 (in case of error)
+ */
+int CEPCUIPublisher_open (const CEPCUIPublisher *self);
+
+
+/**
+ * Publish the result data as a new sequenced file in the directory.<br>
+ * The data is written to a temporary dot-file first and renamed, so that<br>
+ * consumers never see a half-written file.<br>
+ *
+ * @param[in,out] self		Publisher object
+ * @param[in] data			Result data string
+ * @param[in] dataLength	Size of result data[Byte]
+ * @return					true : success, false : failure
+ */
+bool CEPCUIPublisher_publish (CEPCUIPublisher *self, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Set whether the oldest result files are deleted to keep the directory<br>
+ * within its depth (rotation), rather than waiting for the consumer.<br>
+ * When rotation is enabled, the result files already exceeding the depth<br>
+ * are deleted at once.<br>
+ *
+ * @param[in,out] self	Publisher object
+ * @param[in] rotating	true : rotate the result files, false : keep them until consumed
+ * @return				Publisher object or NULL (in case of error)
+ */
+CEPCUIPublisher *CEPCUIPublisher_setRotation (CEPCUIPublisher *self, const bool rotating);
+
+
+
+#endif /* CEPCUIPUBLISHER_H_ */
@@ -0,0 +1,1416 @@
+/*******************************************************************************
+ * CEPCUIQuerySet.c : Set of named SELECT queries executed on the CEP table
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIQuerySet.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Directory entry read by getdents64 system call (the layout of<br>
+ * "struct linux_dirent64", which is not exposed by libc headers)<br>
+ */
+typedef struct
+	{
+	uint64_t inode;
+	int64_t offset;
+	unsigned short recordLength;
+	unsigned char type;
+	char name[];
+	} CEPCUIQuerySetDirectoryEntry;
+
+
+/**
+ * Growing buffer which receives the result copied by CEPCUIQuerySet_select()<br>
+ * (in the arena, or in heap memory if "arena" is NULL)<br>
+ */
+typedef struct
+	{
+	CEPCUIArena *arena;
+	M2MString *data;
+	size_t length;
+	size_t capacity;
+	} CEPCUIQuerySetResult;
+
+
+/**
+ * Destination of the records formatted by CEPCUIQuerySet_selectEach()<br>
+ * ("records" is the number of the records written so far).<br>
+ */
+typedef struct
+	{
+	CEPCUIQuery *query;
+	M2MString *buffer;
+	size_t bufferLength;
+	size_t length;
+	CEPCUIQuerySet_Writer writer;
+	void *argument;
+	int64_t records;
+	} CEPCUIQuerySetStream;
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Add a query to the set.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] name			Query name string (empty for unnamed query)
+ * @param[in] sql			SQL string (not necessarily NULL terminated)
+ * @param[in] sqlLength		Size of SQL string[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_add (CEPCUIQuerySet *self, const M2MString *name, const M2MString *sql, const size_t sqlLength);
+
+
+/**
+ * Append the data to the result buffer, enlarging the buffer if needed.<br>
+ *
+ * @param[in,out] arena		Arena for the buffer or NULL (in case of heap memory)
+ * @param[in,out] buffer	Result buffer (allocated in this function)
+ * @param[in,out] length	Size of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] data			Data to append
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failed to allocate the buffer
+ */
+static bool this_append (CEPCUIArena *arena, M2MString **buffer, size_t *length, size_t *capacity, const void *data, const size_t dataLength);
+
+
+/**
+ * Append the chunk of result to the growing result buffer (writer of<br>
+ * CEPCUIQuerySet_selectEach() used by CEPCUIQuerySet_select()).<br>
+ *
+ * @param[in,out] argument	Result buffer (CEPCUIQuerySetResult)
+ * @param[in] data			Chunk of result
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : failed to allocate the buffer
+ */
+static bool this_appendResult (void *argument, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Close the record whose fields were written by this_writeField().<br>
+ * In delta mode, the record is written only when it wasn't emitted in the<br>
+ * previous result (prefixed with "+" in case of retraction).<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @return					true : success, false : the writer failed or failed to allocate memory
+ */
+static bool this_closeRecord (CEPCUIQuerySetStream *stream);
+
+
+/**
+ * Get the signature of the query files, which changes whenever<br>
+ * "select.sql", "queries" directory or a file in it is replaced, resized,<br>
+ * or written.<br>
+ *
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					Signature of the query files
+ */
+static uint64_t this_getSignature (const M2MString *directoryPath);
+
+
+/**
+ * Check whether the character can be used in query names.<br>
+ *
+ * @param[in] character	Character
+ * @return				true : available, false : not available
+ */
+static bool this_isNameCharacter (const int character);
+
+
+/**
+ * Check whether the file name is a candidate of query file.<br>
+ *
+ * @param[in] entry	Directory entry
+ * @return			1 : candidate, 0 : ignored
+ */
+static int this_isQueryFile (const struct dirent *entry);
+
+
+/**
+ * Check whether the file name is a candidate of query file.<br>
+ *
+ * @param[in] fileName	File name string
+ * @return				true : candidate, false : ignored
+ */
+static bool this_isQueryFileName (const char *fileName);
+
+
+/**
+ * Add the queries in "queries" directory to the set.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] directoryPath	Path of "queries" directory
+ * @return					Number of added queries
+ */
+static size_t this_loadDirectory (CEPCUIQuerySet *self, const M2MString *directoryPath);
+
+
+/**
+ * Add the statements in "select.sql" to the set.<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] filePath	Path of "select.sql"
+ * @return				Number of added queries
+ */
+static size_t this_loadFile (CEPCUIQuerySet *self, const M2MString *filePath);
+
+
+/**
+ * Mix the status (i-node number, size and modified time) of the file into<br>
+ * the signature with FNV-1a hash.<br>
+ *
+ * @param[in] signature	Signature
+ * @param[in] filePath	File path string
+ * @return				Mixed signature
+ */
+static uint64_t this_mixSignature (uint64_t signature, const M2MString *filePath);
+
+
+/**
+ * Get the query name from a "-- name: xxx" comment line.<br>
+ *
+ * @param[in] comment		Comment string next to "--"
+ * @param[in] commentLength	Size of comment string[Byte]
+ * @param[out] name			Buffer for copying the query name
+ * @return					true : the comment names a query, false : ordinary comment
+ */
+static bool this_parseName (const M2MString *comment, const size_t commentLength, M2MString name[CEPCUIQuerySet_NAME_LENGTH]);
+
+
+/**
+ * Read the whole file into new heap memory.<br>
+ *
+ * @param[in] filePath	File path string
+ * @param[out] data		Pointer for copying the NULL terminated file data (allocated in this function)
+ * @return				Size of file data[Byte] or -1 (in case of error)
+ */
+static ssize_t this_readFile (const M2MString *filePath, M2MString **data);
+
+
+/**
+ * Write the record no longer matched, prefixed with "-" (called back by<br>
+ * CEPCUIDelta_retract()).<br>
+ *
+ * @param[in,out] argument	Destination of the result
+ * @param[in] record		Record emitted in the previous result
+ * @param[in] recordLength	Size of the record[Byte]
+ * @return					true : success, false : the writer failed
+ */
+static bool this_retractRecord (void *argument, const M2MString *record, const size_t recordLength);
+
+
+/**
+ * Write the records of the incremental aggregate in the same CSV format as<br>
+ * the statement of the query.<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @param[in] records		Number of result records of the aggregate (already updated)
+ * @return					true : success, false : the writer failed or failed to allocate memory
+ */
+static bool this_selectAggregate (CEPCUIQuerySetStream *stream, const size_t records);
+
+
+/**
+ * Copy the data into the fixed-size buffer, passing the buffer to the<br>
+ * writer beforehand if the data doesn't fit in it.<br>
+ * Data larger than the whole buffer is passed to the writer directly.<br>
+ *
+ * @param[out] buffer			Buffer for formatting the result
+ * @param[in,out] length		Size of the data in the buffer[Byte]
+ * @param[in] bufferLength		Size of the buffer[Byte]
+ * @param[in] data				Data to write
+ * @param[in] dataLength		Size of the data[Byte]
+ * @param[in] writer			Function which receives the formatted result
+ * @param[in,out] argument		Argument passed to the writer
+ * @return						true : success, false : the writer failed
+ */
+static bool this_write (M2MString buffer[], size_t *length, const size_t bufferLength, const void *data, const size_t dataLength, CEPCUIQuerySet_Writer writer, void *argument);
+
+
+/**
+ * Write a field of the record (preceded by the header line before the<br>
+ * first record). In delta mode, the field is held until the record is<br>
+ * closed, since only new records are written.<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @param[in] column		Index of the column
+ * @param[in] value			Text of the field
+ * @param[in] valueLength	Size of the text[Byte]
+ * @return					true : success, false : the writer failed or failed to allocate memory
+ */
+static bool this_writeField (CEPCUIQuerySetStream *stream, const int column, const void *value, const size_t valueLength);
+
+
+/**
+ * Write the header line of the column names (preceded by "delta" column in<br>
+ * case of retraction).<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @return					true : success, false : the writer failed
+ */
+static bool this_writeHeader (CEPCUIQuerySetStream *stream);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Add a query to the set.<br>
+ * Queries with a duplicate name are rejected, since they would share the<br>
+ * same output.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] name			Query name string (empty for unnamed query)
+ * @param[in] sql			SQL string (not necessarily NULL terminated)
+ * @param[in] sqlLength		Size of SQL string[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_add (CEPCUIQuerySet *self, const M2MString *name, const M2MString *sql, const size_t sqlLength)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	CEPCUIQuery *query = NULL;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet.this_add()";
+
+	//===== Check the number of queries =====
+	if (self->count>=CEPCUIQuerySet_MAX_QUERY)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Too many queries are defined, so the rest are ignored");
+		return false;
+		}
+	//===== Check duplicate name =====
+	for (i=0; i<self->count; i++)
+		{
+		if (M2MString_compareTo(self->queryList[i].name, name)==0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Query name(=\"%s\") is duplicated, so the latter is ignored", name);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return false;
+			}
+		}
+	//===== Copy SQL string =====
+	query = &self->queryList[self->count];
+	if ((query->sql=(M2MString *)M2MHeap_malloc(sqlLength+1))!=NULL)
+		{
+		memcpy(query->sql, sql, sqlLength);
+		snprintf((char *)query->name, sizeof(query->name), "%s", name);
+		self->count++;
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for SQL string");
+		return false;
+		}
+	}
+
+
+/**
+ * Append the data to the result buffer, enlarging the buffer if needed.<br>
+ *
+ * @param[in,out] arena		Arena for the buffer or NULL (in case of heap memory)
+ * @param[in,out] buffer	Result buffer (allocated in this function)
+ * @param[in,out] length	Size of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] data			Data to append
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failed to allocate the buffer
+ */
+static bool this_append (CEPCUIArena *arena, M2MString **buffer, size_t *length, size_t *capacity, const void *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	M2MString *enlarged = NULL;
+	size_t newCapacity = (*capacity);
+
+	//===== Enlarge the buffer (keeping room for NULL terminator) =====
+	if ((*buffer)==NULL || (*length)+dataLength+1>(*capacity))
+		{
+		if (newCapacity<CEPCUIQuerySet_RESULT_BUFFER_LENGTH)
+			{
+			newCapacity = CEPCUIQuerySet_RESULT_BUFFER_LENGTH;
+			}
+		while ((*length)+dataLength+1>newCapacity)
+			{
+			newCapacity *= 2;
+			}
+		//===== Enlarge in the arena (in place if possible) =====
+		if (arena!=NULL)
+			{
+			if ((enlarged=(M2MString *)CEPCUIArena_reallocate(arena, (*buffer), (*length), newCapacity))==NULL)
+				{
+				return false;
+				}
+			}
+		else if ((enlarged=(M2MString *)M2MHeap_malloc(newCapacity))==NULL)
+			{
+			return false;
+			}
+		else if ((*buffer)!=NULL)
+			{
+			memcpy(enlarged, (*buffer), (*length));
+			M2MHeap_free((*buffer));
+			}
+		(*buffer) = enlarged;
+		(*capacity) = newCapacity;
+		}
+	memcpy(&(*buffer)[(*length)], data, dataLength);
+	(*length) += dataLength;
+	return true;
+	}
+
+
+/**
+ * Append the chunk of result to the growing result buffer (writer of<br>
+ * CEPCUIQuerySet_selectEach() used by CEPCUIQuerySet_select()).<br>
+ *
+ * @param[in,out] argument	Result buffer (CEPCUIQuerySetResult)
+ * @param[in] data			Chunk of result
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : failed to allocate the buffer
+ */
+static bool this_appendResult (void *argument, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	CEPCUIQuerySetResult *result = (CEPCUIQuerySetResult *)argument;
+
+	return this_append(result->arena, &result->data, &result->length, &result->capacity, data, dataLength);
+	}
+
+
+/**
+ * Close the record whose fields were written by this_writeField().<br>
+ * In delta mode, the record is written only when it wasn't emitted in the<br>
+ * previous result (prefixed with "+" in case of retraction).<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @return					true : success, false : the writer failed or failed to allocate memory
+ */
+static bool this_closeRecord (CEPCUIQuerySetStream *stream)
+	{
+	//========== Variable ==========
+	CEPCUIDelta *delta = stream->query->delta;
+	const M2MString *record = NULL;
+	size_t recordLength = 0;
+	int added = 0;
+
+	//===== Record of delta mode =====
+	if (delta!=NULL)
+		{
+		if ((added=CEPCUIDelta_add(delta, &record, &recordLength))<=0)
+			{
+			return (added==0);
+			}
+		else if ((stream->records==0 && this_writeHeader(stream)==false)
+				|| (delta->retract==true && this_write(stream->buffer, &stream->length, stream->bufferLength, "+,", 2, stream->writer, stream->argument)==false)
+				|| this_write(stream->buffer, &stream->length, stream->bufferLength, record, recordLength, stream->writer, stream->argument)==false)
+			{
+			return false;
+			}
+		}
+	stream->records++;
+	return this_write(stream->buffer, &stream->length, stream->bufferLength, "\r\n", 2, stream->writer, stream->argument);
+	}
+
+
+/**
+ * Get the signature of the query files, which changes whenever<br>
+ * "select.sql", "queries" directory or a file in it is replaced, resized,<br>
+ * or written.<br>
+ * Since this function is called every cycle, the directory is read into a<br>
+ * buffer on the stack (without allocating memory like scandir()), and the<br>
+ * query files are mixed in regardless of the order of the entries.<br>
+ *
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					Signature of the query files
+ */
+static uint64_t this_getSignature (const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	CEPCUIQuerySetDirectoryEntry *entry = NULL;
+	int directory = -1;
+	long length = 0;
+	long position = 0;
+	uint64_t signature = 14695981039346656037ULL;
+	uint64_t fileSignature = 0;
+	M2MString PATH[PATH_MAX];
+	M2MString DIRECTORY_PATH[PATH_MAX];
+	char BUFFER[4096] __attribute__((aligned(8)));
+
+	//===== "select.sql" =====
+	snprintf((char *)PATH, sizeof(PATH), "%s/%s", directoryPath, CEPCUIQuerySet_SQL_FILE_NAME);
+	signature = this_mixSignature(signature, PATH);
+	//===== "queries" directory and its query files =====
+	snprintf((char *)DIRECTORY_PATH, sizeof(DIRECTORY_PATH), "%s/%s", directoryPath, CEPCUIQuerySet_DIRECTORY_NAME);
+	signature = this_mixSignature(signature, DIRECTORY_PATH);
+	if ((directory=open((char *)DIRECTORY_PATH, O_RDONLY | O_DIRECTORY | O_CLOEXEC))>=0)
+		{
+		while ((length=syscall(SYS_getdents64, directory, BUFFER, sizeof(BUFFER)))>0)
+			{
+			for (position=0; position<length; position+=entry->recordLength)
+				{
+				entry = (CEPCUIQuerySetDirectoryEntry *)&BUFFER[position];
+				if (this_isQueryFileName(entry->name)==true
+						&& snprintf((char *)PATH, sizeof(PATH), "%s/%s", DIRECTORY_PATH, entry->name)<(int)sizeof(PATH))
+					{
+					fileSignature += this_mixSignature(14695981039346656037ULL, PATH);
+					}
+				}
+			}
+		close(directory);
+		}
+	return signature ^ fileSignature;
+	}
+
+
+/**
+ * Check whether the character can be used in query names.<br>
+ *
+ * @param[in] character	Character
+ * @return				true : available, false : not available
+ */
+static bool this_isNameCharacter (const int character)
+	{
+	return (isalnum(character)!=0 || character=='_' || character=='-');
+	}
+
+
+/**
+ * Check whether the file name is a candidate of query file.<br>
+ * Dot-files are ignored, and only files with ".sql" extension are chosen.<br>
+ *
+ * @param[in] entry	Directory entry
+ * @return			1 : candidate, 0 : ignored
+ */
+static int this_isQueryFile (const struct dirent *entry)
+	{
+	return (entry!=NULL && this_isQueryFileName(entry->d_name)==true) ? 1 : 0;
+	}
+
+
+/**
+ * Check whether the file name is a candidate of query file.<br>
+ * Dot-files are ignored, and only files with ".sql" extension are chosen.<br>
+ *
+ * @param[in] fileName	File name string
+ * @return				true : candidate, false : ignored
+ */
+static bool this_isQueryFileName (const char *fileName)
+	{
+	//========== Variable ==========
+	size_t length = 0;
+
+	if (fileName!=NULL && fileName[0]!='.' && (length=strlen(fileName))>4)
+		{
+		return (strcmp(&fileName[length-4], ".sql")==0);
+		}
+	return false;
+	}
+
+
+/**
+ * Add the queries in "queries" directory to the set.<br>
+ * Each "*.sql" file is one query named after the file, and the files are<br>
+ * added in alphabetical order.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] directoryPath	Path of "queries" directory
+ * @return					Number of added queries
+ */
+static size_t this_loadDirectory (CEPCUIQuerySet *self, const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	struct dirent **entryList = NULL;
+	int entryCount = 0;
+	int i = 0;
+	size_t j = 0;
+	size_t count = 0;
+	ssize_t length = 0;
+	M2MString *sql = NULL;
+	M2MString NAME[CEPCUIQuerySet_NAME_LENGTH];
+	M2MString FILE_PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet.this_loadDirectory()";
+
+	//===== Get query files =====
+	if ((entryCount=scandir((char *)directoryPath, &entryList, this_isQueryFile, alphasort))>0)
+		{
+		for (i=0; i<entryCount; i++)
+			{
+			//===== Query name from file name =====
+			memset(NAME, 0, sizeof(NAME));
+			for (j=0; j<sizeof(NAME)-1 && this_isNameCharacter((unsigned char)entryList[i]->d_name[j])==true; j++)
+				{
+				NAME[j] = (M2MString)entryList[i]->d_name[j];
+				}
+			if (strcmp(&entryList[i]->d_name[j], ".sql")!=0)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Query file name(=\"%s\") contains unavailable characters, so it's ignored", entryList[i]->d_name);
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				}
+			//===== Read query file =====
+			else if (snprintf((char *)FILE_PATH, sizeof(FILE_PATH), "%s/%s", directoryPath, entryList[i]->d_name)>0
+					&& (length=this_readFile(FILE_PATH, &sql))>0)
+				{
+				if (this_add(self, NAME, sql, (size_t)length)==true)
+					{
+					count++;
+					}
+				M2MHeap_free(sql);
+				}
+			free(entryList[i]);
+			}
+		free(entryList);
+		}
+	return count;
+	}
+
+
+/**
+ * Add the statements in "select.sql" to the set.<br>
+ * The file is split into statements at semicolons which are outside of<br>
+ * string literals, quoted identifiers and comments.<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] filePath	Path of "select.sql"
+ * @return				Number of added queries
+ */
+static size_t this_loadFile (CEPCUIQuerySet *self, const M2MString *filePath)
+	{
+	//========== Variable ==========
+	M2MString *text = NULL;
+	ssize_t length = 0;
+	size_t i = 0;
+	size_t start = 0;
+	size_t end = 0;
+	size_t first = 0;
+	size_t count = 0;
+	size_t unnamed = 0;
+	bool statement = false;
+	M2MString close = '\0';
+	M2MString NAME[CEPCUIQuerySet_NAME_LENGTH];
+	M2MString PENDING_NAME[CEPCUIQuerySet_NAME_LENGTH];
+	const M2MString *END = NULL;
+
+	//===== Read SQL file =====
+	if ((length=this_readFile(filePath, &text))<=0)
+		{
+		return 0;
+		}
+	first = self->count;
+	memset(PENDING_NAME, 0, sizeof(PENDING_NAME));
+	for (i=0; i<=(size_t)length; i++)
+		{
+		//===== Line comment =====
+		if (i+1<(size_t)length && text[i]=='-' && text[i+1]=='-')
+			{
+			END = (const M2MString *)memchr(&text[i], '\n', (size_t)length-i);
+			end = (END!=NULL) ? (size_t)(END - text) : (size_t)length;
+			//===== Name of the next statement =====
+			if (statement==false)
+				{
+				this_parseName(&text[i+2], end-i-2, PENDING_NAME);
+				}
+			i = end;
+			}
+		//===== Block comment =====
+		else if (i+1<(size_t)length && text[i]=='/' && text[i+1]=='*')
+			{
+			END = (const M2MString *)strstr((char *)&text[i+2], "*/");
+			i = (END!=NULL) ? (size_t)(END - text) + 1 : (size_t)length;
+			}
+		//===== String literal or quoted identifier =====
+		else if (i<(size_t)length && (text[i]=='\'' || text[i]=='"' || text[i]=='`' || text[i]=='['))
+			{
+			if (statement==false)
+				{
+				statement = true;
+				start = i;
+				}
+			close = (text[i]=='[') ? ']' : text[i];
+			END = (const M2MString *)memchr(&text[i+1], close, (size_t)length-i-1);
+			i = (END!=NULL) ? (size_t)(END - text) : (size_t)length;
+			}
+		//===== End of statement =====
+		else if (i==(size_t)length || text[i]==';')
+			{
+			if (statement==true)
+				{
+				//===== Trim trailing white spaces =====
+				for (end=i; end>start && isspace(text[end-1])!=0; end--)
+					{
+					}
+				if (M2MString_length(PENDING_NAME)>0)
+					{
+					memcpy(NAME, PENDING_NAME, sizeof(NAME));
+					}
+				else
+					{
+					snprintf((char *)NAME, sizeof(NAME), "query%zu", self->count - first + 1);
+					unnamed++;
+					}
+				if (this_add(self, NAME, &text[start], end-start)==true)
+					{
+					count++;
+					}
+				statement = false;
+				memset(PENDING_NAME, 0, sizeof(PENDING_NAME));
+				}
+			}
+		//===== Beginning of statement =====
+		else if (statement==false && isspace(text[i])==0)
+			{
+			statement = true;
+			start = i;
+			}
+		}
+	//===== Single unnamed statement (legacy output) =====
+	if (count==1 && unnamed==1)
+		{
+		memset(self->queryList[first].name, 0, sizeof(self->queryList[first].name));
+		}
+	M2MHeap_free(text);
+	return count;
+	}
+
+
+/**
+ * Mix the status (i-node number, size and modified time) of the file into<br>
+ * the signature with FNV-1a hash.<br>
+ *
+ * @param[in] signature	Signature
+ * @param[in] filePath	File path string
+ * @return				Mixed signature
+ */
+static uint64_t this_mixSignature (uint64_t signature, const M2MString *filePath)
+	{
+	//========== Variable ==========
+	struct stat fileStatus;
+	uint64_t fieldList[4];
+	const unsigned char *BYTES = (const unsigned char *)fieldList;
+	size_t i = 0;
+
+	memset(fieldList, 0, sizeof(fieldList));
+	if (stat((char *)filePath, &fileStatus)==0)
+		{
+		fieldList[0] = (uint64_t)fileStatus.st_ino;
+		fieldList[1] = (uint64_t)fileStatus.st_size;
+		fieldList[2] = (uint64_t)fileStatus.st_mtim.tv_sec;
+		fieldList[3] = (uint64_t)fileStatus.st_mtim.tv_nsec;
+		}
+	for (i=0; i<sizeof(fieldList); i++)
+		{
+		signature = (signature ^ BYTES[i]) * 1099511628211ULL;
+		}
+	return signature;
+	}
+
+
+/**
+ * Get the query name from a "-- name: xxx" comment line.<br>
+ *
+ * @param[in] comment		Comment string next to "--"
+ * @param[in] commentLength	Size of comment string[Byte]
+ * @param[out] name			Buffer for copying the query name
+ * @return					true : the comment names a query, false : ordinary comment
+ */
+static bool this_parseName (const M2MString *comment, const size_t commentLength, M2MString name[CEPCUIQuerySet_NAME_LENGTH])
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	size_t length = 0;
+	const M2MString *KEYWORD = (M2MString *)"name:";
+	const size_t KEYWORD_LENGTH = M2MString_length(KEYWORD);
+
+	//===== Skip white spaces =====
+	while (i<commentLength && (comment[i]==' ' || comment[i]=='\t'))
+		{
+		i++;
+		}
+	//===== Check keyword =====
+	if (i+KEYWORD_LENGTH<=commentLength && strncasecmp((char *)&comment[i], (char *)KEYWORD, KEYWORD_LENGTH)==0)
+		{
+		i += KEYWORD_LENGTH;
+		while (i<commentLength && (comment[i]==' ' || comment[i]=='\t'))
+			{
+			i++;
+			}
+		//===== Copy query name =====
+		while (i<commentLength && length<CEPCUIQuerySet_NAME_LENGTH-1 && this_isNameCharacter(comment[i])==true)
+			{
+			name[length++] = comment[i++];
+			}
+		name[length] = '\0';
+		return (length>0);
+		}
+	return false;
+	}
+
+
+/**
+ * Read the whole file into new heap memory.<br>
+ *
+ * @param[in] filePath	File path string
+ * @param[out] data		Pointer for copying the NULL terminated file data (allocated in this function)
+ * @return				Size of file data[Byte] or -1 (in case of error)
+ */
+static ssize_t this_readFile (const M2MString *filePath, M2MString **data)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	struct stat fileStatus;
+	ssize_t length = 0;
+	size_t total = 0;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet.this_readFile()";
+
+	//===== Open the file =====
+	if ((fd=open((char *)filePath, O_RDONLY | O_CLOEXEC))>=0)
+		{
+		if (fstat(fd, &fileStatus)==0
+				&& ((*data)=(M2MString *)M2MHeap_malloc((size_t)fileStatus.st_size+1))!=NULL)
+			{
+			//===== Read whole data =====
+			while (total<(size_t)fileStatus.st_size)
+				{
+				if ((length=read(fd, &(*data)[total], (size_t)fileStatus.st_size-total))>0)
+					{
+					total += (size_t)length;
+					}
+				else if (length<0 && errno==EINTR)
+					{
+					continue;
+					}
+				else
+					{
+					break;
+					}
+				}
+			close(fd);
+			return (ssize_t)total;
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to read the SQL file(=\"%s\")", filePath);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			close(fd);
+			return -1;
+			}
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to open the SQL file(=\"%s\") : %s", filePath, strerror(errno));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		return -1;
+		}
+	}
+
+
+/**
+ * Write the record no longer matched, prefixed with "-" (called back by<br>
+ * CEPCUIDelta_retract()).<br>
+ *
+ * @param[in,out] argument	Destination of the result
+ * @param[in] record		Record emitted in the previous result
+ * @param[in] recordLength	Size of the record[Byte]
+ * @return					true : success, false : the writer failed
+ */
+static bool this_retractRecord (void *argument, const M2MString *record, const size_t recordLength)
+	{
+	//========== Variable ==========
+	CEPCUIQuerySetStream *stream = (CEPCUIQuerySetStream *)argument;
+
+	if ((stream->records==0 && this_writeHeader(stream)==false)
+			|| this_write(stream->buffer, &stream->length, stream->bufferLength, "-,", 2, stream->writer, stream->argument)==false
+			|| this_write(stream->buffer, &stream->length, stream->bufferLength, record, recordLength, stream->writer, stream->argument)==false)
+		{
+		return false;
+		}
+	stream->records++;
+	return this_write(stream->buffer, &stream->length, stream->bufferLength, "\r\n", 2, stream->writer, stream->argument);
+	}
+
+
+/**
+ * Write the records of the incremental aggregate in the same CSV format as<br>
+ * the statement of the query.<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @param[in] records		Number of result records of the aggregate (already updated)
+ * @return					true : success, false : the writer failed or failed to allocate memory
+ */
+static bool this_selectAggregate (CEPCUIQuerySetStream *stream, const size_t records)
+	{
+	//========== Variable ==========
+	const int COLUMN_COUNT = sqlite3_column_count(stream->query->statement);
+	const M2MString *value = NULL;
+	size_t valueLength = 0;
+	size_t record = 0;
+	int column = 0;
+	bool written = true;
+
+	for (record=0; record<records && written==true; record++)
+		{
+		for (column=0; column<COLUMN_COUNT && written==true; column++)
+			{
+			value = CEPCUIAggregate_getText(stream->query->aggregate, record, (size_t)column, &valueLength);
+			written = this_writeField(stream, column, value, valueLength);
+			}
+		written = (written==true && this_closeRecord(stream)==true);
+		}
+	return written;
+	}
+
+
+/**
+ * Copy the data into the fixed-size buffer, passing the buffer to the<br>
+ * writer beforehand if the data doesn't fit in it.<br>
+ * Data larger than the whole buffer is passed to the writer directly.<br>
+ *
+ * @param[out] buffer			Buffer for formatting the result
+ * @param[in,out] length		Size of the data in the buffer[Byte]
+ * @param[in] bufferLength		Size of the buffer[Byte]
+ * @param[in] data				Data to write
+ * @param[in] dataLength		Size of the data[Byte]
+ * @param[in] writer			Function which receives the formatted result
+ * @param[in,out] argument		Argument passed to the writer
+ * @return						true : success, false : the writer failed
+ */
+static bool this_write (M2MString buffer[], size_t *length, const size_t bufferLength, const void *data, const size_t dataLength, CEPCUIQuerySet_Writer writer, void *argument)
+	{
+	//===== Flush the buffer =====
+	if ((*length)+dataLength>bufferLength && (*length)>0)
+		{
+		if (writer(argument, buffer, (*length))==false)
+			{
+			return false;
+			}
+		(*length) = 0;
+		}
+	//===== Pass the large data directly =====
+	if (dataLength>bufferLength)
+		{
+		return writer(argument, data, dataLength);
+		}
+	//===== Copy into the buffer =====
+	else
+		{
+		memcpy(&buffer[(*length)], data, dataLength);
+		(*length) += dataLength;
+		return true;
+		}
+	}
+
+
+/**
+ * Write a field of the record (preceded by the header line before the<br>
+ * first record). In delta mode, the field is held until the record is<br>
+ * closed, since only new records are written.<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @param[in] column		Index of the column
+ * @param[in] value			Text of the field
+ * @param[in] valueLength	Size of the text[Byte]
+ * @return					true : success, false : the writer failed or failed to allocate memory
+ */
+static bool this_writeField (CEPCUIQuerySetStream *stream, const int column, const void *value, const size_t valueLength)
+	{
+	//===== Field of delta mode =====
+	if (stream->query->delta!=NULL)
+		{
+		return (column==0 || CEPCUIDelta_append(stream->query->delta, ",", 1)==true)
+				&& CEPCUIDelta_append(stream->query->delta, value, valueLength)==true;
+		}
+	//===== Header line (only when there is a record) =====
+	else if (column==0 && stream->records==0 && this_writeHeader(stream)==false)
+		{
+		return false;
+		}
+	return (column==0 || this_write(stream->buffer, &stream->length, stream->bufferLength, ",", 1, stream->writer, stream->argument)==true)
+			&& this_write(stream->buffer, &stream->length, stream->bufferLength, value, valueLength, stream->writer, stream->argument)==true;
+	}
+
+
+/**
+ * Write the header line of the column names (preceded by "delta" column in<br>
+ * case of retraction).<br>
+ *
+ * @param[in,out] stream	Destination of the result
+ * @return					true : success, false : the writer failed
+ */
+static bool this_writeHeader (CEPCUIQuerySetStream *stream)
+	{
+	//========== Variable ==========
+	const char *name = NULL;
+	int column = 0;
+	bool written = true;
+
+	if (stream->query->delta!=NULL && stream->query->delta->retract==true)
+		{
+		written = this_write(stream->buffer, &stream->length, stream->bufferLength, "delta,", 6, stream->writer, stream->argument);
+		}
+	for (column=0; column<sqlite3_column_count(stream->query->statement) && written==true; column++)
+		{
+		name = sqlite3_column_name(stream->query->statement, column);
+		written = (column==0 || this_write(stream->buffer, &stream->length, stream->bufferLength, ",", 1, stream->writer, stream->argument)==true)
+				&& this_write(stream->buffer, &stream->length, stream->bufferLength, name, (name!=NULL) ? strlen(name) : 0, stream->writer, stream->argument)==true;
+		}
+	return (written==true && this_write(stream->buffer, &stream->length, stream->bufferLength, "\r\n", 2, stream->writer, stream->argument)==true);
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the prepared statements, SQL strings and heap memory of query<br>
+ * set object.<br>
+ *
+ * @param[in,out] self	Query set object
+ */
+void CEPCUIQuerySet_delete (CEPCUIQuerySet **self)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		for (i=0; i<(*self)->count; i++)
+			{
+			CEPCUIAggregate_delete(&(*self)->queryList[i].aggregate);
+			CEPCUIDelta_delete(&(*self)->queryList[i].delta);
+			sqlite3_finalize((*self)->queryList[i].statement);
+			M2MHeap_free((*self)->queryList[i].sql);
+			}
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Check whether "select.sql" or the files in "queries" directory have been<br>
+ * modified since the query set was loaded (or since the last call which<br>
+ * returned true), so that each modification is reported only once.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					true : modified, false : not modified
+ */
+bool CEPCUIQuerySet_isModified (CEPCUIQuerySet *self, const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	uint64_t signature = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && directoryPath!=NULL)
+		{
+		if ((signature=this_getSignature(directoryPath))!=self->signature)
+			{
+			self->signature = signature;
+			return true;
+			}
+		}
+	return false;
+	}
+
+
+/**
+ * Construct new query set object from the regulation directory.<br>
+ * If "queries" directory contains "*.sql" files, each file is one query<br>
+ * named after the file (e.g. "queries/spike.sql" is named "spike").<br>
+ * Otherwise, "select.sql" is split into statements at semicolons; a<br>
+ * statement preceded by a "-- name: xxx" comment line is named "xxx",<br>
+ * other statements are named "query<N>" after their position (from 1).<br>
+ * If "select.sql" contains only one unnamed statement, its name is empty,<br>
+ * which keeps the behaviour of the single query mode.<br>
+ * Query names may consist of alphanumerics, "_" and "-" only, since they<br>
+ * are used as part of output file names.<br>
+ *
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					Created query set object or NULL (in case of error or no query)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_new (const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	CEPCUIQuerySet *self = NULL;
+	M2MString PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet_new()";
+
+	//===== Check argument =====
+	if (directoryPath!=NULL && M2MString_length(directoryPath)>0)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUIQuerySet *)M2MHeap_malloc(sizeof(CEPCUIQuerySet)))!=NULL)
+			{
+			//===== Signature before loading (a later write is detected) =====
+			self->signature = this_getSignature(directoryPath);
+			//===== Load "queries" directory =====
+			snprintf((char *)PATH, sizeof(PATH), "%s/%s", directoryPath, CEPCUIQuerySet_DIRECTORY_NAME);
+			if (this_loadDirectory(self, PATH)<=0)
+				{
+				//===== Load "select.sql" =====
+				snprintf((char *)PATH, sizeof(PATH), "%s/%s", directoryPath, CEPCUIQuerySet_SQL_FILE_NAME);
+				this_loadFile(self, PATH);
+				}
+			//===== Check the number of queries =====
+			if (self->count>0)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Loaded %zu queries from \"%s\"", self->count, PATH);
+				M2MLogger_info(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				return self;
+				}
+			//===== Error handling =====
+			else
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"No query is defined in the regulation directory");
+				CEPCUIQuerySet_delete(&self);
+				return NULL;
+				}
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for query set object");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated directory path is NULL or empty");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Compile all the queries into prepared statements of the database.<br>
+ * Either all the queries are prepared, or none of them is (in case of<br>
+ * error), so a broken query file never leaves a half-prepared set.<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] database	SQLite3 database which contains the CEP table
+ * @return				Query set object or NULL (in case of error)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_prepare (CEPCUIQuerySet *self, sqlite3 *database)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	size_t j = 0;
+	M2MString MESSAGE[512];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet_prepare()";
+
+	//===== Check argument =====
+	if (self!=NULL && database!=NULL)
+		{
+		for (i=0; i<self->count; i++)
+			{
+			//===== Compile the statement once =====
+			if (sqlite3_prepare_v3(database, (char *)self->queryList[i].sql, -1, SQLITE_PREPARE_PERSISTENT, &self->queryList[i].statement, NULL)!=SQLITE_OK
+					|| self->queryList[i].statement==NULL)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to prepare the query(=\"%s\") : %s", self->queryList[i].name, sqlite3_errmsg(database));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				//===== Release the statements prepared so far =====
+				for (j=0; j<=i; j++)
+					{
+					sqlite3_finalize(self->queryList[j].statement);
+					self->queryList[j].statement = NULL;
+					}
+				return NULL;
+				}
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated query set object or database is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Execute the prepared statement of the query and copy the result into a<br>
+ * CSV format string (a header line of column names and one line per record,<br>
+ * each terminated with CRLF), in the same format as M2MCEP_select().<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] index		Index of the query
+ * @param[in,out] arena	Arena for the result string or NULL (in case of heap memory)
+ * @param[out] result	Pointer for copying the result string (allocated in the arena or heap memory)
+ * @return				Result string or NULL (in case of no record or error)
+ */
+M2MString *CEPCUIQuerySet_select (CEPCUIQuerySet *self, const size_t index, CEPCUIArena *arena, M2MString **result)
+	{
+	//========== Variable ==========
+	CEPCUIQuerySetResult copy = {arena, NULL, 0, 0};
+	M2MString BUFFER[CEPCUIQuerySet_RESULT_BUFFER_LENGTH];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet_select()";
+
+	//===== Check argument =====
+	if (result!=NULL)
+		{
+		//===== Result with records =====
+		if (CEPCUIQuerySet_selectEach(self, index, BUFFER, sizeof(BUFFER), this_appendResult, &copy)>0)
+			{
+			copy.data[copy.length] = '\0';
+			return ((*result)=copy.data);
+			}
+		//===== No record or error =====
+		else
+			{
+			if (arena==NULL)
+				{
+				M2MHeap_free(copy.data);
+				}
+			return ((*result)=NULL);
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated result pointer is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Execute the prepared statement of the query and stream the result in the<br>
+ * same CSV format as CEPCUIQuerySet_select() to the writer.<br>
+ * Records are formatted into the indicated buffer, which is passed to the<br>
+ * writer whenever it fills up (a field larger than the buffer is passed<br>
+ * directly), so the memory usage doesn't depend on the size of the result.<br>
+ * The writer is never called for a query which matches no record.<br>
+ * In delta mode (see CEPCUIQuerySet_setDelta()), only the records which<br>
+ * weren't in the previous result are written (and the records no longer<br>
+ * matched, in case of retraction), and the result is remembered only when<br>
+ * it has been written successfully.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] index			Index of the query
+ * @param[out] buffer		Buffer for formatting the result
+ * @param[in] bufferLength	Size of the buffer[Byte]
+ * @param[in] writer		Function which receives the formatted result
+ * @param[in,out] argument	Argument passed to the writer
+ * @return					Number of records written or -1 (in case of error)
+ */
+int64_t CEPCUIQuerySet_selectEach (CEPCUIQuerySet *self, const size_t index, M2MString buffer[], const size_t bufferLength, CEPCUIQuerySet_Writer writer, void *argument)
+	{
+	//========== Variable ==========
+	CEPCUIQuery *query = NULL;
+	CEPCUIQuerySetStream stream = {NULL, buffer, bufferLength, 0, writer, argument, 0};
+	int columnCount = 0;
+	int column = 0;
+	int status = SQLITE_DONE;
+	int64_t records = 0;
+	bool written = true;
+	const unsigned char *value = NULL;
+	M2MString MESSAGE[512];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet_selectEach()";
+
+	//===== Check argument =====
+	if (self!=NULL && index<self->count && (query=&self->queryList[index])->statement!=NULL
+			&& buffer!=NULL && bufferLength>0 && writer!=NULL)
+		{
+		stream.query = query;
+		//===== Incremental aggregation =====
+		if (query->aggregate!=NULL && (records=CEPCUIAggregate_update(query->aggregate))<0)
+			{
+			//===== Fall back to the statement for good =====
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"The query(=\"%s\") can't be aggregated incrementally any more, so it is executed by SQLite3", query->name);
+			M2MLogger_info(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			CEPCUIAggregate_delete(&query->aggregate);
+			}
+		if (query->aggregate!=NULL)
+			{
+			written = this_selectAggregate(&stream, (size_t)records);
+			}
+		else
+			{
+			columnCount = sqlite3_column_count(query->statement);
+			while (written==true && (status=sqlite3_step(query->statement))==SQLITE_ROW)
+				{
+				for (column=0; column<columnCount && written==true; column++)
+					{
+					value = sqlite3_column_text(query->statement, column);
+					written = this_writeField(&stream, column, value, (value!=NULL) ? (size_t)sqlite3_column_bytes(query->statement, column) : 0);
+					}
+				written = (written==true && this_closeRecord(&stream)==true);
+				}
+			sqlite3_reset(query->statement);
+			}
+		//===== Retract the records no longer matched =====
+		if (written==true && status==SQLITE_DONE && query->delta!=NULL && query->delta->retract==true)
+			{
+			written = (CEPCUIDelta_retract(query->delta, this_retractRecord, &stream)>=0);
+			}
+		//===== Flush the rest of the buffer =====
+		if (written==true && stream.length>0)
+			{
+			written = writer(argument, buffer, stream.length);
+			}
+		//===== Error handling =====
+		if (written==false || status!=SQLITE_DONE)
+			{
+			CEPCUIDelta_rollback(query->delta);
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to execute the query(=\"%s\") : %s", query->name, (written==true) ? sqlite3_errstr(status) : "failed to write the result");
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return -1;
+			}
+		else if (query->delta!=NULL)
+			{
+			CEPCUIDelta_commit(query->delta);
+			}
+		return stream.records;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated query set object, index, buffer or writer is invalid (or the query isn't prepared)");
+		return -1;
+		}
+	}
+
+
+/**
+ * Switch the prepared queries to delta output (or back).<br>
+ * Each query remembers the records of its previous result as a hash set<br>
+ * of the record identities, so that a record already emitted isn't<br>
+ * written again. With retraction, the written records are prefixed with<br>
+ * "+" and the records no longer matched are written with "-" (then the<br>
+ * text of the records is kept too). The remembered result is discarded<br>
+ * whenever this function is called.<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] delta		true : write only the changes of the result, false : write the whole result
+ * @param[in] retract	true : write the records no longer matched too, false : write only the new records
+ * @return				Query set object or NULL (in case of error)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_setDelta (CEPCUIQuerySet *self, const bool delta, const bool retract)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet_setDelta()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		for (i=0; i<self->count; i++)
+			{
+			CEPCUIDelta_delete(&self->queryList[i].delta);
+			if (delta==true && (self->queryList[i].delta=CEPCUIDelta_new(retract))==NULL)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new memory for the delta output");
+				return NULL;
+				}
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated query set object is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Switch the prepared queries to incremental aggregation (or back).<br>
+ * Each query recognized by CEPCUIAggregate_new() keeps running sums,<br>
+ * counts and min/max deques per group, updated with the records inserted<br>
+ * and deleted since the previous cycle, instead of scanning the whole CEP<br>
+ * table every cycle. The other queries are executed as before.<br>
+ *
+ * @param[in,out] self		Query set object (already prepared)
+ * @param[in] incremental	true : aggregate incrementally, false : execute the statements
+ * @return					Query set object or NULL (in case of error)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_setIncremental (CEPCUIQuerySet *self, const bool incremental)
+	{
+	//========== Variable ==========
+	CEPCUIQuery *query = NULL;
+	size_t i = 0;
+	M2MString MESSAGE[512];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQuerySet_setIncremental()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		for (i=0; i<self->count; i++)
+			{
+			query = &self->queryList[i];
+			CEPCUIAggregate_delete(&query->aggregate);
+			if (incremental==true && query->statement!=NULL
+					&& (query->aggregate=CEPCUIAggregate_new(query->statement))!=NULL)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"The query(=\"%s\") is aggregated incrementally", query->name);
+				M2MLogger_info(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				}
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated query set object is NULL");
+		return NULL;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,278 @@
+/*******************************************************************************
+ * CEPCUIQuerySet.h : Set of named SELECT queries executed on the CEP table
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIQUERYSET_H_
+#define CEPCUIQUERYSET_H_
+
+
+
+#include "CEPCUIAggregate.h"
+#include "CEPCUIArena.h"
+#include "CEPCUIDelta.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Name of the SQL file in the regulation directory
+ */
+#ifndef CEPCUIQuerySet_SQL_FILE_NAME
+#define CEPCUIQuerySet_SQL_FILE_NAME (M2MString *)"select.sql"
+#endif /* CEPCUIQuerySet_SQL_FILE_NAME */
+
+
+/**
+ * Name of the directory which contains one SQL file per query
+ */
+#ifndef CEPCUIQuerySet_DIRECTORY_NAME
+#define CEPCUIQuerySet_DIRECTORY_NAME (M2MString *)"queries"
+#endif /* CEPCUIQuerySet_DIRECTORY_NAME */
+
+
+/**
+ * Maximum length of query name (including the terminating NULL)
+ */
+#ifndef CEPCUIQuerySet_NAME_LENGTH
+#define CEPCUIQuerySet_NAME_LENGTH 64
+#endif /* CEPCUIQuerySet_NAME_LENGTH */
+
+
+/**
+ * Maximum number of queries in a set
+ */
+#ifndef CEPCUIQuerySet_MAX_QUERY
+#define CEPCUIQuerySet_MAX_QUERY 256
+#endif /* CEPCUIQuerySet_MAX_QUERY */
+
+
+/**
+ * Initial size of the buffer for a query result[Byte]
+ */
+#ifndef CEPCUIQuerySet_RESULT_BUFFER_LENGTH
+#define CEPCUIQuerySet_RESULT_BUFFER_LENGTH 4096
+#endif /* CEPCUIQuerySet_RESULT_BUFFER_LENGTH */
+
+
+/**
+ * Function which receives the result of a query chunk by chunk.<br>
+ * The chunk is valid only during the call.<br>
+ *
+ * @param[in,out] argument	Argument given to CEPCUIQuerySet_selectEach()
+ * @param[in] data			Chunk of CSV format result (not NULL terminated)
+ * @param[in] dataLength	Size of the chunk[Byte]
+ * @return					true : success, false : abort the query
+ */
+#ifndef CEPCUIQuerySet_Writer
+typedef bool (*CEPCUIQuerySet_Writer) (void *argument, const M2MString *data, const size_t dataLength);
+#endif /* CEPCUIQuerySet_Writer */
+
+
+/**
+ * Named SELECT query.<br>
+ * The name is empty for the only query of a plain "select.sql", whose<br>
+ * result goes to the legacy output file.<br>
+ * The statement is compiled once by CEPCUIQuerySet_prepare() and reused in<br>
+ * every cycle.<br>
+ * The aggregate is set by CEPCUIQuerySet_setIncremental() for a query whose<br>
+ * result is maintained incrementally instead of executing the statement.<br>
+ * The delta is set by CEPCUIQuerySet_setDelta() to remember the previous<br>
+ * result, so that only its changes are written.<br>
+ */
+#ifndef CEPCUIQuery
+typedef struct
+	{
+	M2MString name[CEPCUIQuerySet_NAME_LENGTH];
+	M2MString *sql;
+	sqlite3_stmt *statement;
+	CEPCUIAggregate *aggregate;
+	CEPCUIDelta *delta;
+	} CEPCUIQuery;
+#endif /* CEPCUIQuery */
+
+
+/**
+ * Set of SELECT queries executed on the same CEP table every cycle.<br>
+ */
+#ifndef CEPCUIQuerySet
+typedef struct
+	{
+	CEPCUIQuery queryList[CEPCUIQuerySet_MAX_QUERY];
+	size_t count;
+	uint64_t signature;
+	} CEPCUIQuerySet;
+#endif /* CEPCUIQuerySet */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the prepared statements, SQL strings and heap memory of query<br>
+ * set object.<br>
+ *
+ * @param[in,out] self	Query set object
+ */
+void CEPCUIQuerySet_delete (CEPCUIQuerySet **self);
+
+
+/**
+ * Check whether "select.sql" or the files in "queries" directory have been<br>
+ * modified since the query set was loaded (or since the last call which<br>
+ * returned true), so that each modification is reported only once.<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					true : modified, false : not modified
+ */
+bool CEPCUIQuerySet_isModified (CEPCUIQuerySet *self, const M2MString *directoryPath);
+
+
+/**
+ * Construct new query set object from the regulation directory.<br>
+ * If "queries" directory contains "*.sql" files, each file is one query<br>
+ * named after the file (e.g. "queries/spike.sql" is named "spike").<br>
+ * Otherwise, "select.sql" is split into statements at semicolons; a<br>
+ * statement preceded by a "-- name: xxx" comment line is named "xxx",<br>
+ * other statements are named "query<N>" after their position (from 1).<br>
+ * If "select.sql" contains only one unnamed statement, its name is empty,<br>
+ * which keeps the behaviour of the single query mode.<br>
+ * Query names may consist of alphanumerics, "_" and "-" only, since they<br>
+ * are used as part of output file names.<br>
+ *
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					Created query set object or NULL (in case of error or no query)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_new (const M2MString *directoryPath);
+
+
+/**
+ * Compile all the queries into prepared statements of the database.<br>
+ * Either all the queries are prepared, or none of them is (in case of<br>
+ * error), so a broken query file never leaves a half-prepared set.<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] database	SQLite3 database which contains the CEP table
+ * @return				Query set object or NULL (in case of error)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_prepare (CEPCUIQuerySet *self, sqlite3 *database);
+
+
+/**
+ * Execute the prepared statement of the query and copy the result into a<br>
+ * CSV format string (a header line of column names and one line per record,<br>
+ * each terminated with CRLF), in the same format as M2MCEP_select().<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] index		Index of the query
+ * @param[in,out] arena	Arena for the result string or NULL (in case of heap memory)
+ * @param[out] result	Pointer for copying the result string (allocated in the arena or heap memory)
+ * @return				Result string or NULL (in case of no record or error)
+ */
+M2MString *CEPCUIQuerySet_select (CEPCUIQuerySet *self, const size_t index, CEPCUIArena *arena, M2MString **result);
+
+
+/**
+ * Execute the prepared statement of the query and stream the result in the<br>
+ * same CSV format as CEPCUIQuerySet_select() to the writer.<br>
+ * Records are formatted into the indicated buffer, which is passed to the<br>
+ * writer whenever it fills up (a field larger than the buffer is passed<br>
+ * directly), so the memory usage doesn't depend on the size of the result.<br>
+ * The writer is never called for a query which matches no record.<br>
+ * In delta mode (see CEPCUIQuerySet_setDelta()), only the records which<br>
+ * weren't in the previous result are written (and the records no longer<br>
+ * matched, in case of retraction), and the result is remembered only when<br>
+ * it has been written successfully.<br>
+ * A query with an incremental aggregate is answered from its running state<br>
+ * (falling back to the statement once the state can't reproduce it).<br>
+ *
+ * @param[in,out] self		Query set object
+ * @param[in] index			Index of the query
+ * @param[out] buffer		Buffer for formatting the result
+ * @param[in] bufferLength	Size of the buffer[Byte]
+ * @param[in] writer		Function which receives the formatted result
+ * @param[in,out] argument	Argument passed to the writer
+ * @return					Number of records written or -1 (in case of error)
+ */
+int64_t CEPCUIQuerySet_selectEach (CEPCUIQuerySet *self, const size_t index, M2MString buffer[], const size_t bufferLength, CEPCUIQuerySet_Writer writer, void *argument);
+
+
+/**
+ * Switch the prepared queries to delta output (or back).<br>
+ * Each query remembers the records of its previous result as a hash set<br>
+ * of the record identities, so that a record already emitted isn't<br>
+ * written again. With retraction, the written records are prefixed with<br>
+ * "+" and the records no longer matched are written with "-" (then the<br>
+ * text of the records is kept too). The remembered result is discarded<br>
+ * whenever this function is called.<br>
+ *
+ * @param[in,out] self	Query set object
+ * @param[in] delta		true : write only the changes of the result, false : write the whole result
+ * @param[in] retract	true : write the records no longer matched too, false : write only the new records
+ * @return				Query set object or NULL (in case of error)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_setDelta (CEPCUIQuerySet *self, const bool delta, const bool retract);
+
+
+/**
+ * Switch the prepared queries to incremental aggregation (or back).<br>
+ * Each query recognized by CEPCUIAggregate_new() keeps running sums,<br>
+ * counts and min/max deques per group, updated with the records inserted<br>
+ * and deleted since the previous cycle, instead of scanning the whole CEP<br>
+ * table every cycle. The other queries are executed as before.<br>
+ *
+ * @param[in,out] self		Query set object (already prepared)
+ * @param[in] incremental	true : aggregate incrementally, false : execute the statements
+ * @return					Query set object or NULL (in case of error)
+ */
+CEPCUIQuerySet *CEPCUIQuerySet_setIncremental (CEPCUIQuerySet *self, const bool incremental);
+
+
+
+#endif /* CEPCUIQUERYSET_H_ */
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * CEPCUIQueue.c : Bounded single-producer single-consumer queue between threads
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIQueue.h"
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the heap memory of queue object.<br>
+ * The items left in the queue are not released.<br>
+ *
+ * @param[in,out] self	Queue object
+ */
+void CEPCUIQueue_delete (CEPCUIQueue **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		sem_destroy(&(*self)->itemCount);
+		sem_destroy(&(*self)->slotCount);
+		M2MHeap_free((*self)->slotList);
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Check whether the queue has no item.<br>
+ *
+ * @param[in] self	Queue object
+ * @return			true : the queue is empty, false : the queue has items
+ */
+bool CEPCUIQueue_isEmpty (CEPCUIQueue *self)
+	{
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		return (atomic_load_explicit(&self->head, memory_order_acquire)==atomic_load_explicit(&self->tail, memory_order_acquire));
+		}
+	else
+		{
+		return true;
+		}
+	}
+
+
+/**
+ * Construct new queue object.<br>
+ *
+ * @param[in] capacity	Maximum number of items in the queue
+ * @return				Created queue object or NULL (in case of error)
+ */
+CEPCUIQueue *CEPCUIQueue_new (const size_t capacity)
+	{
+	//========== Variable ==========
+	CEPCUIQueue *self = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQueue_new()";
+
+	//===== Check argument =====
+	if (capacity>0 && capacity<=SEM_VALUE_MAX)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUIQueue *)M2MHeap_malloc(sizeof(CEPCUIQueue)))!=NULL
+				&& (self->slotList=(void **)M2MHeap_malloc(sizeof(void *) * capacity))!=NULL)
+			{
+			self->capacity = capacity;
+			atomic_init(&self->head, 0);
+			atomic_init(&self->tail, 0);
+			sem_init(&self->itemCount, 0, 0);
+			sem_init(&self->slotCount, 0, (unsigned int)capacity);
+			return self;
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for queue object");
+			M2MHeap_free(self);
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated capacity is 0 or too large");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Take out the oldest item of the queue (called only by the consumer).<br>
+ * If the queue is empty, wait for an item up to the indicated time.<br>
+ *
+ * @param[in,out] self	Queue object
+ * @param[in] timeout	Maximum waiting time[usec] (0 : don't wait)
+ * @return				Item or NULL (in case of timeout)
+ */
+void *CEPCUIQueue_pop (CEPCUIQueue *self, const unsigned long timeout)
+	{
+	//========== Variable ==========
+	struct timespec deadline;
+	size_t head = 0;
+	void *item = NULL;
+	int result = 0;
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		//===== Wait for an item =====
+		if ((result=sem_trywait(&self->itemCount))!=0 && timeout>0)
+			{
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += (time_t)(timeout / 1000000UL);
+			deadline.tv_nsec += (long)(timeout % 1000000UL) * 1000L;
+			if (deadline.tv_nsec>=1000000000L)
+				{
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000L;
+				}
+			while ((result=sem_timedwait(&self->itemCount, &deadline))!=0 && errno==EINTR)
+				{
+				}
+			}
+		//===== Take out the item =====
+		if (result==0)
+			{
+			head = atomic_load_explicit(&self->head, memory_order_relaxed);
+			item = self->slotList[head%self->capacity];
+			atomic_store_explicit(&self->head, head + 1, memory_order_release);
+			sem_post(&self->slotCount);
+			}
+		}
+	return item;
+	}
+
+
+/**
+ * Put the item into the queue (called only by the producer).<br>
+ * If the queue is full, wait until the consumer takes out an item.<br>
+ *
+ * @param[in,out] self	Queue object
+ * @param[in] item		Item (not NULL)
+ * @return				true : success, false : failure
+ */
+bool CEPCUIQueue_push (CEPCUIQueue *self, void *item)
+	{
+	//========== Variable ==========
+	size_t tail = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIQueue_push()";
+
+	//===== Check argument =====
+	if (self!=NULL && item!=NULL)
+		{
+		//===== Wait for a free slot =====
+		while (sem_wait(&self->slotCount)!=0 && errno==EINTR)
+			{
+			}
+		//===== Put the item =====
+		tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+		self->slotList[tail%self->capacity] = item;
+		atomic_store_explicit(&self->tail, tail + 1, memory_order_release);
+		sem_post(&self->itemCount);
+		return true;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated queue object or item is NULL");
+		return false;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,127 @@
+/*******************************************************************************
+ * CEPCUIQueue.h : Bounded single-producer single-consumer queue between threads
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIQUEUE_H_
+#define CEPCUIQUEUE_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <errno.h>
+#include <limits.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Bounded queue which passes pointers from exactly one producer thread to<br>
+ * exactly one consumer thread.<br>
+ * The ring buffer itself is lock-free (each index is written by only one<br>
+ * side); the semaphores are only used to sleep while the queue is empty or<br>
+ * full, and don't enter the kernel as long as neither side is waiting.<br>
+ */
+#ifndef CEPCUIQueue
+typedef struct
+	{
+	void **slotList;
+	size_t capacity;
+	atomic_size_t head;
+	atomic_size_t tail;
+	sem_t itemCount;
+	sem_t slotCount;
+	} CEPCUIQueue;
+#endif /* CEPCUIQueue */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the heap memory of queue object.<br>
+ * The items left in the queue are not released.<br>
+ *
+ * @param[in,out] self	Queue object
+ */
+void CEPCUIQueue_delete (CEPCUIQueue **self);
+
+
+/**
+ * Check whether the queue has no item.<br>
+ *
+ * @param[in] self	Queue object
+ * @return			true : the queue is empty, false : the queue has items
+ */
+bool CEPCUIQueue_isEmpty (CEPCUIQueue *self);
+
+
+/**
+ * Construct new queue object.<br>
+ *
+ * @param[in] capacity	Maximum number of items in the queue
+ * @return				Created queue object or NULL (in case of error)
+ */
+CEPCUIQueue *CEPCUIQueue_new (const size_t capacity);
+
+
+/**
+ * Take out the oldest item of the queue (called only by the consumer).<br>
+ * If the queue is empty, wait for an item up to the indicated time.<br>
+ *
+ * @param[in,out] self	Queue object
+ * @param[in] timeout	Maximum waiting time[usec] (0 : don't wait)
+ * @return				Item or NULL (in case of timeout)
+ */
+void *CEPCUIQueue_pop (CEPCUIQueue *self, const unsigned long timeout);
+
+
+/**
+ * Put the item into the queue (called only by the producer).<br>
+ * If the queue is full, wait until the consumer takes out an item.<br>
+ *
+ * @param[in,out] self	Queue object
+ * @param[in] item		Item (not NULL)
+ * @return				true : success, false : failure
+ */
+bool CEPCUIQueue_push (CEPCUIQueue *self, void *item);
+
+
+
+#endif /* CEPCUIQUEUE_H_ */
@@ -0,0 +1,560 @@
+/*******************************************************************************
+ * CEPCUIRing.c : Shared memory ring buffer which receives records from producers
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIRing.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Round up the length to the alignment of the entries.<br>
+ *
+ * @param[in] length	Length[Byte]
+ * @return				Aligned length[Byte]
+ */
+static uint64_t this_align (const uint64_t length);
+
+
+/**
+ * Acquire the lock which serializes the producers.<br>
+ *
+ * @param[in,out] header	Header of the shared memory
+ */
+static void this_lock (CEPCUIRingHeader *header);
+
+
+/**
+ * Map the shared memory object into the ring buffer object.<br>
+ *
+ * @param[in,out] self	Ring buffer object
+ * @param[in] fd		File descriptor of the shared memory object
+ * @param[in] length	Size of the shared memory object[Byte]
+ * @return				true : success, false : failure
+ */
+static bool this_map (CEPCUIRing *self, const int fd, const size_t length);
+
+
+/**
+ * Release the lock which serializes the producers.<br>
+ *
+ * @param[in,out] header	Header of the shared memory
+ */
+static void this_unlock (CEPCUIRingHeader *header);
+
+
+/**
+ * Sleep on the futex while it holds the indicated value.<br>
+ *
+ * @param[in] address	Address of the futex in the shared memory
+ * @param[in] value		Value of the futex which was checked before sleeping
+ * @param[in] timeout	Maximum waiting time[msec] (negative : infinite)
+ */
+static void this_wait (_Atomic uint32_t *address, const uint32_t value, const long timeout);
+
+
+/**
+ * Wake up the processes sleeping on the futex.<br>
+ *
+ * @param[in] address	Address of the futex in the shared memory
+ * @param[in] count		Maximum number of woken processes
+ */
+static void this_wake (_Atomic uint32_t *address, const int count);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Round up the length to the alignment of the entries.<br>
+ *
+ * @param[in] length	Length[Byte]
+ * @return				Aligned length[Byte]
+ */
+static uint64_t this_align (const uint64_t length)
+	{
+	return (length + CEPCUIRing_ALIGNMENT - 1) / CEPCUIRing_ALIGNMENT * CEPCUIRing_ALIGNMENT;
+	}
+
+
+/**
+ * Acquire the lock which serializes the producers.<br>
+ * The lock word is 0 (unlocked), 1 (locked) or 2 (locked with waiters),<br>
+ * so that an uncontended lock never enters the kernel.<br>
+ *
+ * @param[in,out] header	Header of the shared memory
+ */
+static void this_lock (CEPCUIRingHeader *header)
+	{
+	//========== Variable ==========
+	uint32_t state = 0;
+
+	//===== Contended =====
+	if (atomic_compare_exchange_strong(&header->lock, &state, 1)==false)
+		{
+		if (state!=2)
+			{
+			state = atomic_exchange(&header->lock, 2);
+			}
+		while (state!=0)
+			{
+			this_wait(&header->lock, 2, -1);
+			state = atomic_exchange(&header->lock, 2);
+			}
+		}
+	return;
+	}
+
+
+/**
+ * Map the shared memory object into the ring buffer object.<br>
+ *
+ * @param[in,out] self	Ring buffer object
+ * @param[in] fd		File descriptor of the shared memory object
+ * @param[in] length	Size of the shared memory object[Byte]
+ * @return				true : success, false : failure
+ */
+static bool this_map (CEPCUIRing *self, const int fd, const size_t length)
+	{
+	//========== Variable ==========
+	void *mapping = NULL;
+
+	//===== Map the whole object =====
+	if ((mapping=mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0))!=MAP_FAILED)
+		{
+		self->header = (CEPCUIRingHeader *)mapping;
+		self->data = (unsigned char *)mapping + CEPCUIRing_DATA_OFFSET;
+		self->mappingLength = length;
+		return true;
+		}
+	else
+		{
+		return false;
+		}
+	}
+
+
+/**
+ * Release the lock which serializes the producers.<br>
+ *
+ * @param[in,out] header	Header of the shared memory
+ */
+static void this_unlock (CEPCUIRingHeader *header)
+	{
+	//===== Wake up a waiter =====
+	if (atomic_fetch_sub(&header->lock, 1)!=1)
+		{
+		atomic_store(&header->lock, 0);
+		this_wake(&header->lock, 1);
+		}
+	return;
+	}
+
+
+/**
+ * Sleep on the futex while it holds the indicated value.<br>
+ * The futex is not private, since it is shared among the processes.<br>
+ *
+ * @param[in] address	Address of the futex in the shared memory
+ * @param[in] value		Value of the futex which was checked before sleeping
+ * @param[in] timeout	Maximum waiting time[msec] (negative : infinite)
+ */
+static void this_wait (_Atomic uint32_t *address, const uint32_t value, const long timeout)
+	{
+	//========== Variable ==========
+	struct timespec time;
+
+	//===== Sleep =====
+	time.tv_sec = timeout / 1000;
+	time.tv_nsec = (timeout % 1000) * 1000000;
+	syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT, value, (timeout<0) ? NULL : &time, NULL, 0);
+	return;
+	}
+
+
+/**
+ * Wake up the processes sleeping on the futex.<br>
+ *
+ * @param[in] address	Address of the futex in the shared memory
+ * @param[in] count		Maximum number of woken processes
+ */
+static void this_wake (_Atomic uint32_t *address, const int count)
+	{
+	syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE, count, NULL, NULL, 0);
+	return;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Unmap the shared memory opened by a producer and release the heap<br>
+ * memory of ring buffer object.<br>
+ *
+ * @param[in,out] self	Ring buffer object
+ */
+void CEPCUIRing_close (CEPCUIRing **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		if ((*self)->header!=NULL)
+			{
+			munmap((*self)->header, (*self)->mappingLength);
+			}
+		free((*self));
+		(*self) = NULL;
+		}
+	return;
+	}
+
+
+/**
+ * Unmap and remove the shared memory created by the consumer and release<br>
+ * the heap memory of ring buffer object.<br>
+ *
+ * @param[in,out] self	Ring buffer object
+ */
+void CEPCUIRing_delete (CEPCUIRing **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		if ((*self)->owner==true)
+			{
+			shm_unlink((char *)(*self)->name);
+			}
+		CEPCUIRing_close(self);
+		}
+	return;
+	}
+
+
+/**
+ * Construct new ring buffer object as the consumer: the shared memory<br>
+ * object is created (replacing the one left by a dead consumer) and<br>
+ * initialized.<br>
+ *
+ * @param[in] name		Name of the shared memory object (e.g. "/cepcui")
+ * @param[in] capacity	Size of the data area[Byte] (rounded up to the alignment)
+ * @return				Created ring buffer object or NULL (in case of error, with errno)
+ */
+CEPCUIRing *CEPCUIRing_new (const char *name, const size_t capacity)
+	{
+	//========== Variable ==========
+	CEPCUIRing *self = NULL;
+	int fd = -1;
+	int error = 0;
+	const uint64_t CAPACITY = this_align(capacity);
+
+	//===== Check argument =====
+	if (name!=NULL && name[0]=='/' && strlen(name)<NAME_MAX && capacity>=CEPCUIRing_ALIGNMENT*2)
+		{
+		if ((self=(CEPCUIRing *)calloc(1, sizeof(CEPCUIRing)))==NULL)
+			{
+			return NULL;
+			}
+		memcpy(self->name, name, strlen(name));
+		//===== Create the shared memory object =====
+		shm_unlink(name);
+		if ((fd=shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600))<0
+				|| ftruncate(fd, (off_t)(CEPCUIRing_DATA_OFFSET + CAPACITY))!=0
+				|| this_map(self, fd, (size_t)(CEPCUIRing_DATA_OFFSET + CAPACITY))==false)
+			{
+			error = errno;
+			if (fd>=0)
+				{
+				close(fd);
+				shm_unlink(name);
+				}
+			CEPCUIRing_close(&self);
+			errno = error;
+			return NULL;
+			}
+		close(fd);
+		self->owner = true;
+		//===== Initialize the header (the magic number comes last) =====
+		self->header->version = CEPCUIRing_VERSION;
+		self->header->capacity = CAPACITY;
+		atomic_store(&self->header->head, 0);
+		atomic_store(&self->header->tail, 0);
+		atomic_store_explicit((_Atomic uint32_t *)&self->header->magic, CEPCUIRing_MAGIC, memory_order_release);
+		return self;
+		}
+	//===== Argument error (the name doesn't start with "/" or is too long, or capacity is too small) =====
+	else
+		{
+		errno = EINVAL;
+		return NULL;
+		}
+	}
+
+
+/**
+ * Construct new ring buffer object as a producer by mapping the shared<br>
+ * memory object created by the consumer.<br>
+ * This function, CEPCUIRing_write() and CEPCUIRing_close() make the<br>
+ * producer library ("libcepcuiring.a"):<br>
+ *<br>
+ * CEPCUIRing *ring = CEPCUIRing_open("/cepcui");<br>
+ * CEPCUIRing_write(ring, false, csv, csvLength, 1000);<br>
+ * CEPCUIRing_close(&ring);<br>
+ *
+ * @param[in] name	Name of the shared memory object
+ * @return			Created ring buffer object or NULL (in case of error, with errno)
+ */
+CEPCUIRing *CEPCUIRing_open (const char *name)
+	{
+	//========== Variable ==========
+	CEPCUIRing *self = NULL;
+	struct stat status;
+	int fd = -1;
+	int error = 0;
+
+	//===== Check argument =====
+	if (name!=NULL && strlen(name)<NAME_MAX)
+		{
+		if ((self=(CEPCUIRing *)calloc(1, sizeof(CEPCUIRing)))==NULL)
+			{
+			return NULL;
+			}
+		memcpy(self->name, name, strlen(name));
+		//===== Map the shared memory object =====
+		if ((fd=shm_open(name, O_RDWR, 0))<0
+				|| fstat(fd, &status)!=0
+				|| (status.st_size<CEPCUIRing_DATA_OFFSET && (errno=EPROTO)!=0)
+				|| this_map(self, fd, (size_t)status.st_size)==false)
+			{
+			error = errno;
+			if (fd>=0)
+				{
+				close(fd);
+				}
+			CEPCUIRing_close(&self);
+			errno = error;
+			return NULL;
+			}
+		close(fd);
+		//===== Check the layout (not a ring buffer of this version) =====
+		if (atomic_load_explicit((_Atomic uint32_t *)&self->header->magic, memory_order_acquire)!=CEPCUIRing_MAGIC
+				|| self->header->version!=CEPCUIRing_VERSION
+				|| CEPCUIRing_DATA_OFFSET+self->header->capacity>self->mappingLength)
+			{
+			CEPCUIRing_close(&self);
+			errno = EPROTO;
+			return NULL;
+			}
+		return self;
+		}
+	//===== Argument error (the name is NULL or too long) =====
+	else
+		{
+		errno = EINVAL;
+		return NULL;
+		}
+	}
+
+
+/**
+ * Wait until entries are published (or the timeout) and pass the records<br>
+ * of all the published entries to the receiver, in place in the shared<br>
+ * memory. The space of each entry is released to the producers after the<br>
+ * receiver returns.<br>
+ *
+ * @param[in,out] self		Ring buffer object (consumer)
+ * @param[in] timeout		Maximum waiting time[msec]
+ * @param[in] receiver		Function which receives the records
+ * @param[in,out] argument	Argument given to the receiver
+ * @return					Number of received entries or -1 (in case of error, with errno)
+ */
+int64_t CEPCUIRing_receive (CEPCUIRing *self, const int timeout, CEPCUIRing_Receiver receiver, void *argument)
+	{
+	//========== Variable ==========
+	CEPCUIRingHeader *header = NULL;
+	uint64_t head = 0;
+	uint64_t tail = 0;
+	uint64_t offset = 0;
+	uint32_t signal = 0;
+	uint32_t ENTRY[2];
+	int64_t entries = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && self->owner==true && receiver!=NULL)
+		{
+		header = self->header;
+		tail = atomic_load_explicit(&header->tail, memory_order_relaxed);
+		signal = atomic_load_explicit(&header->dataSignal, memory_order_acquire);
+		//===== Sleep until an entry is published =====
+		if ((head=atomic_load_explicit(&header->head, memory_order_acquire))==tail)
+			{
+			atomic_store(&header->consumerWaiting, 1);
+			if ((head=atomic_load(&header->head))==tail)
+				{
+				this_wait(&header->dataSignal, signal, timeout);
+				}
+			atomic_store(&header->consumerWaiting, 0);
+			head = atomic_load_explicit(&header->head, memory_order_acquire);
+			}
+		//===== Consume the entries in place =====
+		while (tail<head)
+			{
+			offset = tail % header->capacity;
+			memcpy(ENTRY, &self->data[offset], sizeof(ENTRY));
+			if ((ENTRY[1]!=CEPCUIRing_ENTRY_CSV && ENTRY[1]!=CEPCUIRing_ENTRY_BINARY && ENTRY[1]!=CEPCUIRing_ENTRY_PADDING)
+					|| ENTRY[0]>header->capacity-offset-sizeof(ENTRY))
+				{
+				//===== Broken entry (the published entries are discarded) =====
+				atomic_store_explicit(&header->tail, head, memory_order_release);
+				errno = EBADMSG;
+				return -1;
+				}
+			else if (ENTRY[1]!=CEPCUIRing_ENTRY_PADDING)
+				{
+				receiver(argument, ENTRY[1]==CEPCUIRing_ENTRY_BINARY, &self->data[offset+sizeof(ENTRY)], ENTRY[0]);
+				entries++;
+				}
+			tail += this_align(sizeof(ENTRY) + ENTRY[0]);
+			//===== Release the space =====
+			atomic_store_explicit(&header->tail, tail, memory_order_release);
+			atomic_fetch_add(&header->spaceSignal, 1);
+			if (atomic_load(&header->producerWaiting)!=0)
+				{
+				this_wake(&header->spaceSignal, INT_MAX);
+				}
+			}
+		return entries;
+		}
+	//===== Argument error (the ring buffer isn't the consumer, or receiver is NULL) =====
+	else
+		{
+		errno = EINVAL;
+		return -1;
+		}
+	}
+
+
+/**
+ * Write the records into the ring buffer as one entry and wake up the<br>
+ * consumer. Several producers can write into the same ring buffer.<br>
+ * If the ring buffer is full, this function waits for the consumer to<br>
+ * release space until the timeout.<br>
+ *
+ * @param[in,out] self		Ring buffer object (producer)
+ * @param[in] binary		true : typed binary records, false : CSV format records
+ * @param[in] data			Records
+ * @param[in] dataLength	Size of the records[Byte] (at most a half of the capacity)
+ * @param[in] timeout		Maximum waiting time for space[msec]
+ * @return					true : success, false : timeout (errno is ETIMEDOUT) or error (with errno)
+ */
+bool CEPCUIRing_write (CEPCUIRing *self, const bool binary, const void *data, const size_t dataLength, const int timeout)
+	{
+	//========== Variable ==========
+	CEPCUIRingHeader *header = NULL;
+	uint64_t head = 0;
+	uint64_t offset = 0;
+	uint64_t padding = 0;
+	uint64_t entryLength = 0;
+	uint32_t signal = 0;
+	uint32_t ENTRY[2];
+	long elapsed = 0;
+	struct timespec start;
+	struct timespec now;
+
+	//===== Check argument =====
+	if (self!=NULL && data!=NULL && dataLength>0 && this_align(sizeof(ENTRY) + dataLength)<=self->header->capacity/2)
+		{
+		header = self->header;
+		entryLength = this_align(sizeof(ENTRY) + dataLength);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		this_lock(header);
+		//===== Wait for the space (the end of the data area is skipped if too short) =====
+		while (true)
+			{
+			head = atomic_load_explicit(&header->head, memory_order_relaxed);
+			offset = head % header->capacity;
+			padding = (header->capacity-offset<entryLength) ? header->capacity - offset : 0;
+			signal = atomic_load_explicit(&header->spaceSignal, memory_order_acquire);
+			if (head+padding+entryLength-atomic_load_explicit(&header->tail, memory_order_acquire)<=header->capacity)
+				{
+				break;
+				}
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			if ((elapsed=(now.tv_sec - start.tv_sec) * 1000L + (now.tv_nsec - start.tv_nsec) / 1000000L)>=timeout)
+				{
+				atomic_store(&header->producerWaiting, 0);
+				this_unlock(header);
+				errno = ETIMEDOUT;
+				return false;
+				}
+			atomic_store(&header->producerWaiting, 1);
+			if (head+padding+entryLength-atomic_load(&header->tail)>header->capacity)
+				{
+				this_wait(&header->spaceSignal, signal, timeout-elapsed);
+				}
+			}
+		atomic_store(&header->producerWaiting, 0);
+		//===== Padding entry =====
+		if (padding>0)
+			{
+			ENTRY[0] = (uint32_t)(padding - sizeof(ENTRY));
+			ENTRY[1] = CEPCUIRing_ENTRY_PADDING;
+			memcpy(&self->data[offset], ENTRY, sizeof(ENTRY));
+			head += padding;
+			offset = 0;
+			}
+		//===== Entry =====
+		ENTRY[0] = (uint32_t)dataLength;
+		ENTRY[1] = (binary==true) ? CEPCUIRing_ENTRY_BINARY : CEPCUIRing_ENTRY_CSV;
+		memcpy(&self->data[offset], ENTRY, sizeof(ENTRY));
+		memcpy(&self->data[offset+sizeof(ENTRY)], data, dataLength);
+		//===== Publish the entry and wake up the consumer =====
+		atomic_store_explicit(&header->head, head+entryLength, memory_order_release);
+		this_unlock(header);
+		atomic_fetch_add(&header->dataSignal, 1);
+		if (atomic_load(&header->consumerWaiting)!=0)
+			{
+			this_wake(&header->dataSignal, 1);
+			}
+		return true;
+		}
+	//===== Argument error (the ring buffer or records is NULL, or records are too large) =====
+	else
+		{
+		errno = (self!=NULL && data!=NULL && dataLength>0) ? EMSGSIZE : EINVAL;
+		return false;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,276 @@
+/*******************************************************************************
+ * CEPCUIRing.h : Shared memory ring buffer which receives records from producers
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUIRING_H_
+#define CEPCUIRING_H_
+
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Magic number at the top of the shared memory ("CEPR" in little endian)
+ */
+#ifndef CEPCUIRing_MAGIC
+#define CEPCUIRing_MAGIC 0x52504543U
+#endif /* CEPCUIRing_MAGIC */
+
+
+/**
+ * Version of the shared memory layout
+ */
+#ifndef CEPCUIRing_VERSION
+#define CEPCUIRing_VERSION 1U
+#endif /* CEPCUIRing_VERSION */
+
+
+/**
+ * Default name of the POSIX shared memory object
+ */
+#ifndef CEPCUIRing_DEFAULT_NAME
+#define CEPCUIRing_DEFAULT_NAME "/cepcui"
+#endif /* CEPCUIRing_DEFAULT_NAME */
+
+
+/**
+ * Default size of the data area of the ring buffer[Byte]
+ */
+#ifndef CEPCUIRing_DEFAULT_CAPACITY
+#define CEPCUIRing_DEFAULT_CAPACITY 67108864
+#endif /* CEPCUIRing_DEFAULT_CAPACITY */
+
+
+/**
+ * Offset of the data area from the top of the shared memory[Byte]
+ */
+#ifndef CEPCUIRing_DATA_OFFSET
+#define CEPCUIRing_DATA_OFFSET 4096
+#endif /* CEPCUIRing_DATA_OFFSET */
+
+
+/**
+ * Alignment of the entries in the data area[Byte]
+ */
+#ifndef CEPCUIRing_ALIGNMENT
+#define CEPCUIRing_ALIGNMENT 8
+#endif /* CEPCUIRing_ALIGNMENT */
+
+
+/**
+ * Entry type of CSV format records
+ */
+#ifndef CEPCUIRing_ENTRY_CSV
+#define CEPCUIRing_ENTRY_CSV 'C'
+#endif /* CEPCUIRing_ENTRY_CSV */
+
+
+/**
+ * Entry type of typed binary records (in the format of input.bin)
+ */
+#ifndef CEPCUIRing_ENTRY_BINARY
+#define CEPCUIRing_ENTRY_BINARY 'B'
+#endif /* CEPCUIRing_ENTRY_BINARY */
+
+
+/**
+ * Entry type of the padding which skips the end of the data area
+ */
+#ifndef CEPCUIRing_ENTRY_PADDING
+#define CEPCUIRing_ENTRY_PADDING 'P'
+#endif /* CEPCUIRing_ENTRY_PADDING */
+
+
+/**
+ * Function which receives the records of an entry.<br>
+ * The records point into the shared memory and are valid only during the<br>
+ * call.<br>
+ *
+ * @param[in,out] argument	Argument given to CEPCUIRing_receive()
+ * @param[in] binary		true : typed binary records, false : CSV format records
+ * @param[in] data			Records (not NULL terminated)
+ * @param[in] dataLength	Size of the records[Byte]
+ * @return					true : success, false : failure (the entry is consumed anyway)
+ */
+#ifndef CEPCUIRing_Receiver
+typedef bool (*CEPCUIRing_Receiver) (void *argument, const bool binary, const unsigned char *data, const size_t dataLength);
+#endif /* CEPCUIRing_Receiver */
+
+
+/**
+ * Header at the top of the shared memory.<br>
+ * The data area of "capacity" bytes starts at CEPCUIRing_DATA_OFFSET.<br>
+ * "head" and "tail" are the total numbers of bytes ever written and<br>
+ * consumed, so that the entry starts at "tail % capacity".<br>
+ * An entry consists of 4 bytes of payload length, 4 bytes of type (the<br>
+ * first byte is the type character, the rest are 0) and the payload,<br>
+ * padded to CEPCUIRing_ALIGNMENT bytes. An entry never wraps around the<br>
+ * end of the data area; a padding entry fills the end instead.<br>
+ * The 32 bit words "dataSignal" and "spaceSignal" are futexes incremented<br>
+ * when an entry is published and when space is released; the waiting side<br>
+ * sets "consumerWaiting" or "producerWaiting" before it sleeps on them.<br>
+ * "lock" is a futex lock which serializes the producers.<br>
+ */
+#ifndef CEPCUIRingHeader
+typedef struct
+	{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t capacity;
+	_Atomic uint64_t head __attribute__ ((aligned(64)));
+	_Atomic uint64_t tail __attribute__ ((aligned(64)));
+	_Atomic uint32_t dataSignal __attribute__ ((aligned(64)));
+	_Atomic uint32_t consumerWaiting;
+	_Atomic uint32_t spaceSignal;
+	_Atomic uint32_t producerWaiting;
+	_Atomic uint32_t lock;
+	} CEPCUIRingHeader;
+#endif /* CEPCUIRingHeader */
+
+
+/**
+ * Ring buffer object mapping the shared memory, either as its consumer<br>
+ * (which creates and removes the shared memory object) or as a producer.<br>
+ * The module depends only on libc, so that a producer links the producer<br>
+ * library alone; errors are reported with errno instead of the logger.<br>
+ */
+#ifndef CEPCUIRing
+typedef struct
+	{
+	CEPCUIRingHeader *header;
+	unsigned char *data;
+	size_t mappingLength;
+	char name[NAME_MAX];
+	bool owner;
+	} CEPCUIRing;
+#endif /* CEPCUIRing */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Unmap the shared memory opened by a producer and release the heap<br>
+ * memory of ring buffer object.<br>
+ *
+ * @param[in,out] self	Ring buffer object
+ */
+void CEPCUIRing_close (CEPCUIRing **self);
+
+
+/**
+ * Unmap and remove the shared memory created by the consumer and release<br>
+ * the heap memory of ring buffer object.<br>
+ *
+ * @param[in,out] self	Ring buffer object
+ */
+void CEPCUIRing_delete (CEPCUIRing **self);
+
+
+/**
+ * Construct new ring buffer object as the consumer: the shared memory<br>
+ * object is created (replacing the one left by a dead consumer) and<br>
+ * initialized.<br>
+ *
+ * @param[in] name		Name of the shared memory object (e.g. "/cepcui")
+ * @param[in] capacity	Size of the data area[Byte] (rounded up to the alignment)
+ * @return				Created ring buffer object or NULL (in case of error, with errno)
+ */
+CEPCUIRing *CEPCUIRing_new (const char *name, const size_t capacity);
+
+
+/**
+ * Construct new ring buffer object as a producer by mapping the shared<br>
+ * memory object created by the consumer.<br>
+ * This function, CEPCUIRing_write() and CEPCUIRing_close() make the<br>
+ * producer library ("libcepcuiring.a"):<br>
+ *<br>
+ * CEPCUIRing *ring = CEPCUIRing_open("/cepcui");<br>
+ * CEPCUIRing_write(ring, false, csv, csvLength, 1000);<br>
+ * CEPCUIRing_close(&ring);<br>
+ *
+ * @param[in] name	Name of the shared memory object
+ * @return			Created ring buffer object or NULL (in case of error, with errno)
+ */
+CEPCUIRing *CEPCUIRing_open (const char *name);
+
+
+/**
+ * Wait until entries are published (or the timeout) and pass the records<br>
+ * of all the published entries to the receiver, in place in the shared<br>
+ * memory. The space of each entry is released to the producers after the<br>
+ * receiver returns.<br>
+ *
+ * @param[in,out] self		Ring buffer object (consumer)
+ * @param[in] timeout		Maximum waiting time[msec]
+ * @param[in] receiver		Function which receives the records
+ * @param[in,out] argument	Argument given to the receiver
+ * @return					Number of received entries or -1 (in case of error, with errno)
+ */
+int64_t CEPCUIRing_receive (CEPCUIRing *self, const int timeout, CEPCUIRing_Receiver receiver, void *argument);
+
+
+/**
+ * Write the records into the ring buffer as one entry and wake up the<br>
+ * consumer. Several producers can write into the same ring buffer.<br>
+ * If the ring buffer is full, this function waits for the consumer to<br>
+ * release space until the timeout.<br>
+ *
+ * @param[in,out] self		Ring buffer object (producer)
+ * @param[in] binary		true : typed binary records, false : CSV format records
+ * @param[in] data			Records
+ * @param[in] dataLength	Size of the records[Byte] (at most a half of the capacity)
+ * @param[in] timeout		Maximum waiting time for space[msec]
+ * @return					true : success, false : timeout (errno is ETIMEDOUT) or error (with errno)
+ */
+bool CEPCUIRing_write (CEPCUIRing *self, const bool binary, const void *data, const size_t dataLength, const int timeout);
+
+
+
+#endif /* CEPCUIRING_H_ */
@@ -0,0 +1,319 @@
+/*******************************************************************************
+ * CEPCUIScheduler.c : Deadline-based scheduler of the CEP cycles with adaptive cadence
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIScheduler.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Get the current time of the monotonic clock.<br>
+ *
+ * @return	Current time[nsec]
+ */
+static uint64_t this_getTime (void);
+
+
+/**
+ * Convert the time of the monotonic clock into timespec.<br>
+ *
+ * @param[in] time		Time[nsec]
+ * @param[out] timespec	Converted time
+ */
+static void this_toTimespec (const uint64_t time, struct timespec *timespec);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Get the current time of the monotonic clock.<br>
+ *
+ * @return	Current time[nsec]
+ */
+static uint64_t this_getTime (void)
+	{
+	//========== Variable ==========
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+	}
+
+
+/**
+ * Convert the time of the monotonic clock into timespec.<br>
+ *
+ * @param[in] time		Time[nsec]
+ * @param[out] timespec	Converted time
+ */
+static void this_toTimespec (const uint64_t time, struct timespec *timespec)
+	{
+	timespec->tv_sec = (time_t)(time / 1000000000ULL);
+	timespec->tv_nsec = (long)(time % 1000000000ULL);
+	return;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the timerfd and heap memory of scheduler object.<br>
+ *
+ * @param[in,out] self	Scheduler object
+ */
+void CEPCUIScheduler_delete (CEPCUIScheduler **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		if ((*self)->fd>=0)
+			{
+			close((*self)->fd);
+			}
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Construct new scheduler object, whose first deadline is the current time.<br>
+ * The interval is adapted between the minimum and maximum intervals, and<br>
+ * fixed if they are equal (or 0).<br>
+ *
+ * @param[in] interval		Initial interval of the cycles[usec]
+ * @param[in] minInterval	Minimum interval[usec] (0 : the initial interval)
+ * @param[in] maxInterval	Maximum interval[usec] (0 : the initial interval)
+ * @return					Created scheduler object or NULL (in case of error)
+ */
+CEPCUIScheduler *CEPCUIScheduler_new (const unsigned long interval, const unsigned long minInterval, const unsigned long maxInterval)
+	{
+	//========== Variable ==========
+	CEPCUIScheduler *self = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIScheduler_new()";
+
+	//===== Check argument =====
+	if (interval>0)
+		{
+		if ((self=(CEPCUIScheduler *)M2MHeap_malloc(sizeof(CEPCUIScheduler)))!=NULL)
+			{
+			self->minInterval = (minInterval>0) ? minInterval : interval;
+			self->maxInterval = (maxInterval>0) ? maxInterval : interval;
+			if (self->maxInterval<self->minInterval)
+				{
+				self->maxInterval = self->minInterval;
+				}
+			//===== The initial interval within the bounds =====
+			self->interval = (interval<self->minInterval) ? self->minInterval : (interval>self->maxInterval) ? self->maxInterval : interval;
+			self->deadline = this_getTime();
+			//===== Fall back to clock_nanosleep() without timerfd =====
+			if ((self->fd=timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK))<0)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to create timerfd, so the deadlines are waited by clock_nanosleep()");
+				}
+			return self;
+			}
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new memory for the scheduler");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated interval is 0");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Adapt the interval to the last cycle and set the deadline of the next<br>
+ * cycle.<br>
+ * The next deadline is the previous one plus the interval, so the cadence<br>
+ * doesn't depend on the processing time; the deadlines missed by a long<br>
+ * cycle are skipped (and counted) instead of being caught up in a burst.<br>
+ * If the cycle was started early (by a file event), the previous deadline<br>
+ * is kept unless the shortened interval ends earlier.<br>
+ *
+ * @param[in,out] self	Scheduler object
+ * @param[in] busy		true : the last cycle received records, false : it was idle
+ */
+void CEPCUIScheduler_schedule (CEPCUIScheduler *self, const bool busy)
+	{
+	//========== Variable ==========
+	struct itimerspec timer;
+	uint64_t now = 0;
+	uint64_t interval = 0;
+	uint64_t missed = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIScheduler_schedule()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		//===== Shorten the interval under load, stretch it while idle =====
+		if (busy==true)
+			{
+			self->interval = (self->interval/2>self->minInterval) ? self->interval/2 : self->minInterval;
+			}
+		else
+			{
+			self->interval = (self->interval<self->maxInterval/2) ? self->interval*2 : self->maxInterval;
+			}
+		interval = (uint64_t)self->interval * 1000ULL;
+		now = this_getTime();
+		//===== Started early by an event =====
+		if (self->deadline>now)
+			{
+			if (now+interval<self->deadline)
+				{
+				self->deadline = now + interval;
+				}
+			}
+		//===== Skip the deadlines missed by the last cycle =====
+		else if ((self->deadline+=interval)<=now)
+			{
+			missed = (now - self->deadline) / interval + 1;
+			self->deadline += missed * interval;
+			CEPCUIMetrics_add(CEPCUIMetricsCounter_MISSED_DEADLINE, missed);
+			}
+		//===== Arm the timer at the absolute deadline =====
+		if (self->fd>=0)
+			{
+			memset(&timer, 0, sizeof(timer));
+			this_toTimespec(self->deadline, &timer.it_value);
+			if (timerfd_settime(self->fd, TFD_TIMER_ABSTIME, &timer, NULL)<0)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to arm timerfd, so the deadlines are waited by clock_nanosleep()");
+				close(self->fd);
+				self->fd = -1;
+				}
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated scheduler object is NULL");
+		}
+	return;
+	}
+
+
+/**
+ * Wait until the deadline of the next cycle, or until the indicated file<br>
+ * descriptor becomes readable (then the deadline is kept for the next<br>
+ * call).<br>
+ *
+ * @param[in,out] self	Scheduler object
+ * @param[in] fd		File descriptor waited together or -1
+ * @return				1 : the file descriptor is readable, 0 : the deadline has come, -1 : error
+ */
+int CEPCUIScheduler_wait (CEPCUIScheduler *self, const int fd)
+	{
+	//========== Variable ==========
+	struct pollfd pollFDList[2];
+	struct timespec deadline;
+	uint64_t expiration = 0;
+	uint64_t now = 0;
+	int timeout = -1;
+	int result = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIScheduler_wait()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		while (true)
+			{
+			//===== Sleep until the deadline without timerfd =====
+			if (self->fd<0 && fd<0)
+				{
+				this_toTimespec(self->deadline, &deadline);
+				if ((result=clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL))==0)
+					{
+					return 0;
+					}
+				else if (result!=EINTR)
+					{
+					M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to sleep until the deadline");
+					return -1;
+					}
+				continue;
+				}
+			//===== Remaining time of the deadline without timerfd =====
+			else if (self->fd<0)
+				{
+				if ((now=this_getTime())>=self->deadline)
+					{
+					return 0;
+					}
+				timeout = (int)((self->deadline - now + 999999ULL) / 1000000ULL);
+				}
+			//===== Wait for the timer and the file descriptor (a negative one is ignored) =====
+			pollFDList[0].fd = self->fd;
+			pollFDList[0].events = POLLIN;
+			pollFDList[0].revents = 0;
+			pollFDList[1].fd = fd;
+			pollFDList[1].events = POLLIN;
+			pollFDList[1].revents = 0;
+			if ((result=poll(pollFDList, 2, timeout))>0)
+				{
+				if (pollFDList[1].revents!=0)
+					{
+					return 1;
+					}
+				else if (read(self->fd, &expiration, sizeof(expiration))==sizeof(expiration))
+					{
+					return 0;
+					}
+				}
+			else if (result<0 && errno!=EINTR)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to wait for the deadline");
+				return -1;
+				}
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated scheduler object is NULL");
+		return -1;
+		}
+	}
+
+
+
+/* End Of File */
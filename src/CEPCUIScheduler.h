@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * CEPCUIScheduler.h : Deadline-based scheduler of the CEP cycles with adaptive cadence
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUISCHEDULER_H_
+#define CEPCUISCHEDULER_H_
+
+
+
+#include "CEPCUIMetrics.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Scheduler which starts the CEP cycles on fixed deadlines of the monotonic<br>
+ * clock, instead of sleeping for the interval after each cycle (which<br>
+ * drifts by the processing time of every cycle).<br>
+ * When the minimum and maximum intervals differ, the interval is adapted:<br>
+ * halved after a cycle which received records, doubled after an idle one.<br>
+ * The deadline is armed on a timerfd (or waited by clock_nanosleep() if<br>
+ * the timerfd isn't available), so that it can be polled together with<br>
+ * another file descriptor.<br>
+ */
+#ifndef CEPCUIScheduler
+typedef struct
+	{
+	int fd;
+	uint64_t deadline;
+	unsigned long interval;
+	unsigned long minInterval;
+	unsigned long maxInterval;
+	} CEPCUIScheduler;
+#endif /* CEPCUIScheduler */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the timerfd and heap memory of scheduler object.<br>
+ *
+ * @param[in,out] self	Scheduler object
+ */
+void CEPCUIScheduler_delete (CEPCUIScheduler **self);
+
+
+/**
+ * Construct new scheduler object, whose first deadline is the current time.<br>
+ * The interval is adapted between the minimum and maximum intervals, and<br>
+ * fixed if they are equal (or 0).<br>
+ *
+ * @param[in] interval		Initial interval of the cycles[usec]
+ * @param[in] minInterval	Minimum interval[usec] (0 : the initial interval)
+ * @param[in] maxInterval	Maximum interval[usec] (0 : the initial interval)
+ * @return					Created scheduler object or NULL (in case of error)
+ */
+CEPCUIScheduler *CEPCUIScheduler_new (const unsigned long interval, const unsigned long minInterval, const unsigned long maxInterval);
+
+
+/**
+ * Adapt the interval to the last cycle and set the deadline of the next<br>
+ * cycle.<br>
+ * The next deadline is the previous one plus the interval, so the cadence<br>
+ * doesn't depend on the processing time; the deadlines missed by a long<br>
+ * cycle are skipped (and counted) instead of being caught up in a burst.<br>
+ * If the cycle was started early (by a file event), the previous deadline<br>
+ * is kept unless the shortened interval ends earlier.<br>
+ *
+ * @param[in,out] self	Scheduler object
+ * @param[in] busy		true : the last cycle received records, false : it was idle
+ */
+void CEPCUIScheduler_schedule (CEPCUIScheduler *self, const bool busy);
+
+
+/**
+ * Wait until the deadline of the next cycle, or until the indicated file<br>
+ * descriptor becomes readable (then the deadline is kept for the next<br>
+ * call).<br>
+ *
+ * @param[in,out] self	Scheduler object
+ * @param[in] fd		File descriptor waited together or -1
+ * @return				1 : the file descriptor is readable, 0 : the deadline has come, -1 : error
+ */
+int CEPCUIScheduler_wait (CEPCUIScheduler *self, const int fd);
+
+
+
+#endif /* CEPCUISCHEDULER_H_ */
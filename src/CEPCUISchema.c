@@ -0,0 +1,427 @@
+/*******************************************************************************
+ * CEPCUISchema.c : Column definition of the CEP table
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUISchema.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Name of data type in the schema file
+ */
+typedef struct
+	{
+	const char *name;
+	M2MSQLiteDataType dataType;
+	} CEPCUISchemaType;
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Add a column to the schema.<br>
+ *
+ * @param[in,out] self	Schema object
+ * @param[in] name		Column name string
+ * @param[in] dataType	Data type of the column
+ * @return				true : success, false : failure
+ */
+static bool this_add (CEPCUISchema *self, const M2MString *name, const M2MSQLiteDataType dataType);
+
+
+/**
+ * Get the data type from its name.<br>
+ *
+ * @param[in] typeName	Name of data type (case insensitive)
+ * @param[out] dataType	Data type
+ * @return				true : success, false : unknown data type
+ */
+static bool this_getDataType (const M2MString *typeName, M2MSQLiteDataType *dataType);
+
+
+/**
+ * Get the encoding of the binary field for the data type.<br>
+ *
+ * @param[in] dataType	Data type of the column
+ * @return				Encoding of the binary field
+ */
+static CEPCUIFieldType this_getFieldType (const M2MSQLiteDataType dataType);
+
+
+/**
+ * Check whether the string is a valid column name.<br>
+ *
+ * @param[in] name	Column name string
+ * @return			true : valid, false : invalid
+ */
+static bool this_isColumnName (const M2MString *name);
+
+
+/**
+ * Read the column definitions from the schema file.<br>
+ *
+ * @param[in,out] self	Schema object
+ * @param[in] file		Schema file
+ * @param[in] filePath	Schema file path string (for error messages)
+ * @return				true : success, false : failure
+ */
+static bool this_load (CEPCUISchema *self, FILE *file, const M2MString *filePath);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Add a column to the schema.<br>
+ *
+ * @param[in,out] self	Schema object
+ * @param[in] name		Column name string
+ * @param[in] dataType	Data type of the column
+ * @return				true : success, false : failure
+ */
+static bool this_add (CEPCUISchema *self, const M2MString *name, const M2MSQLiteDataType dataType)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISchema.this_add()";
+
+	//===== Check the number of columns =====
+	if (self->count>=CEPCUISchema_MAX_COLUMN)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Too many columns are defined in the schema");
+		return false;
+		}
+	//===== Check duplicate name =====
+	for (i=0; i<self->count; i++)
+		{
+		if (strcasecmp((char *)self->columnList[i].name, (char *)name)==0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Column name(=\"%s\") is duplicated in the schema", name);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return false;
+			}
+		}
+	snprintf((char *)self->columnList[self->count].name, sizeof(self->columnList[self->count].name), "%s", name);
+	self->columnList[self->count].dataType = dataType;
+	self->columnList[self->count].fieldType = this_getFieldType(dataType);
+	self->count++;
+	return true;
+	}
+
+
+/**
+ * Get the data type from its name.<br>
+ *
+ * @param[in] typeName	Name of data type (case insensitive)
+ * @param[out] dataType	Data type
+ * @return				true : success, false : unknown data type
+ */
+static bool this_getDataType (const M2MString *typeName, M2MSQLiteDataType *dataType)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	const CEPCUISchemaType TYPE_LIST[] =
+		{
+		{"BLOB", M2MSQLiteDataType_BLOB},
+		{"BOOL", M2MSQLiteDataType_BOOL},
+		{"CHAR", M2MSQLiteDataType_CHAR},
+		{"DATETIME", M2MSQLiteDataType_DATETIME},
+		{"DOUBLE", M2MSQLiteDataType_DOUBLE},
+		{"FLOAT", M2MSQLiteDataType_FLOAT},
+		{"INTEGER", M2MSQLiteDataType_INTEGER},
+		{"NUMERIC", M2MSQLiteDataType_NUMERIC},
+		{"REAL", M2MSQLiteDataType_REAL},
+		{"TEXT", M2MSQLiteDataType_TEXT},
+		{"VARCHAR", M2MSQLiteDataType_VARCHAR}
+		};
+
+	for (i=0; i<sizeof(TYPE_LIST)/sizeof(TYPE_LIST[0]); i++)
+		{
+		if (strcasecmp((char *)typeName, TYPE_LIST[i].name)==0)
+			{
+			(*dataType) = TYPE_LIST[i].dataType;
+			return true;
+			}
+		}
+	return false;
+	}
+
+
+/**
+ * Get the encoding of the binary field for the data type.<br>
+ * Integral types are 64bit integers, floating point types (and NUMERIC) are<br>
+ * 64bit IEEE 754 numbers, BLOB is a byte sequence and the others (including<br>
+ * DATETIME) are UTF-8 strings.<br>
+ *
+ * @param[in] dataType	Data type of the column
+ * @return				Encoding of the binary field
+ */
+static CEPCUIFieldType this_getFieldType (const M2MSQLiteDataType dataType)
+	{
+	if (dataType==M2MSQLiteDataType_INTEGER || dataType==M2MSQLiteDataType_BOOL)
+		{
+		return CEPCUIFieldType_INTEGER;
+		}
+	else if (dataType==M2MSQLiteDataType_DOUBLE || dataType==M2MSQLiteDataType_FLOAT
+			|| dataType==M2MSQLiteDataType_REAL || dataType==M2MSQLiteDataType_NUMERIC)
+		{
+		return CEPCUIFieldType_DOUBLE;
+		}
+	else if (dataType==M2MSQLiteDataType_BLOB)
+		{
+		return CEPCUIFieldType_BLOB;
+		}
+	else
+		{
+		return CEPCUIFieldType_TEXT;
+		}
+	}
+
+
+/**
+ * Check whether the string is a valid column name.<br>
+ * A column name begins with an alphabet or "_", followed by alphanumerics<br>
+ * or "_".<br>
+ *
+ * @param[in] name	Column name string
+ * @return			true : valid, false : invalid
+ */
+static bool this_isColumnName (const M2MString *name)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+
+	if (name==NULL || (isalpha(name[0])==0 && name[0]!='_'))
+		{
+		return false;
+		}
+	for (i=1; name[i]!='\0'; i++)
+		{
+		if (isalnum(name[i])==0 && name[i]!='_')
+			{
+			return false;
+			}
+		}
+	return (i<CEPCUISchema_NAME_LENGTH);
+	}
+
+
+/**
+ * Read the column definitions from the schema file.<br>
+ *
+ * @param[in,out] self	Schema object
+ * @param[in] file		Schema file
+ * @param[in] filePath	Schema file path string (for error messages)
+ * @return				true : success, false : failure
+ */
+static bool this_load (CEPCUISchema *self, FILE *file, const M2MString *filePath)
+	{
+	//========== Variable ==========
+	char LINE[512];
+	char NAME[CEPCUISchema_NAME_LENGTH*2];
+	char TYPE[64];
+	char REST[8];
+	unsigned int lineNumber = 0;
+	int count = 0;
+	M2MSQLiteDataType dataType = M2MSQLiteDataType_TEXT;
+	M2MString MESSAGE[PATH_MAX+256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISchema.this_load()";
+
+	while (fgets(LINE, sizeof(LINE), file)!=NULL)
+		{
+		lineNumber++;
+		//===== Comment or empty line =====
+		if ((count=sscanf(LINE, " %127s %63s %7s", NAME, TYPE, REST))<=0 || NAME[0]=='#')
+			{
+			continue;
+			}
+		//===== Column definition =====
+		else if (count==2 && this_isColumnName((M2MString *)NAME)==true && this_getDataType((M2MString *)TYPE, &dataType)==true)
+			{
+			if (this_add(self, (M2MString *)NAME, dataType)==false)
+				{
+				return false;
+				}
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Invalid column definition at line %u of the schema file(=\"%s\")", lineNumber, filePath);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return false;
+			}
+		}
+	return true;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the heap memory of schema object.<br>
+ *
+ * @param[in,out] self	Schema object
+ */
+void CEPCUISchema_delete (CEPCUISchema **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Create new column list object of CEP library from the schema.<br>
+ *
+ * @param[in] self	Schema object
+ * @return			Created column list object or NULL (in case of error)
+ */
+M2MColumnList *CEPCUISchema_getColumnList (const CEPCUISchema *self)
+	{
+	//========== Variable ==========
+	M2MColumnList *columnList = NULL;
+	size_t i = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISchema_getColumnList()";
+
+	//===== Check argument =====
+	if (self!=NULL && self->count>0 && (columnList=M2MColumnList_new())!=NULL)
+		{
+		for (i=0; i<self->count; i++)
+			{
+			if (M2MColumnList_add(columnList, self->columnList[i].name, self->columnList[i].dataType, false, false, false, false)==NULL)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to add the column to the column list");
+				M2MColumnList_delete(columnList);
+				return NULL;
+				}
+			}
+		return columnList;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated schema object is NULL or empty");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Construct new schema object from the schema file in the regulation<br>
+ * directory.<br>
+ * Each line of the file defines one column as "name TYPE" in table order,<br>
+ * and empty lines and lines beginning with "#" are ignored.<br>
+ * TYPE is one of BLOB, BOOL, CHAR, DATETIME, DOUBLE, FLOAT, INTEGER,<br>
+ * NUMERIC, REAL, TEXT and VARCHAR (case insensitive).<br>
+ * If the file doesn't exist, the default schema<br>
+ * "date DATETIME, name TEXT, value DOUBLE" is used.<br>
+ *
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					Created schema object or NULL (in case of error)
+ */
+CEPCUISchema *CEPCUISchema_new (const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	CEPCUISchema *self = NULL;
+	FILE *file = NULL;
+	bool loaded = false;
+	M2MString FILE_PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISchema_new()";
+
+	//===== Check argument =====
+	if (directoryPath!=NULL && M2MString_length(directoryPath)>0)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUISchema *)M2MHeap_malloc(sizeof(CEPCUISchema)))!=NULL)
+			{
+			snprintf((char *)FILE_PATH, sizeof(FILE_PATH), "%s/%s", directoryPath, CEPCUISchema_FILE_NAME);
+			//===== Schema file =====
+			if ((file=fopen((char *)FILE_PATH, "r"))!=NULL)
+				{
+				loaded = this_load(self, file, FILE_PATH);
+				fclose(file);
+				}
+			//===== Default schema =====
+			else if (errno==ENOENT)
+				{
+				loaded = this_add(self, (M2MString *)"date", M2MSQLiteDataType_DATETIME)
+						&& this_add(self, (M2MString *)"name", M2MSQLiteDataType_TEXT)
+						&& this_add(self, (M2MString *)"value", M2MSQLiteDataType_DOUBLE);
+				}
+			//===== Error handling =====
+			else
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to open the schema file(=\"%s\") : %s", FILE_PATH, strerror(errno));
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				}
+			//===== Check the columns =====
+			if (loaded==true && self->count>0)
+				{
+				return self;
+				}
+			else
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to get the columns of the CEP table");
+				CEPCUISchema_delete(&self);
+				return NULL;
+				}
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for schema object");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated directory path is NULL or empty");
+		return NULL;
+		}
+	}
+
+
+
+/* End Of File */
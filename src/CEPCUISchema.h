@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * CEPCUISchema.h : Column definition of the CEP table
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUISCHEMA_H_
+#define CEPCUISCHEMA_H_
+
+
+
+#include "m2m/lib/db/M2MColumnList.h"
+#include "m2m/lib/db/M2MSQLiteDataType.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Name of the schema file in the regulation directory
+ */
+#ifndef CEPCUISchema_FILE_NAME
+#define CEPCUISchema_FILE_NAME (M2MString *)"schema.conf"
+#endif /* CEPCUISchema_FILE_NAME */
+
+
+/**
+ * Maximum number of columns of the CEP table
+ */
+#ifndef CEPCUISchema_MAX_COLUMN
+#define CEPCUISchema_MAX_COLUMN 64
+#endif /* CEPCUISchema_MAX_COLUMN */
+
+
+/**
+ * Maximum length of column name (including the terminating NULL)
+ */
+#ifndef CEPCUISchema_NAME_LENGTH
+#define CEPCUISchema_NAME_LENGTH 64
+#endif /* CEPCUISchema_NAME_LENGTH */
+
+
+/**
+ * Encoding of a field in the binary record format, which is decided by the<br>
+ * data type of the column.<br>
+ */
+#ifndef CEPCUIFieldType
+typedef enum
+	{
+	CEPCUIFieldType_INTEGER,
+	CEPCUIFieldType_DOUBLE,
+	CEPCUIFieldType_TEXT,
+	CEPCUIFieldType_BLOB
+	} CEPCUIFieldType;
+#endif /* CEPCUIFieldType */
+
+
+/**
+ * Column definition of the CEP table.<br>
+ */
+#ifndef CEPCUIColumn
+typedef struct
+	{
+	M2MString name[CEPCUISchema_NAME_LENGTH];
+	M2MSQLiteDataType dataType;
+	CEPCUIFieldType fieldType;
+	} CEPCUIColumn;
+#endif /* CEPCUIColumn */
+
+
+/**
+ * Schema object which holds the columns of the CEP table in order.<br>
+ */
+#ifndef CEPCUISchema
+typedef struct
+	{
+	CEPCUIColumn columnList[CEPCUISchema_MAX_COLUMN];
+	size_t count;
+	} CEPCUISchema;
+#endif /* CEPCUISchema */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the heap memory of schema object.<br>
+ *
+ * @param[in,out] self	Schema object
+ */
+void CEPCUISchema_delete (CEPCUISchema **self);
+
+
+/**
+ * Create new column list object of CEP library from the schema.<br>
+ *
+ * @param[in] self	Schema object
+ * @return			Created column list object or NULL (in case of error)
+ */
+M2MColumnList *CEPCUISchema_getColumnList (const CEPCUISchema *self);
+
+
+/**
+ * Construct new schema object from the schema file in the regulation<br>
+ * directory.<br>
+ * Each line of the file defines one column as "name TYPE" in table order,<br>
+ * and empty lines and lines beginning with "#" are ignored.<br>
+ * TYPE is one of BLOB, BOOL, CHAR, DATETIME, DOUBLE, FLOAT, INTEGER,<br>
+ * NUMERIC, REAL, TEXT and VARCHAR (case insensitive).<br>
+ * If the file doesn't exist, the default schema<br>
+ * "date DATETIME, name TEXT, value DOUBLE" is used.<br>
+ *
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					Created schema object or NULL (in case of error)
+ */
+CEPCUISchema *CEPCUISchema_new (const M2MString *directoryPath);
+
+
+
+#endif /* CEPCUISCHEMA_H_ */
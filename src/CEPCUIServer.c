@@ -0,0 +1,714 @@
+/*******************************************************************************
+ * CEPCUIServer.c : Unix domain socket server which receives records from producers
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIServer.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Accept all the pending connections and register them to epoll.<br>
+ *
+ * @param[in,out] self	Server object
+ */
+static void this_accept (CEPCUIServer *self);
+
+
+/**
+ * Append the data to the heap memory buffer, enlarging it if necessary.<br>
+ *
+ * @param[in,out] buffer	Heap memory buffer (reallocated in this function)
+ * @param[in,out] length	Size of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] data			Appended data (NULL : only the space is reserved)
+ * @param[in] dataLength	Size of the appended data[Byte]
+ * @return					true : success, false : failed to allocate heap memory
+ */
+static bool this_append (M2MString **buffer, size_t *length, size_t *capacity, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Close the connection and unregister it from epoll.<br>
+ * The connection object is released later by this_removeClosed(), since<br>
+ * events of the same epoll_wait() may still refer to it.<br>
+ *
+ * @param[in,out] self			Server object
+ * @param[in,out] connection	Connection object
+ */
+static void this_close (CEPCUIServer *self, CEPCUIConnection *connection);
+
+
+/**
+ * Send the pending frames of the connection as far as the socket accepts<br>
+ * them, and watch the socket for writability while some data is left.<br>
+ *
+ * @param[in,out] self			Server object
+ * @param[in,out] connection	Connection object
+ */
+static void this_flush (CEPCUIServer *self, CEPCUIConnection *connection);
+
+
+/**
+ * Handle all the complete frames received from the connection.<br>
+ *
+ * @param[in,out] self			Server object
+ * @param[in,out] connection	Connection object
+ * @param[in] receiver			Function which receives the records
+ * @param[in,out] argument		Argument given to the receiver
+ * @return						Number of record frames or -1 (in case of malformed frame or receiver error)
+ */
+static int64_t this_parse (CEPCUIServer *self, CEPCUIConnection *connection, CEPCUIServer_Receiver receiver, void *argument);
+
+
+/**
+ * Read the data from the connection into its input buffer.<br>
+ *
+ * @param[in,out] connection	Connection object
+ * @return						true : the connection is alive, false : closed by the peer or error
+ */
+static bool this_read (CEPCUIConnection *connection);
+
+
+/**
+ * Release the connection objects which have been closed.<br>
+ *
+ * @param[in,out] self	Server object
+ */
+static void this_removeClosed (CEPCUIServer *self);
+
+
+/**
+ * Set the file descriptor to non-blocking and close-on-exec mode.<br>
+ *
+ * @param[in] fd	File descriptor
+ * @return			true : success, false : failure
+ */
+static bool this_setNonBlocking (const int fd);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Accept all the pending connections and register them to epoll.<br>
+ *
+ * @param[in,out] self	Server object
+ */
+static void this_accept (CEPCUIServer *self)
+	{
+	//========== Variable ==========
+	CEPCUIConnection *connection = NULL;
+	struct epoll_event event;
+	int fd = -1;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIServer.this_accept()";
+
+	//===== Accept until no connection is pending =====
+	while ((fd=accept(self->fd, NULL, NULL))>=0)
+		{
+		if (this_setNonBlocking(fd)==false
+				|| (connection=(CEPCUIConnection *)M2MHeap_malloc(sizeof(CEPCUIConnection)))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to set up the accepted connection");
+			close(fd);
+			continue;
+			}
+		connection->fd = fd;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.ptr = connection;
+		if (epoll_ctl(self->epollFD, EPOLL_CTL_ADD, fd, &event)!=0)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to register the accepted connection to epoll");
+			close(fd);
+			M2MHeap_free(connection);
+			continue;
+			}
+		connection->next = self->connectionList;
+		self->connectionList = connection;
+		}
+	return;
+	}
+
+
+/**
+ * Append the data to the heap memory buffer, enlarging it if necessary.<br>
+ *
+ * @param[in,out] buffer	Heap memory buffer (reallocated in this function)
+ * @param[in,out] length	Size of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] data			Appended data (NULL : only the space is reserved)
+ * @param[in] dataLength	Size of the appended data[Byte]
+ * @return					true : success, false : failed to allocate heap memory
+ */
+static bool this_append (M2MString **buffer, size_t *length, size_t *capacity, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	M2MString *enlarged = NULL;
+	size_t enlargedCapacity = 0;
+
+	//===== Enlarge the buffer =====
+	if ((*capacity)-(*length)<dataLength)
+		{
+		enlargedCapacity = (*capacity) * 2 + dataLength;
+		if ((enlarged=(M2MString *)M2MHeap_malloc(enlargedCapacity))==NULL)
+			{
+			return false;
+			}
+		if ((*buffer)!=NULL)
+			{
+			memcpy(enlarged, (*buffer), (*length));
+			M2MHeap_free((*buffer));
+			}
+		(*buffer) = enlarged;
+		(*capacity) = enlargedCapacity;
+		}
+	//===== Copy the data =====
+	if (data!=NULL)
+		{
+		memcpy(&(*buffer)[(*length)], data, dataLength);
+		(*length) += dataLength;
+		}
+	return true;
+	}
+
+
+/**
+ * Close the connection and unregister it from epoll.<br>
+ * The connection object is released later by this_removeClosed(), since<br>
+ * events of the same epoll_wait() may still refer to it.<br>
+ *
+ * @param[in,out] self			Server object
+ * @param[in,out] connection	Connection object
+ */
+static void this_close (CEPCUIServer *self, CEPCUIConnection *connection)
+	{
+	//===== Check the connection is open =====
+	if (connection->fd>=0)
+		{
+		epoll_ctl(self->epollFD, EPOLL_CTL_DEL, connection->fd, NULL);
+		close(connection->fd);
+		connection->fd = -1;
+		if (connection->subscribing==true)
+			{
+			connection->subscribing = false;
+			self->subscriberCount--;
+			}
+		}
+	return;
+	}
+
+
+/**
+ * Send the pending frames of the connection as far as the socket accepts<br>
+ * them, and watch the socket for writability while some data is left.<br>
+ *
+ * @param[in,out] self			Server object
+ * @param[in,out] connection	Connection object
+ */
+static void this_flush (CEPCUIServer *self, CEPCUIConnection *connection)
+	{
+	//========== Variable ==========
+	struct epoll_event event;
+	size_t sent = 0;
+	ssize_t result = 0;
+
+	//===== Send without blocking =====
+	while (sent<connection->outputLength)
+		{
+		if ((result=send(connection->fd, &connection->output[sent], connection->outputLength-sent, MSG_NOSIGNAL))>0)
+			{
+			sent += (size_t)result;
+			}
+		else if (result<0 && errno==EINTR)
+			{
+			continue;
+			}
+		else if (result<0 && (errno==EAGAIN || errno==EWOULDBLOCK))
+			{
+			break;
+			}
+		//===== The subscriber is gone =====
+		else
+			{
+			this_close(self, connection);
+			return;
+			}
+		}
+	if (sent>0)
+		{
+		memmove(connection->output, &connection->output[sent], connection->outputLength-sent);
+		connection->outputLength -= sent;
+		}
+	//===== Watch writability only while data is left =====
+	if (connection->writing!=(connection->outputLength>0))
+		{
+		connection->writing = (connection->outputLength>0);
+		memset(&event, 0, sizeof(event));
+		event.events = (connection->writing==true) ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+		event.data.ptr = connection;
+		epoll_ctl(self->epollFD, EPOLL_CTL_MOD, connection->fd, &event);
+		}
+	return;
+	}
+
+
+/**
+ * Handle all the complete frames received from the connection.<br>
+ *
+ * @param[in,out] self			Server object
+ * @param[in,out] connection	Connection object
+ * @param[in] receiver			Function which receives the records
+ * @param[in,out] argument		Argument given to the receiver
+ * @return						Number of record frames or -1 (in case of malformed frame or receiver error)
+ */
+static int64_t this_parse (CEPCUIServer *self, CEPCUIConnection *connection, CEPCUIServer_Receiver receiver, void *argument)
+	{
+	//========== Variable ==========
+	size_t position = 0;
+	uint32_t length = 0;
+	M2MString type = '\0';
+	int64_t frames = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIServer.this_parse()";
+
+	//===== Handle the complete frames =====
+	while (connection->inputLength-position>=CEPCUIServer_HEADER_LENGTH)
+		{
+		type = connection->input[position];
+		memcpy(&length, &connection->input[position+1], sizeof(length));
+		length = ntohl(length);
+		if (length>CEPCUIServer_MAX_FRAME_LENGTH)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Received frame exceeds the maximum length, so the connection is closed");
+			return -1;
+			}
+		else if (connection->inputLength-position-CEPCUIServer_HEADER_LENGTH<length)
+			{
+			break;
+			}
+		//===== Records =====
+		if (type==CEPCUIServer_FRAME_CSV || type==CEPCUIServer_FRAME_BINARY)
+			{
+			if (length>0 && receiver(argument, type==CEPCUIServer_FRAME_BINARY, &connection->input[position+CEPCUIServer_HEADER_LENGTH], length)==false)
+				{
+				return -1;
+				}
+			frames++;
+			}
+		//===== Subscription =====
+		else if (type==CEPCUIServer_FRAME_SUBSCRIBE)
+			{
+			if (connection->subscribing==false)
+				{
+				connection->subscribing = true;
+				self->subscriberCount++;
+				}
+			}
+		//===== Unknown frame =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Received frame has an unknown type, so the connection is closed");
+			return -1;
+			}
+		position += CEPCUIServer_HEADER_LENGTH + length;
+		}
+	//===== Keep the incomplete frame =====
+	if (position>0)
+		{
+		memmove(connection->input, &connection->input[position], connection->inputLength-position);
+		connection->inputLength -= position;
+		}
+	return frames;
+	}
+
+
+/**
+ * Read the data from the connection into its input buffer.<br>
+ *
+ * @param[in,out] connection	Connection object
+ * @return						true : the connection is alive, false : closed by the peer or error
+ */
+static bool this_read (CEPCUIConnection *connection)
+	{
+	//========== Variable ==========
+	ssize_t result = 0;
+
+	//===== Reserve the space =====
+	if (this_append(&connection->input, &connection->inputLength, &connection->inputCapacity, NULL, CEPCUIServer_READ_LENGTH)==false)
+		{
+		return false;
+		}
+	//===== Read once (epoll is level triggered) =====
+	else if ((result=recv(connection->fd, &connection->input[connection->inputLength], connection->inputCapacity-connection->inputLength, 0))>0)
+		{
+		connection->inputLength += (size_t)result;
+		return true;
+		}
+	else
+		{
+		return (result<0 && (errno==EINTR || errno==EAGAIN || errno==EWOULDBLOCK));
+		}
+	}
+
+
+/**
+ * Release the connection objects which have been closed.<br>
+ *
+ * @param[in,out] self	Server object
+ */
+static void this_removeClosed (CEPCUIServer *self)
+	{
+	//========== Variable ==========
+	CEPCUIConnection **link = &self->connectionList;
+	CEPCUIConnection *connection = NULL;
+
+	//===== Unlink the closed connections =====
+	while ((connection=(*link))!=NULL)
+		{
+		if (connection->fd<0)
+			{
+			(*link) = connection->next;
+			M2MHeap_free(connection->input);
+			M2MHeap_free(connection->output);
+			M2MHeap_free(connection);
+			}
+		else
+			{
+			link = &connection->next;
+			}
+		}
+	return;
+	}
+
+
+/**
+ * Set the file descriptor to non-blocking and close-on-exec mode.<br>
+ *
+ * @param[in] fd	File descriptor
+ * @return			true : success, false : failure
+ */
+static bool this_setNonBlocking (const int fd)
+	{
+	//========== Variable ==========
+	int flags = 0;
+
+	//===== Set the flags =====
+	return ((flags=fcntl(fd, F_GETFL))>=0
+			&& fcntl(fd, F_SETFL, flags | O_NONBLOCK)==0
+			&& fcntl(fd, F_SETFD, FD_CLOEXEC)==0);
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Close all the connections and the listening socket, remove the socket<br>
+ * file and release the heap memory of server object.<br>
+ *
+ * @param[in,out] self	Server object
+ */
+void CEPCUIServer_delete (CEPCUIServer **self)
+	{
+	//========== Variable ==========
+	CEPCUIConnection *connection = NULL;
+
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		for (connection=(*self)->connectionList; connection!=NULL; connection=connection->next)
+			{
+			this_close((*self), connection);
+			}
+		this_removeClosed((*self));
+		if ((*self)->fd>=0)
+			{
+			close((*self)->fd);
+			unlink((char *)(*self)->socketPath);
+			}
+		if ((*self)->epollFD>=0)
+			{
+			close((*self)->epollFD);
+			}
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Get the number of connections which subscribe to the query results.<br>
+ *
+ * @param[in] self	Server object
+ * @return			Number of subscribers
+ */
+size_t CEPCUIServer_getSubscriberCount (const CEPCUIServer *self)
+	{
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		return self->subscriberCount;
+		}
+	else
+		{
+		return 0;
+		}
+	}
+
+
+/**
+ * Construct new server object listening on the indicated socket file.<br>
+ * A socket file left by a dead server is replaced, but the construction<br>
+ * fails if another server is still listening on it.<br>
+ *
+ * @param[in] socketPath	Path of the Unix domain socket file
+ * @return					Created server object or NULL (in case of error)
+ */
+CEPCUIServer *CEPCUIServer_new (const M2MString *socketPath)
+	{
+	//========== Variable ==========
+	CEPCUIServer *self = NULL;
+	struct sockaddr_un address;
+	struct epoll_event event;
+	int fd = -1;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIServer_new()";
+
+	//===== Check argument =====
+	if (socketPath!=NULL && M2MString_length(socketPath)<sizeof(address.sun_path))
+		{
+		if ((self=(CEPCUIServer *)M2MHeap_malloc(sizeof(CEPCUIServer)))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for server object");
+			return NULL;
+			}
+		self->fd = -1;
+		self->epollFD = -1;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		memcpy(address.sun_path, socketPath, M2MString_length(socketPath));
+		//===== Replace the socket file left by a dead server =====
+		if ((fd=socket(AF_UNIX, SOCK_STREAM, 0))>=0)
+			{
+			if (connect(fd, (struct sockaddr *)&address, sizeof(address))==0)
+				{
+				close(fd);
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Another server is listening on the socket(=\"%s\")", socketPath);
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				CEPCUIServer_delete(&self);
+				return NULL;
+				}
+			close(fd);
+			unlink((char *)socketPath);
+			}
+		//===== Listen on the socket =====
+		if ((self->epollFD=epoll_create1(EPOLL_CLOEXEC))<0
+				|| (fd=socket(AF_UNIX, SOCK_STREAM, 0))<0
+				|| this_setNonBlocking(fd)==false
+				|| bind(fd, (struct sockaddr *)&address, sizeof(address))!=0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to bind the socket(=\"%s\") : %s", socketPath, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			if (fd>=0)
+				{
+				close(fd);
+				}
+			CEPCUIServer_delete(&self);
+			return NULL;
+			}
+		memcpy(self->socketPath, socketPath, M2MString_length(socketPath));
+		self->fd = fd;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		if (listen(fd, SOMAXCONN)!=0 || epoll_ctl(self->epollFD, EPOLL_CTL_ADD, fd, &event)!=0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to listen on the socket(=\"%s\") : %s", socketPath, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			CEPCUIServer_delete(&self);
+			return NULL;
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated socket path is NULL or too long");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Send the query result to all the subscribers as a result frame, whose<br>
+ * payload is the name of the query and a line feed followed by the result.<br>
+ * The data which can't be sent at once is kept and sent when the socket<br>
+ * becomes writable; a result is dropped for a subscriber which has too<br>
+ * much unsent data.<br>
+ *
+ * @param[in,out] self		Server object
+ * @param[in] name			Name of the query (empty for the unnamed query)
+ * @param[in] data			Result data string
+ * @param[in] dataLength	Size of result data[Byte]
+ * @return					Number of subscribers to which the result was queued
+ */
+size_t CEPCUIServer_publish (CEPCUIServer *self, const M2MString *name, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	CEPCUIConnection *connection = NULL;
+	M2MString HEADER[CEPCUIServer_HEADER_LENGTH];
+	size_t nameLength = 0;
+	size_t frameLength = 0;
+	uint32_t length = 0;
+	size_t count = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIServer_publish()";
+
+	//===== Check argument =====
+	if (self!=NULL && name!=NULL && data!=NULL)
+		{
+		nameLength = M2MString_length(name);
+		frameLength = CEPCUIServer_HEADER_LENGTH + nameLength + 1 + dataLength;
+		HEADER[0] = CEPCUIServer_FRAME_RESULT;
+		length = htonl((uint32_t)(nameLength + 1 + dataLength));
+		memcpy(&HEADER[1], &length, sizeof(length));
+		for (connection=self->connectionList; connection!=NULL; connection=connection->next)
+			{
+			if (connection->fd<0 || connection->subscribing==false)
+				{
+				continue;
+				}
+			//===== Slow subscriber =====
+			else if (connection->outputLength+frameLength>CEPCUIServer_MAX_PENDING_LENGTH)
+				{
+				M2MLogger_info(NULL, METHOD_NAME, __LINE__, (M2MString *)"Subscriber has too much unsent data, so the result is dropped for it");
+				}
+			//===== Queue and send the frame =====
+			else if (this_append(&connection->output, &connection->outputLength, &connection->outputCapacity, NULL, frameLength)==true)
+				{
+				this_append(&connection->output, &connection->outputLength, &connection->outputCapacity, HEADER, sizeof(HEADER));
+				this_append(&connection->output, &connection->outputLength, &connection->outputCapacity, name, nameLength);
+				this_append(&connection->output, &connection->outputLength, &connection->outputCapacity, (M2MString *)"\n", 1);
+				this_append(&connection->output, &connection->outputLength, &connection->outputCapacity, data, dataLength);
+				this_flush(self, connection);
+				count++;
+				}
+			}
+		this_removeClosed(self);
+		return count;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated server object, name or result data is NULL");
+		return 0;
+		}
+	}
+
+
+/**
+ * Wait for the events of the connections once, accept new connections,<br>
+ * send pending results and pass the records of every complete frame to<br>
+ * the receiver.<br>
+ * A connection is closed when it sends a malformed frame or the receiver<br>
+ * fails.<br>
+ *
+ * @param[in,out] self		Server object
+ * @param[in] timeout		Maximum waiting time[msec]
+ * @param[in] receiver		Function which receives the records
+ * @param[in,out] argument	Argument given to the receiver
+ * @return					Number of received record frames or -1 (in case of error)
+ */
+int64_t CEPCUIServer_receive (CEPCUIServer *self, const int timeout, CEPCUIServer_Receiver receiver, void *argument)
+	{
+	//========== Variable ==========
+	CEPCUIConnection *connection = NULL;
+	struct epoll_event EVENT[CEPCUIServer_MAX_EVENT];
+	int count = 0;
+	int i = 0;
+	bool alive = true;
+	int64_t parsed = 0;
+	int64_t frames = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIServer_receive()";
+
+	//===== Check argument =====
+	if (self!=NULL && receiver!=NULL)
+		{
+		if ((count=epoll_wait(self->epollFD, EVENT, CEPCUIServer_MAX_EVENT, timeout))<0)
+			{
+			return (errno==EINTR) ? 0 : -1;
+			}
+		for (i=0; i<count; i++)
+			{
+			//===== New connections =====
+			if ((connection=(CEPCUIConnection *)EVENT[i].data.ptr)==NULL)
+				{
+				this_accept(self);
+				continue;
+				}
+			//===== Closed earlier in this loop =====
+			else if (connection->fd<0)
+				{
+				continue;
+				}
+			//===== Pending results =====
+			if ((EVENT[i].events & EPOLLOUT)!=0)
+				{
+				this_flush(self, connection);
+				}
+			//===== Received frames (also the rest of them on hang-up) =====
+			if (connection->fd>=0 && (EVENT[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))!=0)
+				{
+				alive = this_read(connection);
+				if ((parsed=this_parse(self, connection, receiver, argument))<0 || alive==false)
+					{
+					this_close(self, connection);
+					}
+				frames += (parsed>0) ? parsed : 0;
+				}
+			}
+		this_removeClosed(self);
+		return frames;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated server object or receiver is NULL");
+		return -1;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,250 @@
+/*******************************************************************************
+ * CEPCUIServer.h : Unix domain socket server which receives records from producers
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUISERVER_H_
+#define CEPCUISERVER_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Frame type of CSV format records (producer to server)
+ */
+#ifndef CEPCUIServer_FRAME_CSV
+#define CEPCUIServer_FRAME_CSV 'C'
+#endif /* CEPCUIServer_FRAME_CSV */
+
+
+/**
+ * Frame type of typed binary records (producer to server)
+ */
+#ifndef CEPCUIServer_FRAME_BINARY
+#define CEPCUIServer_FRAME_BINARY 'B'
+#endif /* CEPCUIServer_FRAME_BINARY */
+
+
+/**
+ * Frame type of the subscription to query results (subscriber to server)
+ */
+#ifndef CEPCUIServer_FRAME_SUBSCRIBE
+#define CEPCUIServer_FRAME_SUBSCRIBE 'S'
+#endif /* CEPCUIServer_FRAME_SUBSCRIBE */
+
+
+/**
+ * Frame type of a query result (server to subscriber)
+ */
+#ifndef CEPCUIServer_FRAME_RESULT
+#define CEPCUIServer_FRAME_RESULT 'R'
+#endif /* CEPCUIServer_FRAME_RESULT */
+
+
+/**
+ * Size of the frame header: 1 byte of type and 4 bytes of payload length<br>
+ * (unsigned, big endian)[Byte]
+ */
+#ifndef CEPCUIServer_HEADER_LENGTH
+#define CEPCUIServer_HEADER_LENGTH 5
+#endif /* CEPCUIServer_HEADER_LENGTH */
+
+
+/**
+ * Maximum payload length of a received frame[Byte]
+ */
+#ifndef CEPCUIServer_MAX_FRAME_LENGTH
+#define CEPCUIServer_MAX_FRAME_LENGTH 67108864
+#endif /* CEPCUIServer_MAX_FRAME_LENGTH */
+
+
+/**
+ * Maximum size of the results waiting to be sent to one subscriber[Byte]
+ */
+#ifndef CEPCUIServer_MAX_PENDING_LENGTH
+#define CEPCUIServer_MAX_PENDING_LENGTH 16777216
+#endif /* CEPCUIServer_MAX_PENDING_LENGTH */
+
+
+/**
+ * Size of the data read from a connection at once[Byte]
+ */
+#ifndef CEPCUIServer_READ_LENGTH
+#define CEPCUIServer_READ_LENGTH 65536
+#endif /* CEPCUIServer_READ_LENGTH */
+
+
+/**
+ * Maximum number of events handled by one epoll_wait()
+ */
+#ifndef CEPCUIServer_MAX_EVENT
+#define CEPCUIServer_MAX_EVENT 64
+#endif /* CEPCUIServer_MAX_EVENT */
+
+
+/**
+ * Function which receives the records of a frame.<br>
+ * The records are valid only during the call.<br>
+ *
+ * @param[in,out] argument	Argument given to CEPCUIServer_receive()
+ * @param[in] binary		true : typed binary records, false : CSV format records
+ * @param[in] data			Records (not NULL terminated)
+ * @param[in] dataLength	Size of the records[Byte]
+ * @return					true : success, false : the connection is closed as an error
+ */
+#ifndef CEPCUIServer_Receiver
+typedef bool (*CEPCUIServer_Receiver) (void *argument, const bool binary, const M2MString *data, const size_t dataLength);
+#endif /* CEPCUIServer_Receiver */
+
+
+/**
+ * Connection of a producer or subscriber.<br>
+ * "input" holds the received data of incomplete frames, and "output" holds<br>
+ * the frames waiting until the socket becomes writable.<br>
+ */
+#ifndef CEPCUIConnection
+typedef struct CEPCUIConnection
+	{
+	int fd;
+	bool subscribing;
+	bool writing;
+	M2MString *input;
+	size_t inputLength;
+	size_t inputCapacity;
+	M2MString *output;
+	size_t outputLength;
+	size_t outputCapacity;
+	struct CEPCUIConnection *next;
+	} CEPCUIConnection;
+#endif /* CEPCUIConnection */
+
+
+/**
+ * Server object which listens on a Unix domain socket and multiplexes the<br>
+ * connections with epoll.<br>
+ */
+#ifndef CEPCUIServer
+typedef struct
+	{
+	int fd;
+	int epollFD;
+	M2MString socketPath[PATH_MAX];
+	CEPCUIConnection *connectionList;
+	size_t subscriberCount;
+	} CEPCUIServer;
+#endif /* CEPCUIServer */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Close all the connections and the listening socket, remove the socket<br>
+ * file and release the heap memory of server object.<br>
+ *
+ * @param[in,out] self	Server object
+ */
+void CEPCUIServer_delete (CEPCUIServer **self);
+
+
+/**
+ * Get the number of connections which subscribe to the query results.<br>
+ *
+ * @param[in] self	Server object
+ * @return			Number of subscribers
+ */
+size_t CEPCUIServer_getSubscriberCount (const CEPCUIServer *self);
+
+
+/**
+ * Construct new server object listening on the indicated socket file.<br>
+ * A socket file left by a dead server is replaced, but the construction<br>
+ * fails if another server is still listening on it.<br>
+ *
+ * @param[in] socketPath	Path of the Unix domain socket file
+ * @return					Created server object or NULL (in case of error)
+ */
+CEPCUIServer *CEPCUIServer_new (const M2MString *socketPath);
+
+
+/**
+ * Send the query result to all the subscribers as a result frame, whose<br>
+ * payload is the name of the query and a line feed followed by the result.<br>
+ * The data which can't be sent at once is kept and sent when the socket<br>
+ * becomes writable; a result is dropped for a subscriber which has too<br>
+ * much unsent data.<br>
+ *
+ * @param[in,out] self		Server object
+ * @param[in] name			Name of the query (empty for the unnamed query)
+ * @param[in] data			Result data string
+ * @param[in] dataLength	Size of result data[Byte]
+ * @return					Number of subscribers to which the result was queued
+ */
+size_t CEPCUIServer_publish (CEPCUIServer *self, const M2MString *name, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Wait for the events of the connections once, accept new connections,<br>
+ * send pending results and pass the records of every complete frame to<br>
+ * the receiver.<br>
+ * A connection is closed when it sends a malformed frame or the receiver<br>
+ * fails.<br>
+ *
+ * @param[in,out] self		Server object
+ * @param[in] timeout		Maximum waiting time[msec]
+ * @param[in] receiver		Function which receives the records
+ * @param[in,out] argument	Argument given to the receiver
+ * @return					Number of received record frames or -1 (in case of error)
+ */
+int64_t CEPCUIServer_receive (CEPCUIServer *self, const int timeout, CEPCUIServer_Receiver receiver, void *argument);
+
+
+
+#endif /* CEPCUISERVER_H_ */
@@ -0,0 +1,720 @@
+/*******************************************************************************
+ * CEPCUIShardSet.c : CEP tables partitioned by a key column across worker threads
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUIShardSet.h"
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Append the data to the end of the buffer, enlarging it if necessary.<br>
+ *
+ * @param[in,out] arena		Arena for the buffer or NULL (in case of heap memory)
+ * @param[in,out] buffer	Buffer (allocated or reallocated in this function)
+ * @param[in,out] length	Length of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] data			Data to be appended
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failed to allocate memory
+ */
+static bool this_append (CEPCUIArena *arena, M2MString **buffer, size_t *length, size_t *capacity, const void *data, const size_t dataLength);
+
+
+/**
+ * Get the shard which owns the key (FNV-1a hash of the key bytes).<br>
+ *
+ * @param[in] self			Shard set object
+ * @param[in] key			Key bytes
+ * @param[in] keyLength		Size of the key[Byte]
+ * @return					Shard which owns the key
+ */
+static CEPCUIShard *this_getShard (CEPCUIShardSet *self, const void *key, const size_t keyLength);
+
+
+/**
+ * Request the operation to the worker threads and wait for all of them.<br>
+ * Insertion is requested only to the shards which received records.<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in] operation		Operation
+ * @param[in] queryIndex	Index of the query (for CEPCUIShardOperation_SELECT)
+ * @return					Total number of inserted records
+ */
+static int64_t this_request (CEPCUIShardSet *self, const CEPCUIShardOperation operation, const size_t queryIndex);
+
+
+/**
+ * Worker thread of a shard, which executes the requested operations on its<br>
+ * own CEP table until it is stopped.<br>
+ *
+ * @param[in,out] argument	Shard object
+ * @return					NULL
+ */
+static void *this_run (void *argument);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Append the data to the end of the buffer, enlarging it if necessary.<br>
+ *
+ * @param[in,out] arena		Arena for the buffer or NULL (in case of heap memory)
+ * @param[in,out] buffer	Buffer (allocated or reallocated in this function)
+ * @param[in,out] length	Length of the data in the buffer[Byte]
+ * @param[in,out] capacity	Size of the buffer[Byte]
+ * @param[in] data			Data to be appended
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failed to allocate memory
+ */
+static bool this_append (CEPCUIArena *arena, M2MString **buffer, size_t *length, size_t *capacity, const void *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	M2MString *enlarged = NULL;
+	size_t newCapacity = (*capacity);
+
+	//===== Enlarge the buffer (keeping room for NULL terminator) =====
+	if ((*buffer)==NULL || (*length)+dataLength+1>(*capacity))
+		{
+		if (newCapacity<CEPCUIQuerySet_RESULT_BUFFER_LENGTH)
+			{
+			newCapacity = CEPCUIQuerySet_RESULT_BUFFER_LENGTH;
+			}
+		while ((*length)+dataLength+1>newCapacity)
+			{
+			newCapacity *= 2;
+			}
+		//===== Enlarge in the arena (in place if possible) =====
+		if (arena!=NULL)
+			{
+			if ((enlarged=(M2MString *)CEPCUIArena_reallocate(arena, (*buffer), (*length), newCapacity))==NULL)
+				{
+				return false;
+				}
+			}
+		else if ((enlarged=(M2MString *)M2MHeap_malloc(newCapacity))==NULL)
+			{
+			return false;
+			}
+		else if ((*buffer)!=NULL)
+			{
+			memcpy(enlarged, (*buffer), (*length));
+			M2MHeap_free((*buffer));
+			}
+		(*buffer) = enlarged;
+		(*capacity) = newCapacity;
+		}
+	memcpy(&(*buffer)[(*length)], data, dataLength);
+	(*length) += dataLength;
+	return true;
+	}
+
+
+/**
+ * Get the shard which owns the key (FNV-1a hash of the key bytes).<br>
+ *
+ * @param[in] self			Shard set object
+ * @param[in] key			Key bytes
+ * @param[in] keyLength		Size of the key[Byte]
+ * @return					Shard which owns the key
+ */
+static CEPCUIShard *this_getShard (CEPCUIShardSet *self, const void *key, const size_t keyLength)
+	{
+	//========== Variable ==========
+	const unsigned char *BYTES = (const unsigned char *)key;
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i = 0;
+
+	for (i=0; i<keyLength; i++)
+		{
+		hash = (hash ^ BYTES[i]) * 1099511628211ULL;
+		}
+	return &self->shardList[hash%self->count];
+	}
+
+
+/**
+ * Request the operation to the worker threads and wait for all of them.<br>
+ * Insertion is requested only to the shards which received records.<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in] operation		Operation
+ * @param[in] queryIndex	Index of the query (for CEPCUIShardOperation_SELECT)
+ * @return					Total number of inserted records
+ */
+static int64_t this_request (CEPCUIShardSet *self, const CEPCUIShardOperation operation, const size_t queryIndex)
+	{
+	//========== Variable ==========
+	CEPCUIShard *shard = NULL;
+	bool requested[CEPCUIShardSet_MAX_SHARD];
+	int64_t records = 0;
+	size_t i = 0;
+	const unsigned long TIMEOUT = 1000000UL;
+
+	//===== Request the operation =====
+	for (i=0; i<self->count; i++)
+		{
+		shard = &self->shardList[i];
+		if ((requested[i]=(operation==CEPCUIShardOperation_SELECT || shard->length>0))==true)
+			{
+			shard->operation = operation;
+			shard->queryIndex = queryIndex;
+			shard->records = 0;
+			shard->result = NULL;
+			CEPCUIQueue_push(shard->requestQueue, shard);
+			}
+		}
+	//===== Wait for the workers =====
+	for (i=0; i<self->count; i++)
+		{
+		if (requested[i]==true)
+			{
+			shard = &self->shardList[i];
+			while (CEPCUIQueue_pop(shard->responseQueue, TIMEOUT)==NULL)
+				{
+				}
+			if (shard->records>0)
+				{
+				records += shard->records;
+				}
+			}
+		}
+	return records;
+	}
+
+
+/**
+ * Worker thread of a shard, which executes the requested operations on its<br>
+ * own CEP table until it is stopped.<br>
+ *
+ * @param[in,out] argument	Shard object
+ * @return					NULL
+ */
+static void *this_run (void *argument)
+	{
+	//========== Variable ==========
+	CEPCUIShard *shard = (CEPCUIShard *)argument;
+	CEPCUICSVTokenizer tokenizer;
+	CEPCUIBinaryReader reader;
+	int64_t inserted = 0;
+	const unsigned long TIMEOUT = 1000000UL;
+
+	while (true)
+		{
+		//===== Wait for a request =====
+		if (CEPCUIQueue_pop(shard->requestQueue, TIMEOUT)==NULL)
+			{
+			continue;
+			}
+		//===== Stop =====
+		else if (shard->operation==CEPCUIShardOperation_STOP)
+			{
+			break;
+			}
+		//===== Insert CSV format records =====
+		else if (shard->operation==CEPCUIShardOperation_INSERT_CSV)
+			{
+			CEPCUICSVTokenizer_init(&tokenizer, shard->buffer, shard->length);
+			while (tokenizer.position<tokenizer.length
+					&& (inserted=CEPCUIInserter_insertCSV(shard->inserter, &tokenizer, shard->length))>=0)
+				{
+				shard->records += inserted;
+				}
+			}
+		//===== Insert binary records =====
+		else if (shard->operation==CEPCUIShardOperation_INSERT_BINARY)
+			{
+			if (CEPCUIBinaryReader_init(&reader, shard->schema, shard->buffer, shard->length)==true)
+				{
+				while (reader.position<reader.length
+						&& (inserted=CEPCUIInserter_insertBinary(shard->inserter, &reader, shard->length))>=0)
+					{
+					shard->records += inserted;
+					}
+				}
+			}
+		//===== Execute the query =====
+		else if (shard->queryIndex<shard->querySet->count)
+			{
+			CEPCUIArena_reset(shard->arena);
+			CEPCUIQuerySet_select(shard->querySet, shard->queryIndex, shard->arena, &shard->result);
+			}
+		//===== Respond =====
+		CEPCUIQueue_push(shard->responseQueue, shard);
+		}
+	return NULL;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Stop the worker threads and release the CEP objects and heap memory of<br>
+ * shard set object.<br>
+ *
+ * @param[in,out] self	Shard set object
+ */
+void CEPCUIShardSet_delete (CEPCUIShardSet **self)
+	{
+	//========== Variable ==========
+	CEPCUIShard *shard = NULL;
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		for (i=0; i<(*self)->count; i++)
+			{
+			shard = &(*self)->shardList[i];
+			//===== Stop the worker thread =====
+			if (shard->running==true)
+				{
+				shard->operation = CEPCUIShardOperation_STOP;
+				CEPCUIQueue_push(shard->requestQueue, shard);
+				pthread_join(shard->thread, NULL);
+				}
+			CEPCUIInserter_delete(&shard->inserter);
+			CEPCUIQuerySet_delete(&shard->querySet);
+			M2MCEP_delete(&shard->cep);
+			CEPCUIQueue_delete(&shard->requestQueue);
+			CEPCUIQueue_delete(&shard->responseQueue);
+			M2MHeap_free(shard->buffer);
+			CEPCUIArena_delete(&shard->arena);
+			}
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Partition the typed records from the binary reader among the shards and<br>
+ * insert them in parallel.<br>
+ * Records are consumed until the reader has advanced by the indicated<br>
+ * length (or reached the end of buffer).<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in,out] reader	Reader of binary records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIShardSet_insertBinary (CEPCUIShardSet *self, CEPCUIBinaryReader *reader, const size_t maxLength)
+	{
+	//========== Variable ==========
+	CEPCUIBinaryField fieldList[CEPCUIInserter_MAX_COLUMN];
+	const CEPCUIBinaryField *key = NULL;
+	CEPCUIShard *shard = NULL;
+	size_t fieldCount = 0;
+	size_t start = 0;
+	size_t recordStart = 0;
+	size_t i = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIShardSet_insertBinary()";
+
+	//===== Check argument =====
+	if (self!=NULL && reader!=NULL)
+		{
+		for (i=0; i<self->count; i++)
+			{
+			self->shardList[i].length = 0;
+			}
+		//===== Route records to the shards =====
+		start = reader->position;
+		while (reader->position-start<maxLength
+				&& (recordStart=reader->position)<reader->length
+				&& (fieldCount=CEPCUIBinaryReader_next(reader, fieldList, CEPCUIInserter_MAX_COLUMN))>0)
+			{
+			//===== NULL key =====
+			if (fieldCount<=self->keyIndex || (key=&fieldList[self->keyIndex])->null==true)
+				{
+				shard = this_getShard(self, NULL, 0);
+				}
+			//===== Number key =====
+			else if (key->type==CEPCUIFieldType_INTEGER)
+				{
+				shard = this_getShard(self, &key->integer, sizeof(key->integer));
+				}
+			else if (key->type==CEPCUIFieldType_DOUBLE)
+				{
+				shard = this_getShard(self, &key->real, sizeof(key->real));
+				}
+			//===== String key =====
+			else
+				{
+				shard = this_getShard(self, &reader->data[key->offset], key->length);
+				}
+			//===== Copy the header and the record =====
+			if ((shard->length==0 && this_append(NULL, &shard->buffer, &shard->length, &shard->capacity, reader->data, CEPCUIBinaryReader_HEADER_LENGTH)==false)
+					|| this_append(NULL, &shard->buffer, &shard->length, &shard->capacity, &reader->data[recordStart], reader->position-recordStart)==false)
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for the records of shard");
+				return -1;
+				}
+			}
+		//===== Insert in parallel =====
+		return this_request(self, CEPCUIShardOperation_INSERT_BINARY, 0);
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated shard set or reader object is NULL");
+		return -1;
+		}
+	}
+
+
+/**
+ * Partition the records from the tokenizer among the shards and insert<br>
+ * them in parallel.<br>
+ * Records are consumed until the tokenizer has advanced by the indicated<br>
+ * length (or reached the end of buffer).<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in,out] tokenizer	Tokenizer of CSV format records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIShardSet_insertCSV (CEPCUIShardSet *self, CEPCUICSVTokenizer *tokenizer, const size_t maxLength)
+	{
+	//========== Variable ==========
+	CEPCUICSVField fieldList[CEPCUIInserter_MAX_COLUMN];
+	CEPCUIShard *shard = NULL;
+	size_t fieldCount = 0;
+	size_t start = 0;
+	size_t recordStart = 0;
+	size_t i = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIShardSet_insertCSV()";
+
+	//===== Check argument =====
+	if (self!=NULL && tokenizer!=NULL)
+		{
+		for (i=0; i<self->count; i++)
+			{
+			self->shardList[i].length = 0;
+			}
+		//===== Route records to the shards =====
+		start = tokenizer->position;
+		while (tokenizer->position-start<maxLength
+				&& (recordStart=tokenizer->position)<tokenizer->length
+				&& (fieldCount=CEPCUICSVTokenizer_next(tokenizer, fieldList, CEPCUIInserter_MAX_COLUMN))>0)
+			{
+			if (fieldCount>self->keyIndex)
+				{
+				shard = this_getShard(self, &tokenizer->data[fieldList[self->keyIndex].offset], fieldList[self->keyIndex].length);
+				}
+			else
+				{
+				shard = this_getShard(self, NULL, 0);
+				}
+			//===== Copy the record (terminated with LF) =====
+			if (this_append(NULL, &shard->buffer, &shard->length, &shard->capacity, &tokenizer->data[recordStart], tokenizer->position-recordStart)==false
+					|| (tokenizer->data[tokenizer->position-1]!='\n' && this_append(NULL, &shard->buffer, &shard->length, &shard->capacity, "\n", 1)==false))
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for the records of shard");
+				return -1;
+				}
+			}
+		//===== Insert in parallel =====
+		return this_request(self, CEPCUIShardOperation_INSERT_CSV, 0);
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated shard set or tokenizer object is NULL");
+		return -1;
+		}
+	}
+
+
+/**
+ * Construct new shard set object and start the worker threads.<br>
+ * Each shard creates its own CEP object named "<databaseName>_<N>" with the<br>
+ * table of the schema, and compiles the queries in the regulation directory<br>
+ * on it.<br>
+ *
+ * @param[in] count			Number of shards (2 or more)
+ * @param[in] databaseName	Database name string of CEP
+ * @param[in] tableName		Table name string
+ * @param[in] schema		Schema of the table
+ * @param[in] keyName		Name of the column by which the records are partitioned
+ * @param[in] directoryPath	Regulation directory path string (for loading the queries)
+ * @param[in] maxRecord		Maximum number of records kept in each shard (0 : unlimited)
+ * @param[in] batchRecord	Maximum number of records per transaction (0 : unlimited)
+ * @param[in] windowColumn	Name of the time column of the time window
+ * @param[in] windowTime	Length of the time window[sec] (0 : not bounded by time)
+ * @param[in] windowMemory	Maximum size of the table of each shard[Byte] (0 : not bounded by memory)
+ * @return					Created shard set object or NULL (in case of error)
+ */
+CEPCUIShardSet *CEPCUIShardSet_new (const size_t count, const M2MString *databaseName, const M2MString *tableName, const CEPCUISchema *schema, const M2MString *keyName, const M2MString *directoryPath, const unsigned int maxRecord, const unsigned int batchRecord, const M2MString *windowColumn, const unsigned int windowTime, const size_t windowMemory)
+	{
+	//========== Variable ==========
+	CEPCUIShardSet *self = NULL;
+	CEPCUIShard *shard = NULL;
+	M2MColumnList *columnList = NULL;
+	M2MTableManager *tableManager = NULL;
+	size_t i = 0;
+	M2MString DATABASE_NAME[256];
+	M2MString MESSAGE[512];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIShardSet_new()";
+
+	//===== Check argument =====
+	if (count>=2 && count<=CEPCUIShardSet_MAX_SHARD
+			&& databaseName!=NULL && tableName!=NULL && schema!=NULL && keyName!=NULL && directoryPath!=NULL && windowColumn!=NULL)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUIShardSet *)M2MHeap_malloc(sizeof(CEPCUIShardSet)))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for shard set object");
+			return NULL;
+			}
+		self->schema = schema;
+		//===== Find the key column =====
+		for (self->keyIndex=0; self->keyIndex<schema->count; self->keyIndex++)
+			{
+			if (M2MString_compareTo(schema->columnList[self->keyIndex].name, keyName)==0)
+				{
+				break;
+				}
+			}
+		if (self->keyIndex>=schema->count)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"The key column(=\"%s\") doesn't exist in the schema", keyName);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			CEPCUIShardSet_delete(&self);
+			return NULL;
+			}
+		//===== Create the shards =====
+		for (i=0; i<count; i++)
+			{
+			shard = &self->shardList[i];
+			shard->schema = schema;
+			self->count = i + 1;
+			if (snprintf((char *)DATABASE_NAME, sizeof(DATABASE_NAME), "%s_%zu", databaseName, i + 1)>=(int)sizeof(DATABASE_NAME)
+					|| (columnList=CEPCUISchema_getColumnList(schema))==NULL
+					|| (tableManager=M2MTableManager_new())==NULL
+					|| M2MTableManager_setConfig(tableManager, tableName, columnList)==NULL
+					|| (shard->cep=M2MCEP_new(DATABASE_NAME, tableManager))==NULL
+					|| (shard->inserter=CEPCUIInserter_new(shard->cep->memoryDatabase, tableName, maxRecord))==NULL
+					|| CEPCUIInserter_setBatchRecord(shard->inserter, batchRecord)==NULL
+					|| CEPCUIInserter_setTimeWindow(shard->inserter, tableName, windowColumn, windowTime, windowMemory)==NULL
+					|| (shard->querySet=CEPCUIQuerySet_new(directoryPath))==NULL
+					|| CEPCUIQuerySet_prepare(shard->querySet, shard->cep->memoryDatabase)==NULL
+					|| (shard->requestQueue=CEPCUIQueue_new(1))==NULL
+					|| (shard->responseQueue=CEPCUIQueue_new(1))==NULL
+					|| (shard->arena=CEPCUIArena_new(CEPCUIArena_DEFAULT_CAPACITY))==NULL
+					|| pthread_create(&shard->thread, NULL, this_run, shard)!=0)
+				{
+				memset(MESSAGE, 0, sizeof(MESSAGE));
+				snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to create the shard(=\"%s\")", DATABASE_NAME);
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+				CEPCUIShardSet_delete(&self);
+				return NULL;
+				}
+			shard->running = true;
+			if (maxRecord>0)
+				{
+				M2MCEP_setMaxRecord(shard->cep, maxRecord);
+				}
+			}
+		return self;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated number of shards is out of range, or string or schema is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Replace the queries of all the shards with the query files in the<br>
+ * regulation directory.<br>
+ * The queries are swapped only when they are compiled on every shard.<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					true : replaced, false : the current queries are kept
+ */
+bool CEPCUIShardSet_reload (CEPCUIShardSet *self, const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	CEPCUIQuerySet *querySetList[CEPCUIShardSet_MAX_SHARD];
+	size_t i = 0;
+	bool prepared = true;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIShardSet_reload()";
+
+	//===== Check argument =====
+	if (self!=NULL && directoryPath!=NULL)
+		{
+		//===== Compile the queries on every shard =====
+		memset(querySetList, 0, sizeof(querySetList));
+		for (i=0; i<self->count && prepared==true; i++)
+			{
+			prepared = ((querySetList[i]=CEPCUIQuerySet_new(directoryPath))!=NULL
+					&& CEPCUIQuerySet_prepare(querySetList[i], self->shardList[i].cep->memoryDatabase)!=NULL
+					&& CEPCUIQuerySet_setDelta(querySetList[i], self->delta, self->retract)!=NULL);
+			}
+		//===== Swap the queries =====
+		for (i=0; i<self->count; i++)
+			{
+			if (prepared==true)
+				{
+				CEPCUIQuerySet_delete(&self->shardList[i].querySet);
+				self->shardList[i].querySet = querySetList[i];
+				}
+			else
+				{
+				CEPCUIQuerySet_delete(&querySetList[i]);
+				}
+			}
+		return prepared;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated shard set object or directory path is NULL");
+		return false;
+		}
+	}
+
+
+/**
+ * Execute the query on all the shards in parallel and merge their results<br>
+ * into one CSV format string (the header line of the first result followed<br>
+ * by the records of every shard).<br>
+ *
+ * @param[in,out] self	Shard set object
+ * @param[in] index		Index of the query
+ * @param[in,out] arena	Arena for the result string or NULL (in case of heap memory)
+ * @param[out] result	Pointer for copying the result string (allocated in the arena or heap memory)
+ * @return				Result string or NULL (in case of no record or error)
+ */
+M2MString *CEPCUIShardSet_select (CEPCUIShardSet *self, const size_t index, CEPCUIArena *arena, M2MString **result)
+	{
+	//========== Variable ==========
+	CEPCUIShard *shard = NULL;
+	const M2MString *records = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+	size_t i = 0;
+	bool merged = true;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIShardSet_select()";
+
+	//===== Check argument =====
+	if (self!=NULL && result!=NULL)
+		{
+		(*result) = NULL;
+		//===== Execute the query in parallel =====
+		this_request(self, CEPCUIShardOperation_SELECT, index);
+		//===== Merge the results =====
+		for (i=0; i<self->count; i++)
+			{
+			shard = &self->shardList[i];
+			if (shard->result!=NULL)
+				{
+				records = shard->result;
+				//===== Skip the header line except for the first result =====
+				if ((*result)!=NULL)
+					{
+					records = ((records=(M2MString *)strstr((char *)records, "\r\n"))!=NULL) ? records + 2 : (M2MString *)"";
+					}
+				merged = merged && this_append(arena, result, &length, &capacity, records, M2MString_length(records));
+				}
+			}
+		//===== Error handling =====
+		if (merged==false)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new memory for the merged result");
+			if (arena==NULL)
+				{
+				M2MHeap_free((*result));
+				}
+			return ((*result)=NULL);
+			}
+		else if ((*result)!=NULL)
+			{
+			(*result)[length] = '\0';
+			}
+		return (*result);
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated shard set object or result pointer is NULL");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Switch the queries of all the shards to delta output (or back); the<br>
+ * setting is kept for the queries replaced by CEPCUIShardSet_reload().<br>
+ * Since the records are partitioned by the key column, each shard<br>
+ * remembers the previous result of its own partition.<br>
+ *
+ * @param[in,out] self	Shard set object
+ * @param[in] delta		true : write only the changes of the result, false : write the whole result
+ * @param[in] retract	true : write the records no longer matched too, false : write only the new records
+ * @return				true : success, false : failed to allocate memory
+ */
+bool CEPCUIShardSet_setDelta (CEPCUIShardSet *self, const bool delta, const bool retract)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+	bool set = true;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUIShardSet_setDelta()";
+
+	//===== Check argument =====
+	if (self!=NULL)
+		{
+		self->delta = delta;
+		self->retract = retract;
+		for (i=0; i<self->count && set==true; i++)
+			{
+			set = (CEPCUIQuerySet_setDelta(self->shardList[i].querySet, delta, retract)!=NULL);
+			}
+		return set;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated shard set object is NULL");
+		return false;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,234 @@
+/*******************************************************************************
+ * CEPCUIShardSet.h : CEP tables partitioned by a key column across worker threads
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUISHARDSET_H_
+#define CEPCUISHARDSET_H_
+
+
+
+#include "CEPCUIArena.h"
+#include "CEPCUIBinaryReader.h"
+#include "CEPCUICSVTokenizer.h"
+#include "CEPCUIInserter.h"
+#include "CEPCUIQuerySet.h"
+#include "CEPCUIQueue.h"
+#include "CEPCUISchema.h"
+#include "m2m/cep/M2MCEP.h"
+#include "m2m/lib/db/M2MColumnList.h"
+#include "m2m/lib/db/M2MTableManager.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Maximum number of shards
+ */
+#ifndef CEPCUIShardSet_MAX_SHARD
+#define CEPCUIShardSet_MAX_SHARD 64
+#endif /* CEPCUIShardSet_MAX_SHARD */
+
+
+/**
+ * Operation requested to the worker thread of a shard.<br>
+ */
+#ifndef CEPCUIShardOperation
+typedef enum
+	{
+	CEPCUIShardOperation_INSERT_BINARY,
+	CEPCUIShardOperation_INSERT_CSV,
+	CEPCUIShardOperation_SELECT,
+	CEPCUIShardOperation_STOP
+	} CEPCUIShardOperation;
+#endif /* CEPCUIShardOperation */
+
+
+/**
+ * Shard which owns its own CEP object (memory database), inserter and<br>
+ * prepared queries, operated only by its worker thread while a request is<br>
+ * in progress.<br>
+ * The records routed to the shard are copied into "buffer" in the format of<br>
+ * the input file.<br>
+ */
+#ifndef CEPCUIShard
+typedef struct
+	{
+	M2MCEP *cep;
+	CEPCUIInserter *inserter;
+	CEPCUIQuerySet *querySet;
+	const CEPCUISchema *schema;
+	CEPCUIQueue *requestQueue;
+	CEPCUIQueue *responseQueue;
+	pthread_t thread;
+	bool running;
+	CEPCUIShardOperation operation;
+	size_t queryIndex;
+	M2MString *buffer;
+	size_t length;
+	size_t capacity;
+	int64_t records;
+	CEPCUIArena *arena;
+	M2MString *result;
+	} CEPCUIShard;
+#endif /* CEPCUIShard */
+
+
+/**
+ * Set of shards among which the records are partitioned by the hash of the<br>
+ * key column.<br>
+ */
+#ifndef CEPCUIShardSet
+typedef struct
+	{
+	CEPCUIShard shardList[CEPCUIShardSet_MAX_SHARD];
+	size_t count;
+	size_t keyIndex;
+	const CEPCUISchema *schema;
+	bool delta;
+	bool retract;
+	} CEPCUIShardSet;
+#endif /* CEPCUIShardSet */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Stop the worker threads and release the CEP objects and heap memory of<br>
+ * shard set object.<br>
+ *
+ * @param[in,out] self	Shard set object
+ */
+void CEPCUIShardSet_delete (CEPCUIShardSet **self);
+
+
+/**
+ * Partition the typed records from the binary reader among the shards and<br>
+ * insert them in parallel.<br>
+ * Records are consumed until the reader has advanced by the indicated<br>
+ * length (or reached the end of buffer).<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in,out] reader	Reader of binary records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIShardSet_insertBinary (CEPCUIShardSet *self, CEPCUIBinaryReader *reader, const size_t maxLength);
+
+
+/**
+ * Partition the records from the tokenizer among the shards and insert<br>
+ * them in parallel.<br>
+ * Records are consumed until the tokenizer has advanced by the indicated<br>
+ * length (or reached the end of buffer).<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in,out] tokenizer	Tokenizer of CSV format records
+ * @param[in] maxLength		Length of the buffer consumed at once[Byte]
+ * @return					Number of inserted records or -1 (in case of error)
+ */
+int64_t CEPCUIShardSet_insertCSV (CEPCUIShardSet *self, CEPCUICSVTokenizer *tokenizer, const size_t maxLength);
+
+
+/**
+ * Construct new shard set object and start the worker threads.<br>
+ * Each shard creates its own CEP object named "<databaseName>_<N>" with the<br>
+ * table of the schema, and compiles the queries in the regulation directory<br>
+ * on it.<br>
+ *
+ * @param[in] count			Number of shards (2 or more)
+ * @param[in] databaseName	Database name string of CEP
+ * @param[in] tableName		Table name string
+ * @param[in] schema		Schema of the table
+ * @param[in] keyName		Name of the column by which the records are partitioned
+ * @param[in] directoryPath	Regulation directory path string (for loading the queries)
+ * @param[in] maxRecord		Maximum number of records kept in each shard (0 : unlimited)
+ * @param[in] batchRecord	Maximum number of records per transaction (0 : unlimited)
+ * @param[in] windowColumn	Name of the time column of the time window
+ * @param[in] windowTime	Length of the time window[sec] (0 : not bounded by time)
+ * @param[in] windowMemory	Maximum size of the table of each shard[Byte] (0 : not bounded by memory)
+ * @return					Created shard set object or NULL (in case of error)
+ */
+CEPCUIShardSet *CEPCUIShardSet_new (const size_t count, const M2MString *databaseName, const M2MString *tableName, const CEPCUISchema *schema, const M2MString *keyName, const M2MString *directoryPath, const unsigned int maxRecord, const unsigned int batchRecord, const M2MString *windowColumn, const unsigned int windowTime, const size_t windowMemory);
+
+
+/**
+ * Replace the queries of all the shards with the query files in the<br>
+ * regulation directory.<br>
+ * The queries are swapped only when they are compiled on every shard.<br>
+ *
+ * @param[in,out] self		Shard set object
+ * @param[in] directoryPath	Regulation directory path string
+ * @return					true : replaced, false : the current queries are kept
+ */
+bool CEPCUIShardSet_reload (CEPCUIShardSet *self, const M2MString *directoryPath);
+
+
+/**
+ * Execute the query on all the shards in parallel and merge their results<br>
+ * into one CSV format string (the header line of the first result followed<br>
+ * by the records of every shard).<br>
+ *
+ * @param[in,out] self	Shard set object
+ * @param[in] index		Index of the query
+ * @param[in,out] arena	Arena for the result string or NULL (in case of heap memory)
+ * @param[out] result	Pointer for copying the result string (allocated in the arena or heap memory)
+ * @return				Result string or NULL (in case of no record or error)
+ */
+M2MString *CEPCUIShardSet_select (CEPCUIShardSet *self, const size_t index, CEPCUIArena *arena, M2MString **result);
+
+
+/**
+ * Switch the queries of all the shards to delta output (or back); the<br>
+ * setting is kept for the queries replaced by CEPCUIShardSet_reload().<br>
+ * Since the records are partitioned by the key column, each shard<br>
+ * remembers the previous result of its own partition.<br>
+ *
+ * @param[in,out] self	Shard set object
+ * @param[in] delta		true : write only the changes of the result, false : write the whole result
+ * @param[in] retract	true : write the records no longer matched too, false : write only the new records
+ * @return				true : success, false : failed to allocate memory
+ */
+bool CEPCUIShardSet_setDelta (CEPCUIShardSet *self, const bool delta, const bool retract);
+
+
+
+#endif /* CEPCUISHARDSET_H_ */
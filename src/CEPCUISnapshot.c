@@ -0,0 +1,823 @@
+/*******************************************************************************
+ * CEPCUISnapshot.c : Snapshot and journal of the CEP table for restoring its window after a restart
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUISnapshot.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Item passed to the writing thread: a serialized database (snapshot), or<br>
+ * a journal entry whose records follow the header in the same heap memory.<br>
+ */
+typedef struct
+	{
+	M2MString *image;
+	size_t imageLength;
+	CEPCUISnapshotEntry entry;
+	M2MString data[];
+	} CEPCUISnapshotItem;
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Pass the records of an inserted batch to the writing thread as a journal<br>
+ * entry, and take a snapshot at the interval (called back by the inserter<br>
+ * after each transaction).<br>
+ *
+ * @param[in,out] argument	Snapshot object
+ * @param[in] binary		true : typed binary records (without the header), false : CSV format records
+ * @param[in] data			Records of the batch
+ * @param[in] dataLength	Size of the records[Byte]
+ */
+static void this_append (void *argument, const bool binary, const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Calculate FNV-1a hash of the data as the checksum of a journal entry.<br>
+ *
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					Checksum
+ */
+static uint64_t this_getChecksum (const M2MString *data, const size_t dataLength);
+
+
+/**
+ * Get the current time of the monotonic clock.<br>
+ *
+ * @return	Current time[usec]
+ */
+static uint64_t this_getTime (void);
+
+
+/**
+ * Check whether the CEP table is defined in the same way in both databases.<br>
+ *
+ * @param[in] source		Database of the snapshot
+ * @param[in] database		Memory database
+ * @param[in] tableName		Name of the CEP table
+ * @return					true : the same definition, false : different or not found
+ */
+static bool this_isSameTable (sqlite3 *source, sqlite3 *database, const M2MString *tableName);
+
+
+/**
+ * Write the journal entries and the snapshots passed by the inserting<br>
+ * thread until the snapshot object is deleted (thread function).<br>
+ * The journal is flushed by fdatasync() whenever the queue is drained, or<br>
+ * every CEPCUISnapshot_SYNC_TIME under continuous load.<br>
+ *
+ * @param[in,out] argument	Snapshot object
+ * @return					NULL
+ */
+static void *this_loop (void *argument);
+
+
+/**
+ * Get the sequence number of the last batch contained in the snapshot.<br>
+ *
+ * @param[in] source	Database of the snapshot
+ * @return				Sequence number or -1 (in case of not found)
+ */
+static int64_t this_readSequence (sqlite3 *source);
+
+
+/**
+ * Insert the records of the journal entries newer than the snapshot into<br>
+ * the CEP table in the original order (the batches are inserted one by one,<br>
+ * so the same records are evicted as before the restart).<br>
+ * A torn or corrupted entry ends the journal, and is cut off the file.<br>
+ *
+ * @param[in,out] self		Snapshot object
+ * @param[in,out] inserter	Inserter object of the CEP table
+ * @param[in] schema		Schema of the CEP table (for the binary records)
+ * @return					Number of the replayed records or -1 (in case of error)
+ */
+static int64_t this_replay (CEPCUISnapshot *self, CEPCUIInserter *inserter, const CEPCUISchema *schema);
+
+
+/**
+ * Write all the data to the file descriptor (retrying partial writes).<br>
+ *
+ * @param[in] fd			File descriptor
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_writeFile (const int fd, const void *data, const size_t dataLength);
+
+
+/**
+ * Write the serialized database to the temporary file, replace the<br>
+ * snapshot file with it, and truncate the journal (every entry written so<br>
+ * far is contained in the new snapshot).<br>
+ *
+ * @param[in,out] self	Snapshot object
+ * @param[in] item		Item of the snapshot
+ * @return				true : success, false : failure (the previous snapshot and the journal are kept)
+ */
+static bool this_writeImage (CEPCUISnapshot *self, const CEPCUISnapshotItem *item);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Pass the records of an inserted batch to the writing thread as a journal<br>
+ * entry, and take a snapshot at the interval (called back by the inserter<br>
+ * after each transaction).<br>
+ *
+ * @param[in,out] argument	Snapshot object
+ * @param[in] binary		true : typed binary records (without the header), false : CSV format records
+ * @param[in] data			Records of the batch
+ * @param[in] dataLength	Size of the records[Byte]
+ */
+static void this_append (void *argument, const bool binary, const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	CEPCUISnapshot *self = (CEPCUISnapshot *)argument;
+	CEPCUISnapshotItem *item = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot.this_append()";
+
+	//===== Pass the records to the writing thread =====
+	if ((item=(CEPCUISnapshotItem *)M2MHeap_malloc(sizeof(CEPCUISnapshotItem) + dataLength))!=NULL)
+		{
+		item->entry.magic = CEPCUISnapshot_MAGIC;
+		item->entry.binary = (binary==true) ? 1 : 0;
+		item->entry.sequence = ++self->sequence;
+		item->entry.length = (uint64_t)dataLength;
+		memcpy(item->data, data, dataLength);
+		if (CEPCUIQueue_push(self->queue, item)==false)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to pass the batch to the writing thread, so it can't be replayed after a restart");
+			M2MHeap_free(item);
+			}
+		}
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new memory for the journal entry, so the batch can't be replayed after a restart");
+		}
+	//===== Take a snapshot at the interval =====
+	if (this_getTime()-self->snapshotTime>=(uint64_t)self->interval * 1000000ULL)
+		{
+		CEPCUISnapshot_save(self);
+		}
+	return;
+	}
+
+
+/**
+ * Calculate FNV-1a hash of the data as the checksum of a journal entry.<br>
+ *
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					Checksum
+ */
+static uint64_t this_getChecksum (const M2MString *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	uint64_t checksum = 0xCBF29CE484222325ULL;
+	size_t i = 0;
+
+	for (i=0; i<dataLength; i++)
+		{
+		checksum = (checksum ^ (uint64_t)data[i]) * 0x100000001B3ULL;
+		}
+	return checksum;
+	}
+
+
+/**
+ * Get the current time of the monotonic clock.<br>
+ *
+ * @return	Current time[usec]
+ */
+static uint64_t this_getTime (void)
+	{
+	//========== Variable ==========
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+	}
+
+
+/**
+ * Check whether the CEP table is defined in the same way in both databases.<br>
+ *
+ * @param[in] source		Database of the snapshot
+ * @param[in] database		Memory database
+ * @param[in] tableName		Name of the CEP table
+ * @return					true : the same definition, false : different or not found
+ */
+static bool this_isSameTable (sqlite3 *source, sqlite3 *database, const M2MString *tableName)
+	{
+	//========== Variable ==========
+	sqlite3_stmt *sourceStatement = NULL;
+	sqlite3_stmt *statement = NULL;
+	const unsigned char *sourceSQL = NULL;
+	const unsigned char *sql = NULL;
+	bool same = false;
+	const char *SQL = "SELECT sql FROM sqlite_master WHERE type='table' AND name=?";
+
+	if (sqlite3_prepare_v2(source, SQL, -1, &sourceStatement, NULL)==SQLITE_OK
+			&& sqlite3_prepare_v2(database, SQL, -1, &statement, NULL)==SQLITE_OK
+			&& sqlite3_bind_text(sourceStatement, 1, (char *)tableName, -1, SQLITE_STATIC)==SQLITE_OK
+			&& sqlite3_bind_text(statement, 1, (char *)tableName, -1, SQLITE_STATIC)==SQLITE_OK
+			&& sqlite3_step(sourceStatement)==SQLITE_ROW
+			&& sqlite3_step(statement)==SQLITE_ROW
+			&& (sourceSQL=sqlite3_column_text(sourceStatement, 0))!=NULL
+			&& (sql=sqlite3_column_text(statement, 0))!=NULL)
+		{
+		same = (strcmp((const char *)sourceSQL, (const char *)sql)==0);
+		}
+	sqlite3_finalize(sourceStatement);
+	sqlite3_finalize(statement);
+	return same;
+	}
+
+
+/**
+ * Write the journal entries and the snapshots passed by the inserting<br>
+ * thread until the snapshot object is deleted (thread function).<br>
+ * The journal is flushed by fdatasync() whenever the queue is drained, or<br>
+ * every CEPCUISnapshot_SYNC_TIME under continuous load.<br>
+ *
+ * @param[in,out] argument	Snapshot object
+ * @return					NULL
+ */
+static void *this_loop (void *argument)
+	{
+	//========== Variable ==========
+	CEPCUISnapshot *self = (CEPCUISnapshot *)argument;
+	CEPCUISnapshotItem *item = NULL;
+	uint64_t syncTime = this_getTime();
+	bool synchronized = true;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot.this_loop()";
+
+	while (atomic_load(&self->writing)==true || CEPCUIQueue_isEmpty(self->queue)==false)
+		{
+		if ((item=(CEPCUISnapshotItem *)CEPCUIQueue_pop(self->queue, CEPCUISnapshot_SYNC_TIME))!=NULL)
+			{
+			//===== Snapshot =====
+			if (item->image!=NULL)
+				{
+				if (this_writeImage(self, item)==true)
+					{
+					synchronized = true;
+					}
+				sqlite3_free(item->image);
+				atomic_store(&self->pending, false);
+				}
+			//===== Journal entry =====
+			else
+				{
+				item->entry.checksum = this_getChecksum(item->data, (size_t)item->entry.length);
+				if (this_writeFile(self->fd, &item->entry, sizeof(CEPCUISnapshotEntry) + (size_t)item->entry.length)==false)
+					{
+					M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to write the journal entry");
+					}
+				synchronized = false;
+				}
+			M2MHeap_free(item);
+			}
+		//===== Flush the journal =====
+		if (synchronized==false
+				&& (CEPCUIQueue_isEmpty(self->queue)==true || this_getTime()-syncTime>=CEPCUISnapshot_SYNC_TIME))
+			{
+			fdatasync(self->fd);
+			syncTime = this_getTime();
+			synchronized = true;
+			}
+		}
+	return NULL;
+	}
+
+
+/**
+ * Get the sequence number of the last batch contained in the snapshot.<br>
+ *
+ * @param[in] source	Database of the snapshot
+ * @return				Sequence number or -1 (in case of not found)
+ */
+static int64_t this_readSequence (sqlite3 *source)
+	{
+	//========== Variable ==========
+	sqlite3_stmt *statement = NULL;
+	int64_t sequence = -1;
+
+	if (sqlite3_prepare_v2(source, "SELECT sequence FROM " CEPCUISnapshot_TABLE_NAME, -1, &statement, NULL)==SQLITE_OK
+			&& sqlite3_step(statement)==SQLITE_ROW)
+		{
+		sequence = sqlite3_column_int64(statement, 0);
+		}
+	sqlite3_finalize(statement);
+	return sequence;
+	}
+
+
+/**
+ * Insert the records of the journal entries newer than the snapshot into<br>
+ * the CEP table in the original order (the batches are inserted one by one,<br>
+ * so the same records are evicted as before the restart).<br>
+ * A torn or corrupted entry ends the journal, and is cut off the file.<br>
+ *
+ * @param[in,out] self		Snapshot object
+ * @param[in,out] inserter	Inserter object of the CEP table
+ * @param[in] schema		Schema of the CEP table (for the binary records)
+ * @return					Number of the replayed records or -1 (in case of error)
+ */
+static int64_t this_replay (CEPCUISnapshot *self, CEPCUIInserter *inserter, const CEPCUISchema *schema)
+	{
+	//========== Variable ==========
+	struct stat fileStatus;
+	M2MString *data = NULL;
+	size_t length = 0;
+	size_t position = 0;
+	size_t start = 0;
+	CEPCUISnapshotEntry entry;
+	const M2MString *records = NULL;
+	CEPCUICSVTokenizer tokenizer;
+	CEPCUIBinaryReader reader;
+	int64_t replayed = 0;
+	int64_t inserted = 0;
+	int fd = -1;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot.this_replay()";
+
+	//===== No journal =====
+	if ((fd=open((char *)self->journalFilePath, O_RDONLY | O_CLOEXEC))<0)
+		{
+		return 0;
+		}
+	else if (fstat(fd, &fileStatus)<0 || fileStatus.st_size<=0)
+		{
+		close(fd);
+		return 0;
+		}
+	//===== Map the journal =====
+	else if ((data=(M2MString *)mmap(NULL, (length=(size_t)fileStatus.st_size), PROT_READ, MAP_PRIVATE, fd, 0))==MAP_FAILED)
+		{
+		close(fd);
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Failed to map the journal(=\"%s\") : %s", self->journalFilePath, strerror(errno));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		return -1;
+		}
+	close(fd);
+	while (length-position>=sizeof(CEPCUISnapshotEntry))
+		{
+		//===== End of the valid entries =====
+		memcpy(&entry, &data[position], sizeof(CEPCUISnapshotEntry));
+		records = &data[position+sizeof(CEPCUISnapshotEntry)];
+		if (entry.magic!=CEPCUISnapshot_MAGIC
+				|| entry.length>(uint64_t)(length-position-sizeof(CEPCUISnapshotEntry))
+				|| this_getChecksum(records, (size_t)entry.length)!=entry.checksum)
+			{
+			break;
+			}
+		//===== Insert the batch newer than the snapshot =====
+		else if (entry.sequence>self->sequence)
+			{
+			if (entry.binary!=0)
+				{
+				// the journal keeps the records without the header, so the reader starts at the first record
+				reader.data = records;
+				reader.length = (size_t)entry.length;
+				reader.position = 0;
+				reader.schema = schema;
+				reader.broken = false;
+				do
+					{
+					start = reader.position;
+					if ((inserted=CEPCUIInserter_insertBinary(inserter, &reader, reader.length - reader.position))>0)
+						{
+						replayed += inserted;
+						}
+					} while (reader.position>start && reader.position<reader.length);
+				}
+			else
+				{
+				CEPCUICSVTokenizer_init(&tokenizer, records, (size_t)entry.length);
+				do
+					{
+					start = tokenizer.position;
+					if ((inserted=CEPCUIInserter_insertCSV(inserter, &tokenizer, tokenizer.length - tokenizer.position))>0)
+						{
+						replayed += inserted;
+						}
+					} while (tokenizer.position>start && tokenizer.position<tokenizer.length);
+				}
+			self->sequence = entry.sequence;
+			}
+		position += sizeof(CEPCUISnapshotEntry) + (size_t)entry.length;
+		}
+	munmap(data, length);
+	//===== Cut off the torn entry =====
+	if (position<length)
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "The journal(=\"%s\") ends with a torn entry of %zu[Byte], which is discarded", self->journalFilePath, length-position);
+		M2MLogger_info(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		if (truncate((char *)self->journalFilePath, (off_t)position)<0)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to cut off the torn entry of the journal");
+			return -1;
+			}
+		}
+	return replayed;
+	}
+
+
+/**
+ * Write all the data to the file descriptor (retrying partial writes).<br>
+ *
+ * @param[in] fd			File descriptor
+ * @param[in] data			Data
+ * @param[in] dataLength	Size of the data[Byte]
+ * @return					true : success, false : failure
+ */
+static bool this_writeFile (const int fd, const void *data, const size_t dataLength)
+	{
+	//========== Variable ==========
+	const unsigned char *pointer = (const unsigned char *)data;
+	size_t written = 0;
+	ssize_t result = 0;
+
+	while (written<dataLength)
+		{
+		if ((result=write(fd, pointer+written, dataLength-written))>0)
+			{
+			written += (size_t)result;
+			}
+		else if (result<0 && errno==EINTR)
+			{
+			continue;
+			}
+		else
+			{
+			return false;
+			}
+		}
+	return true;
+	}
+
+
+/**
+ * Write the serialized database to the temporary file, replace the<br>
+ * snapshot file with it, and truncate the journal (every entry written so<br>
+ * far is contained in the new snapshot).<br>
+ *
+ * @param[in,out] self	Snapshot object
+ * @param[in] item		Item of the snapshot
+ * @return				true : success, false : failure (the previous snapshot and the journal are kept)
+ */
+static bool this_writeImage (CEPCUISnapshot *self, const CEPCUISnapshotItem *item)
+	{
+	//========== Variable ==========
+	int fd = -1;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot.this_writeImage()";
+
+	//===== Write the temporary file =====
+	if ((fd=open((char *)self->temporaryFilePath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))<0
+			|| this_writeFile(fd, item->image, item->imageLength)==false
+			|| fsync(fd)<0)
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Failed to write the snapshot(=\"%s\") : %s", self->temporaryFilePath, strerror(errno));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		if (fd>=0)
+			{
+			close(fd);
+			unlink((char *)self->temporaryFilePath);
+			}
+		return false;
+		}
+	close(fd);
+	//===== Replace the snapshot (durably, before the journal is truncated) =====
+	if (rename((char *)self->temporaryFilePath, (char *)self->filePath)<0)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to replace the snapshot file");
+		unlink((char *)self->temporaryFilePath);
+		return false;
+		}
+	else if ((fd=open((char *)self->directoryPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC))>=0)
+		{
+		fsync(fd);
+		close(fd);
+		}
+	//===== Every entry written so far is in the snapshot =====
+	if (ftruncate(self->fd, 0)<0)
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to truncate the journal");
+		return false;
+		}
+	return true;
+	}
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Stop the writing thread after all the queued entries and snapshots are<br>
+ * written, and release the heap memory of snapshot object.<br>
+ *
+ * @param[in,out] self	Snapshot object
+ */
+void CEPCUISnapshot_delete (CEPCUISnapshot **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		//===== Stop the writing thread =====
+		if ((*self)->running==true)
+			{
+			atomic_store(&(*self)->writing, false);
+			pthread_join((*self)->thread, NULL);
+			(*self)->running = false;
+			}
+		if ((*self)->fd>=0)
+			{
+			close((*self)->fd);
+			}
+		CEPCUIQueue_delete(&(*self)->queue);
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Restore the memory database from the snapshot file with the backup API<br>
+ * (called before anything is prepared on the database).<br>
+ * The snapshot is ignored (and the journal discarded by<br>
+ * CEPCUISnapshot_start()) if the definition of the CEP table differs.<br>
+ *
+ * @param[in,out] self		Snapshot object
+ * @param[in] tableName		Name of the CEP table
+ * @return					true : restored, false : no valid snapshot
+ */
+bool CEPCUISnapshot_load (CEPCUISnapshot *self, const M2MString *tableName)
+	{
+	//========== Variable ==========
+	sqlite3 *source = NULL;
+	sqlite3_backup *backup = NULL;
+	int64_t sequence = -1;
+	int result = SQLITE_ERROR;
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot_load()";
+
+	//===== Check argument =====
+	if (self!=NULL && tableName!=NULL)
+		{
+		//===== No snapshot (the whole journal is replayed) =====
+		if (access((char *)self->filePath, F_OK)!=0)
+			{
+			return false;
+			}
+		//===== Check the snapshot =====
+		else if (sqlite3_open_v2((char *)self->filePath, &source, SQLITE_OPEN_READONLY, NULL)!=SQLITE_OK
+				|| this_isSameTable(source, self->database, tableName)==false
+				|| (sequence=this_readSequence(source))<0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "The snapshot(=\"%s\") doesn't match the CEP table, so it is discarded with the journal", self->filePath);
+			M2MLogger_info(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			}
+		//===== Copy the snapshot into the memory database =====
+		else if ((backup=sqlite3_backup_init(self->database, "main", source, "main"))==NULL
+				|| (result=sqlite3_backup_step(backup, -1))!=SQLITE_DONE)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Failed to restore the snapshot(=\"%s\") : %s, so it is discarded with the journal", self->filePath, (backup!=NULL) ? sqlite3_errstr(result) : sqlite3_errmsg(self->database));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			}
+		sqlite3_backup_finish(backup);
+		sqlite3_close(source);
+		self->discarded = (result!=SQLITE_DONE);
+		self->sequence = (self->discarded==false) ? (uint64_t)sequence : 0;
+		return (self->discarded==false);
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated snapshot object or table name is NULL");
+		return false;
+		}
+	}
+
+
+/**
+ * Construct new snapshot object of the memory database.<br>
+ *
+ * @param[in] database		Memory database which contains the CEP table
+ * @param[in] directoryPath	Regulation directory path string
+ * @param[in] interval		Interval of taking snapshots[sec]
+ * @return					Created snapshot object or NULL (in case of error)
+ */
+CEPCUISnapshot *CEPCUISnapshot_new (sqlite3 *database, const M2MString *directoryPath, const unsigned int interval)
+	{
+	//========== Variable ==========
+	CEPCUISnapshot *self = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot_new()";
+
+	//===== Check argument =====
+	if (database!=NULL && directoryPath!=NULL && interval>0)
+		{
+		if ((self=(CEPCUISnapshot *)M2MHeap_malloc(sizeof(CEPCUISnapshot)))!=NULL)
+			{
+			self->database = database;
+			self->interval = interval;
+			self->fd = -1;
+			self->snapshotTime = this_getTime();
+			atomic_init(&self->writing, false);
+			atomic_init(&self->pending, false);
+			snprintf((char *)self->directoryPath, sizeof(self->directoryPath), "%s", directoryPath);
+			snprintf((char *)self->filePath, sizeof(self->filePath), "%s/%s", directoryPath, CEPCUISnapshot_FILE_NAME);
+			snprintf((char *)self->temporaryFilePath, sizeof(self->temporaryFilePath), "%s/.%s.tmp", directoryPath, CEPCUISnapshot_FILE_NAME);
+			snprintf((char *)self->journalFilePath, sizeof(self->journalFilePath), "%s/%s", directoryPath, CEPCUISnapshot_JOURNAL_FILE_NAME);
+			return self;
+			}
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new memory for the snapshot");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated database or directory path is NULL, or interval is 0");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Serialize the memory database and pass it to the writing thread as the<br>
+ * new snapshot (called between transactions).<br>
+ * Nothing is done while the previous snapshot is still being written.<br>
+ *
+ * @param[in,out] self	Snapshot object
+ * @return				true : success, false : failure
+ */
+bool CEPCUISnapshot_save (CEPCUISnapshot *self)
+	{
+	//========== Variable ==========
+	CEPCUISnapshotItem *item = NULL;
+	sqlite3_int64 length = 0;
+	M2MString SQL[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot_save()";
+
+	//===== Check argument =====
+	if (self!=NULL && self->running==true)
+		{
+		//===== The previous snapshot is still being written =====
+		if (atomic_load(&self->pending)==true)
+			{
+			return true;
+			}
+		self->snapshotTime = this_getTime();
+		//===== Record the last batch contained in the snapshot =====
+		snprintf((char *)SQL, sizeof(SQL), "CREATE TABLE IF NOT EXISTS %s (sequence INTEGER);DELETE FROM %s;INSERT INTO %s VALUES (%llu)", CEPCUISnapshot_TABLE_NAME, CEPCUISnapshot_TABLE_NAME, CEPCUISnapshot_TABLE_NAME, (unsigned long long)self->sequence);
+		if (sqlite3_exec(self->database, (char *)SQL, NULL, NULL, NULL)!=SQLITE_OK)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to record the sequence number of the snapshot");
+			return false;
+			}
+		else if ((item=(CEPCUISnapshotItem *)M2MHeap_malloc(sizeof(CEPCUISnapshotItem)))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new memory for the snapshot");
+			return false;
+			}
+		//===== Copy the memory database =====
+		else if ((item->image=(M2MString *)sqlite3_serialize(self->database, "main", &length, 0))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to serialize the memory database");
+			M2MHeap_free(item);
+			return false;
+			}
+		item->imageLength = (size_t)length;
+		item->entry.sequence = self->sequence;
+		//===== Pass it to the writing thread =====
+		atomic_store(&self->pending, true);
+		if (CEPCUIQueue_push(self->queue, item)==false)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to pass the snapshot to the writing thread");
+			atomic_store(&self->pending, false);
+			sqlite3_free(item->image);
+			M2MHeap_free(item);
+			return false;
+			}
+		return true;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated snapshot object is NULL or not started");
+		return false;
+		}
+	}
+
+
+/**
+ * Replay the journal entries which are newer than the restored snapshot,<br>
+ * start the writing thread, and journal the batches inserted from now on.<br>
+ *
+ * @param[in,out] self		Snapshot object
+ * @param[in,out] inserter	Inserter object of the CEP table
+ * @param[in] schema		Schema of the CEP table (for the binary records)
+ * @return					Number of the replayed records or -1 (in case of error)
+ */
+int64_t CEPCUISnapshot_start (CEPCUISnapshot *self, CEPCUIInserter *inserter, const CEPCUISchema *schema)
+	{
+	//========== Variable ==========
+	int64_t replayed = 0;
+	M2MString MESSAGE[256];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISnapshot_start()";
+
+	//===== Check argument =====
+	if (self!=NULL && self->running==false && inserter!=NULL && schema!=NULL)
+		{
+		//===== Discard the journal of the discarded snapshot =====
+		if (self->discarded==true)
+			{
+			unlink((char *)self->journalFilePath);
+			}
+		//===== Replay the batches inserted after the snapshot =====
+		else if ((replayed=this_replay(self, inserter, schema))<0)
+			{
+			return -1;
+			}
+		else if (replayed>0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Replayed %lld records journaled after the snapshot", (long long)replayed);
+			M2MLogger_info(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			}
+		//===== Start journaling =====
+		if ((self->fd=open((char *)self->journalFilePath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644))<0
+				|| (self->queue=CEPCUIQueue_new(CEPCUISnapshot_QUEUE_LENGTH))==NULL)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to open the journal");
+			return -1;
+			}
+		atomic_store(&self->writing, true);
+		if (pthread_create(&self->thread, NULL, this_loop, self)!=0)
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to start the writing thread of the journal");
+			atomic_store(&self->writing, false);
+			return -1;
+			}
+		self->running = true;
+		self->snapshotTime = this_getTime();
+		CEPCUIInserter_setJournal(inserter, this_append, self);
+		return replayed;
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated snapshot object is NULL or already started, or inserter object or schema is NULL");
+		return -1;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,227 @@
+/*******************************************************************************
+ * CEPCUISnapshot.h : Snapshot and journal of the CEP table for restoring its window after a restart
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUISNAPSHOT_H_
+#define CEPCUISNAPSHOT_H_
+
+
+
+#include "CEPCUIBinaryReader.h"
+#include "CEPCUICSVTokenizer.h"
+#include "CEPCUIInserter.h"
+#include "CEPCUIQueue.h"
+#include "CEPCUISchema.h"
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sqlite3.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Snapshot file name (in the regulation directory)
+ */
+#ifndef CEPCUISnapshot_FILE_NAME
+#define CEPCUISnapshot_FILE_NAME "cepcui.snapshot"
+#endif /* CEPCUISnapshot_FILE_NAME */
+
+
+/**
+ * Journal file name (in the regulation directory)
+ */
+#ifndef CEPCUISnapshot_JOURNAL_FILE_NAME
+#define CEPCUISnapshot_JOURNAL_FILE_NAME "cepcui.journal"
+#endif /* CEPCUISnapshot_JOURNAL_FILE_NAME */
+
+
+/**
+ * Magic number of the journal entries ("CEPJ" in little endian)
+ */
+#ifndef CEPCUISnapshot_MAGIC
+#define CEPCUISnapshot_MAGIC 0x4A504543U
+#endif /* CEPCUISnapshot_MAGIC */
+
+
+/**
+ * Maximum number of the journal entries and snapshots waiting for the<br>
+ * writing thread (the insertion waits beyond it)<br>
+ */
+#ifndef CEPCUISnapshot_QUEUE_LENGTH
+#define CEPCUISnapshot_QUEUE_LENGTH 1024
+#endif /* CEPCUISnapshot_QUEUE_LENGTH */
+
+
+/**
+ * Maximum time[usec] the written journal entries wait for fdatasync() while<br>
+ * entries keep arriving<br>
+ */
+#ifndef CEPCUISnapshot_SYNC_TIME
+#define CEPCUISnapshot_SYNC_TIME 1000000UL
+#endif /* CEPCUISnapshot_SYNC_TIME */
+
+
+/**
+ * Name of the table which holds the sequence number of the last batch<br>
+ * contained in the snapshot<br>
+ */
+#ifndef CEPCUISnapshot_TABLE_NAME
+#define CEPCUISnapshot_TABLE_NAME "cepcui_snapshot"
+#endif /* CEPCUISnapshot_TABLE_NAME */
+
+
+/**
+ * Header of a journal entry, followed by the records of one batch as they<br>
+ * were consumed by the inserter (all numbers are in native byte order).<br>
+ * "checksum" is FNV-1a of the records, so a torn entry at the end of the<br>
+ * journal (left by a crash) is detected and discarded.<br>
+ */
+#ifndef CEPCUISnapshotEntry
+typedef struct
+	{
+	uint32_t magic;
+	uint32_t binary;
+	uint64_t sequence;
+	uint64_t length;
+	uint64_t checksum;
+	} CEPCUISnapshotEntry;
+#endif /* CEPCUISnapshotEntry */
+
+
+/**
+ * Snapshot object which keeps the CEP table recoverable after a restart.<br>
+ * Every batch inserted is numbered and appended to the journal, and every<br>
+ * "interval" seconds the whole memory database is serialized (a copy in<br>
+ * memory, taken between transactions) with the number of its last batch.<br>
+ * The writing thread writes the journal entries and the snapshots to the<br>
+ * files, so the insertion never waits for the disk; a new snapshot is<br>
+ * written to a temporary file and renamed, and then the journal is<br>
+ * truncated, since all of its entries are contained in the snapshot.<br>
+ */
+#ifndef CEPCUISnapshot
+typedef struct
+	{
+	sqlite3 *database;
+	M2MString directoryPath[PATH_MAX];
+	M2MString filePath[PATH_MAX];
+	M2MString temporaryFilePath[PATH_MAX];
+	M2MString journalFilePath[PATH_MAX];
+	unsigned int interval;
+	uint64_t sequence;
+	bool discarded;
+	uint64_t snapshotTime;
+	int fd;
+	CEPCUIQueue *queue;
+	pthread_t thread;
+	bool running;
+	atomic_bool writing;
+	atomic_bool pending;
+	} CEPCUISnapshot;
+#endif /* CEPCUISnapshot */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Stop the writing thread after all the queued entries and snapshots are<br>
+ * written, and release the heap memory of snapshot object.<br>
+ *
+ * @param[in,out] self	Snapshot object
+ */
+void CEPCUISnapshot_delete (CEPCUISnapshot **self);
+
+
+/**
+ * Restore the memory database from the snapshot file with the backup API<br>
+ * (called before anything is prepared on the database).<br>
+ * The snapshot is ignored (and the journal discarded by<br>
+ * CEPCUISnapshot_start()) if the definition of the CEP table differs.<br>
+ *
+ * @param[in,out] self		Snapshot object
+ * @param[in] tableName		Name of the CEP table
+ * @return					true : restored, false : no valid snapshot
+ */
+bool CEPCUISnapshot_load (CEPCUISnapshot *self, const M2MString *tableName);
+
+
+/**
+ * Construct new snapshot object of the memory database.<br>
+ *
+ * @param[in] database		Memory database which contains the CEP table
+ * @param[in] directoryPath	Regulation directory path string
+ * @param[in] interval		Interval of taking snapshots[sec]
+ * @return					Created snapshot object or NULL (in case of error)
+ */
+CEPCUISnapshot *CEPCUISnapshot_new (sqlite3 *database, const M2MString *directoryPath, const unsigned int interval);
+
+
+/**
+ * Serialize the memory database and pass it to the writing thread as the<br>
+ * new snapshot (called between transactions).<br>
+ * Nothing is done while the previous snapshot is still being written.<br>
+ *
+ * @param[in,out] self	Snapshot object
+ * @return				true : success, false : failure
+ */
+bool CEPCUISnapshot_save (CEPCUISnapshot *self);
+
+
+/**
+ * Replay the journal entries which are newer than the restored snapshot,<br>
+ * start the writing thread, and journal the batches inserted from now on.<br>
+ *
+ * @param[in,out] self		Snapshot object
+ * @param[in,out] inserter	Inserter object of the CEP table
+ * @param[in] schema		Schema of the CEP table (for the binary records)
+ * @return					Number of the replayed records or -1 (in case of error)
+ */
+int64_t CEPCUISnapshot_start (CEPCUISnapshot *self, CEPCUIInserter *inserter, const CEPCUISchema *schema);
+
+
+
+#endif /* CEPCUISNAPSHOT_H_ */
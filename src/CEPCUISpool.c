@@ -0,0 +1,421 @@
+/*******************************************************************************
+ * CEPCUISpool.c : Spool directory queue of CEP input/output files
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include "CEPCUISpool.h"
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Input file entry sorted in arrival order
+ */
+typedef struct
+	{
+	M2MString *path;
+	struct timespec modifiedTime;
+	} CEPCUISpoolEntry;
+
+
+
+/*******************************************************************************
+ * Declaration of private function
+ ******************************************************************************/
+/**
+ * Compare two input file entries in arrival order.<br>
+ *
+ * @param[in] one		Input file entry
+ * @param[in] another	Input file entry
+ * @return				Negative : one arrived first, 0 : same, positive : another arrived first
+ */
+static int this_compareEntry (const void *one, const void *another);
+
+
+/**
+ * Create the directory if it doesn't exist.<br>
+ *
+ * @param[in] directoryPath	Directory path string
+ * @return					true : the directory exists, false : failed to create the directory
+ */
+static bool this_createDirectory (const M2MString *directoryPath);
+
+
+/**
+ * Check whether the file name is a candidate of spool file.<br>
+ *
+ * @param[in] entry	Directory entry
+ * @return			1 : candidate, 0 : ignored
+ */
+static int this_isSpoolFile (const struct dirent *entry);
+
+
+
+/*******************************************************************************
+ * Private function
+ ******************************************************************************/
+/**
+ * Compare two input file entries in arrival order.<br>
+ * The modified time is compared first, and the file name is used as a tie<br>
+ * breaker so that the order is stable.<br>
+ *
+ * @param[in] one		Input file entry
+ * @param[in] another	Input file entry
+ * @return				Negative : one arrived first, 0 : same, positive : another arrived first
+ */
+static int this_compareEntry (const void *one, const void *another)
+	{
+	//========== Variable ==========
+	const CEPCUISpoolEntry *ONE = (const CEPCUISpoolEntry *)one;
+	const CEPCUISpoolEntry *ANOTHER = (const CEPCUISpoolEntry *)another;
+
+	if (ONE->modifiedTime.tv_sec!=ANOTHER->modifiedTime.tv_sec)
+		{
+		return (ONE->modifiedTime.tv_sec<ANOTHER->modifiedTime.tv_sec) ? -1 : 1;
+		}
+	else if (ONE->modifiedTime.tv_nsec!=ANOTHER->modifiedTime.tv_nsec)
+		{
+		return (ONE->modifiedTime.tv_nsec<ANOTHER->modifiedTime.tv_nsec) ? -1 : 1;
+		}
+	else
+		{
+		return M2MString_compareTo(ONE->path, ANOTHER->path);
+		}
+	}
+
+
+/**
+ * Create the directory if it doesn't exist.<br>
+ *
+ * @param[in] directoryPath	Directory path string
+ * @return					true : the directory exists, false : failed to create the directory
+ */
+static bool this_createDirectory (const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	M2MString MESSAGE[PATH_MAX+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISpool.this_createDirectory()";
+
+	//===== Create directory =====
+	if (mkdir((char *)directoryPath, 0755)==0 || errno==EEXIST)
+		{
+		return true;
+		}
+	//===== Error handling =====
+	else
+		{
+		memset(MESSAGE, 0, sizeof(MESSAGE));
+		snprintf(MESSAGE, sizeof(MESSAGE)-1, (M2MString *)"Failed to create the spool directory(=\"%s\") : %s", directoryPath, strerror(errno));
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+		return false;
+		}
+	}
+
+
+/**
+ * Check whether the file name is a candidate of spool file.<br>
+ *
+ * @param[in] entry	Directory entry
+ * @return			1 : candidate, 0 : ignored
+ */
+static int this_isSpoolFile (const struct dirent *entry)
+	{
+	return (entry!=NULL && entry->d_name[0]!='.') ? 1 : 0;
+	}
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the heap memory of spool queue object.<br>
+ *
+ * @param[in,out] self	Spool queue object
+ */
+void CEPCUISpool_delete (CEPCUISpool **self)
+	{
+	//===== Check argument =====
+	if (self!=NULL && (*self)!=NULL)
+		{
+		M2MHeap_free((*self));
+		}
+	return;
+	}
+
+
+/**
+ * Release the file path list got by CEPCUISpool_getIncomingFileList().<br>
+ *
+ * @param[in,out] fileList	File path list
+ * @param[in] count			Number of file paths in the list
+ */
+void CEPCUISpool_deleteFileList (M2MString ***fileList, const size_t count)
+	{
+	//========== Variable ==========
+	size_t i = 0;
+
+	//===== Check argument =====
+	if (fileList!=NULL && (*fileList)!=NULL)
+		{
+		for (i=0; i<count; i++)
+			{
+			M2MHeap_free((*fileList)[i]);
+			}
+		M2MHeap_free((*fileList));
+		}
+	return;
+	}
+
+
+/**
+ * Get the paths of input files in incoming directory in arrival order.<br>
+ * Files whose names begin with "." are regarded as still being written<br>
+ * (producers should write to a dot-file and rename it when finished) and<br>
+ * are ignored.<br>
+ *
+ * @param[in] self			Spool queue object
+ * @param[out] fileList		Pointer for copying the file path list (allocated in this function)
+ * @param[in] maxCount		Maximum number of file paths to get
+ * @return					Number of file paths in the list
+ */
+size_t CEPCUISpool_getIncomingFileList (const CEPCUISpool *self, M2MString ***fileList, const size_t maxCount)
+	{
+	//========== Variable ==========
+	struct dirent **nameList = NULL;
+	CEPCUISpoolEntry *entryList = NULL;
+	struct stat fileStatus;
+	int nameCount = 0;
+	size_t count = 0;
+	size_t pathLength = 0;
+	int i = 0;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISpool_getIncomingFileList()";
+
+	//===== Check argument =====
+	if (self!=NULL && fileList!=NULL && maxCount>0)
+		{
+		(*fileList) = NULL;
+		//===== Scan incoming directory =====
+		if ((nameCount=scandir((char *)self->incomingDirectoryPath, &nameList, this_isSpoolFile, NULL))>0)
+			{
+			if ((entryList=(CEPCUISpoolEntry *)M2MHeap_malloc(sizeof(CEPCUISpoolEntry) * (size_t)nameCount))!=NULL)
+				{
+				//===== Collect regular files with their modified time =====
+				for (i=0; i<nameCount; i++)
+					{
+					pathLength = M2MString_length(self->incomingDirectoryPath) + strlen(nameList[i]->d_name) + 2;
+					if ((entryList[count].path=(M2MString *)M2MHeap_malloc(pathLength))!=NULL)
+						{
+						snprintf((char *)entryList[count].path, pathLength, "%s/%s", self->incomingDirectoryPath, nameList[i]->d_name);
+						if (stat((char *)entryList[count].path, &fileStatus)==0 && S_ISREG(fileStatus.st_mode))
+							{
+							entryList[count].modifiedTime = fileStatus.st_mtim;
+							count++;
+							}
+						else
+							{
+							M2MHeap_free(entryList[count].path);
+							}
+						}
+					free(nameList[i]);
+					}
+				free(nameList);
+				//===== Sort in arrival order =====
+				qsort(entryList, count, sizeof(CEPCUISpoolEntry), this_compareEntry);
+				//===== Copy the oldest file paths =====
+				if (count>0 && ((*fileList)=(M2MString **)M2MHeap_malloc(sizeof(M2MString *) * count))!=NULL)
+					{
+					for (i=0; (size_t)i<count; i++)
+						{
+						if ((size_t)i<maxCount)
+							{
+							(*fileList)[i] = entryList[i].path;
+							}
+						else
+							{
+							M2MHeap_free(entryList[i].path);
+							}
+						}
+					count = (count<maxCount) ? count : maxCount;
+					}
+				else
+					{
+					for (i=0; (size_t)i<count; i++)
+						{
+						M2MHeap_free(entryList[i].path);
+						}
+					count = 0;
+					}
+				M2MHeap_free(entryList);
+				return count;
+				}
+			//===== Error handling =====
+			else
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for input file list");
+				for (i=0; i<nameCount; i++)
+					{
+					free(nameList[i]);
+					}
+				free(nameList);
+				return 0;
+				}
+			}
+		//===== No input file =====
+		else
+			{
+			if (nameList!=NULL)
+				{
+				free(nameList);
+				}
+			return 0;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated spool object or file list pointer is NULL");
+		return 0;
+		}
+	}
+
+
+/**
+ * Construct new spool queue object.<br>
+ * The incoming and outgoing directories are created under the indicated<br>
+ * directory if they don't exist.<br>
+ * Result files in outgoing directory are published with CEPCUIPublisher.<br>
+ *
+ * @param[in] directoryPath	Path of the directory which contains the spool directories
+ * @return					Created spool queue object or NULL (in case of error)
+ */
+CEPCUISpool *CEPCUISpool_new (const M2MString *directoryPath)
+	{
+	//========== Variable ==========
+	CEPCUISpool *self = NULL;
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISpool_new()";
+
+	//===== Check argument =====
+	if (directoryPath!=NULL && M2MString_length(directoryPath)>0)
+		{
+		//===== Allocate new heap memory =====
+		if ((self=(CEPCUISpool *)M2MHeap_malloc(sizeof(CEPCUISpool)))!=NULL)
+			{
+			snprintf((char *)self->incomingDirectoryPath, sizeof(self->incomingDirectoryPath), "%s/%s", directoryPath, CEPCUISpool_INCOMING_DIRECTORY_NAME);
+			snprintf((char *)self->outgoingDirectoryPath, sizeof(self->outgoingDirectoryPath), "%s/%s", directoryPath, CEPCUISpool_OUTGOING_DIRECTORY_NAME);
+			snprintf((char *)self->rejectedDirectoryPath, sizeof(self->rejectedDirectoryPath), "%s/%s", directoryPath, CEPCUISpool_REJECTED_DIRECTORY_NAME);
+			//===== Create spool directories =====
+			if (this_createDirectory(self->incomingDirectoryPath)==true
+					&& this_createDirectory(self->outgoingDirectoryPath)==true
+					&& this_createDirectory(self->rejectedDirectoryPath)==true)
+				{
+				return self;
+				}
+			//===== Error handling =====
+			else
+				{
+				M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to prepare the spool directories");
+				CEPCUISpool_delete(&self);
+				return NULL;
+				}
+			}
+		//===== Error handling =====
+		else
+			{
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Failed to allocate new heap memory for spool object");
+			return NULL;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated directory path is NULL or empty");
+		return NULL;
+		}
+	}
+
+
+/**
+ * Move the input file which can't be read (by permission, memory shortage<br>
+ * and so on) out of incoming directory into rejected directory, so that it<br>
+ * isn't retried forever. If it can't be moved, it is removed.<br>
+ *
+ * @param[in] self		Spool queue object
+ * @param[in] filePath	Input file path string
+ * @return				true : the file is out of incoming directory, false : failure
+ */
+bool CEPCUISpool_reject (const CEPCUISpool *self, const M2MString *filePath)
+	{
+	//========== Variable ==========
+	const M2MString *fileName = NULL;
+	M2MString REJECTED_FILE_PATH[PATH_MAX];
+	M2MString MESSAGE[PATH_MAX*2+128];
+	const M2MString *METHOD_NAME = (M2MString *)"CEPCUISpool_reject()";
+
+	//===== Check argument =====
+	if (self!=NULL && filePath!=NULL)
+		{
+		fileName = (M2MString *)strrchr((char *)filePath, '/');
+		fileName = (fileName!=NULL) ? fileName + 1 : filePath;
+		//===== Move the file into rejected directory =====
+		if (snprintf((char *)REJECTED_FILE_PATH, sizeof(REJECTED_FILE_PATH), "%s/%s", self->rejectedDirectoryPath, fileName)<(int)sizeof(REJECTED_FILE_PATH)
+				&& rename((char *)filePath, (char *)REJECTED_FILE_PATH)==0)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Moved the unreadable input file(=\"%s\") to \"%s\"", filePath, REJECTED_FILE_PATH);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return true;
+			}
+		//===== Remove the file =====
+		else if (unlink((char *)filePath)==0 || errno==ENOENT)
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Removed the unreadable input file(=\"%s\"), which couldn't be moved to rejected directory", filePath);
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return true;
+			}
+		//===== Error handling =====
+		else
+			{
+			memset(MESSAGE, 0, sizeof(MESSAGE));
+			snprintf((char *)MESSAGE, sizeof(MESSAGE)-1, "Failed to move or remove the unreadable input file(=\"%s\") : %s", filePath, strerror(errno));
+			M2MLogger_error(NULL, METHOD_NAME, __LINE__, MESSAGE);
+			return false;
+			}
+		}
+	//===== Argument error =====
+	else
+		{
+		M2MLogger_error(NULL, METHOD_NAME, __LINE__, (M2MString *)"Argument error! Indicated spool object or file path is NULL");
+		return false;
+		}
+	}
+
+
+
+/* End Of File */
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * CEPCUISpool.h : Spool directory queue of CEP input/output files
+ *
+ * Copyright (c) 2014, Akihisa Yasuda
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#pragma once
+
+#ifndef CEPCUISPOOL_H_
+#define CEPCUISPOOL_H_
+
+
+
+#include "m2m/lib/io/M2MHeap.h"
+#include "m2m/lib/lang/M2MString.h"
+#include "m2m/lib/log/M2MFileAppender.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+
+
+/*******************************************************************************
+ * Definition
+ ******************************************************************************/
+/**
+ * Name of the directory where producers drop input files
+ */
+#ifndef CEPCUISpool_INCOMING_DIRECTORY_NAME
+#define CEPCUISpool_INCOMING_DIRECTORY_NAME (M2MString *)"incoming"
+#endif /* CEPCUISpool_INCOMING_DIRECTORY_NAME */
+
+
+/**
+ * Name of the directory where sequenced result files are published
+ */
+#ifndef CEPCUISpool_OUTGOING_DIRECTORY_NAME
+#define CEPCUISpool_OUTGOING_DIRECTORY_NAME (M2MString *)"outgoing"
+#endif /* CEPCUISpool_OUTGOING_DIRECTORY_NAME */
+
+
+/**
+ * Name of the directory where input files which can't be read are moved
+ */
+#ifndef CEPCUISpool_REJECTED_DIRECTORY_NAME
+#define CEPCUISpool_REJECTED_DIRECTORY_NAME (M2MString *)"rejected"
+#endif /* CEPCUISpool_REJECTED_DIRECTORY_NAME */
+
+
+/**
+ * Spool directory queue object.<br>
+ */
+#ifndef CEPCUISpool
+typedef struct
+	{
+	M2MString incomingDirectoryPath[PATH_MAX];
+	M2MString outgoingDirectoryPath[PATH_MAX];
+	M2MString rejectedDirectoryPath[PATH_MAX];
+	} CEPCUISpool;
+#endif /* CEPCUISpool */
+
+
+
+/*******************************************************************************
+ * Public function
+ ******************************************************************************/
+/**
+ * Release the heap memory of spool queue object.<br>
+ *
+ * @param[in,out] self	Spool queue object
+ */
+void CEPCUISpool_delete (CEPCUISpool **self);
+
+
+/**
+ * Release the file path list got by CEPCUISpool_getIncomingFileList().<br>
+ *
+ * @param[in,out] fileList	File path list
+ * @param[in] count			Number of file paths in the list
+ */
+void CEPCUISpool_deleteFileList (M2MString ***fileList, const size_t count);
+
+
+/**
+ * Get the paths of input files in incoming directory in arrival order.<br>
+ * Files whose names begin with "." are regarded as still being written<br>
+ * (producers should write to a dot-file and rename it when finished) and<br>
+ * are ignored.<br>
+ *
+ * @param[in] self			Spool queue object
+ * @param[out] fileList		Pointer for copying the file path list (allocated in this function)
+ * @param[in] maxCount		Maximum number of file paths to get
+ * @return					Number of file paths in the list
+ */
+size_t CEPCUISpool_getIncomingFileList (const CEPCUISpool *self, M2MString ***fileList, const size_t maxCount);
+
+
+/**
+ * Construct new spool queue object.<br>
+ * The incoming and outgoing directories are created under the indicated<br>
+ * directory if they don't exist.<br>
+ * Result files in outgoing directory are published with CEPCUIPublisher.<br>
+ *
+ * @param[in] directoryPath	Path of the directory which contains the spool directories
+ * @return					Created spool queue object or NULL (in case of error)
+ */
+CEPCUISpool *CEPCUISpool_new (const M2MString *directoryPath);
+
+
+/**
+ * Move the input file which can't be read (by permission, memory shortage<br>
+ * and so on) out of incoming directory into rejected directory, so that it<br>
+ * isn't retried forever. If it can't be moved, it is removed.<br>
+ *
+ * @param[in] self		Spool queue object
+ * @param[in] filePath	Input file path string
+ * @return				true : the file is out of incoming directory, false : failure
+ */
+bool CEPCUISpool_reject (const CEPCUISpool *self, const M2MString *filePath);
+
+
+
+#endif /* CEPCUISPOOL_H_ */